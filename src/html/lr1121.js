@@ -4,6 +4,8 @@
 
 document.addEventListener('DOMContentLoaded', onReady, false);
 
+let resume = null;
+
 function _(el) {
   return document.getElementById(el);
 }
@@ -33,6 +35,11 @@ function loadData() {
         _('radio_hardware2').textContent = dec2hex(data['radio2']['hardware'], 2)
         _('radio_firmware2').textContent = dec2hex(data['radio2']['firmware'], 4)
       }
+      // An upload which stopped part way can carry on from where it got to
+      resume = data['resume'] || null;
+    } else if (this.readyState === 4 && this.status === 503) {
+      // Still writing what an upload that just stopped sent, ask again once it has given up on it
+      setTimeout(loadData, 1000);
     }
   };
   xmlhttp.open('GET', '/lr1121.json', true);
@@ -68,18 +75,38 @@ function fileSelectHandler(e) {
 }
 
 function uploadFile(file) {
+  const radio = document.querySelector("input[name=optionsRadio]:checked").value;
+  if (resume && resume.size === file.size && resume.radio == radio) {
+    cuteAlert({
+      type: 'question',
+      title: 'Carry On Upload',
+      message: 'The last upload of a file this size stopped after ' + resume.offset + ' bytes. Carry on from there?',
+      confirmText: 'Carry on',
+      cancelText: 'Start again'
+    }).then((e)=>{
+      sendFile(file, radio, e === 'confirm' ? resume.offset : 0);
+    });
+  } else {
+    sendFile(file, radio, 0);
+  }
+}
+
+function sendFile(file, radio, offset) {
   _('upload_btn').disabled = true
   try {
     const formdata = new FormData();
-    formdata.append('upload', file, file.name);
+    formdata.append('upload', file.slice(offset), file.name);
     const ajax = new XMLHttpRequest();
-    ajax.upload.addEventListener('progress', progressHandler, false);
+    ajax.upload.addEventListener('progress', (event) => {
+      progressHandler({loaded: offset + event.loaded, total: offset + event.total});
+    }, false);
     ajax.addEventListener('load', completeHandler, false);
     ajax.addEventListener('error', errorHandler, false);
     ajax.addEventListener('abort', abortHandler, false);
     ajax.open('POST', '/lr1121');
     ajax.setRequestHeader('X-FileSize', file.size);
-    ajax.setRequestHeader('X-Radio', document.querySelector("input[name=optionsRadio]:checked").value);
+    ajax.setRequestHeader('X-Radio', radio);
+    ajax.setRequestHeader('X-Offset', offset);
     ajax.send(formdata);
   }
   catch (e) {
@@ -155,6 +182,7 @@ function completeHandler(event) {
       xmlhttp.send(data);
     });
   } else {
+    loadData();
     cuteAlert({
       type: 'error',
       title: 'Update Failed',
@@ -164,6 +192,7 @@ function completeHandler(event) {
 }
 
 function errorHandler(event) {
+  loadData();
   _('status').innerHTML = '';
   _('progressBar').value = 0;
   _('upload_btn').disabled = false
@@ -175,6 +204,7 @@ function errorHandler(event) {
 }
 
 function abortHandler(event) {
+  loadData();
   _('status').innerHTML = '';
   _('progressBar').value = 0;
   _('upload_btn').disabled = false
@@ -232,6 +232,9 @@
 #ifndef GPIO_PIN_RCSIGNAL_RX_SBUS
 #define GPIO_PIN_RCSIGNAL_RX_SBUS UNDEF_PIN
 #endif
+#ifndef GPIO_PIN_SERIAL_RTS
+#define GPIO_PIN_SERIAL_RTS UNDEF_PIN
+#endif
 #if defined(PLATFORM_ESP8266)
 #ifndef GPIO_PIN_DEBUG_RX
 #define GPIO_PIN_DEBUG_RX       3
@@ -0,0 +1,221 @@
+#include "AirPortLink.h"
+
+#include <string.h>
+
+#define SEQ_MASK (AIRPORT_SEQ_COUNT - 1)
+#define HEADER(seq, ack, sack) ((uint8_t)(((seq) << 5) | ((ack) << 2) | (sack)))
+#define HEADER_SEQ(h) ((h) >> 5)
+#define HEADER_ACK(h) (((h) >> 2) & SEQ_MASK)
+#define HEADER_SACK(h) ((h) & 0x03)
+
+AirPortLink::AirPortLink(FIFO<AP_MAX_BUF_LEN> &input, FIFO<AP_MAX_BUF_LEN> &output, bool reliable)
+    : _input(input), _output(output), _reliable(reliable), _inputPaused(false)
+{
+    reset();
+    // Both ends are new, there is nothing from before to get out of step with
+    _sync = AIRPORT_SYNCED;
+}
+
+void ICACHE_RAM_ATTR AirPortLink::reset()
+{
+    _input.lock();
+    _input.flush();
+    _input.unlock();
+    _output.lock();
+    _output.flush();
+    _output.unlock();
+
+    restartWindow();
+    _sync = _reliable ? AIRPORT_RESETTING : AIRPORT_SYNCED;
+}
+
+void ICACHE_RAM_ATTR AirPortLink::restartWindow()
+{
+    memset(_tx, 0, sizeof(_tx));
+    memset(_rx, 0, sizeof(_rx));
+    _txBase = 0;
+    _txNext = 0;
+    _txSlot = 0;
+    _rxNext = 0;
+    _ackPending = false;
+}
+
+bool ICACHE_RAM_ATTR AirPortLink::hasPending() const
+{
+    if (!_reliable)
+        return _input.size() > 0;
+    return _sync != AIRPORT_SYNCED || _ackPending || outstanding() > 0 || _input.size() > 0;
+}
+
+uint8_t ICACHE_RAM_ATTR AirPortLink::pack(uint8_t *payload, uint8_t maxLen)
+{
+    if (!_reliable)
+    {
+        _input.lock();
+        uint8_t const count = _input.size() < maxLen ? _input.size() : maxLen;
+        _input.popBytes(payload, count);
+        _input.unlock();
+        return count;
+    }
+
+    if (_sync != AIRPORT_SYNCED)
+    {
+        payload[0] = HEADER(_sync == AIRPORT_RESETTING ? AIRPORT_CTRL_RESET : AIRPORT_CTRL_RESET_ACK, 0, 0);
+        return 1;
+    }
+
+    ++_txSlot;
+    // Oldest segment which needs sending again first
+    airport_segment_t *seg = nullptr;
+    uint8_t seq = 0;
+    for (uint8_t i = 0; i < outstanding(); ++i)
+    {
+        seq = (_txBase + i) & SEQ_MASK;
+        airport_segment_t &s = _tx[seq];
+        if (!s.sacked && (s.lost || (uint8_t)(_txSlot - s.sentSlot) >= AIRPORT_RESEND_SLOTS))
+        {
+            seg = &s;
+            ++segmentsResent;
+            break;
+        }
+    }
+    // then new data if the window has room
+    if (!seg && outstanding() < AIRPORT_WINDOW && _input.size() > 0)
+    {
+        seq = _txNext;
+        seg = &_tx[seq];
+        _input.lock();
+        seg->len = _input.size() < maxLen - 1 ? _input.size() : maxLen - 1;
+        _input.popBytes(seg->data, seg->len);
+        _input.unlock();
+        seg->sacked = false;
+        _txNext = (_txNext + 1) & SEQ_MASK;
+        ++segmentsSent;
+    }
+
+    uint8_t const sack = (_rx[(_rxNext + 1) & SEQ_MASK].len ? 2 : 0) | (_rx[(_rxNext + 2) & SEQ_MASK].len ? 1 : 0);
+    _ackPending = false;
+    if (!seg)
+    {
+        payload[0] = HEADER(AIRPORT_CTRL_ACK, _rxNext, sack);
+        return 1;
+    }
+
+    seg->lost = false;
+    seg->sentSlot = _txSlot;
+    // The payload size only changes with the packet rate, which means a new connection
+    uint8_t const len = seg->len < maxLen - 1 ? seg->len : maxLen - 1;
+    payload[0] = HEADER(seq, _rxNext, sack);
+    memcpy(&payload[1], seg->data, len);
+    return len + 1;
+}
+
+void ICACHE_RAM_ATTR AirPortLink::unpack(const uint8_t *payload, uint8_t count)
+{
+    if (!_reliable)
+    {
+        _output.atomicPushBytes(payload, count);
+        return;
+    }
+    if (count == 0)
+        return;
+
+    uint8_t const header = payload[0];
+    uint8_t const ctrl = count == 1 ? HEADER_SEQ(header) : AIRPORT_CTRL_ACK;
+    if (ctrl == AIRPORT_CTRL_RESET)
+    {
+        // The other end started over, anything in flight either way is from before
+        if (_sync == AIRPORT_SYNCED)
+            ++resyncs;
+        restartWindow();
+        _sync = AIRPORT_ACKING;
+        return;
+    }
+    if (ctrl == AIRPORT_CTRL_RESET_ACK)
+    {
+        // Acknowledged, so the other end stops sending reset acks even with no data to send
+        _sync = AIRPORT_SYNCED;
+        _ackPending = true;
+        return;
+    }
+    if (_sync == AIRPORT_RESETTING)
+    {
+        // Still from before the reset
+        return;
+    }
+    // Anything else means the other end has had the reset ack
+    _sync = AIRPORT_SYNCED;
+
+    processAck(HEADER_ACK(header), HEADER_SACK(header));
+    if (count > 1)
+        receive(HEADER_SEQ(header), &payload[1], count - 1);
+    // Segments waiting for room in the output buffer
+    deliver();
+}
+
+void ICACHE_RAM_ATTR AirPortLink::processAck(uint8_t ack, uint8_t sack)
+{
+    // Stale, or from before a reset
+    if (((ack - _txBase) & SEQ_MASK) > outstanding())
+        return;
+    _txBase = ack;
+
+    bool laterReceived = false;
+    for (uint8_t i = 1; i < AIRPORT_WINDOW; ++i)
+    {
+        if (i < outstanding() && (sack & (1 << (AIRPORT_WINDOW - 1 - i))))
+        {
+            _tx[(_txBase + i) & SEQ_MASK].sacked = true;
+            laterReceived = true;
+        }
+    }
+    if (laterReceived)
+        _tx[_txBase].lost = true;
+}
+
+void ICACHE_RAM_ATTR AirPortLink::receive(uint8_t seq, const uint8_t *data, uint8_t len)
+{
+    _ackPending = true;
+    airport_segment_t &seg = _rx[seq];
+    if (((seq - _rxNext) & SEQ_MASK) >= AIRPORT_WINDOW || seg.len != 0)
+    {
+        ++duplicates;
+        return;
+    }
+    if (len > sizeof(seg.data))
+        len = sizeof(seg.data);
+    memcpy(seg.data, data, len);
+    seg.len = len;
+}
+
+void ICACHE_RAM_ATTR AirPortLink::deliver()
+{
+    while (_rx[_rxNext].len != 0)
+    {
+        airport_segment_t &seg = _rx[_rxNext];
+        _output.lock();
+        bool const fits = _output.free() >= seg.len;
+        if (fits)
+            _output.pushBytes(seg.data, seg.len);
+        _output.unlock();
+        if (!fits)
+        {
+            ++outputStalls;
+            return;
+        }
+        seg.len = 0;
+        _rxNext = (_rxNext + 1) & SEQ_MASK;
+        _ackPending = true;
+        ++segmentsReceived;
+    }
+}
+
+bool AirPortLink::updateFlowControl()
+{
+    uint16_t const size = _input.size();
+    bool const paused = _inputPaused ? size > AIRPORT_FLOW_RESUME : size >= AIRPORT_FLOW_STOP;
+    if (paused == _inputPaused)
+        return false;
+    _inputPaused = paused;
+    return true;
+}
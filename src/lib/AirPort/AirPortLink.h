@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stdint.h>
+#include "FIFO.h"
+#include "telemetry_protocol.h"
+
+// Reliable mode, both ends must be built with the same setting
+#if defined(USE_AIRPORT_RELIABLE)
+#define AIRPORT_RELIABLE_DEFAULT true
+#else
+#define AIRPORT_RELIABLE_DEFAULT false
+#endif
+
+// Sequence numbers are 3 bits, selective repeat needs the window to be at most half of that
+#define AIRPORT_SEQ_COUNT 8
+#define AIRPORT_WINDOW 3
+// The seq field of a packet with only the header, which has no segment in it
+#define AIRPORT_CTRL_ACK 0          // just the acknowledgement
+#define AIRPORT_CTRL_RESET 1        // this end has started over
+#define AIRPORT_CTRL_RESET_ACK 2    // started over too after a reset from the other end
+// Largest payload the OTA packets carry, one byte of it is the header in reliable mode
+#define AIRPORT_MAX_PAYLOAD ELRS8_TELEMETRY_BYTES_PER_CALL
+// Own packets sent before an unacknowledged segment is sent again
+#if !defined(AIRPORT_RESEND_SLOTS)
+#define AIRPORT_RESEND_SLOTS 3
+#endif
+// Input buffer fill at which the UART is told to stop, and to carry on again
+#define AIRPORT_FLOW_STOP (AP_MAX_BUF_LEN * 3 / 4)
+#define AIRPORT_FLOW_RESUME (AP_MAX_BUF_LEN / 4)
+
+// Software flow control characters
+#define AIRPORT_XON 0x11
+#define AIRPORT_XOFF 0x13
+
+/**
+ * Carries the AirPort serial stream over the telemetry and uplink slots
+ *
+ * Without reliable mode bytes go out as they are, and are lost with the
+ * packet that carried them. In reliable mode the first byte of each packet's
+ * payload is a header:
+ *   seq:3   sequence number of the segment in the rest of the payload
+ *   ack:3   next sequence number expected from the other end
+ *   sack:2  the two segments after ack have been received out of order
+ * A packet with no data after the header only carries the acknowledgement.
+ * Up to AIRPORT_WINDOW segments are in flight. A segment is sent again when
+ * a later one has been selectively acknowledged, or when AIRPORT_RESEND_SLOTS
+ * of our packets have gone out without it being acknowledged. Received
+ * segments are only acknowledged once they fit in the output buffer, so a
+ * slow UART on the far end holds the sender back instead of losing data.
+ * Both ends start over from sequence 0 with reset(), which is called on
+ * every new connection. As the two ends don't always see the same connection
+ * come and go, after a reset an end only sends header-only packets with
+ * AIRPORT_CTRL_RESET in the seq field until the other end answers with
+ * AIRPORT_CTRL_RESET_ACK. The other end starts its own window over when it
+ * gets the reset, so neither is left waiting for sequence numbers from before.
+ */
+class AirPortLink
+{
+public:
+    AirPortLink(FIFO<AP_MAX_BUF_LEN> &input, FIFO<AP_MAX_BUF_LEN> &output, bool reliable = AIRPORT_RELIABLE_DEFAULT);
+
+    bool isReliable() const { return _reliable; }
+
+    /**
+     * @brief Forget all data in flight and empty both buffers
+     */
+    void reset();
+
+    /**
+     * @brief true if there is data or an acknowledgement to send
+     */
+    bool hasPending() const;
+
+    /**
+     * @brief true if this TX packet should carry AirPort data. AirPort only gets the packets
+     * channel data would go in, so MSP still gets its turn while the window is full.
+     * @param mspDue the packet is MSP's turn and it has something to send
+     */
+    bool takesUplinkSlot(bool mspDue) const { return !mspDue && hasPending(); }
+
+    /**
+     * @brief Fill the payload of an outgoing packet
+     * @return number of bytes used
+     */
+    uint8_t pack(uint8_t *payload, uint8_t maxLen);
+
+    /**
+     * @brief Take the payload of a received packet
+     */
+    void unpack(const uint8_t *payload, uint8_t count);
+
+    /**
+     * @brief Update the flow control state from how full the input buffer is
+     * @return true if it changed, isInputPaused() has the new state
+     */
+    bool updateFlowControl();
+    bool isInputPaused() const { return _inputPaused; }
+
+    uint32_t segmentsSent = 0;     // new segments sent
+    uint32_t segmentsResent = 0;   // segments sent again
+    uint32_t segmentsReceived = 0; // segments passed to the output buffer
+    uint32_t duplicates = 0;       // segments received again
+    uint32_t outputStalls = 0;     // times a received segment had to wait for room in the output buffer
+    uint32_t resyncs = 0;          // times the other end started over and this one followed
+
+private:
+    typedef struct {
+        uint8_t data[AIRPORT_MAX_PAYLOAD - 1];
+        uint8_t len;       // 0 if not held
+        uint8_t sentSlot;  // _txSlot when last sent
+        bool sacked;       // received out of order by the other end
+        bool lost;         // a later segment was received, send it again
+    } airport_segment_t;
+
+    typedef enum : uint8_t {
+        AIRPORT_SYNCED,
+        AIRPORT_RESETTING,  // started over, waiting for the other end to follow
+        AIRPORT_ACKING,     // the other end started over, telling it this one has too
+    } airport_sync_e;
+
+    uint8_t outstanding() const { return (_txNext - _txBase) & (AIRPORT_SEQ_COUNT - 1); }
+    void processAck(uint8_t ack, uint8_t sack);
+    void receive(uint8_t seq, const uint8_t *data, uint8_t len);
+    void deliver();
+    void restartWindow();
+
+    FIFO<AP_MAX_BUF_LEN> &_input;
+    FIFO<AP_MAX_BUF_LEN> &_output;
+    bool _reliable;
+    bool _inputPaused;
+    airport_sync_e _sync;
+
+    // Sending
+    airport_segment_t _tx[AIRPORT_SEQ_COUNT];
+    uint8_t _txBase;   // oldest unacknowledged
+    uint8_t _txNext;   // next new segment
+    uint8_t _txSlot;   // packets sent
+
+    // Receiving
+    airport_segment_t _rx[AIRPORT_SEQ_COUNT];
+    uint8_t _rxNext;   // next to pass to the output buffer
+    bool _ackPending;
+};
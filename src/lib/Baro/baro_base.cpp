@@ -1,7 +1,8 @@
-#include <math.h>
+#ifndef UNIT_TEST
 #include <Wire.h>
 
 #include "baro_base.h"
+#include "baro_math.h"
 
 uint8_t BaroI2CBase::m_address = 0;
 
@@ -10,8 +11,7 @@ uint8_t BaroI2CBase::m_address = 0;
  **/
 int32_t BaroBase::pressureToAltitude(uint32_t pressuredPa)
 {
-    const float seaLeveldPa = 1013250; // 1013.25hPa
-    return 4433000 * (1.0 - pow(pressuredPa / seaLeveldPa, 0.1903));
+    return baroPressureToAltitude(pressuredPa);
 }
 
 void BaroI2CBase::readRegister(uint8_t reg, uint8_t *data, size_t size)
@@ -32,3 +32,4 @@ void BaroI2CBase::writeRegister(uint8_t reg, uint8_t *data, size_t size)
     Wire.write(data, size);
     Wire.endTransmission();
 }
+#endif
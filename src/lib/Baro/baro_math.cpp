@@ -0,0 +1,84 @@
+#include "baro_math.h"
+
+// 4433000 * (1 - (i * 4096 / 1013250) ^ 0.1903) in cm, for i from BARO_ALT_LUT_FIRST
+static const int32_t altitudeLut[BARO_ALT_LUT_COUNT] = {
+    1188243, 1175486, 1162938, 1150592, 1138440, 1126476, 1114694, 1103086,
+    1091649, 1080375, 1069261, 1058301, 1047490, 1036824, 1026298, 1015910,
+    1005654, 995526, 985525, 975645, 965884, 956238, 946705, 937282,
+    927965, 918753, 909642, 900631, 891716, 882895, 874167, 865529,
+    856980, 848516, 840136, 831839, 823623, 815485, 807424, 799439,
+    791528, 783689, 775921, 768223, 760593, 753030, 745533, 738099,
+    730729, 723421, 716174, 708986, 701856, 694785, 687769, 680809,
+    673904, 667052, 660253, 653506, 646809, 640163, 633565, 627016,
+    620515, 614060, 607652, 601289, 594970, 588696, 582465, 576276,
+    570129, 564024, 557960, 551935, 545950, 540004, 534097, 528227,
+    522394, 516599, 510839, 505116, 499427, 493774, 488154, 482569,
+    477017, 471498, 466011, 460557, 455134, 449743, 444382, 439052,
+    433752, 428482, 423241, 418029, 412845, 407690, 402563, 397464,
+    392391, 387346, 382327, 377335, 372369, 367428, 362513, 357623,
+    352757, 347917, 343100, 338308, 333539, 328794, 324072, 319373,
+    314697, 310043, 305412, 300802, 296214, 291648, 287103, 282580,
+    278077, 273594, 269133, 264691, 260270, 255868, 251486, 247124,
+    242780, 238456, 234151, 229864, 225596, 221346, 217115, 212901,
+    208706, 204527, 200367, 196224, 192097, 187988, 183896, 179821,
+    175762, 171719, 167693, 163682, 159688, 155710, 151747, 147800,
+    143868, 139951, 136050, 132164, 128292, 124436, 120593, 116766,
+    112953, 109154, 105369, 101598, 97841, 94098, 90369, 86653,
+    82951, 79262, 75586, 71924, 68274, 64638, 61014, 57403,
+    53805, 50219, 46645, 43084, 39536, 35999, 32474, 28962,
+    25461, 21972, 18495, 15029, 11575, 8133, 4701, 1281,
+    -2128, -5525, -8912, -12288, -15652, -19007, -22350, -25683,
+    -29005, -32316, -35618, -38908, -42189, -45459, -48720, -51970,
+    -55210, -58440, -61661, -64872, -68073, -71264, -74445,
+};
+
+int32_t baroPressureToAltitude(uint32_t pressuredPa)
+{
+    // Outside the table the first or last segment is extended
+    int32_t idx = (int32_t)(pressuredPa >> BARO_ALT_LUT_SHIFT) - BARO_ALT_LUT_FIRST;
+    if (idx < 0)
+        idx = 0;
+    else if (idx > BARO_ALT_LUT_COUNT - 2)
+        idx = BARO_ALT_LUT_COUNT - 2;
+
+    int32_t const frac = (int32_t)pressuredPa - ((idx + BARO_ALT_LUT_FIRST) << BARO_ALT_LUT_SHIFT);
+    int32_t const a = altitudeLut[idx];
+    int32_t const b = altitudeLut[idx + 1];
+    return a + (int32_t)(((int64_t)(b - a) * frac) >> BARO_ALT_LUT_SHIFT);
+}
+
+uint32_t spl06ScaleReciprocal(int32_t scaleFactor)
+{
+    // Q48, the largest scale factor still leaves 25 bits
+    return ((uint64_t)1 << (SPL06_SCALED_SHIFT + 24)) / scaleFactor;
+}
+
+int32_t spl06Scale(int32_t raw, uint32_t reciprocal)
+{
+    return ((int64_t)raw * reciprocal) >> 24;
+}
+
+int32_t spl06Temperature(const spl06_calib_t &calib, int32_t tempScaled)
+{
+    // 100 * (c0 / 2 + c1 * t)
+    return 50 * (int32_t)calib.c0 + (int32_t)(((int64_t)100 * calib.c1 * tempScaled) >> SPL06_SCALED_SHIFT);
+}
+
+uint32_t spl06Pressure(const spl06_calib_t &calib, int32_t pressScaled, int32_t tempScaled)
+{
+    // c00 + p * (c10 + p * (c20 + p * c30)) + t * (c01 + p * (c11 + p * c21))
+    int64_t pres = (int64_t)calib.c30 << SPL06_ACC_SHIFT;
+    pres = ((int64_t)calib.c20 << SPL06_ACC_SHIFT) + ((pres * pressScaled) >> SPL06_SCALED_SHIFT);
+    pres = ((int64_t)calib.c10 << SPL06_ACC_SHIFT) + ((pres * pressScaled) >> SPL06_SCALED_SHIFT);
+    pres = ((int64_t)calib.c00 << SPL06_ACC_SHIFT) + ((pres * pressScaled) >> SPL06_SCALED_SHIFT);
+
+    int64_t temp = (int64_t)calib.c21 << SPL06_ACC_SHIFT;
+    temp = ((int64_t)calib.c11 << SPL06_ACC_SHIFT) + ((temp * pressScaled) >> SPL06_SCALED_SHIFT);
+    temp = ((int64_t)calib.c01 << SPL06_ACC_SHIFT) + ((temp * pressScaled) >> SPL06_SCALED_SHIFT);
+    pres += (temp * tempScaled) >> SPL06_SCALED_SHIFT;
+
+    if (pres <= 0)
+        return 0;
+    // Pa to dPa, rounded
+    return (uint32_t)((pres * 10 + (1 << (SPL06_ACC_SHIFT - 1))) >> SPL06_ACC_SHIFT);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+
+#define BARO_ALT_LUT_SHIFT      12  // 4096dPa between points, 41hPa
+#define BARO_ALT_LUT_FIRST      48  // 197hPa, about 11900m
+#define BARO_ALT_LUT_COUNT      223 // to 1106hPa, about -700m
+#define SPL06_SCALED_SHIFT      24  // raw values divided by the oversampling scale factor, Q24
+#define SPL06_ACC_SHIFT         12  // fraction bits of the pressure polynomial, Q12 Pa
+
+/**
+ * @brief Altitude in cm from pressure in deci-Pascals
+ *
+ * Same as 4433000 * (1 - (p / 1013.25hPa) ^ 0.1903), from a table of the curve with linear
+ * interpolation, so no soft-float pow() on receivers without an FPU. Inside the table it is
+ * within 30cm of the float curve at 200hPa and within 2cm near sea level, outside it the end
+ * segments are extended.
+ */
+int32_t baroPressureToAltitude(uint32_t pressuredPa);
+
+/**
+ * SPL06 calibration coefficients, sign extended from the coefficient registers
+ */
+typedef struct {
+    int16_t c0;
+    int16_t c1;
+    int32_t c00;
+    int32_t c10;
+    int16_t c01;
+    int16_t c11;
+    int16_t c20;
+    int16_t c21;
+    int16_t c30;
+} spl06_calib_t;
+
+/**
+ * @brief The reciprocal of an SPL06 oversampling scale factor, for spl06Scale()
+ */
+uint32_t spl06ScaleReciprocal(int32_t scaleFactor);
+
+/**
+ * @brief A raw 24 bit SPL06 reading divided by its scale factor, Q24
+ */
+int32_t spl06Scale(int32_t raw, uint32_t reciprocal);
+
+/**
+ * @brief SPL06 temperature in centiDegrees from the scaled raw temperature
+ */
+int32_t spl06Temperature(const spl06_calib_t &calib, int32_t tempScaled);
+
+/**
+ * @brief SPL06 pressure in deci-Pascals from the scaled raw pressure and temperature
+ *
+ * The datasheet's float polynomial in Q12 fixed point with 64 bit intermediates.
+ */
+uint32_t spl06Pressure(const spl06_calib_t &calib, int32_t pressScaled, int32_t tempScaled);
@@ -1,3 +1,4 @@
+#ifndef UNIT_TEST
 #include <Wire.h>
 
 /****
@@ -66,6 +67,9 @@ void SPL06::initialize()
     m_calib.c21 = ((uint16_t)caldata[14] << 8) | (uint16_t)caldata[15];
     m_calib.c30 = ((uint16_t)caldata[16] << 8) | (uint16_t)caldata[17];
 
+    m_pressureReciprocal = spl06ScaleReciprocal(oversampleToScaleFactor(OVERSAMPLING_PRESSURE));
+    m_temperatureReciprocal = spl06ScaleReciprocal(oversampleToScaleFactor(OVERSAMPLING_TEMPERATURE));
+
     // Step 2: Set up oversampling and FIFO
     uint8_t reg_value;
     reg_value = SPL06_TEMP_USE_EXT_SENSOR | oversampleToRegVal(OVERSAMPLING_TEMPERATURE);
@@ -108,12 +112,10 @@ int32_t SPL06::getTemperature()
 
     // Unpack and descale
     int32_t uncorr_temp = (int32_t)((data[0] & 0x80 ? 0xFF000000 : 0) | (((uint32_t)(data[0])) << 16) | (((uint32_t)(data[1])) << 8) | ((uint32_t)data[2]));
-    m_temperatureLast = (float)uncorr_temp / oversampleToScaleFactor(OVERSAMPLING_TEMPERATURE);
+    m_temperatureLast = spl06Scale(uncorr_temp, m_temperatureReciprocal);
 
     // Adjust for calibration
-    const float temp_comp = (float)m_calib.c0 / 2 + m_temperatureLast * m_calib.c1;
-
-    return temp_comp * 100;
+    return spl06Temperature(m_calib, m_temperatureLast);
 }
 
 uint8_t SPL06::getPressureDuration()
@@ -139,13 +141,10 @@ uint32_t SPL06::getPressure()
 
     // Unpack and descale
     int32_t uncorr_press = (int32_t)((data[0] & 0x80 ? 0xFF000000 : 0) | (((uint32_t)(data[0])) << 16) | (((uint32_t)(data[1])) << 8) | ((uint32_t)data[2]));
-    const float p_raw_sc = (float)uncorr_press / oversampleToScaleFactor(OVERSAMPLING_PRESSURE);
+    const int32_t p_raw_sc = spl06Scale(uncorr_press, m_pressureReciprocal);
 
     // Adjust for calibration and temperature
-    const float pressure_cal = (float)m_calib.c00 + p_raw_sc * ((float)m_calib.c10 + p_raw_sc * ((float)m_calib.c20 + p_raw_sc * m_calib.c30));
-    const float p_temp_comp = m_temperatureLast * ((float)m_calib.c01 + p_raw_sc * ((float)m_calib.c11 + p_raw_sc * m_calib.c21));
-
-    return (pressure_cal + p_temp_comp) * 10.0;
+    return spl06Pressure(m_calib, p_raw_sc, m_temperatureLast);
 }
 
 bool SPL06::detect()
@@ -165,3 +164,4 @@ bool SPL06::detect()
     readRegister(SPL06_CHIP_ID_REG, &chipid, sizeof(chipid));
     return chipid == SPL06_DEFAULT_CHIP_ID;
 }
+#endif
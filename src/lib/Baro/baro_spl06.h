@@ -1,6 +1,7 @@
 #pragma once
 
 #include "baro_base.h"
+#include "baro_math.h"
 #include "baro_spl06_regs.h"
 
 class SPL06 : public BaroI2CBase
@@ -27,19 +28,10 @@ protected:
 
     uint8_t oversampleToRegVal(const uint8_t oversamples) const;
     int32_t oversampleToScaleFactor(const uint8_t oversamples) const;
-    float m_temperatureLast; // last uncompensated temperature value
+    int32_t m_temperatureLast; // last uncompensated temperature value, scaled Q24
+    uint32_t m_pressureReciprocal; // spl06ScaleReciprocal() of the oversampling scale factors
+    uint32_t m_temperatureReciprocal;
 
-    struct tagCalibrationData
-    {
-        int16_t c0;
-        int16_t c1;
-        int32_t c00;
-        int32_t c10;
-        int16_t c01;
-        int16_t c11;
-        int16_t c20;
-        int16_t c21;
-        int16_t c30;
-    } m_calib; // calibration data, if initialized
+    spl06_calib_t m_calib; // calibration data, if initialized
 
 };
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "telemetry.h"
 #include "baro_spl06.h"
 #include "baro_bmp280.h"
+#include "ema.h"
 //#include "baro_bmp085.h"
 
 #define BARO_STARTUP_INTERVAL       100
@@ -69,7 +70,7 @@ static int Baro_Init()
 static void Baro_PublishPressure(uint32_t pressuredPa)
 {
     static int32_t last_altitude_cm;
-    static int16_t verticalspd_smoothed;
+    static EmaFilter<2> verticalspd_smoothed;
     int32_t altitude_cm = baro->pressureToAltitude(pressuredPa);
     int32_t altitude_diff_cm = altitude_cm - last_altitude_cm;
     last_altitude_cm = altitude_cm;
@@ -106,15 +107,13 @@ static void Baro_PublishPressure(uint32_t pressuredPa)
 
     // Item: VSpd
     int16_t vspd = altitude_diff_cm * 1000 / (int32_t)dT_ms;
-    verticalspd_smoothed = (verticalspd_smoothed * 3 + vspd) / 4; // Simple smoothing
-    crsfBaro.p.verticalspd = htobe16(verticalspd_smoothed);
-    //DBGLN("diff=%d smooth=%d dT=%u", altitude_diff_cm, verticalspd_smoothed, dT_ms);
+    crsfBaro.p.verticalspd = htobe16((int16_t)verticalspd_smoothed.update(vspd));
+    //DBGLN("diff=%d smooth=%d dT=%u", altitude_diff_cm, verticalspd_smoothed.value(), dT_ms);
 
     // if no external vario is connected output internal Vspd on CRSF_FRAMETYPE_BARO_ALTITUDE packet
     if (!telemetry.GetCrsfBaroSensorDetected())
     {
-        CRSF::SetHeaderAndCrc((uint8_t *)&crsfBaro, CRSF_FRAMETYPE_BARO_ALTITUDE, CRSF_FRAME_SIZE(sizeof(crsf_sensor_baro_vario_t)), CRSF_ADDRESS_CRSF_TRANSMITTER);
-        telemetry.AppendTelemetryPackage((uint8_t *)&crsfBaro);
+        telemetry.AppendSensorPayload((uint8_t *)&crsfBaro, CRSF_FRAMETYPE_BARO_ALTITUDE, CRSF_FRAME_SIZE(sizeof(crsf_sensor_baro_vario_t)));
     }
 }
 
@@ -21,6 +21,7 @@
 #endif
 
 #define CRSF_CRC_POLY 0xd5
+#define CRSF_CRC_POLY_COMMAND 0xba // the extra CRC at the end of the payload of a command frame
 
 #define CRSF_CHANNEL_VALUE_MIN  172 // 987us - actual CRSF min is 0 with E.Limits on
 #define CRSF_CHANNEL_VALUE_1000 191
@@ -58,6 +59,8 @@ typedef enum : uint8_t
     CRSF_FRAMETYPE_VARIO = 0x07,
     CRSF_FRAMETYPE_BATTERY_SENSOR = 0x08,
     CRSF_FRAMETYPE_BARO_ALTITUDE = 0x09,
+    CRSF_FRAMETYPE_RPM = 0x0C,
+    CRSF_FRAMETYPE_TEMP = 0x0D,
     CRSF_FRAMETYPE_LINK_STATISTICS = 0x14,
     CRSF_FRAMETYPE_OPENTX_SYNC = 0x10,
     CRSF_FRAMETYPE_RADIO_ID = 0x3A,
@@ -86,12 +89,15 @@ typedef enum : uint8_t
 } crsf_frame_type_e;
 
 typedef enum : uint8_t {
+    CRSF_COMMAND_SUBCMD_GENERAL = 0x0A,
     CRSF_COMMAND_SUBCMD_RX = 0x10
 } crsf_command_e;
 
 typedef enum : uint8_t {
     CRSF_COMMAND_SUBCMD_RX_BIND = 0x01,
-    CRSF_COMMAND_MODEL_SELECT_ID = 0x05
+    CRSF_COMMAND_MODEL_SELECT_ID = 0x05,
+    CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL = 0x70, // port id, baud rate (uint32 BigEndian)
+    CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE = 0x71  // port id, accepted
 } crsf_subcommand_e;
 
 enum {
@@ -105,6 +111,8 @@ enum {
     CRSF_FRAME_VARIO_PAYLOAD_SIZE = 2,
     CRSF_FRAME_BARO_ALTITUDE_PAYLOAD_SIZE = 4, // TBS version is 2, ELRS is 4 (combines vario)
     CRSF_FRAME_BATTERY_SENSOR_PAYLOAD_SIZE = 8,
+    CRSF_FRAME_RPM_PAYLOAD_SIZE = 1 + 3 * 4, // source id and up to 4 motors, the protocol allows more
+    CRSF_FRAME_TEMP_PAYLOAD_SIZE = 1 + 2 * 4,
     CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE = 6,
     CRSF_FRAME_DEVICE_INFO_PAYLOAD_SIZE = 48,
     CRSF_FRAME_FLIGHT_MODE_PAYLOAD_SIZE = 16,
@@ -294,6 +302,20 @@ typedef struct crsf_sensor_battery_s
     unsigned remaining : 8; // %
 } PACKED crsf_sensor_battery_t;
 
+// CRSF_FRAMETYPE_RPM, sized to the number of values sent
+typedef struct crsf_sensor_rpm_s
+{
+    uint8_t source_id;
+    uint8_t rpm[(CRSF_FRAME_RPM_PAYLOAD_SIZE - 1) / 3][3]; // int24 RPM, BigEndian
+} PACKED crsf_sensor_rpm_t;
+
+// CRSF_FRAMETYPE_TEMP, sized to the number of values sent
+typedef struct crsf_sensor_temp_s
+{
+    uint8_t source_id;
+    int16_t temperature[(CRSF_FRAME_TEMP_PAYLOAD_SIZE - 1) / 2]; // degrees C * 10, BigEndian
+} PACKED crsf_sensor_temp_t;
+
 // CRSF_FRAMETYPE_BARO_ALTITUDE
 typedef struct crsf_sensor_baro_vario_s
 {
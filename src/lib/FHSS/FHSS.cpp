@@ -72,6 +72,46 @@ bool FHSSuseDualBand = false;
 uint16_t primaryBandCount;
 uint16_t secondaryBandCount;
 
+#if defined(RADIO_LR1121)
+FHSSHopPlan FHSSplan;
+
+static void FHSSbuildHopPlan()
+{
+    fhss_band_t const bands[FHSS_BAND_COUNT] = {
+        {FHSSconfig->freq_start, freq_spread, FREQ_SPREAD_SCALE, (uint8_t)FHSSconfig->freq_count, (uint8_t)sync_channel, FHSSsequence},
+        {FHSSconfigDualBand->freq_start, freq_spread_DualBand, FREQ_SPREAD_SCALE, (uint8_t)FHSSconfigDualBand->freq_count, (uint8_t)sync_channel_DualBand, FHSSsequence_DualBand},
+    };
+    uint8_t const band = FHSSusePrimaryFreqBand ? FHSS_BAND_PRIMARY : FHSS_BAND_DUAL;
+
+    if (FHSSuseDualBand)
+    {
+        // Use the smaller of the 2 bands as not to go beyond the max index for each sequence.
+        uint16_t const count = primaryBandCount < secondaryBandCount ? primaryBandCount : secondaryBandCount;
+        FHSSplan.build(bands, &band, 1, FHSS_RADIO2_OTHER_BAND, count);
+    }
+    else
+    {
+        FHSSplan.build(bands, &band, 1, FHSS_RADIO2_GEMINI, FHSSusePrimaryFreqBand ? primaryBandCount : secondaryBandCount);
+    }
+}
+#endif
+
+void FHSSconfigureBands(bool usePrimaryFreqBand, bool useDualBand)
+{
+#if defined(RADIO_LR1121)
+    if (usePrimaryFreqBand == FHSSusePrimaryFreqBand && useDualBand == FHSSuseDualBand)
+    {
+        return;
+    }
+    FHSSusePrimaryFreqBand = usePrimaryFreqBand;
+    FHSSuseDualBand = useDualBand;
+    FHSSbuildHopPlan();
+#else
+    (void)usePrimaryFreqBand;
+    (void)useDualBand;
+#endif
+}
+
 void FHSSrandomiseFHSSsequence(const uint32_t seed)
 {
     FHSSconfig = &domains[firmwareOptions.domain];
@@ -95,9 +135,9 @@ void FHSSrandomiseFHSSsequence(const uint32_t seed)
     DBGLN("Number of FHSS frequencies = %u", FHSSconfigDualBand->freq_count);
     DBGLN("Sync channel Dual Band = %u", sync_channel_DualBand);
 
-    FHSSusePrimaryFreqBand = false;
     FHSSrandomiseFHSSsequenceBuild(seed, FHSSconfigDualBand->freq_count, sync_channel_DualBand, FHSSsequence_DualBand);
-    FHSSusePrimaryFreqBand = true;
+
+    FHSSbuildHopPlan();
 #endif
 }
 
@@ -120,8 +160,11 @@ void FHSSrandomiseFHSSsequenceBuild(const uint32_t seed, uint32_t freqCount, uin
     FHSSptr = 0;
     rngSeed(seed);
 
+    // whole blocks of each channel, the same as primaryBandCount or secondaryBandCount for this band
+    uint16_t const sequenceCount = (FHSS_SEQUENCE_LEN / freqCount) * freqCount;
+
     // initialize the sequence array
-    for (uint16_t i = 0; i < FHSSgetSequenceCount(); i++)
+    for (uint16_t i = 0; i < sequenceCount; i++)
     {
         if (i % freqCount == 0) {
             inSequence[i] = syncChannel;
@@ -132,7 +175,7 @@ void FHSSrandomiseFHSSsequenceBuild(const uint32_t seed, uint32_t freqCount, uin
         }
     }
 
-    for (uint16_t i = 0; i < FHSSgetSequenceCount(); i++)
+    for (uint16_t i = 0; i < sequenceCount; i++)
     {
         // if it's not the sync channel
         if (i % freqCount != 0)
@@ -148,7 +191,7 @@ void FHSSrandomiseFHSSsequenceBuild(const uint32_t seed, uint32_t freqCount, uin
     }
 
     // output FHSS sequence
-    for (uint16_t i=0; i < FHSSgetSequenceCount(); i++)
+    for (uint16_t i=0; i < sequenceCount; i++)
     {
         DBG("%u ",inSequence[i]);
         if (i % 10 == 9)
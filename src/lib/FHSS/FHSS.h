@@ -2,6 +2,7 @@
 
 #include "targets.h"
 #include "random.h"
+#include "FHSSHopPlan.h"
 
 #if defined(RADIO_SX127X)
 #define FreqCorrectionMax ((int32_t)(100000/FREQ_STEP))
@@ -20,8 +21,6 @@
 #define FREQ_SPREAD_SCALE 256
 #endif
 
-#define FHSS_SEQUENCE_LEN 256
-
 typedef struct {
     const char  *domain;
     uint32_t    freq_start;
@@ -50,9 +49,16 @@ extern uint8_t FHSSsequence_DualBand[];
 extern uint_fast8_t sync_channel_DualBand;
 extern const fhss_config_t *FHSSconfigDualBand;
 
+#if defined(RADIO_LR1121)
+// The frequencies of both radios for every hop, for the bands in use
+extern FHSSHopPlan FHSSplan;
+#endif
+
 // create and randomise an FHSS sequence
 void FHSSrandomiseFHSSsequence(uint32_t seed);
 void FHSSrandomiseFHSSsequenceBuild(uint32_t seed, uint32_t freqCount, uint_fast8_t sync_channel, uint8_t *sequence);
+// select the band(s) to hop on, LR1121 only, the others always use the primary band
+void FHSSconfigureBands(bool usePrimaryFreqBand, bool useDualBand);
 
 static inline uint32_t FHSSgetMinimumFreq(void)
 {
@@ -80,39 +86,22 @@ static inline uint32_t FHSSgetChannelCount(void)
 // get the number of entries in the FHSS sequence
 static inline uint16_t FHSSgetSequenceCount()
 {
-    if (FHSSuseDualBand) // Use the smaller of the 2 bands as not to go beyond the max index for each sequence.
-    {
-        if (primaryBandCount < secondaryBandCount)
-        {
-            return primaryBandCount;
-        }
-        else
-        {
-            return secondaryBandCount;
-        }
-    }
-
-    if (FHSSusePrimaryFreqBand)
-    {
-        return primaryBandCount;
-    }
-    else
-    {
-        return secondaryBandCount;
-    }
+#if defined(RADIO_LR1121)
+    return FHSSplan.getCount();
+#else
+    return primaryBandCount;
+#endif
 }
 
 // get the initial frequency, which is also the sync channel
 static inline uint32_t FHSSgetInitialFreq()
 {
-    if (FHSSusePrimaryFreqBand)
-    {
-        return FHSSconfig->freq_start + (sync_channel * freq_spread / FREQ_SPREAD_SCALE) - FreqCorrection;
-    }
-    else
-    {
-        return FHSSconfigDualBand->freq_start + (sync_channel_DualBand * freq_spread_DualBand / FREQ_SPREAD_SCALE);
-    }
+#if defined(RADIO_LR1121)
+    // The LR1121 has no frequency error readout, so there is no FreqCorrection on it
+    return FHSSplan.getFreq(0, 0);
+#else
+    return FHSSconfig->freq_start + (sync_channel * freq_spread / FREQ_SPREAD_SCALE) - FreqCorrection;
+#endif
 }
 
 // Get the current sequence pointer
@@ -124,14 +113,11 @@ static inline uint8_t FHSSgetCurrIndex()
 // Is the current frequency the sync frequency
 static inline uint8_t FHSSonSyncChannel()
 {
-    if (FHSSusePrimaryFreqBand)
-    {
-        return FHSSsequence[FHSSptr] == sync_channel;
-    }
-    else
-    {
-        return FHSSsequence_DualBand[FHSSptr] == sync_channel_DualBand;
-    }
+#if defined(RADIO_LR1121)
+    return (FHSSplan.getFlags(FHSSptr) & FHSS_HOP_SYNC) != 0;
+#else
+    return FHSSsequence[FHSSptr] == sync_channel;
+#endif
 }
 
 // Set the sequence pointer, used by RX on SYNC
@@ -145,14 +131,11 @@ static inline uint32_t FHSSgetNextFreq()
 {
     FHSSptr = (FHSSptr + 1) % FHSSgetSequenceCount();
 
-    if (FHSSusePrimaryFreqBand)
-    {
-        return FHSSconfig->freq_start + (freq_spread * FHSSsequence[FHSSptr] / FREQ_SPREAD_SCALE) - FreqCorrection;
-    }
-    else
-    {
-        return FHSSconfigDualBand->freq_start + (freq_spread_DualBand * FHSSsequence_DualBand[FHSSptr] / FREQ_SPREAD_SCALE);
-    }
+#if defined(RADIO_LR1121)
+    return FHSSplan.getFreq(0, FHSSptr);
+#else
+    return FHSSconfig->freq_start + (freq_spread * FHSSsequence[FHSSptr] / FREQ_SPREAD_SCALE) - FreqCorrection;
+#endif
 }
 
 static inline const char *FHSSgetRegulatoryDomain()
@@ -167,60 +150,43 @@ static inline const char *FHSSgetRegulatoryDomain()
     }
 }
 
+#if !defined(RADIO_LR1121)
 // Get frequency offset by half of the domain frequency range
 static inline uint32_t FHSSGeminiFreq(uint8_t FHSSsequenceIdx)
 {
-    uint32_t freq;
     uint32_t numfhss = FHSSgetChannelCount();
-    uint8_t offSetIdx = (FHSSsequenceIdx + (numfhss / 2)) % numfhss; 
-
-    if (FHSSusePrimaryFreqBand)
-    {
-        freq = FHSSconfig->freq_start + (freq_spread * offSetIdx / FREQ_SPREAD_SCALE) - FreqCorrection_2;
-    }
-    else
-    {
-        freq = FHSSconfigDualBand->freq_start + (freq_spread_DualBand * offSetIdx / FREQ_SPREAD_SCALE);
-    }
+    uint8_t offSetIdx = (FHSSsequenceIdx + (numfhss / 2)) % numfhss;
 
-    return freq;
+    return FHSSconfig->freq_start + (freq_spread * offSetIdx / FREQ_SPREAD_SCALE) - FreqCorrection_2;
 }
+#endif
 
+// The frequency of radio 2, half the band away from radio 1 in Gemini mode or the other band in Dual Band
 static inline uint32_t FHSSgetGeminiFreq()
 {
-    if (FHSSuseDualBand)
-    {
-        // When using Dual Band there is no need to calculate an offset frequency. Unlike Gemini with 2 frequencies in the same band.
-        return FHSSconfigDualBand->freq_start + (FHSSsequence_DualBand[FHSSptr] * freq_spread_DualBand / FREQ_SPREAD_SCALE);
-    }
-    else
-    {
-        if (FHSSusePrimaryFreqBand)
-        {
-            return FHSSGeminiFreq(FHSSsequence[FHSSgetCurrIndex()]);
-        }
-        else
-        {
-            return FHSSGeminiFreq(FHSSsequence_DualBand[FHSSgetCurrIndex()]);
-        }
-    }
+#if defined(RADIO_LR1121)
+    return FHSSplan.getFreq(1, FHSSptr);
+#else
+    return FHSSGeminiFreq(FHSSsequence[FHSSgetCurrIndex()]);
+#endif
 }
 
 static inline uint32_t FHSSgetInitialGeminiFreq()
 {
-    if (FHSSuseDualBand)
-    {
-        return FHSSconfigDualBand->freq_start + (sync_channel_DualBand * freq_spread_DualBand / FREQ_SPREAD_SCALE);
-    }
-    else
-    {
-        if (FHSSusePrimaryFreqBand)
-        {
-            return FHSSGeminiFreq(sync_channel);
-        }
-        else
-        {
-            return FHSSGeminiFreq(sync_channel_DualBand);
-        }
-    }
+#if defined(RADIO_LR1121)
+    return FHSSplan.getFreq(1, 0);
+#else
+    return FHSSGeminiFreq(sync_channel);
+#endif
+}
+
+// Is a radio on the band at this hop
+static inline bool FHSSusesBand(fhss_band_e band, uint8_t index)
+{
+#if defined(RADIO_LR1121)
+    return (FHSSplan.getFlags(index) & (band == FHSS_BAND_PRIMARY ? FHSS_HOP_USES_PRIMARY : FHSS_HOP_USES_DUAL)) != 0;
+#else
+    (void)index;
+    return band == FHSS_BAND_PRIMARY;
+#endif
 }
@@ -0,0 +1,54 @@
+#include "FHSSHopPlan.h"
+
+static uint32_t channelFreq(const fhss_band_t &band, uint8_t channel)
+{
+    return band.freqStart + (band.freqSpread * channel / band.spreadScale);
+}
+
+void FHSSHopPlan::build(const fhss_band_t *bands, const uint8_t *pattern, uint8_t patternLen, fhss_radio2_e radio2, uint16_t count)
+{
+    _count = count;
+    // Each band steps through its own sequence only on the hops it is used, so when the
+    // bands are interleaved each still gets every channel evenly and no repeats
+    uint16_t pos[FHSS_BAND_COUNT] = {0, 0};
+    for (uint16_t i = 0; i < count; i++)
+    {
+        uint8_t const band1 = pattern[i % patternLen];
+        uint8_t const band2 = radio2 == FHSS_RADIO2_GEMINI ? band1 : FHSS_BAND_DUAL - band1;
+        const fhss_band_t &b1 = bands[band1];
+        const fhss_band_t &b2 = bands[band2];
+
+        uint8_t const channel1 = b1.sequence[pos[band1]++];
+        _freq[0][i] = channelFreq(b1, channel1);
+        if (radio2 == FHSS_RADIO2_GEMINI)
+        {
+            // Half the band away from radio 1
+            _freq[1][i] = channelFreq(b2, (channel1 + b2.freqCount / 2) % b2.freqCount);
+        }
+        else
+        {
+            _freq[1][i] = channelFreq(b2, b2.sequence[pos[band2]++]);
+        }
+
+        uint8_t flags = 0;
+        flags |= channel1 == b1.syncChannel ? FHSS_HOP_SYNC : 0;
+        flags |= band1 == FHSS_BAND_DUAL ? FHSS_HOP_RADIO1_DUAL : 0;
+        flags |= band2 == FHSS_BAND_DUAL ? FHSS_HOP_RADIO2_DUAL : 0;
+        flags |= (band1 == FHSS_BAND_PRIMARY || band2 == FHSS_BAND_PRIMARY) ? FHSS_HOP_USES_PRIMARY : 0;
+        flags |= (band1 == FHSS_BAND_DUAL || band2 == FHSS_BAND_DUAL) ? FHSS_HOP_USES_DUAL : 0;
+        _flags[i] = flags;
+    }
+
+    // Compared with the hop before, which for the first is the last one as the plan wraps
+    uint8_t const bandMask = FHSS_HOP_RADIO1_DUAL | FHSS_HOP_RADIO2_DUAL;
+    uint8_t prev = count ? _flags[count - 1] & bandMask : 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        uint8_t const bandsNow = _flags[i] & bandMask;
+        if (bandsNow != prev)
+        {
+            _flags[i] |= FHSS_HOP_BAND_CHANGE;
+        }
+        prev = bandsNow;
+    }
+}
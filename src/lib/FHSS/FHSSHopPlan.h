@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+
+#define FHSS_SEQUENCE_LEN 256
+#define FHSS_PLAN_RADIOS 2
+
+typedef enum : uint8_t {
+    FHSS_BAND_PRIMARY,  // sub-GHz on the LR1121, the only band on the others
+    FHSS_BAND_DUAL,     // 2.4GHz on the LR1121
+    FHSS_BAND_COUNT
+} fhss_band_e;
+
+// Flags for each hop of a plan
+#define FHSS_HOP_SYNC           0x01    // radio 1 is on the sync channel of its band
+#define FHSS_HOP_BAND_CHANGE    0x02    // a radio is on a different band to the hop before and needs its modem configured
+#define FHSS_HOP_RADIO1_DUAL    0x04    // radio 1 is on the dual band, else the primary band
+#define FHSS_HOP_RADIO2_DUAL    0x08
+#define FHSS_HOP_USES_PRIMARY   0x10    // either radio is on the primary band, for its power calibration
+#define FHSS_HOP_USES_DUAL      0x20
+
+typedef enum : uint8_t {
+    FHSS_RADIO2_GEMINI,     // the same band as radio 1, half the band away
+    FHSS_RADIO2_OTHER_BAND, // the other band, on that band's sequence
+} fhss_radio2_e;
+
+/**
+ * The channels of one band and the order they are hopped in
+ */
+typedef struct {
+    uint32_t freqStart;
+    uint32_t freqSpread;    // between channels, times spreadScale
+    uint16_t spreadScale;
+    uint8_t freqCount;
+    uint8_t syncChannel;
+    const uint8_t *sequence;
+} fhss_band_t;
+
+/**
+ * The frequency of each radio and the band it is on for every hop, worked out when the
+ * sequences or the bands change so hopping is one step through the table. Radio 1 follows
+ * a repeating pattern of bands, a single band or the bands interleaved, and radio 2 is either
+ * on the same band as radio 1 (Gemini) or the other one.
+ */
+class FHSSHopPlan
+{
+public:
+    /**
+     * @param bands the primary and dual band, the dual band is only used if the pattern or radio2 uses it
+     * @param pattern the band radio 1 is on for each hop, repeated, e.g. {PRIMARY} or {PRIMARY, DUAL}
+     * @param count hops in the plan, no band can be used on more hops than the length of its sequence
+     */
+    void build(const fhss_band_t *bands, const uint8_t *pattern, uint8_t patternLen, fhss_radio2_e radio2, uint16_t count);
+
+    uint16_t getCount() const { return _count; }
+    uint32_t getFreq(uint8_t radio, uint16_t index) const { return _freq[radio][index]; }
+    uint8_t getFlags(uint16_t index) const { return _flags[index]; }
+    fhss_band_e getBand(uint8_t radio, uint16_t index) const
+    {
+        return (_flags[index] & (radio == 0 ? FHSS_HOP_RADIO1_DUAL : FHSS_HOP_RADIO2_DUAL)) ? FHSS_BAND_DUAL : FHSS_BAND_PRIMARY;
+    }
+
+private:
+    uint32_t _freq[FHSS_PLAN_RADIOS][FHSS_SEQUENCE_LEN];
+    uint8_t _flags[FHSS_SEQUENCE_LEN];
+    uint16_t _count;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+/**
+ * Second order IIR filter (Direct Form I) with fixed point coefficients
+ *
+ * Coefficients are calculated once in floating point by setLowpass(), the
+ * filter itself only uses integer multiply and shift. The remainder of each
+ * output shift is fed back into the next sample, so the output settles on
+ * the input instead of stalling a few counts away as a plain truncating
+ * fixed point IIR does. The first sample initializes the state.
+ */
+template <unsigned CoefBits = 14>
+class BiquadFilter
+{
+public:
+    /**
+     * @brief Configure as a lowpass (RBJ cookbook)
+     * @param cutoffHz -3dB frequency
+     * @param sampleHz rate update() is called at
+     * @param q quality factor, 0.707 for a Butterworth response
+     */
+    void setLowpass(float cutoffHz, float sampleHz, float q = 0.7071f)
+    {
+        float const omega = 2.0f * (float)M_PI * cutoffHz / sampleHz;
+        float const sn = sinf(omega);
+        float const cs = cosf(omega);
+        float const alpha = sn / (2.0f * q);
+        float const a0 = 1.0f + alpha;
+        float const scale = (float)(1 << CoefBits) / a0;
+
+        _b0 = lroundf((1.0f - cs) / 2.0f * scale);
+        _b1 = lroundf((1.0f - cs) * scale);
+        _b2 = _b0;
+        _a1 = lroundf(-2.0f * cs * scale);
+        _a2 = lroundf((1.0f - alpha) * scale);
+        reset();
+    }
+
+    /**
+     * Start over from the next sample
+     */
+    void reset() { _needReset = true; }
+
+    int32_t update(int32_t x)
+    {
+        if (_needReset)
+        {
+            _needReset = false;
+            _x1 = _x2 = _y1 = _y2 = x;
+            _err = 0;
+        }
+
+        int64_t acc = (int64_t)_b0 * x + (int64_t)_b1 * _x1 + (int64_t)_b2 * _x2
+            - (int64_t)_a1 * _y1 - (int64_t)_a2 * _y2 + _err;
+        int32_t y = (int32_t)(acc >> CoefBits);
+        _err = (int32_t)(acc - ((int64_t)y << CoefBits));
+
+        _x2 = _x1;
+        _x1 = x;
+        _y2 = _y1;
+        _y1 = y;
+        return y;
+    }
+
+    int32_t value() const { return _y1; }
+
+private:
+    int32_t _b0 = 1 << CoefBits, _b1 = 0, _b2 = 0, _a1 = 0, _a2 = 0;
+    int32_t _x1 = 0, _x2 = 0, _y1 = 0, _y2 = 0;
+    int32_t _err = 0;
+    bool _needReset = true;
+};
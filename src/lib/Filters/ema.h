@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Exponential moving average, y += (x - y) / 2^Shift
+ *
+ * The state keeps FracBits fractional bits, and the output is rounded, so
+ * small steps in the input are not lost to truncation the way an integer
+ * (y * 3 + x) / 4 is. The first sample initializes the output.
+ * Inputs must fit in 31 - FracBits bits.
+ */
+template <unsigned Shift, unsigned FracBits = 8>
+class EmaFilter
+{
+    static_assert(FracBits <= 16 && Shift < 16, "EmaFilter state would overflow");
+
+public:
+    int32_t update(int32_t val)
+    {
+        int32_t scaled = val * (1 << FracBits);
+        if (_needReset)
+        {
+            _needReset = false;
+            _state = scaled;
+        }
+        else
+        {
+            _state += (scaled - _state) / (1 << Shift);
+        }
+        return value();
+    }
+
+    /**
+     * Start over from the next sample
+     */
+    void reset() { _needReset = true; }
+
+    /**
+     * Current output rounded to the nearest integer
+     */
+    int32_t value() const
+    {
+        int32_t const half = (1 << FracBits) / 2;
+        return (_state >= 0 ? _state + half : _state - half) / (1 << FracBits);
+    }
+
+    /**
+     * Current output with FracBits fractional bits
+     */
+    int32_t valueScaled() const { return _state; }
+
+    operator int32_t() const { return value(); }
+
+private:
+    int32_t _state = 0;
+    bool _needReset = true;
+};
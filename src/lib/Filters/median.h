@@ -0,0 +1,167 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Window of the last N samples, kept both in arrival order and sorted, along
+ * with their running sum. Adding a sample finds the position of the sample it
+ * replaces and of the new sample by binary search, and shifts only the sorted
+ * entries between the two, so the median and trimmed mean are available without
+ * rescanning the window.
+ * The window starts out filled with zeros.
+ */
+template <typename T, size_t N>
+class SortedWindow
+{
+public:
+    SortedWindow() { clear(); }
+
+    /**
+     * Adds a value to the window, replacing the oldest. Returns 0
+     * if the window has filled a complete cycle of N elements
+     */
+    unsigned int add(T item)
+    {
+        T oldest = _data[_counter];
+        _data[_counter] = item;
+        _counter = (_counter + 1) % N;
+        _sum += item - oldest;
+
+        // Remove the oldest and insert the new item in one pass, only moving
+        // the entries that lie between the two
+        size_t from = lowerBound(oldest, 0, N);
+        if (item > oldest)
+        {
+            size_t to = lowerBound(item, from + 1, N) - 1;
+            memmove(&_sorted[from], &_sorted[from + 1], (to - from) * sizeof(T));
+            _sorted[to] = item;
+        }
+        else
+        {
+            size_t to = lowerBound(item, 0, from);
+            memmove(&_sorted[to + 1], &_sorted[to], (from - to) * sizeof(T));
+            _sorted[to] = item;
+        }
+        return _counter;
+    }
+
+    /**
+     * Resets the window to all zeros and the position to the start
+     */
+    void clear() { fill(0); }
+
+    /**
+     * Resets every value in the window to val and the position to the start,
+     * so the output starts at the first sample rather than ramping up from 0
+     */
+    void fill(T val)
+    {
+        _counter = 0;
+        _sum = val * N;
+        for (size_t i = 0; i < N; ++i)
+            _data[i] = _sorted[i] = val;
+    }
+
+    /**
+     * Middle value of the window, the mean of the two middle values if N is even
+     */
+    T median() const
+    {
+        if (N % 2)
+            return _sorted[N / 2];
+        return (_sorted[N / 2 - 1] + _sorted[N / 2]) / 2;
+    }
+
+    /**
+     * Sum of the window without the trim lowest and trim highest values
+     */
+    T trimmedSum(size_t trim) const
+    {
+        T retVal = _sum;
+        for (size_t i = 0; i < trim; ++i)
+            retVal -= _sorted[i] + _sorted[N - 1 - i];
+        return retVal;
+    }
+
+    T lowest() const { return _sorted[0]; }
+    T highest() const { return _sorted[N - 1]; }
+    T sum() const { return _sum; }
+
+private:
+    // Index of the first sorted entry in [first, last) that is not less than val
+    size_t lowerBound(T val, size_t first, size_t last) const
+    {
+        while (first < last)
+        {
+            size_t mid = (first + last) / 2;
+            if (_sorted[mid] < val)
+                first = mid + 1;
+            else
+                last = mid;
+        }
+        return first;
+    }
+
+    T _data[N];
+    T _sorted[N];
+    T _sum;
+    unsigned int _counter;
+};
+
+/**
+ * Running median of the last N samples
+ */
+template <typename T, size_t N>
+class MedianFilter : public SortedWindow<T, N>
+{
+public:
+    T calc() const { return this->median(); }
+
+    operator T() const { return calc(); }
+};
+
+/**
+ * Throws out the Trim highest and Trim lowest values then averages what's left
+ */
+template <typename T, size_t N, size_t Trim = 1>
+class TrimmedMeanFilter : public SortedWindow<T, N>
+{
+    static_assert(N > 2 * Trim, "Trimming must leave at least one value");
+
+public:
+    /**
+     * Calculate the trimmed mean
+     */
+    T calc() const
+    {
+        return calc_scaled() / scale();
+    }
+
+    /**
+     * Calculate the trimmed mean but without dividing by count
+     * Useful for preserving precision when applying external scaling
+     */
+    T calc_scaled() const
+    {
+        return this->trimmedSum(Trim);
+    }
+
+    /**
+     * Scale of the value returned by calc_scaled()
+     * Divide by this to convert from unscaled to original units
+     */
+    size_t scale() const { return N - 2 * Trim; }
+
+    /**
+     * Operator to just assign as type
+     */
+    operator T() const { return calc(); }
+};
+
+/**
+ * Throws out the highest and lowest values then averages what's left
+ */
+template <typename T, size_t N>
+using MedianAvgFilter = TrimmedMeanFilter<T, N, 1>;
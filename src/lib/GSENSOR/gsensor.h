@@ -1,6 +1,7 @@
 #pragma once
 
 #include "targets.h"
+#include "gsensor_motion.h"
 
 typedef enum
 {
@@ -9,17 +10,10 @@ typedef enum
     GSENSOR_STATUS_SUSPEND = 2
 } Gsensor_Status_t;
 
-typedef enum
-{
-    GSENSOR_SYSTEM_STATE_MOVING = 0,
-    GSENSOR_SYSTEM_STATE_QUIET = 1
-} Gsensor_System_State_t;
-
 class Gsensor
 {
 private:
-    int system_state;
-    bool is_flipped;
+    GsensorMotion motion;
 public:
     bool init();
     void handle();
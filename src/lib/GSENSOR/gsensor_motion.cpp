@@ -0,0 +1,102 @@
+#include "gsensor_motion.h"
+
+#include <math.h>
+
+void GsensorMotion::reset()
+{
+    _motion = MOTION_MOVING;
+    _state = GSENSOR_SYSTEM_STATE_MOVING;
+    _flipped = false;
+    _bumpSamples = 0;
+    _count = 0;
+    _bumps = 0;
+}
+
+void GsensorMotion::restart(const float *sample)
+{
+    _count = 1;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        _mean[i] = sample[i];
+        _m2[i] = 0;
+    }
+}
+
+bool GsensorMotion::isStill(const float *sample) const
+{
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        if (fabsf(sample[i] - _mean[i]) > GSENSOR_QUIET_DEVIATION)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void GsensorMotion::update(float x, float y, float z)
+{
+    const float sample[3] = {x, y, z};
+
+    if (z > GSENSOR_FLIPPED_ON)
+    {
+        _flipped = true;
+    }
+    else if (z < GSENSOR_FLIPPED_OFF)
+    {
+        _flipped = false;
+    }
+
+    switch (_motion)
+    {
+    case MOTION_MOVING:
+        if (_count == 0 || !isStill(sample))
+        {
+            restart(sample);
+            break;
+        }
+
+        ++_count;
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            float const delta = sample[i] - _mean[i];
+            _mean[i] += delta / _count;
+            _m2[i] += delta * (sample[i] - _mean[i]);
+            // Steady, but shaking too much to be put down
+            if (_m2[i] > GSENSOR_QUIET_VARIANCE * _count)
+            {
+                restart(sample);
+                return;
+            }
+        }
+
+        if (_count >= GSENSOR_QUIET_SAMPLES)
+        {
+            _motion = MOTION_QUIET;
+            _state = GSENSOR_SYSTEM_STATE_QUIET;
+        }
+        break;
+
+    case MOTION_QUIET:
+        if (!isStill(sample))
+        {
+            _motion = MOTION_BUMP;
+            _bumpSamples = 1;
+        }
+        break;
+
+    case MOTION_BUMP:
+        if (isStill(sample))
+        {
+            _motion = MOTION_QUIET;
+            ++_bumps;
+        }
+        else if (++_bumpSamples > GSENSOR_BUMP_SAMPLES)
+        {
+            _motion = MOTION_MOVING;
+            _state = GSENSOR_SYSTEM_STATE_MOVING;
+            restart(sample);
+        }
+        break;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+#define GSENSOR_QUIET_SAMPLES           20      // samples in a row without movement before it is quiet, 20s at 1s
+#define GSENSOR_QUIET_VARIANCE          0.0002f // g^2, per axis
+#define GSENSOR_QUIET_DEVIATION         0.04f   // g from the mean, per axis
+#define GSENSOR_BUMP_SAMPLES            1       // samples away from the quiet mean which are a knock if it comes back, not a pick up
+#define GSENSOR_FLIPPED_ON              0.3f    // g on z, either side of 0.2g so the screen does not flicker
+#define GSENSOR_FLIPPED_OFF             0.1f
+
+typedef enum
+{
+    GSENSOR_SYSTEM_STATE_MOVING = 0,
+    GSENSOR_SYSTEM_STATE_QUIET = 1
+} Gsensor_System_State_t;
+
+/**
+ * Tracks the mean and variance of each axis since the last movement with Welford's
+ * algorithm, so each sample is O(1) with no sample buffers to rescan. The handset is quiet
+ * once GSENSOR_QUIET_SAMPLES in a row have stayed close to their mean, and from then on any
+ * sample away from that mean is movement, unless it is back within GSENSOR_BUMP_SAMPLES
+ * which is only a bump.
+ */
+class GsensorMotion
+{
+public:
+    void reset();
+    void update(float x, float y, float z);
+
+    Gsensor_System_State_t getState() const { return _state; }
+    bool isFlipped() const { return _flipped; }
+    uint32_t getBumpCount() const { return _bumps; }
+    uint16_t getStillSamples() const { return _count; }
+
+private:
+    enum state_e : uint8_t {
+        MOTION_MOVING,
+        MOTION_QUIET,
+        MOTION_BUMP,    // quiet, but the last samples were off the mean
+    };
+
+    void restart(const float *sample);
+    bool isStill(const float *sample) const;
+
+    state_e _motion;
+    Gsensor_System_State_t _state;
+    bool _flipped;
+    uint8_t _bumpSamples;
+    uint16_t _count;
+    float _mean[3];
+    float _m2[3];       // sum of squared differences from the mean
+    uint32_t _bumps;
+};
@@ -16,12 +16,6 @@ volatile int32_t hwTimer::FreqOffset = 0;
 static hw_timer_t *timer = NULL;
 static portMUX_TYPE isrMutex = portMUX_INITIALIZER_UNLOCKED;
 
-#if defined(TARGET_RX)
-#define HWTIMER_TICKS_PER_US 5
-#else
-#define HWTIMER_TICKS_PER_US 1
-#endif
-
 void ICACHE_RAM_ATTR hwTimer::init(void (*callbackTick)(), void (*callbackTock)())
 {
 
@@ -14,7 +14,6 @@ volatile int32_t hwTimer::FreqOffset = 0;
 // Internal implementation specific variables
 static uint32_t NextTimeout;
 
-#define HWTIMER_TICKS_PER_US 5
 #define HWTIMER_PRESCALER (clockCyclesPerMicrosecond() / HWTIMER_TICKS_PER_US)
 
 void hwTimer::init(void (*callbackTick)(), void (*callbackTock)())
@@ -9,6 +9,13 @@
 #define TimerIntervalUSDefault 20000
 #endif
 
+// Resolution of the frequency offset
+#if defined(PLATFORM_ESP8266) || (defined(PLATFORM_ESP32) && defined(TARGET_RX))
+#define HWTIMER_TICKS_PER_US 5
+#else
+#define HWTIMER_TICKS_PER_US 1
+#endif
+
 /**
  * @brief Hardware abstraction for the hardware timer to provide precise timing
  *
@@ -73,6 +80,11 @@ public:
      */
     static ICACHE_RAM_ATTR void inline decFreqOffset() { FreqOffset--; }
 
+    /**
+     * @brief Set the frequency offset in timer ticks (HWTIMER_TICKS_PER_US), applied to each half of the update interval
+     */
+    static ICACHE_RAM_ATTR void inline setFreqOffset(int32_t offset) { FreqOffset = offset; }
+
     /**
      * @brief Get the frequency offset
      */
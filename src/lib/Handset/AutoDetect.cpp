@@ -3,13 +3,17 @@
 #if defined(PLATFORM_ESP32) && defined(TARGET_TX)
 
 #include "AutoDetect.h"
-#include "CRSFHandset.h"
-#include "PPMHandset.h"
 #include "logging.h"
 
 #include <driver/rmt.h>
 
 constexpr auto RMT_TICKS_PER_US = 10;
+// Short enough that a serial frame is one capture and a PPM pulse is a capture on its own
+constexpr auto DETECT_IDLE_US = 100;
+// Longer than any PPM channel so a capture is a whole frame, ended by the sync gap
+constexpr auto PPM_IDLE_US = 4000;
+// Runs looked at to classify a capture, enough for a 16 channel PPM frame and plenty of a serial one
+constexpr auto DETECT_MAX_RUNS = 64;
 
 void AutoDetect::Begin()
 {
@@ -18,85 +22,205 @@ void AutoDetect::Begin()
     rmt_config_t rmt_rx_config = RMT_DEFAULT_CONFIG_RX(static_cast<gpio_num_t>(GPIO_PIN_RCSIGNAL_RX), PPM_RMT_CHANNEL);
     rmt_rx_config.clk_div = divisor;
     rmt_rx_config.rx_config.filter_ticks_thresh = 1;
-    rmt_rx_config.rx_config.idle_threshold = 100;
+    rmt_rx_config.rx_config.idle_threshold = RMT_TICKS_PER_US * DETECT_IDLE_US;
     rmt_config(&rmt_rx_config);
     rmt_driver_install(PPM_RMT_CHANNEL, 1000, 0);
 
     rmt_get_ringbuf_handle(PPM_RMT_CHANNEL, &rb);
     rmt_rx_start(PPM_RMT_CHANNEL, true);
-    input_detect = 0;
+    capturing = true;
+    detector.reset();
+    baudVote.reset();
+    active = nullptr;
 }
 
 void AutoDetect::End()
 {
+    release();
     rmt_driver_uninstall(PPM_RMT_CHANNEL);
 }
 
 bool AutoDetect::IsArmed()
 {
-    return false;
+    return active && active->IsArmed();
 }
 
-void AutoDetect::migrateTo(Handset *that) const
+void AutoDetect::setIdleThreshold(uint32_t us) const
+{
+    rmt_set_rx_idle_thresh(PPM_RMT_CHANNEL, RMT_TICKS_PER_US * us);
+}
+
+void AutoDetect::setCapturing(bool capture)
+{
+    if (capture == capturing)
+    {
+        return;
+    }
+    if (capture)
+    {
+        rmt_rx_start(PPM_RMT_CHANNEL, true);
+    }
+    else
+    {
+        rmt_rx_stop(PPM_RMT_CHANNEL);
+    }
+    capturing = capture;
+}
+
+void AutoDetect::release()
+{
+    // The PPMHandset has nothing of its own to stop, its frames come from this RMT channel
+    if (active == &crsf)
+    {
+        crsf.End();
+    }
+    active = nullptr;
+}
+
+void AutoDetect::adopt(Handset *that)
 {
     that->setRCDataCallback(RCdataCallback);
     that->registerParameterUpdateCallback(RecvParameterUpdate);
     that->registerCallbacks(connected, disconnected, RecvModelUpdate, OnBindingCommand);
-    that->Begin();
     that->setPacketInterval(RequestedRCpacketInterval);
-    delete this;
-    handset = that;
+    active = that;
 }
 
-void AutoDetect::startPPM() const
+void AutoDetect::switchTo(handset_signal_e signal)
 {
-    migrateTo(new PPMHandset());
-}
-
-void AutoDetect::startCRSF() const
-{
-    migrateTo(new CRSFHandset());
+    switch (signal)
+    {
+    case HANDSET_SIGNAL_PPM:
+        DBGLN("PPM signal detected in %ums", detector.getDetectMs());
+        // The RMT decodes PPM itself, so it just needs whole frames
+        setIdleThreshold(PPM_IDLE_US);
+        if (active != &ppm)
+        {
+            release();
+            adopt(&ppm);
+            if (connected)
+            {
+                connected();
+            }
+        }
+        break;
+    case HANDSET_SIGNAL_SERIAL:
+        DBGLN("Serial signal detected in %ums", detector.getDetectMs());
+        // Serial frames at the PPM idle threshold run into each other and never end a capture
+        setIdleThreshold(DETECT_IDLE_US);
+        crsf.setBaudHint(baudVote.getBaud());
+        if (active != &crsf)
+        {
+            release();
+            adopt(&crsf);
+            crsf.Begin();
+        }
+        break;
+    default:
+        // Leave the handset running, it handles losing its signal, but be ready for either again
+        DBGLN("No signal detected");
+        setIdleThreshold(DETECT_IDLE_US);
+        break;
+    }
 }
 
 void AutoDetect::handleInput()
 {
-    size_t length = 0;
     const auto now = millis();
+    size_t length = 0;
+    handset_capture_e capture = HANDSET_CAPTURE_NONE;
 
-    const auto items = static_cast<rmt_item32_t *>(xRingbufferReceive(rb, &length, 0));
+    const auto items = capturing ? static_cast<rmt_item32_t *>(xRingbufferReceive(rb, &length, 0)) : nullptr;
     if (items)
     {
-        vRingbufferReturnItem(rb, static_cast<void *>(items));
-        lastDetect = now;
         length /= 4; // one RMT = 4 Bytes
-        if (length == 0)
+        uint16_t runs[DETECT_MAX_RUNS];
+        uint16_t count = 0;
+        for (size_t i = 0; i < length && count < DETECT_MAX_RUNS; i++)
         {
-            input_detect++;
-            if (input_detect > 100)
-            {
-                DBGLN("PPM signal detected");
-                rmt_driver_uninstall(PPM_RMT_CHANNEL);
-                startPPM();
-            }
+            // The capture ends on a 0 duration
+            if (items[i].duration0 == 0)
+                break;
+            runs[count++] = items[i].duration0;
+            if (items[i].duration1 == 0)
+                break;
+            runs[count++] = items[i].duration1;
+        }
+        capture = handsetClassifyCapture(runs, count, RMT_TICKS_PER_US);
+        if (active == &ppm && capture == HANDSET_CAPTURE_PPM_FRAME)
+        {
+            ppm.handleFrame(items, length);
         }
-        else
+        else if (capture == HANDSET_CAPTURE_SERIAL)
         {
-            input_detect--;
-            if (input_detect < -100)
+            const auto baud = baudVote.getBaud();
+            if (baudVote.update(handsetBaudDetect(runs, count, RMT_TICKS_PER_US)) != baud && active == &crsf)
             {
-                DBGLN("Serial signal detected");
-                rmt_driver_uninstall(PPM_RMT_CHANNEL);
-                startCRSF();
+                DBGLN("Serial at %u baud", baudVote.getBaud());
+                crsf.setBaudHint(baudVote.getBaud());
             }
         }
+        vRingbufferReturnItem(rb, static_cast<void *>(items));
     }
-    else
+
+    const auto signal = detector.getSignal();
+    if (capturing && detector.update(capture, now) != signal)
     {
-        if (now - 1000 > lastDetect && input_detect != 0)
-        {
-            DBGLN("No signal detected");
-            input_detect = 0;
-        }
+        switchTo(detector.getSignal());
+    }
+
+    if (active)
+    {
+        active->handleInput();
+        RCdataLastRecv = active->GetRCdataLastRecv();
+    }
+
+    // With one RMT memory block, CRSF frames of more than 128 runs would overflow every
+    // capture, and once the CRSFHandset has the handset there is nothing to detect until
+    // it loses it again
+    setCapturing(!(active == &crsf && crsf.IsConnected()));
+}
+
+void AutoDetect::setPacketInterval(int32_t PacketInterval)
+{
+    Handset::setPacketInterval(PacketInterval);
+    if (active)
+    {
+        active->setPacketInterval(PacketInterval);
+    }
+}
+
+uint8_t AutoDetect::GetMaxPacketBytes() const
+{
+    return active ? active->GetMaxPacketBytes() : Handset::GetMaxPacketBytes();
+}
+
+int AutoDetect::getMinPacketInterval() const
+{
+    return active ? active->getMinPacketInterval() : Handset::getMinPacketInterval();
+}
+
+void AutoDetect::JustSentRFpacket()
+{
+    if (active)
+    {
+        active->JustSentRFpacket();
+    }
+}
+
+void AutoDetect::sendTelemetryToTX(uint8_t *data)
+{
+    if (active)
+    {
+        active->sendTelemetryToTX(data);
+    }
+}
+
+void AutoDetect::sendTelemetryBatchToTX(uint8_t *data, uint16_t len)
+{
+    if (active)
+    {
+        active->sendTelemetryBatchToTX(data, len);
     }
 }
 
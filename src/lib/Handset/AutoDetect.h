@@ -1,9 +1,20 @@
 #pragma once
 
 #include "handset.h"
+#include "CRSFHandset.h"
+#include "HandsetBaud.h"
+#include "HandsetDetect.h"
+#include "PPMHandset.h"
 
 #include <driver/rmt.h>
 
+/**
+ * Watches the handset signal with an RMT channel and passes everything through to a
+ * PPMHandset or CRSFHandset depending on what it sees, switching between them if the
+ * module is moved to a different handset. Serial captures also give the baud rate, which
+ * the CRSFHandset uses rather than cycling through them. The RMT is stopped while the
+ * CRSFHandset has a stable connection, and watches again once it loses it.
+ */
 class AutoDetect final : public Handset
 {
 public:
@@ -12,12 +23,25 @@ public:
     bool IsArmed() override;
     void handleInput() override;
 
+    void setPacketInterval(int32_t PacketInterval) override;
+    uint8_t GetMaxPacketBytes() const override;
+    int getMinPacketInterval() const override;
+    void JustSentRFpacket() override;
+    void sendTelemetryToTX(uint8_t *data) override;
+    void sendTelemetryBatchToTX(uint8_t *data, uint16_t len) override;
+
 private:
-    void migrateTo(Handset *that) const;
-    void startPPM() const;
-    void startCRSF() const;
+    void switchTo(handset_signal_e signal);
+    void setIdleThreshold(uint32_t us) const;
+    void adopt(Handset *that);
+    void release();
+    void setCapturing(bool capture);
 
-    int input_detect = 0;
+    PPMHandset ppm;
+    CRSFHandset crsf;
+    Handset *active = nullptr;
+    HandsetDetector detector;
+    HandsetBaudVote baudVote;
     RingbufHandle_t rb = nullptr;
-    uint32_t lastDetect = 0;
-};
\ No newline at end of file
+    bool capturing = false;
+};
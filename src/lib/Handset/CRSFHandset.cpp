@@ -41,6 +41,9 @@ Stream *CRSFHandset::PortSecondary;
 /// UART Handling ///
 uint32_t CRSFHandset::GoodPktsCountResult = 0;
 uint32_t CRSFHandset::BadPktsCountResult = 0;
+uint16_t CRSFHandset::StickAgeP50Result = 0;
+uint16_t CRSFHandset::StickAgeP99Result = 0;
+uint8_t CRSFHandset::WindowUseResult = 0;
 
 uint8_t CRSFHandset::modelId = 0;
 bool CRSFHandset::ForwardDevicePings = false;
@@ -49,10 +52,8 @@ bool CRSFHandset::halfDuplex = false;
 
 /// OpenTX mixer sync ///
 static const int32_t OpenTXsyncPacketInterval = 200; // in ms
-static const int32_t OpenTXsyncOffsetSafeMargin = 1000; // 100us
 
 /// UART Handling ///
-static const int32_t TxToHandsetBauds[] = {400000, 115200, 5250000, 3750000, 1870000, 921600, 2250000};
 uint8_t CRSFHandset::UARTcurrentBaudIdx = 6;   // only used for baud-cycling, initialized to the end so the next one we try is the first in the list
 uint32_t CRSFHandset::UARTrequestedBaud = 5250000;
 
@@ -64,6 +65,13 @@ void CRSFHandset::Begin()
     DBGLN("About to start CRSF task...");
 
     UARTwdtLastChecked = millis() + UARTwdtInterval; // allows a delay before the first time the UARTwdt() function is called
+    mixerSync.reset(RequestedRCpacketInterval);
+    if (UARTbaudHint != 0)
+    {
+        UARTrequestedBaud = UARTbaudHint;
+        UARTbaudHint = 0;
+    }
+    UARTbaudChanged = millis();
 
     halfDuplex = (GPIO_PIN_RCSIGNAL_TX == GPIO_PIN_RCSIGNAL_RX);
 
@@ -123,6 +131,8 @@ void CRSFHandset::Begin()
     CRSFHandset::Port.flush();
     flush_port_input();
 #endif
+    // The packet interval and baud can be set before the port is started
+    outputScheduler.setHalfDuplex(halfDuplex);
 }
 
 void CRSFHandset::End()
@@ -190,24 +200,41 @@ void CRSFHandset::packetQueueExtended(uint8_t type, void *data, uint8_t len)
     SerialOutFIFO.unlock();
 }
 
+// Caller holds the SerialOutFIFO lock
+static void queueTelemetry(uint8_t *data)
+{
+    uint8_t size = CRSF_FRAME_SIZE(data[CRSF_TELEMETRY_LENGTH_INDEX]);
+    if (size > CRSF_MAX_PACKET_LEN)
+    {
+        ERRLN("too large");
+        return;
+    }
+
+    data[0] = CRSF_ADDRESS_RADIO_TRANSMITTER;
+    if (SerialOutFIFO.ensure(size + 1))
+    {
+        SerialOutFIFO.push(size); // length
+        SerialOutFIFO.pushBytes(data, size);
+    }
+}
+
 void CRSFHandset::sendTelemetryToTX(uint8_t *data)
 {
     if (controllerConnected)
     {
-        uint8_t size = CRSF_FRAME_SIZE(data[CRSF_TELEMETRY_LENGTH_INDEX]);
-        if (size > CRSF_MAX_PACKET_LEN)
-        {
-            ERRLN("too large");
-            return;
-        }
+        SerialOutFIFO.lock();
+        queueTelemetry(data);
+        SerialOutFIFO.unlock();
+    }
+}
 
-        data[0] = CRSF_ADDRESS_RADIO_TRANSMITTER;
+void CRSFHandset::sendTelemetryBatchToTX(uint8_t *data, uint16_t len)
+{
+    if (controllerConnected)
+    {
         SerialOutFIFO.lock();
-        if (SerialOutFIFO.ensure(size + 1))
-        {
-            SerialOutFIFO.push(size); // length
-            SerialOutFIFO.pushBytes(data, size);
-        }
+        for (uint16_t pos = 0; pos < len; pos += CRSF_FRAME_SIZE(data[pos + CRSF_TELEMETRY_LENGTH_INDEX]))
+            queueTelemetry(&data[pos]);
         SerialOutFIFO.unlock();
     }
 }
@@ -215,9 +242,7 @@ void CRSFHandset::sendTelemetryToTX(uint8_t *data)
 void ICACHE_RAM_ATTR CRSFHandset::setPacketInterval(int32_t PacketInterval)
 {
     RequestedRCpacketInterval = PacketInterval;
-    OpenTXsyncOffset = 0;
-    OpenTXsyncWindow = 0;
-    OpenTXsyncWindowSize = std::max((int32_t)1, (int32_t)(20000/RequestedRCpacketInterval));
+    mixerSync.reset(PacketInterval);
     OpenTXsyncLastSent -= OpenTXsyncPacketInterval;
     adjustMaxPacketSize();
 }
@@ -229,23 +254,14 @@ void ICACHE_RAM_ATTR CRSFHandset::JustSentRFpacket()
     uint32_t m = micros();
     auto delta = (int32_t)(m - last);
 
-    if (delta >= (int32_t)RequestedRCpacketInterval)
+    if (mixerSync.update(delta))
     {
         // missing/late packet, force resync
-        OpenTXsyncOffset = -(delta % RequestedRCpacketInterval) * 10;
-        OpenTXsyncWindow = 0;
         OpenTXsyncLastSent -= OpenTXsyncPacketInterval;
 #ifdef DEBUG_OPENTX_SYNC
         DBGLN("Missed packet, forced resync (%d)!", delta);
 #endif
     }
-    else
-    {
-        // The number of packets in the sync window is how many will fit in 20ms.
-        // This gives quite quite coarse changes for 50Hz, but more fine grained changes at 1000Hz.
-        OpenTXsyncWindow = std::min(OpenTXsyncWindow + 1, (int32_t)OpenTXsyncWindowSize);
-        OpenTXsyncOffset = ((OpenTXsyncOffset * (OpenTXsyncWindow-1)) + delta * 10) / OpenTXsyncWindow;
-    }
 }
 
 void CRSFHandset::sendSyncPacketToTX() // in values in us.
@@ -254,9 +270,9 @@ void CRSFHandset::sendSyncPacketToTX() // in values in us.
     if (controllerConnected && (now - OpenTXsyncLastSent) >= OpenTXsyncPacketInterval)
     {
         int32_t packetRate = RequestedRCpacketInterval * 10; //convert from us to right format
-        int32_t offset = OpenTXsyncOffset - OpenTXsyncOffsetSafeMargin; // offset so that opentx always has some headroom
+        int32_t offset = mixerSync.getOffset(); // offset so that opentx always has some headroom for its jitter
 #ifdef DEBUG_OPENTX_SYNC
-        DBGLN("Offset %d", offset); // in 10ths of us (OpenTX sync unit)
+        DBGLN("Offset %d margin %uus", offset, mixerSync.getMarginUs()); // in 10ths of us (OpenTX sync unit)
 #endif
 
         struct otxSyncData {
@@ -332,6 +348,24 @@ bool CRSFHandset::processInternalCrsfPackage(uint8_t *package)
         return true;
     }
 
+    // Handset proposing a baud rate, the response goes out at the current one before switching
+    if (packetType == CRSF_FRAMETYPE_COMMAND
+        && header->frame_size >= 11
+        && header->dest_addr == CRSF_ADDRESS_CRSF_TRANSMITTER
+        && header->payload[0] == CRSF_COMMAND_SUBCMD_GENERAL
+        && header->payload[1] == CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL)
+    {
+        const uint32_t baud = (uint32_t)header->payload[3] << 24 | (uint32_t)header->payload[4] << 16 | (uint32_t)header->payload[5] << 8 | header->payload[6];
+        const bool accepted = handsetBaudSupported(baud);
+        DBGLN("Baud rate %u proposed, %s", baud, accepted ? "accepted" : "rejected");
+        sendSpeedResponse(header->payload[2], accepted);
+        if (accepted && baud != UARTrequestedBaud)
+        {
+            UARTproposedBaud = baud;
+        }
+        return true;
+    }
+
     if (packetType >= CRSF_FRAMETYPE_DEVICE_PING &&
         (header->dest_addr == CRSF_ADDRESS_CRSF_TRANSMITTER || header->dest_addr == CRSF_ADDRESS_BROADCAST) &&
         (header->orig_addr == CRSF_ADDRESS_RADIO_TRANSMITTER || header->orig_addr == CRSF_ADDRESS_ELRS_LUA))
@@ -357,11 +391,35 @@ bool CRSFHandset::processInternalCrsfPackage(uint8_t *package)
     return false;
 }
 
+void CRSFHandset::sendSpeedResponse(uint8_t portId, bool accepted)
+{
+    static GENERIC_CRC8 crsf_crc_command(CRSF_CRC_POLY_COMMAND);
+
+    // The command CRC covers the type and addresses packetQueueExtended() puts in front
+    uint8_t frame[] = {
+        CRSF_FRAMETYPE_COMMAND,
+        CRSF_ADDRESS_RADIO_TRANSMITTER,
+        CRSF_ADDRESS_CRSF_TRANSMITTER,
+        CRSF_COMMAND_SUBCMD_GENERAL,
+        CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE,
+        portId,
+        accepted,
+        0
+    };
+    frame[sizeof(frame) - 1] = crsf_crc_command.calc(frame, sizeof(frame) - 1);
+    packetQueueExtended(CRSF_FRAMETYPE_COMMAND, &frame[3], sizeof(frame) - 3);
+}
+
 bool CRSFHandset::ProcessPacket()
 {
     bool packetReceived = false;
 
     CRSFHandset::dataLastRecv = micros();
+    if (UARTbaudChanged != 0)
+    {
+        DBGLN("First frame at %u baud after %ums", UARTrequestedBaud, millis() - UARTbaudChanged);
+        UARTbaudChanged = 0;
+    }
 
     if (!controllerConnected)
     {
@@ -454,6 +512,14 @@ void CRSFHandset::handleInput()
         flush_port_input();
     }
 
+    // The handset switches as soon as it has the response, so follow once it has gone
+    if (UARTproposedBaud != 0 && SerialOutFIFO.size() == 0)
+    {
+        setBaud(UARTproposedBaud);
+        UARTproposedBaud = 0;
+        return;
+    }
+
     // Add new data, and then discard bytes until we start with header byte
     auto toRead = std::min(CRSFHandset::Port.available(), CRSF_MAX_PACKET_LEN - SerialInPacketPtr);
     SerialInPacketPtr += CRSFHandset::Port.readBytes(&SerialInBuffer[SerialInPacketPtr], toRead);
@@ -521,32 +587,46 @@ void CRSFHandset::handleOutput(int receivedBytes)
 
     // if partial package remaining, or data in the output FIFO that needs to be written
     if (packageLengthRemaining > 0 || SerialOutFIFO.size() > 0) {
-        uint8_t periodBytesRemaining = HANDSET_TELEMETRY_FIFO_SIZE;
-        if (halfDuplex)
-        {
-            periodBytesRemaining = std::min((maxPeriodBytes - receivedBytes % maxPeriodBytes), (int)maxPacketBytes);
-            periodBytesRemaining = std::max(periodBytesRemaining, (uint8_t)10);
-            if (!transmitting)
-            {
-                transmitting = true;
-                duplex_set_TX();
-            }
-        }
+        outputScheduler.startWindow(receivedBytes);
 
-        do
+        for (;;)
         {
+            bool const continuing = packageLengthRemaining > 0;
+            uint8_t writeLength;
             SerialOutFIFO.lock();
-            // no package is in transit so get new data from the fifo
-            if (packageLengthRemaining == 0)
+            if (!continuing)
             {
-                packageLengthRemaining = SerialOutFIFO.pop();
-                SerialOutFIFO.popBytes(CRSFoutBuffer, packageLengthRemaining);
-                sendingOffset = 0;
+                if (SerialOutFIFO.size() == 0)
+                {
+                    SerialOutFIFO.unlock();
+                    break;
+                }
+                // whole packages go out if they fit what is left of the window, otherwise wait for the next
+                uint8_t const packageLength = SerialOutFIFO.peek();
+                writeLength = outputScheduler.take(packageLength, false);
+                if (writeLength)
+                {
+                    packageLengthRemaining = SerialOutFIFO.pop();
+                    SerialOutFIFO.popBytes(CRSFoutBuffer, packageLengthRemaining);
+                    sendingOffset = 0;
+                }
+            }
+            else
+            {
+                // the rest of a package too large for one window
+                writeLength = outputScheduler.take(packageLengthRemaining, true);
             }
             SerialOutFIFO.unlock();
 
-            // if the package is long we need to split it, so it fits in the sending interval
-            uint8_t writeLength = std::min(packageLengthRemaining, periodBytesRemaining);
+            if (writeLength == 0)
+            {
+                break;
+            }
+            if (halfDuplex && !transmitting)
+            {
+                transmitting = true;
+                duplex_set_TX();
+            }
 
             // write the packet out, if it's a large package the offset holds the starting position
             CRSFHandset::Port.write(CRSFoutBuffer + sendingOffset, writeLength);
@@ -557,8 +637,7 @@ void CRSFHandset::handleOutput(int receivedBytes)
 
             sendingOffset += writeLength;
             packageLengthRemaining -= writeLength;
-            periodBytesRemaining -= writeLength;
-        } while(periodBytesRemaining != 0 && SerialOutFIFO.size() != 0);
+        }
     }
 }
 
@@ -648,6 +727,8 @@ void ICACHE_RAM_ATTR CRSFHandset::adjustMaxPacketSize()
     maxPeriodBytes = std::min((int)(UARTrequestedBaud / 10 / (1000000/RequestedRCpacketInterval) * 87 / 100), HANDSET_TELEMETRY_FIFO_SIZE);
     // Maximum number of bytes we can send in a single window, half the period bytes, upto one full CRSF packet.
     maxPacketBytes = std::min(maxPeriodBytes - max(maxPeriodBytes / 2, LUA_CHUNK_QUERY_SIZE), CRSF_MAX_PACKET_LEN);
+    // The output itself is scheduled from the exact window left after each RC frame
+    outputScheduler.configure(UARTrequestedBaud, RequestedRCpacketInterval, HANDSET_TELEMETRY_FIFO_SIZE);
     DBGLN("Adjusted max packet size %u-%u", maxPacketBytes, maxPeriodBytes);
 }
 
@@ -691,15 +772,7 @@ uint32_t CRSFHandset::autobaud()
     DBGLN("autobaud: low %d, high %d", low_period, high_period);
     // According to the tecnnical reference
     const int32_t calulatedBaud = UART_CLK_FREQ / (low_period + high_period + 2);
-    int32_t bestBaud = TxToHandsetBauds[0];
-    for(int i=0 ; i<ARRAY_SIZE(TxToHandsetBauds) ; i++)
-    {
-        if (abs(calulatedBaud - bestBaud) > abs(calulatedBaud - TxToHandsetBauds[i]))
-        {
-            bestBaud = TxToHandsetBauds[i];
-        }
-    }
-    return bestBaud;
+    return handsetBaudNearest(calulatedBaud);
 }
 #elif defined(PLATFORM_ESP32)
 uint32_t CRSFHandset::autobaud()
@@ -736,15 +809,7 @@ uint32_t CRSFHandset::autobaud()
     // says baud rate = 80000000/min(UART_LOWPULSE_REG, UART_HIGHPULSE_REG);
     // Based on testing use max and add 2 for lowest deviation
     int32_t calculatedBaud = 80000000 / (max(low_period, high_period) + 3);
-    auto bestBaud = TxToHandsetBauds[0];
-    for(int TxToHandsetBaud : TxToHandsetBauds)
-    {
-        if (abs(calculatedBaud - bestBaud) > abs(calculatedBaud - (int32_t)TxToHandsetBaud))
-        {
-            bestBaud = (int32_t)TxToHandsetBaud;
-        }
-    }
-    return bestBaud;
+    return handsetBaudNearest(calculatedBaud);
 }
 #else
 uint32_t CRSFHandset::autobaud() {
@@ -753,12 +818,49 @@ uint32_t CRSFHandset::autobaud() {
 }
 #endif
 
+void CRSFHandset::setBaud(uint32_t baud)
+{
+    UARTrequestedBaud = baud;
+    UARTbaudChanged = millis();
+    DBGLN("UART switch to: %d baud", UARTrequestedBaud);
+
+    adjustMaxPacketSize();
+
+    SerialOutFIFO.flush();
+#if defined(PLATFORM_ESP8266) || defined(PLATFORM_ESP32)
+    CRSFHandset::Port.flush();
+    CRSFHandset::Port.updateBaudRate(UARTrequestedBaud);
+#elif defined(TARGET_TX_GHOST)
+    CRSFHandset::Port.begin(UARTrequestedBaud);
+    USART1->CR1 &= ~USART_CR1_UE;
+    USART1->CR3 |= USART_CR3_HDSEL;
+    USART1->CR2 |= USART_CR2_RXINV | USART_CR2_TXINV | USART_CR2_SWAP; //inverted/swapped
+    USART1->CR1 |= USART_CR1_UE;
+#elif defined(TARGET_TX_FM30_MINI)
+    CRSFHandset::Port.begin(UARTrequestedBaud);
+    LL_GPIO_SetPinPull(GPIOA, GPIO_PIN_2, LL_GPIO_PULL_DOWN); // default is PULLUP
+    USART2->CR1 &= ~USART_CR1_UE;
+    USART2->CR2 |= USART_CR2_RXINV | USART_CR2_TXINV; //inverted
+    USART2->CR1 |= USART_CR1_UE;
+#else
+    CRSFHandset::Port.begin(UARTrequestedBaud);
+#endif
+    if (halfDuplex)
+    {
+        duplex_set_RX();
+    }
+    // cleanup input buffer
+    flush_port_input();
+}
+
 bool CRSFHandset::UARTwdt()
 {
     bool retval = false;
 #if !defined(DEBUG_TX_FREERUN)
     uint32_t now = millis();
-    if (now - UARTwdtLastChecked > UARTwdtInterval)
+    // Measured from outside the UART, so there is no need to wait and see if this baud rate gets any frames
+    bool const hinted = !controllerConnected && UARTbaudHint != 0;
+    if (hinted || now - UARTwdtLastChecked > UARTwdtInterval)
     {
         // If no packets or more bad than good packets, rate cycle/autobaud the UART but
         // do not adjust the parameters while in wifi mode. If a firmware is being
@@ -774,45 +876,18 @@ bool CRSFHandset::UARTwdt()
                 controllerConnected = false;
             }
 
-            UARTrequestedBaud = autobaud();
-            if (UARTrequestedBaud != 0)
+            uint32_t const baud = UARTbaudHint != 0 ? UARTbaudHint : autobaud();
+            UARTbaudHint = 0;
+            if (baud != 0)
             {
-                DBGLN("UART WDT: Switch to: %d baud", UARTrequestedBaud);
-
-                adjustMaxPacketSize();
-
-                SerialOutFIFO.flush();
-#if defined(PLATFORM_ESP8266) || defined(PLATFORM_ESP32)
-                CRSFHandset::Port.flush();
-                CRSFHandset::Port.updateBaudRate(UARTrequestedBaud);
-#elif defined(TARGET_TX_GHOST)
-                CRSFHandset::Port.begin(UARTrequestedBaud);
-                USART1->CR1 &= ~USART_CR1_UE;
-                USART1->CR3 |= USART_CR3_HDSEL;
-                USART1->CR2 |= USART_CR2_RXINV | USART_CR2_TXINV | USART_CR2_SWAP; //inverted/swapped
-                USART1->CR1 |= USART_CR1_UE;
-#elif defined(TARGET_TX_FM30_MINI)
-                CRSFHandset::Port.begin(UARTrequestedBaud);
-                LL_GPIO_SetPinPull(GPIOA, GPIO_PIN_2, LL_GPIO_PULL_DOWN); // default is PULLUP
-                USART2->CR1 &= ~USART_CR1_UE;
-                USART2->CR2 |= USART_CR2_RXINV | USART_CR2_TXINV; //inverted
-                USART2->CR1 |= USART_CR1_UE;
-#else
-                CRSFHandset::Port.begin(UARTrequestedBaud);
-#endif
-                if (halfDuplex)
-                {
-                    duplex_set_RX();
-                }
-                // cleanup input buffer
-                flush_port_input();
+                setBaud(baud);
             }
             retval = true;
         }
 #ifdef DEBUG_OPENTX_SYNC
         if (abs((int)((1000000 / (ExpressLRS_currAirRate_Modparams->interval * ExpressLRS_currAirRate_Modparams->numOfSends)) - (int)GoodPktsCount)) > 1)
 #endif
-            DBGLN("UART STATS Bad:Good = %u:%u", BadPktsCount, GoodPktsCount);
+            DBGLN("UART STATS Bad:Good = %u:%u window use %u%%", BadPktsCount, GoodPktsCount, WindowUseResult);
 
         UARTwdtLastChecked = now;
         if (retval)
@@ -823,6 +898,9 @@ bool CRSFHandset::UARTwdt()
 
         GoodPktsCountResult = GoodPktsCount;
         BadPktsCountResult = BadPktsCount;
+        StickAgeP50Result = mixerSync.getAgePercentileUs(50);
+        StickAgeP99Result = mixerSync.getAgePercentileUs(99);
+        WindowUseResult = outputScheduler.getWindowUse();
         BadPktsCount = 0;
         GoodPktsCount = 0;
     }
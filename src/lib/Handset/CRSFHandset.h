@@ -3,6 +3,9 @@
 
 #include "handset.h"
 #include "crsf_protocol.h"
+#include "HandsetBaud.h"
+#include "HandsetOutputScheduler.h"
+#include "MixerSync.h"
 #ifndef TARGET_NATIVE
 #include "HardwareSerial.h"
 #endif
@@ -34,6 +37,9 @@ public:
 
     static uint32_t GoodPktsCountResult; // need to latch the results
     static uint32_t BadPktsCountResult;  // need to latch the results
+    static uint16_t StickAgeP50Result;   // us from an RC packet arriving to it being sent, latched with the packet counts
+    static uint16_t StickAgeP99Result;
+    static uint8_t WindowUseResult;      // percent of the time after RC frames used for telemetry to the handset
 
     static void makeLinkStatisticsPacket(uint8_t *buffer);
 
@@ -42,11 +48,17 @@ public:
     void setPacketInterval(int32_t PacketInterval) override;
     void JustSentRFpacket() override;
     void sendTelemetryToTX(uint8_t *data) override;
+    void sendTelemetryBatchToTX(uint8_t *data, uint16_t len) override;
 
     static uint8_t getModelID() { return modelId; }
 
     uint8_t GetMaxPacketBytes() const override { return maxPacketBytes; }
     static uint32_t GetCurrentBaudRate() { return UARTrequestedBaud; }
+    /**
+     * @brief The baud rate the handset was measured at from outside the UART, switched to straight
+     * away if it isn't connected instead of cycling through them. Used once.
+     */
+    void setBaudHint(uint32_t baud) { UARTbaudHint = baud; }
     static bool isHalfDuplex() { return halfDuplex; }
     int getMinPacketInterval() const override;
 
@@ -55,9 +67,7 @@ private:
 
     /// OpenTX mixer sync ///
     volatile uint32_t dataLastRecv = 0;
-    volatile int32_t OpenTXsyncOffset = 0;
-    volatile int32_t OpenTXsyncWindow = 0;
-    volatile int32_t OpenTXsyncWindowSize = 0;
+    MixerSync mixerSync;
     uint32_t OpenTXsyncLastSent = 0;
 
     /// UART Handling ///
@@ -69,9 +79,13 @@ private:
     uint32_t UARTwdtLastChecked = 0;
     uint8_t maxPacketBytes = CRSF_MAX_PACKET_LEN;
     uint8_t maxPeriodBytes = CRSF_MAX_PACKET_LEN;
+    HandsetOutputScheduler outputScheduler;
 
     static uint8_t UARTcurrentBaudIdx;
     static uint32_t UARTrequestedBaud;
+    uint32_t UARTbaudHint = 0;
+    uint32_t UARTproposedBaud = 0; // accepted from the handset, switched to once the response has gone out
+    uint32_t UARTbaudChanged = 0;  // ms, 0 once there has been a valid frame
 
 #if defined(PLATFORM_ESP32)
     bool UARTinverted = false;
@@ -87,6 +101,8 @@ private:
     bool ProcessPacket();
     bool UARTwdt();
     uint32_t autobaud();
+    void setBaud(uint32_t baud);
+    void sendSpeedResponse(uint8_t portId, bool accepted);
     void flush_port_input();
 #endif
 };
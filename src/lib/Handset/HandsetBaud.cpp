@@ -0,0 +1,117 @@
+#include "HandsetBaud.h"
+
+#include <stdlib.h>
+
+const int32_t TxToHandsetBauds[HANDSET_BAUD_COUNT] = {400000, 115200, 5250000, 3750000, 1870000, 921600, 2250000};
+
+uint32_t handsetBaudNearest(int32_t measured)
+{
+    int32_t bestBaud = TxToHandsetBauds[0];
+    for (int32_t baud : TxToHandsetBauds)
+    {
+        if (abs(measured - bestBaud) > abs(measured - baud))
+        {
+            bestBaud = baud;
+        }
+    }
+    return bestBaud;
+}
+
+uint32_t handsetBaudDetect(const uint16_t *runs, uint16_t count, uint8_t ticksPerUs)
+{
+    if (count < HANDSET_BAUD_MIN_RUNS)
+    {
+        return 0;
+    }
+
+    uint32_t bestBaud = 0;
+    uint32_t bestErr = 0;
+    uint16_t bestUsed = 0;
+    for (int32_t baud : TxToHandsetBauds)
+    {
+        // Bit width in ticks, Q8
+        uint32_t const bitQ8 = ((uint64_t)ticksPerUs * 1000000 * 256 + baud / 2) / baud;
+
+        uint32_t err = 0;
+        uint16_t used = 0;
+        uint16_t singles = 0;
+        for (uint16_t i = 0; i < count; i++)
+        {
+            uint32_t const runQ8 = (uint32_t)runs[i] << 8;
+            uint32_t const runBits = (runQ8 + bitQ8 / 2) / bitQ8;
+            // Shorter than a bit, the baud rate is too low
+            if (runBits == 0)
+            {
+                used = 0;
+                break;
+            }
+            // Idle line between bytes
+            if (runBits > HANDSET_BAUD_MAX_RUN_BITS)
+            {
+                continue;
+            }
+            err += abs((int32_t)(runQ8 - runBits * bitQ8));
+            singles += runBits == 1;
+            ++used;
+        }
+        if (used < HANDSET_BAUD_MIN_RUNS)
+        {
+            continue;
+        }
+        // Random data has lots of single bits. Without them every run is a multiple of
+        // two or more bits and the baud rate is a multiple of the real one
+        if (singles * HANDSET_BAUD_MIN_SINGLES_DIV < used)
+        {
+            continue;
+        }
+        // Runs which don't fit are a quarter of a bit off on average, but the edges
+        // are on ticks so at the fastest rates a run can be most of a tick out anyway
+        if (err * 4 >= bitQ8 * used && err >= 256U * used)
+        {
+            continue;
+        }
+        // The closest fit, by the mean distance of the runs from a whole number of bits
+        if (bestBaud == 0 || (uint64_t)err * bestUsed < (uint64_t)bestErr * used)
+        {
+            bestBaud = baud;
+            bestErr = err;
+            bestUsed = used;
+        }
+    }
+    return bestBaud;
+}
+
+void HandsetBaudVote::reset()
+{
+    _last = 0;
+    _count = 0;
+    _baud = 0;
+}
+
+uint32_t HandsetBaudVote::update(uint32_t detected)
+{
+    if (detected == 0)
+    {
+        return _baud;
+    }
+    _count = detected == _last ? _count + 1 : 1;
+    _last = detected;
+    if (_count >= HANDSET_BAUD_AGREE)
+    {
+        _count = HANDSET_BAUD_AGREE;
+        _baud = detected;
+    }
+    return _baud;
+}
+
+bool handsetBaudSupported(uint32_t baud)
+{
+    for (int32_t supported : TxToHandsetBauds)
+    {
+        if ((uint32_t)supported == baud)
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+
+#define HANDSET_BAUD_COUNT          7
+#define HANDSET_BAUD_MAX_RUN_BITS   10  // start bit and 8 data bits or 8 data bits and the stop bit, longer is idle line
+#define HANDSET_BAUD_MIN_RUNS       8   // runs which have to fit the baud rate before it is trusted
+#define HANDSET_BAUD_MIN_SINGLES_DIV 8  // at least 1/8 of the runs have to be a single bit
+#define HANDSET_BAUD_AGREE          2   // captures in a row which have to give the same baud rate
+
+/**
+ * The baud rates handsets use for CRSF, in the order they are tried when cycling
+ */
+extern const int32_t TxToHandsetBauds[HANDSET_BAUD_COUNT];
+
+/**
+ * @brief The supported baud rate nearest to a measured one
+ */
+uint32_t handsetBaudNearest(int32_t measured);
+
+/**
+ * @brief Find the baud rate of 8N1 serial from the widths of the runs of one level on the line
+ *
+ * Each baud rate is tried by rounding the runs to whole bits. It can't have runs shorter than
+ * a bit and has to have plenty of single bits, and of those which do, the one with the runs
+ * closest to whole bits wins.
+ * @param runs the run lengths in ticks, alternating levels
+ * @return the baud rate, 0 if none of them fit
+ */
+uint32_t handsetBaudDetect(const uint16_t *runs, uint16_t count, uint8_t ticksPerUs);
+
+/**
+ * At the fastest rates a bit is only a couple of capture ticks, so one capture now and then
+ * gives the neighbouring baud rate. This only passes one on once captures in a row agree.
+ */
+class HandsetBaudVote
+{
+public:
+    void reset();
+    /**
+     * @param detected from handsetBaudDetect(), 0 is ignored
+     * @return the baud rate the captures agree on, 0 if they haven't yet
+     */
+    uint32_t update(uint32_t detected);
+    uint32_t getBaud() const { return _baud; }
+
+private:
+    uint32_t _last;
+    uint8_t _count;
+    uint32_t _baud;
+};
+
+/**
+ * @brief If the baud rate from a CRSF speed proposal can be switched to
+ */
+bool handsetBaudSupported(uint32_t baud);
@@ -0,0 +1,105 @@
+#include "HandsetDetect.h"
+
+handset_capture_e handsetClassifyCapture(const uint16_t *runs, uint16_t count, uint8_t ticksPerUs)
+{
+    uint32_t const serialMax = HANDSET_DETECT_SERIAL_MAX_RUN_US * ticksPerUs;
+    uint16_t serialRuns = 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        serialRuns += runs[i] <= serialMax;
+    }
+
+    // The capture ended on the idle threshold straight after the edge
+    if (count <= 1)
+    {
+        return serialRuns ? HANDSET_CAPTURE_UNKNOWN : HANDSET_CAPTURE_EDGE;
+    }
+    if (count >= 4 && serialRuns * 4 >= count * 3)
+    {
+        return HANDSET_CAPTURE_SERIAL;
+    }
+
+    // Pulse then gap for each channel, the last run carries on into the sync gap
+    uint16_t const channels = count / 2;
+    if (channels < HANDSET_DETECT_PPM_MIN_CHANNELS || channels > HANDSET_DETECT_PPM_MAX_CHANNELS)
+    {
+        return HANDSET_CAPTURE_UNKNOWN;
+    }
+    for (uint16_t ch = 0; ch < channels; ch++)
+    {
+        uint32_t const us = (runs[ch * 2] + runs[ch * 2 + 1]) / ticksPerUs;
+        if (us < HANDSET_DETECT_PPM_MIN_US || us > HANDSET_DETECT_PPM_MAX_US)
+        {
+            return HANDSET_CAPTURE_UNKNOWN;
+        }
+    }
+    return HANDSET_CAPTURE_PPM_FRAME;
+}
+
+void HandsetDetector::reset()
+{
+    _signal = HANDSET_SIGNAL_NONE;
+    _votes = 0;
+    _pending = false;
+    _pendingMs = 0;
+    _lastAgreeMs = 0;
+    _detectMs = 0;
+}
+
+handset_signal_e HandsetDetector::update(handset_capture_e capture, uint32_t nowMs)
+{
+    int8_t vote;
+    switch (capture)
+    {
+    case HANDSET_CAPTURE_EDGE:
+        vote = 1;
+        break;
+    case HANDSET_CAPTURE_PPM_FRAME:
+        vote = HANDSET_DETECT_VOTES / 2;
+        break;
+    case HANDSET_CAPTURE_SERIAL:
+        vote = -HANDSET_DETECT_VOTES / 4;
+        break;
+    default:
+        vote = 0;
+        break;
+    }
+
+    handset_signal_e const votedFor = vote > 0 ? HANDSET_SIGNAL_PPM : vote < 0 ? HANDSET_SIGNAL_SERIAL : HANDSET_SIGNAL_NONE;
+    if (votedFor == HANDSET_SIGNAL_NONE)
+    {
+        if (_signal != HANDSET_SIGNAL_NONE && nowMs - _lastAgreeMs > HANDSET_DETECT_LOST_MS)
+        {
+            _signal = HANDSET_SIGNAL_NONE;
+            _votes = 0;
+            _pending = false;
+        }
+        return _signal;
+    }
+
+    if (votedFor == _signal)
+    {
+        _lastAgreeMs = nowMs;
+        _pending = false;
+    }
+    else if (!_pending)
+    {
+        _pending = true;
+        _pendingMs = nowMs;
+    }
+
+    int16_t const votes = _votes + vote;
+    _votes = votes > HANDSET_DETECT_VOTES ? HANDSET_DETECT_VOTES : votes < -HANDSET_DETECT_VOTES ? -HANDSET_DETECT_VOTES : votes;
+
+    handset_signal_e const decided = _votes == HANDSET_DETECT_VOTES ? HANDSET_SIGNAL_PPM
+                                   : _votes == -HANDSET_DETECT_VOTES ? HANDSET_SIGNAL_SERIAL
+                                   : _signal;
+    if (decided != _signal)
+    {
+        _signal = decided;
+        _detectMs = nowMs - _pendingMs;
+        _lastAgreeMs = nowMs;
+        _pending = false;
+    }
+    return _signal;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+#define HANDSET_DETECT_SERIAL_MAX_RUN_US    40  // a few bits at 115200 baud, PPM pulses are much longer
+#define HANDSET_DETECT_PPM_MIN_US           750 // one PPM channel, pulse and gap
+#define HANDSET_DETECT_PPM_MAX_US           2250
+#define HANDSET_DETECT_PPM_MIN_CHANNELS     4
+#define HANDSET_DETECT_PPM_MAX_CHANNELS     16
+#define HANDSET_DETECT_VOTES                24  // about one and a half PPM frames of edges, or four serial frames
+#define HANDSET_DETECT_LOST_MS              250 // no captures which agree with the signal for this long, and it is gone
+
+/**
+ * What one RMT capture looks like, from the widths of the runs in it
+ */
+typedef enum : uint8_t {
+    HANDSET_CAPTURE_NONE,       // nothing was captured
+    HANDSET_CAPTURE_UNKNOWN,
+    HANDSET_CAPTURE_EDGE,       // a lone edge, PPM seen with an idle threshold shorter than its pulses
+    HANDSET_CAPTURE_PPM_FRAME,  // a whole PPM frame, seen with an idle threshold longer than its pulses
+    HANDSET_CAPTURE_SERIAL,     // mostly runs of a few bits
+} handset_capture_e;
+
+typedef enum : uint8_t {
+    HANDSET_SIGNAL_NONE,
+    HANDSET_SIGNAL_PPM,
+    HANDSET_SIGNAL_SERIAL,
+} handset_signal_e;
+
+/**
+ * @brief Classify one capture from a histogram of its run widths
+ * @param runs the run lengths in ticks, alternating levels starting with the first edge
+ */
+handset_capture_e handsetClassifyCapture(const uint16_t *runs, uint16_t count, uint8_t ticksPerUs);
+
+/**
+ * Decides which signal is on the input from a stream of classified captures.
+ * Captures vote for PPM or serial, and the signal only changes once the votes
+ * have gone all the way to the other side, so it can switch live between
+ * handsets but one odd capture won't flip it.
+ */
+class HandsetDetector
+{
+public:
+    void reset();
+
+    /**
+     * @param capture HANDSET_CAPTURE_NONE if there was nothing this time
+     * @return the signal
+     */
+    handset_signal_e update(handset_capture_e capture, uint32_t nowMs);
+
+    handset_signal_e getSignal() const { return _signal; }
+    /**
+     * @return ms from the first capture which disagreed with the old signal to the decision
+     */
+    uint32_t getDetectMs() const { return _detectMs; }
+
+private:
+    handset_signal_e _signal;
+    int8_t _votes;          // + for PPM, - for serial
+    bool _pending;          // captures have started to disagree with _signal
+    uint32_t _pendingMs;
+    uint32_t _lastAgreeMs;  // last capture which agreed with _signal
+    uint32_t _detectMs;
+};
@@ -0,0 +1,63 @@
+#include "HandsetOutputScheduler.h"
+
+void ICACHE_RAM_ATTR HandsetOutputScheduler::configure(uint32_t baud, int32_t intervalUs, uint16_t maxWindowBytes)
+{
+    _baud = baud;
+    _intervalUs = intervalUs;
+    _maxWindowBytes = maxWindowBytes;
+    _window = 0;
+    _left = 0;
+    _windowTotal = 0;
+    _usedTotal = 0;
+    _splits = 0;
+}
+
+uint16_t HandsetOutputScheduler::windowBytes(uint16_t rcBytes) const
+{
+    if (!_halfDuplex)
+    {
+        return _maxWindowBytes;
+    }
+    // 10 bits per byte, the window is what is left of the interval after the RC frame
+    int64_t const usableUs = (int64_t)_intervalUs * HANDSET_OUTPUT_WINDOW_PCT / 100;
+    int64_t const rcUs = (int64_t)rcBytes * 10 * 1000000 / _baud;
+    int64_t const bytes = (usableUs - rcUs) * _baud / 10 / 1000000;
+    return bytes < HANDSET_OUTPUT_MIN_WINDOW ? HANDSET_OUTPUT_MIN_WINDOW : bytes > _maxWindowBytes ? _maxWindowBytes : bytes;
+}
+
+void HandsetOutputScheduler::startWindow(uint16_t rcBytes)
+{
+    _window = windowBytes(rcBytes);
+    _left = _window;
+    _windowTotal += _window;
+}
+
+uint16_t HandsetOutputScheduler::take(uint16_t frameBytes, bool continuing)
+{
+    uint16_t bytes;
+    if (continuing || frameBytes <= _left)
+    {
+        bytes = frameBytes < _left ? frameBytes : _left;
+    }
+    else if (_left == _window)
+    {
+        // Too big for a whole window, so it has to be split, start it with the window to itself
+        bytes = _left;
+        ++_splits;
+    }
+    else
+    {
+        bytes = 0;
+    }
+    _left -= bytes;
+    _usedTotal += bytes;
+    return bytes;
+}
+
+uint8_t HandsetOutputScheduler::getWindowUse()
+{
+    uint8_t const use = _windowTotal ? _usedTotal * 100 / _windowTotal : 0;
+    _windowTotal = 0;
+    _usedTotal = 0;
+    return use;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include "targets.h"
+
+#define HANDSET_OUTPUT_WINDOW_PCT       87  // of the packet interval, measured to leave room for processing and switching direction
+#define HANDSET_OUTPUT_MIN_WINDOW       10  // bytes, always let some out so telemetry isn't starved completely
+
+/**
+ * Decides how much of the queued telemetry to write to the handset after each RC frame.
+ * On a half duplex module the window is the time left in the packet interval after the
+ * RC frame, as bytes at the current baud. Whole frames are packed into the window in
+ * order, and a frame which doesn't fit what is left waits for the next window rather
+ * than being split, unless it is too big for any window.
+ */
+class HandsetOutputScheduler
+{
+public:
+    /**
+     * @param maxWindowBytes the most to write after one RC frame, the handset's telemetry FIFO
+     */
+    void configure(uint32_t baud, int32_t intervalUs, uint16_t maxWindowBytes);
+
+    /**
+     * @brief Set once the port is started, which can be after the first configure()
+     */
+    void setHalfDuplex(bool halfDuplex) { _halfDuplex = halfDuplex; }
+
+    /**
+     * @return the bytes that fit in the window after an RC frame of rcBytes
+     */
+    uint16_t windowBytes(uint16_t rcBytes) const;
+
+    /**
+     * @brief Start the window after an RC frame
+     */
+    void startWindow(uint16_t rcBytes);
+
+    /**
+     * @brief How much of a frame to write now, and take it from the window
+     * @param frameBytes the bytes left of the frame
+     * @param continuing true if the start of the frame went out in an earlier window
+     * @return bytes to write, 0 to leave it for the next window
+     */
+    uint16_t take(uint16_t frameBytes, bool continuing);
+
+    /**
+     * @return percent of the window bytes used, since the last call
+     */
+    uint8_t getWindowUse();
+    uint32_t getSplitCount() const { return _splits; }
+
+private:
+    uint32_t _baud;
+    int32_t _intervalUs;
+    bool _halfDuplex = false;
+    uint16_t _maxWindowBytes;
+
+    uint16_t _window;   // bytes in this window
+    uint16_t _left;     // bytes left in this window
+    uint32_t _windowTotal;
+    uint32_t _usedTotal;
+    uint32_t _splits;
+};
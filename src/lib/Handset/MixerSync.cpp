@@ -0,0 +1,107 @@
+#include "MixerSync.h"
+
+void MixerSyncHistogram::reset(uint16_t binUs)
+{
+    for (uint8_t i = 0; i < MIXER_SYNC_BINS; i++)
+    {
+        _bins[i] = 0;
+    }
+    _binUs = binUs ? binUs : 1;
+    _count = 0;
+}
+
+void ICACHE_RAM_ATTR MixerSyncHistogram::add(uint32_t us)
+{
+    uint32_t const bin = us / _binUs;
+    ++_bins[bin < MIXER_SYNC_BINS ? bin : MIXER_SYNC_BINS - 1];
+    if (++_count >= MIXER_SYNC_DECAY_COUNT)
+    {
+        _count = 0;
+        for (uint8_t i = 0; i < MIXER_SYNC_BINS; i++)
+        {
+            _bins[i] /= 2;
+            _count += _bins[i];
+        }
+    }
+}
+
+uint32_t ICACHE_RAM_ATTR MixerSyncHistogram::percentile(uint8_t pct) const
+{
+    if (_count == 0)
+    {
+        return 0;
+    }
+    // The first bin where the count so far reaches pct% of the samples
+    uint32_t const target = ((uint32_t)_count * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < MIXER_SYNC_BINS; i++)
+    {
+        seen += _bins[i];
+        if (seen >= target)
+        {
+            return (uint32_t)(i + 1) * _binUs;
+        }
+    }
+    return (uint32_t)MIXER_SYNC_BINS * _binUs;
+}
+
+void MixerSync::reset(int32_t intervalUs)
+{
+    _intervalUs = intervalUs;
+    _offset = 0;
+    _window = 0;
+    // The number of packets in the sync window is how many will fit in 20ms.
+    // This gives quite quite coarse changes for 50Hz, but more fine grained changes at 1000Hz.
+    _windowSize = 20000 / intervalUs;
+    if (_windowSize < 1)
+    {
+        _windowSize = 1;
+    }
+    _marginUs = MIXER_SYNC_DEFAULT_MARGIN_US;
+    _late = 0;
+    _jitter.reset(MIXER_SYNC_JITTER_BIN_US);
+    _age.reset(intervalUs / MIXER_SYNC_AGE_BINS_PER_INTERVAL);
+}
+
+bool ICACHE_RAM_ATTR MixerSync::update(int32_t deltaUs)
+{
+    _age.add(deltaUs > 0 ? deltaUs : 0);
+
+    if (deltaUs >= _intervalUs)
+    {
+        // missing/late packet, force resync. Count it as the worst jitter so the margin grows
+        _offset = -(deltaUs % _intervalUs) * 10;
+        _window = 0;
+        _jitter.add(UINT32_MAX);
+        if (_late < UINT16_MAX)
+        {
+            ++_late;
+        }
+        updateMargin();
+        return true;
+    }
+
+    // Only once the average has settled, arriving later than it eats into the margin
+    if (_window == _windowSize)
+    {
+        int32_t const late = _offset / 10 - deltaUs;
+        _jitter.add(late > 0 ? late : 0);
+        updateMargin();
+    }
+    _window = _window < _windowSize ? _window + 1 : _windowSize;
+    _offset = ((_offset * (_window - 1)) + deltaUs * 10) / _window;
+    return false;
+}
+
+void ICACHE_RAM_ATTR MixerSync::updateMargin()
+{
+    if (_jitter.getCount() < MIXER_SYNC_MIN_SAMPLES)
+    {
+        return;
+    }
+    uint32_t margin = _jitter.percentile(MIXER_SYNC_JITTER_PERCENTILE);
+    // Never more than half the interval, the packet would be as likely to be late the other way
+    uint32_t const maxMargin = _intervalUs / 2;
+    margin = margin < MIXER_SYNC_MIN_MARGIN_US ? MIXER_SYNC_MIN_MARGIN_US : margin > maxMargin ? maxMargin : margin;
+    _marginUs = margin;
+}
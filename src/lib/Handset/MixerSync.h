@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include "targets.h"
+
+#define MIXER_SYNC_BINS             32
+#define MIXER_SYNC_JITTER_BIN_US    10  // 0-320us of jitter
+#define MIXER_SYNC_AGE_BINS_PER_INTERVAL 16 // stick age histogram covers two packet intervals
+#define MIXER_SYNC_DECAY_COUNT      1024 // histograms are halved when they reach this many samples
+#define MIXER_SYNC_MIN_SAMPLES      128 // before this many jitter samples the default margin is used
+#define MIXER_SYNC_DEFAULT_MARGIN_US 100
+#define MIXER_SYNC_MIN_MARGIN_US    20
+#define MIXER_SYNC_JITTER_PERCENTILE 99
+
+/**
+ * A histogram of microsecond values in fixed width bins, which decays by halving
+ * so it follows changes without keeping a window of samples
+ */
+class MixerSyncHistogram
+{
+public:
+    void reset(uint16_t binUs);
+    void add(uint32_t us);
+    /**
+     * @return the upper edge of the bin containing the percentile, or 0 if empty
+     */
+    uint32_t percentile(uint8_t pct) const;
+    uint16_t getCount() const { return _count; }
+
+private:
+    uint16_t _bins[MIXER_SYNC_BINS];
+    uint16_t _binUs;
+    uint16_t _count;
+};
+
+/**
+ * Works out the OpenTX mixer sync offset to send to the handset. The handset is asked to
+ * have its RC packets arrive a safety margin ahead of each RF packet, and that margin is
+ * sized from the p99 of how much later than average the packets arrive, so a handset with
+ * a steady UART gets less stick latency and one with a jittery UART misses fewer RF packets.
+ * Also keeps the distribution of stick age at transmit, the time from an RC packet arriving
+ * to it going out over the air.
+ */
+class MixerSync
+{
+public:
+    void reset(int32_t intervalUs);
+
+    /**
+     * @brief Add the time from the last RC packet arriving to an RF packet being sent
+     * @return true if the packet was missed and the handset should be resynced now
+     */
+    bool update(int32_t deltaUs);
+
+    /**
+     * @return the offset to send to the handset, in tenths of us
+     */
+    int32_t getOffset() const { return _offset - (int32_t)_marginUs * 10; }
+    uint16_t getMarginUs() const { return _marginUs; }
+    uint32_t getAgePercentileUs(uint8_t pct) const { return _age.percentile(pct); }
+    uint16_t getLateCount() const { return _late; }
+
+private:
+    void updateMargin();
+
+    int32_t _intervalUs;
+    int32_t _offset;        // average delta, tenths of us
+    int32_t _window;
+    int32_t _windowSize;
+    uint16_t _marginUs;
+    uint16_t _late;         // RF packets sent without a new RC packet, since reset
+    MixerSyncHistogram _jitter;
+    MixerSyncHistogram _age;
+};
@@ -42,31 +42,37 @@ bool PPMHandset::IsArmed()
     return maybeArmed && lastPPM;
 }
 
+void PPMHandset::handleFrame(const rmt_item32_t *items, size_t length)
+{
+    int channelCount = 0;
+    for (int i = 0; i < length; i++)
+    {
+        const auto item = items[i];
+        // Stop if there is a 0 duration
+        if (item.duration0 == 0 || item.duration1 == 0)
+        {
+            break;
+        }
+        channelCount ++;
+        const auto ppm = (item.duration0 + item.duration1) / RMT_TICKS_PER_US;
+        ChannelData[i] = fmap(ppm, 988, 2012, CRSF_CHANNEL_VALUE_MIN, CRSF_CHANNEL_VALUE_MAX);
+    }
+    numChannels = channelCount;
+    lastPPM = millis();
+}
+
 void PPMHandset::handleInput()
 {
     const auto now = millis();
     size_t length = 0;
 
-    auto *items = static_cast<rmt_item32_t *>(xRingbufferReceive(rb, &length, 0));
+    // No ringbuffer when AutoDetect is passing frames in
+    auto *items = rb ? static_cast<rmt_item32_t *>(xRingbufferReceive(rb, &length, 0)) : nullptr;
     if (items)
     {
         length /= 4; // one RMT = 4 Bytes
-        int channelCount = 0;
-        for (int i = 0; i < length; i++)
-        {
-            const auto item = items[i];
-            // Stop if there is a 0 duration
-            if (item.duration0 == 0 || item.duration1 == 0)
-            {
-                break;
-            }
-            channelCount ++;
-            const auto ppm = (item.duration0 + item.duration1) / RMT_TICKS_PER_US;
-            ChannelData[i] = fmap(ppm, 988, 2012, CRSF_CHANNEL_VALUE_MIN, CRSF_CHANNEL_VALUE_MAX);
-        }
-        numChannels = channelCount;
+        handleFrame(items, length);
         vRingbufferReturnItem(rb, static_cast<void *>(items));
-        lastPPM = now;
     }
     else if (lastPPM && now - 1000 > lastPPM)
     {
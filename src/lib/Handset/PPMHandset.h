@@ -11,6 +11,11 @@ public:
     bool IsArmed() override;
     void handleInput() override;
 
+    /**
+     * @brief Decode a PPM frame captured by the RMT, for when something else owns the channel
+     */
+    void handleFrame(const rmt_item32_t *items, size_t length);
+
 private:
     uint32_t lastPPM = 0;
     size_t numChannels = 0;
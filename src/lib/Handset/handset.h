@@ -9,9 +9,10 @@
  *
  * - CRSFHandset - implements the CRSF protocol for communicating with the handset
  * - PPMHandset - PPM protocol, can be connected to the DSC/trainer port for simple non-CRSF handsets
- * - AutoDetect - this implementation uses an RMT channel to auto-detect a PPM or CRSF handset and swap the
- *   global `handset` variable to point to instance of the actual implementation. This allows a TX module
- *   to be moved between a CRSF capable handset and PPM only handset e.g. an EdgeTX radio and a surface radio.
+ * - AutoDetect - this implementation keeps an RMT channel watching the handset signal to auto-detect a PPM
+ *   or CRSF handset, and passes everything through to its own instance of the actual implementation. This
+ *   allows a TX module to be moved between a CRSF capable handset and PPM only handset e.g. an EdgeTX radio
+ *   and a surface radio, without a restart.
  */
 class Handset
 {
@@ -90,11 +91,28 @@ public:
      */
     virtual void sendTelemetryToTX(uint8_t *data) {}
 
+    /**
+     * Send several telemetry packets back to the handset at once
+     * @param data CRSF packets one after the other
+     * @param len total length of the packets
+     */
+    virtual void sendTelemetryBatchToTX(uint8_t *data, uint16_t len)
+    {
+        // device_addr, frame_size then frame_size bytes
+        for (uint16_t pos = 0; pos < len; pos += data[pos + 1] + 2)
+            sendTelemetryToTX(&data[pos]);
+    }
+
     /**
      * @return the time in microseconds when the last RC packet was received from the handset
      */
     uint32_t GetRCdataLastRecv() const { return RCdataLastRecv; }
 
+    /**
+     * @return true while the protocol has a stable connection to the handset
+     */
+    bool IsConnected() const { return controllerConnected; }
+
 #if defined(DEBUG_TX_FREERUN)
     /**
      * @brief Can be used to force a connected callback for debugging
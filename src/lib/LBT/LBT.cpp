@@ -2,8 +2,10 @@
 #include "common.h"
 #include "logging.h"
 #include "LBT.h"
+#include "FHSS.h"
 
 LQCALC<100> LBTSuccessCalc;
+LBTChannelStats LBTChannels;
 static uint32_t rxStartTime;
 
 #if !defined(LBT_RSSI_THRESHOLD_OFFSET_DB)
@@ -12,6 +14,7 @@ static uint32_t rxStartTime;
 
 bool LBTEnabled = false;
 static uint32_t validRSSIdelayUs = 0;
+static expresslrs_mod_settings_s const *validRSSIdelayModParams; // the rate validRSSIdelayUs is for
 
 static uint32_t ICACHE_RAM_ATTR SpreadingFactorToRSSIvalidDelayUs(
   SX1280_RadioLoRaSpreadingFactors_t SF,
@@ -103,7 +106,11 @@ void ICACHE_RAM_ATTR SetClearChannelAssessmentTime(void)
     return;
 
   rxStartTime = micros();
-  validRSSIdelayUs = SpreadingFactorToRSSIvalidDelayUs((SX1280_RadioLoRaSpreadingFactors_t)ExpressLRS_currAirRate_Modparams->sf, ExpressLRS_currAirRate_Modparams->radio_type);
+  if (validRSSIdelayModParams != ExpressLRS_currAirRate_Modparams)
+  {
+    validRSSIdelayModParams = ExpressLRS_currAirRate_Modparams;
+    validRSSIdelayUs = SpreadingFactorToRSSIvalidDelayUs((SX1280_RadioLoRaSpreadingFactors_t)ExpressLRS_currAirRate_Modparams->sf, ExpressLRS_currAirRate_Modparams->radio_type);
+  }
 
 #if defined(TARGET_TX)
   Radio.RXnb(SX1280_MODE_RX, validRSSIdelayUs);
@@ -123,6 +130,13 @@ SX12XX_Radio_Number_t ICACHE_RAM_ATTR ChannelIsClear(SX12XX_Radio_Number_t radio
     return SX12XX_Radio_All;
   }
 
+  // A channel which is nearly always busy is taken as busy without waiting to listen to it
+  uint8_t const channel = FHSSsequence[FHSSgetCurrIndex()];
+  if (!LBTChannels.shouldAssess(channel))
+  {
+    return SX12XX_Radio_NONE;
+  }
+
   // Read rssi after waiting the minimum RSSI valid delay.
   // If this function is called long enough after RX enable,
   // this will always be ok on first try as is the case for TX.
@@ -172,6 +186,8 @@ SX12XX_Radio_Number_t ICACHE_RAM_ATTR ChannelIsClear(SX12XX_Radio_Number_t radio
   {
     LBTSuccessCalc.add(); // Add success only when actually preparing for TX
   }
+  // Clear if either radio is, with Gemini only the first radio's channel is tracked
+  LBTChannels.update(channel, clearChannelsMask != SX12XX_Radio_NONE);
 
   return clearChannelsMask;
 }
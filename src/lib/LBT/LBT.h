@@ -4,8 +4,10 @@
 #include "POWERMGNT.h"
 #include "LQCALC.h"
 #include "SX1280Driver.h"
+#include "LBTChannelStats.h"
 
 extern LQCALC<100> LBTSuccessCalc;
+extern LBTChannelStats LBTChannels;
 extern bool LBTEnabled;
 
 void ICACHE_RAM_ATTR SetClearChannelAssessmentTime(void);
@@ -0,0 +1,40 @@
+#include "LBTChannelStats.h"
+
+#include <string.h>
+#include "targets.h"
+
+void LBTChannelStats::reset()
+{
+    memset(_busy, 0, sizeof(_busy));
+    memset(_visits, 0, sizeof(_visits));
+    _assessed = 0;
+    _busyCount = 0;
+    _skipped = 0;
+}
+
+bool ICACHE_RAM_ATTR LBTChannelStats::shouldAssess(uint8_t channel)
+{
+    if (channel >= LBT_CHANNELS || _busy[channel] <= LBT_BUSY_SKIP)
+    {
+        return true;
+    }
+    if (++_visits[channel] >= LBT_PROBE_INTERVAL)
+    {
+        return true;
+    }
+    ++_skipped;
+    return false;
+}
+
+void ICACHE_RAM_ATTR LBTChannelStats::update(uint8_t channel, bool clear)
+{
+    ++_assessed;
+    _busyCount += !clear;
+    if (channel >= LBT_CHANNELS)
+    {
+        return;
+    }
+    uint8_t const busy = _busy[channel];
+    _busy[channel] = clear ? busy - (busy >> 3) : busy + ((LBT_BUSY_MAX - busy + 7) >> 3);
+    _visits[channel] = 0;
+}
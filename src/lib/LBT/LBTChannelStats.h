@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#define LBT_CHANNELS            128 // FHSS channels tracked, the 2.4GHz domains have 80
+#define LBT_BUSY_MAX            255
+#define LBT_BUSY_SKIP           224 // about 16 busy visits in a row, and the channel isn't listened to any more
+#define LBT_PROBE_INTERVAL      8   // a skipped channel is still listened to on every this many visits, to see if it has cleared
+
+/**
+ * How often each FHSS channel has been found busy. A channel which is busy almost every
+ * time it comes round is taken as busy without listening to it, which saves waiting out
+ * the RSSI settling time just to find it is still in use. It is listened to again now and
+ * then, and one clear result is enough to start listening to it every time again.
+ */
+class LBTChannelStats
+{
+public:
+    void reset();
+
+    /**
+     * @return false if the channel is busy so often it can be skipped this time
+     */
+    bool shouldAssess(uint8_t channel);
+    /**
+     * @brief Add the result of listening to the channel
+     */
+    void update(uint8_t channel, bool clear);
+
+    /**
+     * @return how busy the channel has been lately, 0 never to LBT_BUSY_MAX always
+     */
+    uint8_t getBusyScore(uint8_t channel) const { return channel < LBT_CHANNELS ? _busy[channel] : 0; }
+    uint32_t getAssessedCount() const { return _assessed; }
+    uint32_t getBusyCount() const { return _busyCount; }
+    uint32_t getSkippedCount() const { return _skipped; }
+
+private:
+    uint8_t _busy[LBT_CHANNELS];  // EWMA of busy results, 1/8 per result
+    uint8_t _visits[LBT_CHANNELS]; // since the channel was last listened to
+    uint32_t _assessed;
+    uint32_t _busyCount;
+    uint32_t _skipped;
+};
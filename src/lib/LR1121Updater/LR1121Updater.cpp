@@ -0,0 +1,142 @@
+#include "LR1121Updater.h"
+#include <string.h>
+
+void LR1121Updater::reset()
+{
+    _head = 0;
+    _tail = 0;
+    _queued = 0;
+    _inFlight = false;
+    _fill = 0;
+    _fileSize = 0;
+    _received = 0;
+    _sent = 0;
+    _flashed = 0;
+    _startOffset = 0;
+    _startMs = 0;
+    _lastMs = 0;
+}
+
+void LR1121Updater::start(size_t fileSize, size_t offset)
+{
+    _fileSize = fileSize;
+    _received = offset;
+    _startOffset = offset;
+    _fill = 0;
+    _startMs = _port.getMillis();
+    _lastMs = _startMs;
+}
+
+void LR1121Updater::begin(size_t fileSize)
+{
+    reset();
+    start(fileSize, 0);
+}
+
+bool LR1121Updater::resume(size_t fileSize, size_t offset)
+{
+    if (!canResume() || fileSize != _fileSize || offset != _sent)
+    {
+        return false;
+    }
+    // The packets which were never sent are sent again from the new upload, only the one
+    // the LR1121 may still be writing is kept
+    _queued = _inFlight ? 1 : 0;
+    _head = (_tail + _queued) % LR1121_UPDATE_RING;
+    start(fileSize, offset);
+    _startOffset = _flashed;
+    return true;
+}
+
+void LR1121Updater::queue()
+{
+    uint32_t const offset = _received - _fill;
+    packet_t &packet = _ring[_head];
+    packet.header[0] = (uint8_t)(_opcode >> 8);
+    packet.header[1] = (uint8_t)_opcode;
+    packet.header[2] = (uint8_t)(offset >> 24);
+    packet.header[3] = (uint8_t)(offset >> 16);
+    packet.header[4] = (uint8_t)(offset >> 8);
+    packet.header[5] = (uint8_t)offset;
+    _size[_head] = _fill;
+    _head = (_head + 1) % LR1121_UPDATE_RING;
+    ++_queued;
+    _fill = 0;
+}
+
+void LR1121Updater::pump()
+{
+    if (_inFlight)
+    {
+        if (_port.isBusy())
+        {
+            return;
+        }
+        _inFlight = false;
+        _flashed += _size[_tail];
+        _tail = (_tail + 1) % LR1121_UPDATE_RING;
+        --_queued;
+    }
+    if (_queued)
+    {
+        _port.startWrite((uint8_t *)&_ring[_tail], LR1121_UPDATE_HEADER + _size[_tail]);
+        _inFlight = true;
+        _sent += _size[_tail];
+    }
+}
+
+void LR1121Updater::waitQueued(uint8_t most)
+{
+    pump();
+    while (_queued > most)
+    {
+        _port.idle();
+        pump();
+    }
+    _lastMs = _port.getMillis();
+}
+
+void LR1121Updater::write(const uint8_t *data, size_t len)
+{
+    while (len)
+    {
+        if (_queued == LR1121_UPDATE_RING)
+        {
+            // Every packet is full, the one being filled has to wait for the oldest to be written
+            waitQueued(LR1121_UPDATE_RING - 1);
+        }
+        uint32_t const size = len < (size_t)(LR1121_UPDATE_CHUNK - _fill) ? len : LR1121_UPDATE_CHUNK - _fill;
+        memcpy(_ring[_head].buffer + _fill, data, size);
+        _fill += size;
+        _received += size;
+        data += size;
+        len -= size;
+        if (_fill == LR1121_UPDATE_CHUNK)
+        {
+            queue();
+            pump();
+        }
+    }
+    // Send everything but the last packet before going back for more of the upload, which
+    // leaves the LR1121 writing that one while the next part of the file comes in
+    waitQueued(1);
+}
+
+void LR1121Updater::finish()
+{
+    if (_fill)
+    {
+        if (_queued == LR1121_UPDATE_RING)
+        {
+            waitQueued(LR1121_UPDATE_RING - 1);
+        }
+        queue();
+    }
+    waitQueued(0);
+}
+
+uint32_t LR1121Updater::getThroughput() const
+{
+    uint32_t const ms = _lastMs - _startMs;
+    return ms ? (uint64_t)(_flashed - _startOffset) * 1000 / ms : 0;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LR1121_UPDATE_CHUNK         256 // bytes of firmware in each bootloader write, the most it takes
+#define LR1121_UPDATE_HEADER        6   // opcode and flash offset
+#define LR1121_UPDATE_RING          4   // packets which can be filled while one is being written
+
+/**
+ * The SPI side of writing to the LR1121 bootloader
+ */
+class LR1121UpdatePort
+{
+public:
+    /**
+     * @brief Send a whole packet with NSS held low, without waiting for BUSY afterwards
+     */
+    virtual void startWrite(uint8_t *packet, uint32_t size) = 0;
+    /**
+     * @return true while the LR1121 is still writing the last packet to flash
+     */
+    virtual bool isBusy() = 0;
+    /**
+     * @brief Called while waiting for BUSY to clear when there is nothing else to do
+     */
+    virtual void idle() = 0;
+    virtual uint32_t getMillis() = 0;
+};
+
+/**
+ * Writes the LR1121 firmware from the web upload in LR1121_UPDATE_CHUNK packets. The upload
+ * fills a ring of packets and each one is sent as soon as the LR1121 is done with the one
+ * before, so the flash write of the last packet carries on while the next part of the file
+ * is on its way over WiFi, instead of the upload waiting on BUSY after every packet.
+ *
+ * The offset sent up to is kept when an upload stops part way, so another upload of the
+ * rest of the same file can carry on from getResumeOffset() without erasing the flash again.
+ */
+class LR1121Updater
+{
+public:
+    LR1121Updater(LR1121UpdatePort &port, uint16_t writeOpcode) : _port(port), _opcode(writeOpcode) { reset(); }
+
+    void reset();
+    /**
+     * @brief Start writing a file at the start of the flash, after it has been erased
+     */
+    void begin(size_t fileSize);
+    /**
+     * @brief Carry on writing the file an upload stopped part way through
+     * @param offset where the upload starts in the file, it has to be getResumeOffset()
+     * @return false if there is no interrupted upload of a file this size to carry on from there
+     */
+    bool resume(size_t fileSize, size_t offset);
+    /**
+     * @brief Add the next part of the file, only waiting on the LR1121 when the ring is full.
+     * On return the last full packet may still be being written.
+     */
+    void write(const uint8_t *data, size_t len);
+    /**
+     * @brief Write what is left of the file and wait until the LR1121 has it all
+     */
+    void finish();
+
+    bool isComplete() const { return _fileSize != 0 && _flashed == _fileSize; }
+    /**
+     * @return true if an upload stopped part way and resume() can carry it on
+     */
+    bool canResume() const { return _sent != 0 && _sent < _fileSize; }
+    size_t getFileSize() const { return _fileSize; }
+    /**
+     * @return bytes of the file sent to the LR1121, everything before this is or will be in the flash
+     */
+    size_t getResumeOffset() const { return _sent; }
+    size_t getReceived() const { return _received; }
+    size_t getFlashed() const { return _flashed; }
+    uint8_t getProgress() const { return _fileSize ? (uint64_t)_flashed * 100 / _fileSize : 0; }
+    /**
+     * @return bytes per second written to the LR1121 since begin() or resume()
+     */
+    uint32_t getThroughput() const;
+
+private:
+    typedef struct {
+        uint8_t header[LR1121_UPDATE_HEADER];
+        uint8_t buffer[LR1121_UPDATE_CHUNK];
+    } __attribute__((packed)) packet_t;
+
+    void start(size_t fileSize, size_t offset);
+    void queue();
+    void pump();
+    void waitQueued(uint8_t most);
+
+    LR1121UpdatePort &_port;
+    packet_t _ring[LR1121_UPDATE_RING];
+    uint16_t _size[LR1121_UPDATE_RING];
+    uint16_t _opcode;
+    uint8_t _head;      // packet being filled
+    uint8_t _tail;      // packet in flight, or the next to send
+    uint8_t _queued;    // full packets, including the one in flight
+    bool _inFlight;
+    uint16_t _fill;     // bytes in the packet being filled
+    size_t _fileSize;
+    size_t _received;   // offsets in the file, including the part before a resume
+    size_t _sent;
+    size_t _flashed;
+    size_t _startOffset;
+    uint32_t _startMs;
+    uint32_t _lastMs;
+};
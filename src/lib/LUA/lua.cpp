@@ -1,4 +1,5 @@
 #include "lua.h"
+#include "luaParamCache.h"
 #include "common.h"
 #include "CRSF.h"
 #include "logging.h"
@@ -18,7 +19,6 @@ static uint8_t luaWarningFlags = 0b00000000; //8 flag, 1 bit for each flag. set
 static void (*devicePingCallback)() = nullptr;
 #endif
 
-#define LUA_MAX_PARAMS 64
 static uint8_t parameterType;
 static uint8_t parameterIndex;
 static uint8_t parameterArg;
@@ -29,21 +29,6 @@ static luaCallback paramCallbacks[LUA_MAX_PARAMS] = {0};
 static uint8_t lastLuaField = 0;
 static uint8_t nextStatusChunk = 0;
 
-static uint8_t luaSelectionOptionMax(const char *strOptions)
-{
-  // Returns the max index of the semicolon-delimited option string
-  // e.g. A;B;C;D = 3
-  uint8_t retVal = 0;
-  while (true)
-  {
-    char c = *strOptions++;
-    if (c == ';')
-      ++retVal;
-    else if (c == '\0')
-      return retVal;
-  }
-}
-
 uint8_t getLabelLength(char *text, char separator){
   char *c = (char*)text;
   //get label length up to null or lua separator ;
@@ -76,121 +61,15 @@ uint8_t findLuaSelectionLabel(const void *luaStruct, char *outarray, uint8_t val
   return 0;
 }
 
-static uint8_t *luaTextSelectionStructToArray(const void *luaStruct, uint8_t *next)
-{
-  const struct luaItem_selection *p1 = (const struct luaItem_selection *)luaStruct;
-  next = (uint8_t *)stpcpy((char *)next, p1->options) + 1;
-  *next++ = p1->value; // value
-  *next++ = 0; // min
-  *next++ = luaSelectionOptionMax(p1->options); //max
-  *next++ = 0; // default value
-  return (uint8_t *)stpcpy((char *)next, p1->units);
-}
-
-static uint8_t *luaCommandStructToArray(const void *luaStruct, uint8_t *next)
-{
-  const struct luaItem_command *p1 = (const struct luaItem_command *)luaStruct;
-  *next++ = p1->step;
-  *next++ = 200; // timeout in 10ms
-  return (uint8_t *)stpcpy((char *)next, p1->info);
-}
-
-static uint8_t *luaInt8StructToArray(const void *luaStruct, uint8_t *next)
-{
-  const struct luaItem_int8 *p1 = (const struct luaItem_int8 *)luaStruct;
-  memcpy(next, &p1->properties, sizeof(p1->properties));
-  next += sizeof(p1->properties);
-  *next++ = 0; // default value
-  return (uint8_t *)stpcpy((char *)next, p1->units);
-}
-
-static uint8_t *luaInt16StructToArray(const void *luaStruct, uint8_t *next)
-{
-  const struct luaItem_int16 *p1 = (const struct luaItem_int16 *)luaStruct;
-  memcpy(next, &p1->properties, sizeof(p1->properties));
-  next += sizeof(p1->properties);
-  *next++ = 0; // default value byte 1
-  *next++ = 0; // default value byte 2
-  return (uint8_t *)stpcpy((char *)next, p1->units);
-}
-
-static uint8_t *luaStringStructToArray(const void *luaStruct, uint8_t *next)
-{
-  const struct luaItem_string *p1 = (const struct luaItem_string *)luaStruct;
-  return (uint8_t *)stpcpy((char *)next, p1->value);
-}
-static uint8_t *luaFolderStructToArray(const void *luaStruct, uint8_t *next)
-{
-  const struct luaItem_folder *p1 = (const struct luaItem_folder *)luaStruct;
-  if(p1->dyn_name != NULL){
-    return (uint8_t *)stpcpy((char *)next, p1->dyn_name) + 1;
-  } else {
-    return (uint8_t *)stpcpy((char *)next, p1->common.name) + 1;
-  }
-}
 static uint8_t sendCRSFparam(crsf_frame_type_e frameType, uint8_t fieldChunk, struct luaPropertiesCommon *luaData)
 {
-  uint8_t dataType = luaData->type & CRSF_FIELD_TYPE_MASK;
-
-  // 256 max payload + (FieldID + ChunksRemain + Parent + Type)
-  // Chunk 1: (FieldID + ChunksRemain + Parent + Type) + fieldChunk0 data
-  // Chunk 2-N: (FieldID + ChunksRemain) + fieldChunk1 data
-  uint8_t chunkBuffer[256+4];
-  // Start the field payload at 2 to leave room for (FieldID + ChunksRemain)
-  chunkBuffer[2] = luaData->parent;
-  chunkBuffer[3] = dataType;
-#ifdef TARGET_TX
-  // Set the hidden flag
-  chunkBuffer[3] |= luaData->type & CRSF_FIELD_HIDDEN ? 0x80 : 0;
-  if (CRSFHandset::elrsLUAmode) {
-    chunkBuffer[3] |= luaData->type & CRSF_FIELD_ELRS_HIDDEN ? 0x80 : 0;
-  }
-#else
-  chunkBuffer[3] |= luaData->type;
-  uint8_t paramInformation[DEVICE_INFORMATION_LENGTH];
-#endif
-
-  // Copy the name to the buffer starting at chunkBuffer[4]
-  uint8_t *chunkStart = (uint8_t *)stpcpy((char *)&chunkBuffer[4], luaData->name) + 1;
-  uint8_t *dataEnd;
-
-  switch(dataType) {
-    case CRSF_TEXT_SELECTION:
-      dataEnd = luaTextSelectionStructToArray(luaData, chunkStart);
-      break;
-    case CRSF_COMMAND:
-      dataEnd = luaCommandStructToArray(luaData, chunkStart);
-      break;
-    case CRSF_INT8: // fallthrough
-    case CRSF_UINT8:
-      dataEnd = luaInt8StructToArray(luaData, chunkStart);
-      break;
-    case CRSF_INT16: // fallthrough
-    case CRSF_UINT16:
-      dataEnd = luaInt16StructToArray(luaData, chunkStart);
-      break;
-    case CRSF_STRING: // fallthough
-    case CRSF_INFO:
-      dataEnd = luaStringStructToArray(luaData, chunkStart);
-      break;
-    case CRSF_FOLDER:
-      // re-fetch the lua data name, because luaFolderStructToArray will decide whether
-      //to return the fixed name or dynamic name.
-      chunkStart = luaFolderStructToArray(luaData, &chunkBuffer[4]);
-      // subtract 1 because dataSize expects the end to not include the null
-      // which is already accounted for in chunkStart
-      dataEnd = chunkStart - 1;
-      break;
-    case CRSF_FLOAT:
-    case CRSF_OUT_OF_RANGE:
-    default:
-      return 0;
+  uint16_t imageLen;
+  const uint8_t *image = luaParamCache.getImage(luaData, fieldChunk, imageLen);
+  if (image == nullptr)
+  {
+    return 0;
   }
 
-  // dataEnd points to the end of the last string
-  // -2 bytes Lua chunk header: FieldId, ChunksRemain
-  // +1 for the null on the last string
-  uint8_t dataSize = (dataEnd - chunkBuffer) - 2 + 1;
   // Maximum number of chunked bytes that can be sent in one response
   // 6 bytes CRSF header/CRC: Dest, Len, Type, ExtSrc, ExtDst, CRC
   // 2 bytes Lua chunk header: FieldId, ChunksRemain
@@ -200,19 +79,39 @@ static uint8_t sendCRSFparam(crsf_frame_type_e frameType, uint8_t fieldChunk, st
   uint8_t chunkMax = CRSF_MAX_PACKET_LEN - 6 - 2;
 #endif
   // How many chunks needed to send this field (rounded up)
-  uint8_t chunkCnt = (dataSize + chunkMax - 1) / chunkMax;
-  // Data left to send is adjustedSize - chunks sent already
-  uint8_t chunkSize = min((uint8_t)(dataSize - (fieldChunk * chunkMax)), chunkMax);
-
-  // Move chunkStart back 2 bytes to add (FieldId + ChunksRemain) to each packet
-  chunkStart = &chunkBuffer[fieldChunk * chunkMax];
-  chunkStart[0] = luaData->id;                 // FieldId
-  chunkStart[1] = chunkCnt - (fieldChunk + 1); // ChunksRemain
+  uint8_t chunkCnt = luaImageChunkCount(imageLen, chunkMax);
+  if (fieldChunk >= chunkCnt)
+  {
+    return 0;
+  }
+  // Data left to send is imageLen - chunks sent already
+  uint8_t chunkSize = min((uint16_t)(imageLen - (fieldChunk * chunkMax)), (uint16_t)chunkMax);
+
 #ifdef TARGET_TX
-  CRSFHandset::packetQueueExtended(frameType, chunkStart, chunkSize + 2);
+  uint8_t chunkBuffer[CRSF_MAX_PACKET_LEN];
 #else
-  memcpy(paramInformation + sizeof(crsf_ext_header_t),chunkStart,chunkSize + 2);
+  uint8_t paramInformation[DEVICE_INFORMATION_LENGTH];
+  uint8_t *chunkBuffer = paramInformation + sizeof(crsf_ext_header_t);
+#endif
+  chunkBuffer[0] = luaData->id;                 // FieldId
+  chunkBuffer[1] = chunkCnt - (fieldChunk + 1); // ChunksRemain
+  memcpy(&chunkBuffer[2], &image[fieldChunk * chunkMax], chunkSize);
+  if (fieldChunk == 0)
+  {
+    // The image only holds the data type, add the hidden flags
+#ifdef TARGET_TX
+    chunkBuffer[3] |= luaData->type & CRSF_FIELD_HIDDEN ? 0x80 : 0;
+    if (CRSFHandset::elrsLUAmode) {
+      chunkBuffer[3] |= luaData->type & CRSF_FIELD_ELRS_HIDDEN ? 0x80 : 0;
+    }
+#else
+    chunkBuffer[3] |= luaData->type;
+#endif
+  }
 
+#ifdef TARGET_TX
+  CRSFHandset::packetQueueExtended(frameType, chunkBuffer, chunkSize + 2);
+#else
   CRSF::SetExtendedHeaderAndCrc(paramInformation, frameType, chunkSize + CRSF_FRAME_LENGTH_EXT_TYPE_CRC + 2, CRSF_ADDRESS_CRSF_RECEIVER, CRSF_ADDRESS_CRSF_TRANSMITTER);
 
   telemetry.AppendTelemetryPackage(paramInformation);
@@ -4,6 +4,9 @@
 #include "helpers.h"
 #include "devServoOutput.h"
 #include "deferred.h"
+#if defined(HAS_VTX_SPI)
+#include "devVTXSPI.h"
+#endif
 
 extern void reconfigureSerial();
 #if defined(PLATFORM_ESP32)
@@ -12,6 +15,9 @@ extern void reconfigureSerial1();
 extern bool BindingModeRequest;
 
 static char modelString[] = "000";
+#if defined(HAS_VTX_SPI)
+static char vtxPowerString[20] = "-";
+#endif
 #if defined(GPIO_PIN_PWM_OUTPUTS)
 static char pwmModes[] = "50Hz;60Hz;100Hz;160Hz;333Hz;400Hz;10kHzDuty;On/Off;DShot;Serial RX;Serial TX;I2C SCL;I2C SDA;Serial2 RX;Serial2 TX";
 #endif
@@ -97,6 +103,13 @@ static struct luaItem_string luaELRSversion = {
     commit
 };
 
+#if defined(HAS_VTX_SPI)
+static struct luaItem_string luaVtxPower = {
+    {"VTX Settle", CRSF_INFO},
+    vtxPowerString
+};
+#endif
+
 //----------------------------Info-----------------------------------
 
 //---------------------------- WiFi -----------------------------
@@ -349,6 +362,7 @@ static void luaparamMappingChannelOut(struct luaPropertiesCommon *item, uint8_t
     {
         pwmModes[lastPos] = '\0';
     }
+    luaParamInvalidate(&luaMappingOutputMode.common);
 
     // Trigger an event to update the related fields to represent the selected channel
     devicesTriggerEvent();
@@ -563,6 +577,12 @@ static void registerLuaParameters()
     sendLuaCommandResponse(&luaBindMode, arg < 5 ? lcsExecuting : lcsIdle, arg < 5 ? "Entering..." : "");
   });
 
+#if defined(HAS_VTX_SPI)
+  if (OPT_HAS_VTX_SPI)
+  {
+    registerLUAParameter(&luaVtxPower);
+  }
+#endif
   registerLUAParameter(&luaModelNumber);
   registerLUAParameter(&luaELRSversion);
   registerLUAParameter(nullptr);
@@ -630,9 +650,34 @@ static int event()
   return DURATION_IMMEDIATELY;
 }
 
+#if defined(HAS_VTX_SPI)
+static void updateVtxPowerLabel()
+{
+  // Time the VPD took to reach the setpoint, and the average error since
+  uint16_t settleMs;
+  int16_t error;
+  char newString[sizeof(vtxPowerString)] = "-";
+  if (VTxSPIGetPowerStats(&settleMs, &error))
+  {
+    snprintf(newString, sizeof(newString), "%ums err %d", settleMs, error);
+  }
+  if (strcmp(newString, vtxPowerString) != 0)
+  {
+    strcpy(vtxPowerString, newString);
+    setLuaStringValue(&luaVtxPower, vtxPowerString);
+  }
+}
+#endif
+
 static int timeout()
 {
   luaHandleUpdateParameter();
+#if defined(HAS_VTX_SPI)
+  if (OPT_HAS_VTX_SPI)
+  {
+    updateVtxPowerLabel();
+  }
+#endif
   // Receivers can only `UpdateParamReq == true` every 4th packet due to the transmitter cadence in 1:2
   // Channels, Downlink Telemetry Slot, Uplink Telemetry (the write command), Downlink Telemetry Slot...
   // (interval * 4 / 1000) or 1 second if not connected
@@ -148,6 +148,11 @@ static struct luaItem_string luaInfo = {
     STR_EMPTYSPACE
 };
 
+static struct luaItem_string luaStickAge = {
+    {"Stick Age", CRSF_INFO},
+    STR_EMPTYSPACE
+};
+
 static struct luaItem_string luaELRSversion = {
     {version_domain, CRSF_INFO},
     commit
@@ -299,6 +304,7 @@ static struct luaItem_string luaBackpackVersion = {
 //---------------------------- BACKPACK ------------------
 
 static char luaBadGoodString[10];
+static char luaStickAgeString[16];
 static int event();
 
 extern TxConfig config;
@@ -319,6 +325,7 @@ extern void setWifiUpdateMode();
 static void luadevUpdateModelID() {
   itoa(CRSFHandset::getModelID(), modelMatchUnit+6, 10);
   strcat(modelMatchUnit, ")");
+  luaParamInvalidate(&luaModelMatch.common);
 }
 
 static void luadevUpdateTlmBandwidth()
@@ -362,6 +369,7 @@ static void luadevUpdateTlmBandwidth()
     itoa(bandwidthValue, &tlmBandwidth[2], 10);
     strcat(tlmBandwidth, "bps)");
   }
+  luaParamInvalidate(&luaTlmRate.common);
 }
 
 static void luadevUpdateBackpackOpts()
@@ -565,6 +573,8 @@ static void luadevUpdateBadGood()
   itoa(CRSFHandset::BadPktsCountResult, luaBadGoodString, 10);
   strcat(luaBadGoodString, "/");
   itoa(CRSFHandset::GoodPktsCountResult, luaBadGoodString + strlen(luaBadGoodString), 10);
+  // p50/p99 of the time from the handset's RC packet arriving to it being sent
+  snprintf(luaStickAgeString, sizeof(luaStickAgeString), "%u/%uus", CRSFHandset::StickAgeP50Result, CRSFHandset::StickAgeP99Result);
 }
 
 /***
@@ -611,6 +621,7 @@ static void recalculatePacketRateOptions(int minInterval)
     {
         luastrPacketRates[lastPos] = '\0';
     }
+    luaParamInvalidate(&luaAirRate.common);
 }
 
 uint8_t adjustSwitchModeForAirRate(OtaSwitchMode_e eSwitchMode, uint8_t packetSize)
@@ -848,6 +859,7 @@ static void registerLuaParameters()
   }
 
   registerLUAParameter(&luaInfo);
+  registerLUAParameter(&luaStickAge);
   if (strlen(version) < 21) {
     strlcpy(version_domain, version, 21);
     strlcat(version_domain, " ", sizeof(version_domain));
@@ -884,6 +896,7 @@ static int event()
   {
     luaSwitch.options = OtaIsFullRes ? switchmodeOpts8ch : switchmodeOpts4ch;
   }
+  luaParamInvalidate(&luaSwitch.common);
 
   if (isDualRadio())
   {
@@ -944,6 +957,7 @@ static int start()
   registerLuaParameters();
 
   setLuaStringValue(&luaInfo, luaBadGoodString);
+  setLuaStringValue(&luaStickAge, luaStickAgeString);
   luaRegisterDevicePingCallback(&luadevUpdateBadGood);
 
   event();
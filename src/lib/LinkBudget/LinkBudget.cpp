@@ -0,0 +1,102 @@
+#include "LinkBudget.h"
+#include "common.h"
+
+// Average the loss over about 2^shift reports, the fade margin covers the fading
+#define LINKBUDGET_FILTER_SHIFT 2
+
+LinkBudget::LinkBudget(uint8_t targetMarginDb, uint8_t downHysteresisDb)
+    : _target(targetMarginDb * 4), _downHysteresis(downHysteresisDb * 4)
+{
+    reset();
+}
+
+void LinkBudget::reset()
+{
+    _valid = false;
+    _txDbm = 0;
+    _snrRate = false;
+    _snrValid = false;
+    _rssiLoss = 0;
+    _snrLoss = 0;
+    _sensitivity = 0;
+    _snrThreshUp = 0;
+}
+
+void LinkBudget::filterLoss(int16_t &filtered, int16_t loss)
+{
+    filtered += (loss - filtered) / (1 << LINKBUDGET_FILTER_SHIFT);
+}
+
+void LinkBudget::update(int8_t txDbm, int8_t rssi, int8_t snrScaled, int16_t sensitivity, int8_t snrThreshUp, int8_t snrThreshDn)
+{
+    // The first report after a power change may have been measured before it
+    if (_valid && txDbm != _txDbm)
+    {
+        _txDbm = txDbm;
+        return;
+    }
+    _txDbm = txDbm;
+
+    int16_t const tx = txDbm * 4;
+    int16_t const snr = snrScaled * 4 / RADIO_SNR_SCALE;
+    // Below the noise floor the RSSI is mostly noise, the signal is the SNR below it
+    int16_t const rssiLoss = tx - (rssi * 4 + (snr < 0 ? snr : 0));
+
+    if (_valid)
+        filterLoss(_rssiLoss, rssiLoss);
+    else
+        _rssiLoss = rssiLoss;
+    _sensitivity = sensitivity * 4;
+    _valid = true;
+
+    _snrRate = snrThreshUp != DYNPOWER_SNR_THRESH_NONE;
+    if (_snrRate)
+    {
+        int16_t const snrLoss = tx - snr;
+        if (!_snrValid)
+            _snrLoss = snrLoss;
+        else if (snrScaled < snrThreshDn)
+            filterLoss(_snrLoss, snrLoss);
+        // Up where the SNR tops out it only says the loss is no worse than this
+        else if (snrLoss < _snrLoss)
+            _snrLoss = snrLoss;
+        _snrThreshUp = snrThreshUp * 4 / RADIO_SNR_SCALE;
+    }
+    _snrValid = _snrRate;
+}
+
+int16_t LinkBudget::margin(int8_t txDbm) const
+{
+    int16_t const tx = txDbm * 4;
+    // Rates with SNR thresholds are tuned on the SNR, the RSSI target doesn't apply
+    if (_snrRate)
+        return tx - _snrLoss - _snrThreshUp;
+    return tx - _rssiLoss - _sensitivity - _target;
+}
+
+PowerLevels_e LinkBudget::selectPower(PowerLevels_e current, PowerLevels_e minPower, PowerLevels_e maxPower) const
+{
+    if (current > maxPower)
+        current = maxPower;
+    if (!_valid)
+        return current;
+
+    int16_t const tx = powerToDbm(current) * 4;
+    int16_t const m = margin(powerToDbm(current));
+    int16_t needed;
+    if (m < 0)
+        // Straight to the level which makes up the shortfall
+        needed = tx - m;
+    else if (m >= _downHysteresis)
+        // The lowest level which keeps most of the hysteresis spare, so noise in the next report won't raise it again
+        needed = tx - m + _downHysteresis * 3 / 4;
+    else
+        return current;
+
+    for (uint8_t power = minPower; power < maxPower; ++power)
+    {
+        if (powerToDbm((PowerLevels_e)power) * 4 >= needed)
+            return (PowerLevels_e)power;
+    }
+    return maxPower;
+}
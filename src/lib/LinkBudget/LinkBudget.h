@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include "POWERMGNT.h"
+
+#if !defined(RADIO_SNR_SCALE)
+#define RADIO_SNR_SCALE 4 // Unit tests, all the radios report SNR in quarter dB
+#endif
+
+/**
+ * Estimates the uplink path loss from the RSSI and SNR the receiver reports,
+ * and picks the lowest power level which keeps a fade margin over the
+ * receiver's sensitivity, rather than stepping one level per report.
+ *
+ * All values are in quarter dB, the same units as a scaled SNR.
+ */
+class LinkBudget
+{
+public:
+    /**
+     * @param targetMarginDb RSSI above the sensitivity to keep
+     * @param downHysteresisDb how much more than that is needed before lowering power,
+     *        which then keeps three quarters of it
+     */
+    LinkBudget(uint8_t targetMarginDb, uint8_t downHysteresisDb);
+
+    void reset();
+
+    /**
+     * @brief Add a link statistics report, the first one after the power changes is skipped
+     * @param txDbm the current output power
+     * @param rssi uplink RSSI in dBm
+     * @param snrScaled uplink SNR, SNR_SCALE() units
+     * @param sensitivity RXsensitivity of the current rate
+     * @param snrThreshUp,snrThreshDn DynpowerSnrThresh of the current rate, the SNR
+     *        is kept above snrThreshUp unless these are DYNPOWER_SNR_THRESH_NONE
+     */
+    void update(int8_t txDbm, int8_t rssi, int8_t snrScaled, int16_t sensitivity, int8_t snrThreshUp, int8_t snrThreshDn);
+
+    /**
+     * @return the margin over the target at txDbm, negative if more power is needed
+     */
+    int16_t margin(int8_t txDbm) const;
+
+    /**
+     * @brief The lowest power level between minPower and maxPower which meets the target
+     * margin, or current if it isn't worth changing
+     */
+    PowerLevels_e selectPower(PowerLevels_e current, PowerLevels_e minPower, PowerLevels_e maxPower) const;
+
+    bool isValid() const { return _valid; }
+    int16_t getPathLoss() const { return _rssiLoss; }
+
+private:
+    static void filterLoss(int16_t &filtered, int16_t loss);
+
+    int16_t const _target;
+    int16_t const _downHysteresis;
+    bool _valid;
+    bool _snrRate;          // the rate has SNR thresholds
+    bool _snrValid;         // _snrLoss has been set since the rate changed
+    int16_t _rssiLoss;      // tx power - received signal
+    int16_t _snrLoss;       // tx power - SNR
+    int16_t _sensitivity;
+    int16_t _snrThreshUp;
+    int8_t _txDbm;          // power of the last report
+};
@@ -18,6 +18,8 @@ enum lua_Flags{
     LUA_FLAG_CRITICAL_WARNING2,
 };
 
+#define LUA_MAX_PARAMS 64
+
 struct luaPropertiesCommon {
     const char* name;   // display name
     crsf_value_type_e type;
@@ -145,32 +147,48 @@ void sendLuaCommandResponse(struct luaItem_command *cmd, luaCmdStep_e step, cons
 extern void luaParamUpdateReq(uint8_t type, uint8_t index, uint8_t arg);
 extern bool luaHandleUpdateParameter();
 
+// Invalidate the cached image of a parameter whose options, units or labels were changed
+// directly instead of through one of the setters below
+void luaParamInvalidate(const struct luaPropertiesCommon *luaStruct);
+
 typedef void (*luaCallback)(struct luaPropertiesCommon *item, uint8_t arg);
 void registerLUAParameter(void *definition, luaCallback callback = nullptr, uint8_t parent = 0);
 
 uint8_t findLuaSelectionLabel(const void *luaStruct, char *outarray, uint8_t value);
 
 void sendLuaDevicePacket(void);
+// Setters invalidate the cached image of the parameter only when the value changes
 inline void setLuaTextSelectionValue(struct luaItem_selection *luaStruct, uint8_t newvalue) {
+    if (luaStruct->value == newvalue) return;
     luaStruct->value = newvalue;
+    luaParamInvalidate(&luaStruct->common);
 }
 inline void setLuaUint8Value(struct luaItem_int8 *luaStruct, uint8_t newvalue) {
+    if (luaStruct->properties.u.value == newvalue) return;
     luaStruct->properties.u.value = newvalue;
+    luaParamInvalidate(&luaStruct->common);
 }
 inline void setLuaInt8Value(struct luaItem_int8 *luaStruct, int8_t newvalue) {
+    if (luaStruct->properties.s.value == newvalue) return;
     luaStruct->properties.s.value = newvalue;
+    luaParamInvalidate(&luaStruct->common);
 }
 inline void setLuaUint16Value(struct luaItem_int16 *luaStruct, uint16_t newvalue) {
+    if (luaStruct->properties.u.value == htobe16(newvalue)) return;
     luaStruct->properties.u.value = htobe16(newvalue);
+    luaParamInvalidate(&luaStruct->common);
 }
 inline void setLuaInt16Value(struct luaItem_int16 *luaStruct, int16_t newvalue) {
+    if (luaStruct->properties.u.value == htobe16((uint16_t)newvalue)) return;
     luaStruct->properties.u.value = htobe16((uint16_t)newvalue);
+    luaParamInvalidate(&luaStruct->common);
 }
 inline void setLuaFloatValue(struct luaItem_float *luaStruct, int32_t newvalue) {
     luaStruct->properties.value = htobe32((uint32_t)newvalue);
 }
 inline void setLuaStringValue(struct luaItem_string *luaStruct, const char *newvalue) {
     luaStruct->value = newvalue;
+    luaParamInvalidate(&luaStruct->common);
 }
 
 #define LUASYM_ARROW_UP "\xc0"
@@ -0,0 +1,174 @@
+#include "luaParamCache.h"
+#include "helpers.h"
+
+LuaParamCache luaParamCache;
+
+static uint8_t luaSelectionOptionMax(const char *strOptions)
+{
+  // Returns the max index of the semicolon-delimited option string
+  // e.g. A;B;C;D = 3
+  uint8_t retVal = 0;
+  while (true)
+  {
+    char c = *strOptions++;
+    if (c == ';')
+      ++retVal;
+    else if (c == '\0')
+      return retVal;
+  }
+}
+
+// Each serializer writes the type specific data after the name and
+// returns a pointer to the null terminating the last string
+static uint8_t *luaTextSelectionStructToArray(const void *luaStruct, uint8_t *next)
+{
+  const struct luaItem_selection *p1 = (const struct luaItem_selection *)luaStruct;
+  next = (uint8_t *)stpcpy((char *)next, p1->options) + 1;
+  *next++ = p1->value; // value
+  *next++ = 0; // min
+  *next++ = luaSelectionOptionMax(p1->options); //max
+  *next++ = 0; // default value
+  return (uint8_t *)stpcpy((char *)next, p1->units);
+}
+
+static uint8_t *luaCommandStructToArray(const void *luaStruct, uint8_t *next)
+{
+  const struct luaItem_command *p1 = (const struct luaItem_command *)luaStruct;
+  *next++ = p1->step;
+  *next++ = 200; // timeout in 10ms
+  return (uint8_t *)stpcpy((char *)next, p1->info);
+}
+
+static uint8_t *luaInt8StructToArray(const void *luaStruct, uint8_t *next)
+{
+  const struct luaItem_int8 *p1 = (const struct luaItem_int8 *)luaStruct;
+  memcpy(next, &p1->properties, sizeof(p1->properties));
+  next += sizeof(p1->properties);
+  *next++ = 0; // default value
+  return (uint8_t *)stpcpy((char *)next, p1->units);
+}
+
+static uint8_t *luaInt16StructToArray(const void *luaStruct, uint8_t *next)
+{
+  const struct luaItem_int16 *p1 = (const struct luaItem_int16 *)luaStruct;
+  memcpy(next, &p1->properties, sizeof(p1->properties));
+  next += sizeof(p1->properties);
+  *next++ = 0; // default value byte 1
+  *next++ = 0; // default value byte 2
+  return (uint8_t *)stpcpy((char *)next, p1->units);
+}
+
+static uint8_t *luaStringStructToArray(const void *luaStruct, uint8_t *next)
+{
+  const struct luaItem_string *p1 = (const struct luaItem_string *)luaStruct;
+  return (uint8_t *)stpcpy((char *)next, p1->value);
+}
+
+static uint8_t *luaFolderStructToArray(const void *luaStruct, uint8_t *next)
+{
+  // Folders have no data, the name is replaced by the dynamic name if there is one
+  const struct luaItem_folder *p1 = (const struct luaItem_folder *)luaStruct;
+  return (uint8_t *)stpcpy((char *)next, p1->dyn_name != NULL ? p1->dyn_name : p1->common.name);
+}
+
+static const struct {
+  uint8_t *(*toArray)(const void *luaStruct, uint8_t *next);
+  bool writesName;     // serializer writes the name itself
+  bool rebuildOnRead;  // text may change in place, re-serialize when the first chunk is read
+} luaSerializers[] = {
+  { luaInt8StructToArray, false, false },           // CRSF_UINT8
+  { luaInt8StructToArray, false, false },           // CRSF_INT8
+  { luaInt16StructToArray, false, false },          // CRSF_UINT16
+  { luaInt16StructToArray, false, false },          // CRSF_INT16
+  { nullptr, false, false },                        // CRSF_UINT32
+  { nullptr, false, false },                        // CRSF_INT32
+  { nullptr, false, false },                        // CRSF_UINT64
+  { nullptr, false, false },                        // CRSF_INT64
+  { nullptr, false, false },                        // CRSF_FLOAT
+  { luaTextSelectionStructToArray, false, false },  // CRSF_TEXT_SELECTION
+  { luaStringStructToArray, false, true },          // CRSF_STRING
+  { luaFolderStructToArray, true, true },           // CRSF_FOLDER
+  { luaStringStructToArray, false, true },          // CRSF_INFO
+  { luaCommandStructToArray, false, true },         // CRSF_COMMAND
+};
+
+uint16_t luaBuildParamImage(const struct luaPropertiesCommon *luaData, uint8_t *image)
+{
+  uint8_t dataType = luaData->type & CRSF_FIELD_TYPE_MASK;
+  if (dataType >= ARRAY_SIZE(luaSerializers) || luaSerializers[dataType].toArray == nullptr)
+  {
+    return 0;
+  }
+
+  image[0] = luaData->parent;
+  image[1] = dataType;
+  uint8_t *next = &image[2];
+  if (!luaSerializers[dataType].writesName)
+  {
+    next = (uint8_t *)stpcpy((char *)next, luaData->name) + 1;
+  }
+  uint8_t *dataEnd = luaSerializers[dataType].toArray(luaData, next);
+
+  // +1 for the null on the last string
+  return dataEnd - image + 1;
+}
+
+void LuaParamCache::clear()
+{
+  arenaUsed = 0;
+  memset(entries, 0, sizeof(entries));
+}
+
+const uint8_t *LuaParamCache::getImage(const struct luaPropertiesCommon *luaData, uint8_t fieldChunk, uint16_t &len)
+{
+  uint8_t id = luaData->id;
+  if (id >= LUA_MAX_PARAMS)
+  {
+    return nullptr;
+  }
+
+  // Later chunks are always sent from the image the first chunk was sent from
+  luaImageEntry *entry = &entries[id];
+  uint8_t dataType = luaData->type & CRSF_FIELD_TYPE_MASK;
+  bool rebuild = !entry->valid ||
+    (fieldChunk == 0 && dataType < ARRAY_SIZE(luaSerializers) && luaSerializers[dataType].rebuildOnRead);
+  if (entry->len != 0 && (fieldChunk != 0 || !rebuild))
+  {
+    ++imageHits;
+    len = entry->len;
+    return &arena[entry->offset];
+  }
+
+  uint8_t image[LUA_IMAGE_MAX_SIZE];
+  uint16_t imageLen = luaBuildParamImage(luaData, image);
+  if (imageLen == 0)
+  {
+    return nullptr;
+  }
+  ++imageBuilds;
+  imageBytesBuilt += imageLen;
+
+  if (entry->size < imageLen)
+  {
+    // The image grew out of its space, move it to the end of the arena. If the arena
+    // is full start it over, the other parameters are re-serialized as they are read
+    if (arenaUsed + imageLen > LUA_IMAGE_CACHE_SIZE)
+    {
+      clear();
+    }
+    entry->offset = arenaUsed;
+    entry->size = imageLen;
+    arenaUsed += imageLen;
+  }
+  memcpy(&arena[entry->offset], image, imageLen);
+  entry->len = imageLen;
+  entry->valid = true;
+
+  len = imageLen;
+  return &arena[entry->offset];
+}
+
+void luaParamInvalidate(const struct luaPropertiesCommon *luaData)
+{
+  luaParamCache.invalidate(luaData->id);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "lua.h"
+
+// Arena holding the serialized image of every parameter
+#if !defined(LUA_IMAGE_CACHE_SIZE)
+#if defined(TARGET_TX)
+#define LUA_IMAGE_CACHE_SIZE 2048
+#else
+#define LUA_IMAGE_CACHE_SIZE 1024
+#endif
+#endif
+
+// 256 max chunked payload + (Parent + Type)
+#define LUA_IMAGE_MAX_SIZE (256 + 2)
+
+static_assert(LUA_IMAGE_CACHE_SIZE >= LUA_IMAGE_MAX_SIZE, "Lua image cache must hold the largest parameter");
+
+/**
+ * @brief Serialize a parameter to its PARAMETER_SETTINGS_ENTRY image
+ * Parent, Type, Name, then the type specific data. The Type byte only holds the
+ * data type, the hidden flags are added when the frame is sent.
+ * @return length of the image in bytes, or 0 if the type is not supported
+ */
+uint16_t luaBuildParamImage(const struct luaPropertiesCommon *luaData, uint8_t *image);
+
+/**
+ * @brief Number of chunks needed to send an image of len bytes, chunkMax bytes at a time
+ */
+inline uint8_t luaImageChunkCount(uint16_t len, uint8_t chunkMax)
+{
+    return (len + chunkMax - 1) / chunkMax;
+}
+
+/**
+ * @brief Cache of serialized parameter images
+ *
+ * The handset reads every parameter chunk by chunk each time the Lua menu is opened, and
+ * re-reads them while it is open. Instead of serializing the parameter for every chunk
+ * request, the image is kept until the parameter is invalidated by a value change.
+ * Parameters whose text is changed in place without going through a setter (strings,
+ * info, folders and commands) are re-serialized each time their first chunk is read,
+ * the remaining chunks are always served from the image built for the first, so a
+ * multi-chunk parameter is never sent half old and half new.
+ */
+class LuaParamCache
+{
+public:
+    /**
+     * @brief Get the image to send the requested chunk of a parameter from
+     * @param len set to the image length
+     * @return the image, or nullptr if the parameter can not be serialized
+     */
+    const uint8_t *getImage(const struct luaPropertiesCommon *luaData, uint8_t fieldChunk, uint16_t &len);
+
+    /**
+     * @brief Rebuild the image of a parameter the next time its first chunk is read
+     */
+    void invalidate(uint8_t id)
+    {
+        if (id < LUA_MAX_PARAMS)
+            entries[id].valid = false;
+    }
+
+    // Statistics
+    uint32_t imageBuilds = 0;     // number of times a parameter was serialized
+    uint32_t imageBytesBuilt = 0; // total bytes serialized
+    uint32_t imageHits = 0;       // number of chunk requests served without serializing
+
+private:
+    struct luaImageEntry {
+        uint16_t offset; // start of the image in the arena
+        uint16_t len;    // length of the image, 0 if there is no image
+        uint16_t size;   // space reserved in the arena
+        bool valid;      // image matches the parameter
+    };
+
+    void clear();
+
+    uint8_t arena[LUA_IMAGE_CACHE_SIZE];
+    uint16_t arenaUsed = 0;
+    luaImageEntry entries[LUA_MAX_PARAMS] = {};
+};
+
+extern LuaParamCache luaParamCache;
@@ -5,8 +5,10 @@
 #endif
 #include <CRSFHandset.h>
 
-// Takes a MAVLink message wrapped in CRSF and possibly converts it to a CRSF telemetry message
-void convert_mavlink_to_crsf_telem(uint8_t *CRSFinBuffer, uint8_t count, Handset *handset);
+// Passes MAVLink from the RX to forward as it arrives, and frames it to convert what it can to CRSF telemetry for the handset
+void processMAVLinkDownlink(const uint8_t *data, uint8_t count, uint32_t now, Handset *handset, void (*forward)(const uint8_t *data, uint16_t len));
 
 bool isThisAMavPacket(uint8_t *buffer, uint16_t bufferSize);
-uint16_t buildMAVLinkELRSModeChange(uint8_t mode, uint8_t *buffer);
\ No newline at end of file
+uint16_t buildMAVLinkELRSModeChange(uint8_t mode, uint8_t *buffer);
+// CRC_EXTRA seed of a message for MAVLinkFramer, false if the message is not known
+bool mavlinkCrcExtra(uint32_t msgid, uint8_t *crcExtra);
\ No newline at end of file
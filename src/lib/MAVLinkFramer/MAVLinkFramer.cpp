@@ -0,0 +1,192 @@
+#include "MAVLinkFramer.h"
+
+// CRC-16/MCRF4XX, the X.25 CRC used by MAVLink
+static inline uint16_t crcAccumulate(uint8_t data, uint16_t crc)
+{
+    uint8_t tmp = data ^ (uint8_t)(crc & 0xFF);
+    tmp ^= (tmp << 4);
+    return (crc >> 8) ^ (tmp << 8) ^ (tmp << 3) ^ (tmp >> 4);
+}
+
+MAVLinkFramer::framer_result_e MAVLinkFramer::nextFrame(uint16_t &pos, uint16_t &frameStart, uint16_t &frameLen, uint32_t now)
+{
+    for (; pos < _len; ++pos, ++bytesDiscarded, _synced = false)
+    {
+        uint8_t const stx = _buf[pos];
+        if (stx != MAVLINK_STX_V1 && stx != MAVLINK_STX_V2)
+            continue;
+
+        uint16_t const headerLen = (stx == MAVLINK_STX_V2) ? MAVLINK_V2_HEADER_LEN : MAVLINK_V1_HEADER_LEN;
+        uint16_t const avail = _len - pos;
+        if (avail < headerLen)
+            return FRAMER_NEED_MORE;
+
+        const uint8_t *frame = &_buf[pos];
+        uint16_t len = headerLen + frame[1] + MAVLINK_CRC_LEN;
+        if (stx == MAVLINK_STX_V2)
+        {
+            // Any incompatibility flag other than signing means we can't frame it
+            if (frame[2] & ~MAVLINK_IFLAG_SIGNED)
+                continue;
+            if (frame[2] & MAVLINK_IFLAG_SIGNED)
+                len += MAVLINK_SIGNATURE_LEN;
+        }
+        uint32_t const msgid = mavlinkFrameMsgId(frame);
+        if (avail < len)
+            return FRAMER_NEED_MORE;
+
+        uint8_t crcExtra;
+        if (_crcExtra(msgid, &crcExtra))
+        {
+            uint16_t const crcEnd = headerLen + frame[1];
+            uint16_t crc = 0xFFFF;
+            for (uint16_t i = 1; i < crcEnd; ++i)
+                crc = crcAccumulate(frame[i], crc);
+            crc = crcAccumulate(crcExtra, crc);
+            if (frame[crcEnd] != (crc & 0xFF) || frame[crcEnd + 1] != (crc >> 8))
+            {
+                // Not a frame, or a corrupted one, look for the next STX after this one
+                ++framesBadCrc;
+                continue;
+            }
+        }
+        else if (_synced)
+        {
+            ++framesUnchecked;
+        }
+        else
+        {
+            // Without a CRC to check, only trust it if it follows straight on from a good frame
+            continue;
+        }
+        _synced = true;
+
+        frameStart = pos;
+        frameLen = len;
+        pos += len;
+
+        bool forward = true;
+        mavlink_msg_stats_t *stats = findStats(msgid, true);
+        if (stats)
+        {
+            ++stats->frames;
+            ++stats->windowFrames;
+            stats->bytes += len;
+            if (stats->minIntervalMs == MAVLINK_FILTER_DROP ||
+                (stats->minIntervalMs != 0 && stats->frames > 1 && now - stats->lastForwardMs < stats->minIntervalMs))
+            {
+                forward = false;
+                ++stats->dropped;
+            }
+            else
+            {
+                stats->lastForwardMs = now;
+            }
+        }
+        else
+        {
+            ++framesUntracked;
+        }
+
+        if (!forward)
+        {
+            ++framesFiltered;
+            return FRAMER_FILTERED;
+        }
+        ++framesForwarded;
+        bytesForwarded += len;
+        return FRAMER_FORWARD;
+    }
+    return FRAMER_NEED_MORE;
+}
+
+mavlink_msg_stats_t *MAVLinkFramer::findStats(uint32_t msgid, bool create)
+{
+    // Messages often arrive in bursts of the same ID
+    if (_lastStats < _statsCount && _stats[_lastStats].msgid == msgid)
+        return &_stats[_lastStats];
+
+    for (uint8_t i = 0; i < _statsCount; ++i)
+    {
+        if (_stats[i].msgid == msgid)
+        {
+            _lastStats = i;
+            return &_stats[i];
+        }
+    }
+
+    if (!create || _statsCount == MAVLINK_FRAMER_MAX_MSG_IDS)
+        return nullptr;
+
+    mavlink_msg_stats_t *stats = &_stats[_statsCount];
+    memset(stats, 0, sizeof(*stats));
+    stats->msgid = msgid;
+    _lastStats = _statsCount++;
+    return stats;
+}
+
+const mavlink_msg_stats_t *MAVLinkFramer::getStats(uint32_t msgid) const
+{
+    for (uint8_t i = 0; i < _statsCount; ++i)
+    {
+        if (_stats[i].msgid == msgid)
+            return &_stats[i];
+    }
+    return nullptr;
+}
+
+bool MAVLinkFramer::setFilter(uint32_t msgid, uint16_t minIntervalMs)
+{
+    mavlink_msg_stats_t *stats = findStats(msgid, true);
+    if (stats == nullptr)
+        return false;
+    stats->minIntervalMs = minIntervalMs;
+    return true;
+}
+
+void MAVLinkFramer::setFilters(const mavlink_filter_t *filters, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; ++i)
+        setFilter(filters[i].msgid, filters[i].minIntervalMs);
+}
+
+void MAVLinkFramer::resetStats()
+{
+    // Filtered messages keep their entry, everything else is forgotten
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < _statsCount; ++i)
+    {
+        if (_stats[i].minIntervalMs == 0)
+            continue;
+        uint32_t const msgid = _stats[i].msgid;
+        uint16_t const minIntervalMs = _stats[i].minIntervalMs;
+        memset(&_stats[kept], 0, sizeof(_stats[kept]));
+        _stats[kept].msgid = msgid;
+        _stats[kept].minIntervalMs = minIntervalMs;
+        ++kept;
+    }
+    _statsCount = kept;
+    _lastStats = 0;
+
+    framesForwarded = 0;
+    framesFiltered = 0;
+    framesUnchecked = 0;
+    framesBadCrc = 0;
+    bytesForwarded = 0;
+    bytesDiscarded = 0;
+    framesUntracked = 0;
+}
+
+void MAVLinkFramer::updateRates(uint32_t now)
+{
+    uint32_t const elapsed = now - _windowStartMs;
+    if (elapsed < 1000)
+        return;
+
+    for (uint8_t i = 0; i < _statsCount; ++i)
+    {
+        _stats[i].rateHz = (uint32_t)_stats[i].windowFrames * 1000 / elapsed;
+        _stats[i].windowFrames = 0;
+    }
+    _windowStartMs = now;
+}
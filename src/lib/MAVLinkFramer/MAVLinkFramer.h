@@ -0,0 +1,204 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#define MAVLINK_STX_V1 0xFE
+#define MAVLINK_STX_V2 0xFD
+
+#define MAVLINK_V1_HEADER_LEN 6  // STX, len, seq, sysid, compid, msgid
+#define MAVLINK_V2_HEADER_LEN 10 // STX, len, incompat, compat, seq, sysid, compid, msgid x3
+#define MAVLINK_CRC_LEN 2
+#define MAVLINK_SIGNATURE_LEN 13
+
+#define MAVLINK_IFLAG_SIGNED 0x01
+
+// Largest frame: v2 header (10) + payload (255) + CRC (2) + signature (13)
+#define MAVLINK_FRAMER_MAX_FRAME_LEN 280
+
+// Working buffer, must hold at least one complete frame
+#if !defined(MAVLINK_FRAMER_BUF_LEN)
+#define MAVLINK_FRAMER_BUF_LEN 512
+#endif
+static_assert(MAVLINK_FRAMER_BUF_LEN >= MAVLINK_FRAMER_MAX_FRAME_LEN, "MAVLink framer buffer must hold a complete frame");
+
+// Number of message IDs statistics are kept for, the rest only count towards framesUntracked
+#if !defined(MAVLINK_FRAMER_MAX_MSG_IDS)
+#define MAVLINK_FRAMER_MAX_MSG_IDS 32
+#endif
+
+// minIntervalMs which drops every frame of a message
+#define MAVLINK_FILTER_DROP 0xFFFF
+
+/**
+ * @brief Look up the CRC_EXTRA seed of a message
+ * @return false if the message is not known, its CRC can not be checked
+ */
+typedef bool (*mavlink_crc_extra_fn)(uint32_t msgid, uint8_t *crcExtra);
+
+typedef struct {
+    uint32_t msgid;
+    uint16_t minIntervalMs; // filter, 0 forwards every frame, MAVLINK_FILTER_DROP forwards none
+} mavlink_filter_t;
+
+typedef struct {
+    uint32_t msgid;
+    uint32_t frames;        // valid frames seen
+    uint32_t bytes;         // total length of the valid frames
+    uint32_t dropped;       // frames not forwarded because of the filter
+    uint16_t rateHz;        // frames in the last complete second
+    uint16_t windowFrames;  // frames so far in the current second
+    uint16_t minIntervalMs; // see mavlink_filter_t
+    uint32_t lastForwardMs;
+} mavlink_msg_stats_t;
+
+// Header fields of a frame passed on by MAVLinkFramer
+inline uint32_t mavlinkFrameMsgId(const uint8_t *frame)
+{
+    if (frame[0] == MAVLINK_STX_V2)
+        return frame[7] | (frame[8] << 8) | ((uint32_t)frame[9] << 16);
+    return frame[5];
+}
+inline uint16_t mavlinkFrameLen(const uint8_t *frame)
+{
+    if (frame[0] == MAVLINK_STX_V2)
+        return MAVLINK_V2_HEADER_LEN + frame[1] + MAVLINK_CRC_LEN + ((frame[2] & MAVLINK_IFLAG_SIGNED) ? MAVLINK_SIGNATURE_LEN : 0);
+    return MAVLINK_V1_HEADER_LEN + frame[1] + MAVLINK_CRC_LEN;
+}
+inline uint8_t mavlinkFrameSysId(const uint8_t *frame) { return frame[0] == MAVLINK_STX_V2 ? frame[5] : frame[3]; }
+inline uint8_t mavlinkFrameCompId(const uint8_t *frame) { return frame[0] == MAVLINK_STX_V2 ? frame[6] : frame[4]; }
+
+/**
+ * Splits a stream of bytes into MAVLink v1/v2 frames without decoding them
+ *
+ * Bytes are appended to the framer's buffer and frames are validated where
+ * they are (STX, length, and CRC including the message's CRC_EXTRA) then the
+ * original bytes are passed on, so a frame is never decoded into a
+ * mavlink_message_t and encoded again. Consecutive frames that are forwarded
+ * are passed on as one block. Bytes between frames and frames with a bad CRC
+ * are discarded. Frames of messages whose CRC_EXTRA isn't known can't be
+ * checked, they are forwarded as they are if they follow on directly from a
+ * good frame, as the far end may know them.
+ *
+ * Per message ID frame counts, sizes and rates are kept, and any message can
+ * be decimated to a minimum interval or dropped entirely.
+ */
+class MAVLinkFramer
+{
+public:
+    explicit MAVLinkFramer(mavlink_crc_extra_fn crcExtra) : _crcExtra(crcExtra) {}
+
+    /**
+     * @brief Space available in the buffer, at least MAVLINK_FRAMER_BUF_LEN - MAVLINK_FRAMER_MAX_FRAME_LEN after process()
+     */
+    uint16_t space() const { return MAVLINK_FRAMER_BUF_LEN - _len; }
+
+    /**
+     * @brief Bytes held waiting for the rest of their frame
+     */
+    uint16_t pending() const { return _len; }
+
+    /**
+     * @brief Where to write up to space() new bytes, call commit() once written
+     */
+    uint8_t *writePtr() { return &_buf[_len]; }
+    void commit(uint16_t len) { _len += len; }
+
+    /**
+     * @brief Append up to space() bytes
+     * @return number of bytes taken
+     */
+    uint16_t append(const uint8_t *data, uint16_t len)
+    {
+        if (len > space())
+            len = space();
+        memcpy(writePtr(), data, len);
+        commit(len);
+        return len;
+    }
+
+    /**
+     * @brief Pass every complete frame in the buffer to forward(const uint8_t *data, uint16_t len),
+     * keeping any incomplete frame at the end for the next call
+     * @param now current time in ms, for the statistics and filters
+     */
+    template <typename F>
+    void process(uint32_t now, F forward)
+    {
+        updateRates(now);
+
+        uint16_t pos = 0;
+        uint16_t runStart = 0;
+        uint16_t runLen = 0;
+        uint16_t frameStart;
+        uint16_t frameLen;
+        framer_result_e result;
+        while ((result = nextFrame(pos, frameStart, frameLen, now)) != FRAMER_NEED_MORE)
+        {
+            if (result == FRAMER_FORWARD && runLen && runStart + runLen == frameStart)
+            {
+                runLen += frameLen;
+                continue;
+            }
+            if (runLen)
+                forward(&_buf[runStart], runLen);
+            runLen = 0;
+            if (result == FRAMER_FORWARD)
+            {
+                runStart = frameStart;
+                runLen = frameLen;
+            }
+        }
+        if (runLen)
+            forward(&_buf[runStart], runLen);
+
+        // Keep the start of an incomplete frame
+        _len -= pos;
+        memmove(_buf, &_buf[pos], _len);
+    }
+
+    /**
+     * @brief Forward a message at most once every minIntervalMs, MAVLINK_FILTER_DROP to drop it entirely
+     * @return false if there is no room left for the message's statistics
+     */
+    bool setFilter(uint32_t msgid, uint16_t minIntervalMs);
+    void setFilters(const mavlink_filter_t *filters, uint8_t count);
+
+    /**
+     * @brief Statistics of a message, nullptr if it has not been seen or filtered
+     */
+    const mavlink_msg_stats_t *getStats(uint32_t msgid) const;
+    const mavlink_msg_stats_t *getStats() const { return _stats; }
+    uint8_t getStatsCount() const { return _statsCount; }
+    void resetStats();
+
+    // Totals
+    uint32_t framesForwarded = 0;
+    uint32_t framesFiltered = 0;
+    uint32_t framesUnchecked = 0; // forwarded without a CRC check, CRC_EXTRA unknown
+    uint32_t framesBadCrc = 0;
+    uint32_t bytesForwarded = 0;
+    uint32_t bytesDiscarded = 0;  // not part of a valid frame
+    uint32_t framesUntracked = 0; // valid frames with no room for statistics
+
+private:
+    typedef enum {
+        FRAMER_NEED_MORE,
+        FRAMER_FORWARD,
+        FRAMER_FILTERED,
+    } framer_result_e;
+
+    framer_result_e nextFrame(uint16_t &pos, uint16_t &frameStart, uint16_t &frameLen, uint32_t now);
+    mavlink_msg_stats_t *findStats(uint32_t msgid, bool create);
+    void updateRates(uint32_t now);
+
+    const mavlink_crc_extra_fn _crcExtra;
+    uint8_t _buf[MAVLINK_FRAMER_BUF_LEN];
+    uint16_t _len = 0;
+    bool _synced = false; // the next byte follows on from a good frame
+
+    mavlink_msg_stats_t _stats[MAVLINK_FRAMER_MAX_MSG_IDS];
+    uint8_t _statsCount = 0;
+    uint8_t _lastStats = 0;
+    uint32_t _windowStartMs = 0;
+};
@@ -0,0 +1,347 @@
+#include "MAVLinkScheduler.h"
+
+#include <string.h>
+
+typedef struct {
+    uint32_t msgid;
+    mavlink_prio_e prio;
+} mavlink_prio_entry_t;
+
+// Anything not listed is MAVLINK_PRIO_NORMAL
+static const mavlink_prio_entry_t mavlinkPriorities[] = {
+    {0, MAVLINK_PRIO_HIGH},     // HEARTBEAT
+    {1, MAVLINK_PRIO_STATE},    // SYS_STATUS
+    {2, MAVLINK_PRIO_STATE},    // SYSTEM_TIME
+    {11, MAVLINK_PRIO_HIGH},    // SET_MODE
+    {20, MAVLINK_PRIO_BULK},    // PARAM_REQUEST_READ
+    {21, MAVLINK_PRIO_BULK},    // PARAM_REQUEST_LIST
+    {22, MAVLINK_PRIO_BULK},    // PARAM_VALUE
+    {23, MAVLINK_PRIO_BULK},    // PARAM_SET
+    {24, MAVLINK_PRIO_STATE},   // GPS_RAW_INT
+    {27, MAVLINK_PRIO_STATE},   // RAW_IMU
+    {29, MAVLINK_PRIO_STATE},   // SCALED_PRESSURE
+    {30, MAVLINK_PRIO_STATE},   // ATTITUDE
+    {33, MAVLINK_PRIO_STATE},   // GLOBAL_POSITION_INT
+    {36, MAVLINK_PRIO_STATE},   // SERVO_OUTPUT_RAW
+    {39, MAVLINK_PRIO_BULK},    // MISSION_ITEM
+    {40, MAVLINK_PRIO_BULK},    // MISSION_REQUEST
+    {42, MAVLINK_PRIO_STATE},   // MISSION_CURRENT
+    {43, MAVLINK_PRIO_BULK},    // MISSION_REQUEST_LIST
+    {44, MAVLINK_PRIO_BULK},    // MISSION_COUNT
+    {47, MAVLINK_PRIO_BULK},    // MISSION_ACK
+    {51, MAVLINK_PRIO_BULK},    // MISSION_REQUEST_INT
+    {62, MAVLINK_PRIO_STATE},   // NAV_CONTROLLER_OUTPUT
+    {65, MAVLINK_PRIO_STATE},   // RC_CHANNELS
+    {69, MAVLINK_PRIO_HIGH},    // MANUAL_CONTROL
+    {70, MAVLINK_PRIO_HIGH},    // RC_CHANNELS_OVERRIDE
+    {73, MAVLINK_PRIO_BULK},    // MISSION_ITEM_INT
+    {74, MAVLINK_PRIO_STATE},   // VFR_HUD
+    {75, MAVLINK_PRIO_HIGH},    // COMMAND_INT
+    {76, MAVLINK_PRIO_HIGH},    // COMMAND_LONG
+    {77, MAVLINK_PRIO_HIGH},    // COMMAND_ACK
+    {86, MAVLINK_PRIO_HIGH},    // SET_POSITION_TARGET_GLOBAL_INT
+    {109, MAVLINK_PRIO_HIGH},   // RADIO_STATUS
+    {110, MAVLINK_PRIO_BULK},   // FILE_TRANSFER_PROTOCOL
+    {117, MAVLINK_PRIO_BULK},   // LOG_REQUEST_LIST
+    {118, MAVLINK_PRIO_BULK},   // LOG_ENTRY
+    {119, MAVLINK_PRIO_BULK},   // LOG_REQUEST_DATA
+    {120, MAVLINK_PRIO_BULK},   // LOG_DATA
+    {125, MAVLINK_PRIO_STATE},  // POWER_STATUS
+    {136, MAVLINK_PRIO_STATE},  // TERRAIN_REPORT
+    {147, MAVLINK_PRIO_STATE},  // BATTERY_STATUS
+    {152, MAVLINK_PRIO_STATE},  // MEMINFO (ardupilotmega)
+    {160, MAVLINK_PRIO_BULK},   // FENCE_POINT (ardupilotmega)
+    {163, MAVLINK_PRIO_STATE},  // AHRS (ardupilotmega)
+    {165, MAVLINK_PRIO_STATE},  // HWSTATUS (ardupilotmega)
+    {175, MAVLINK_PRIO_BULK},   // RALLY_POINT (ardupilotmega)
+    {178, MAVLINK_PRIO_STATE},  // AHRS2 (ardupilotmega)
+    {193, MAVLINK_PRIO_STATE},  // EKF_STATUS_REPORT (ardupilotmega)
+    {241, MAVLINK_PRIO_STATE},  // VIBRATION
+    {242, MAVLINK_PRIO_STATE},  // HOME_POSITION
+    {245, MAVLINK_PRIO_STATE},  // EXTENDED_SYS_STATE
+    {253, MAVLINK_PRIO_HIGH},   // STATUSTEXT
+};
+
+static const uint8_t mavlinkWeights[MAVLINK_PRIO_COUNT] = {0, 4, 2, 1};
+
+mavlink_prio_e mavlinkPriority(uint32_t msgid)
+{
+    // Sorted by message ID
+    uint8_t first = 0;
+    uint8_t last = sizeof(mavlinkPriorities) / sizeof(mavlinkPriorities[0]);
+    while (first < last)
+    {
+        uint8_t const mid = (first + last) / 2;
+        if (mavlinkPriorities[mid].msgid < msgid)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    if (first < sizeof(mavlinkPriorities) / sizeof(mavlinkPriorities[0]) && mavlinkPriorities[first].msgid == msgid)
+        return mavlinkPriorities[first].prio;
+    return MAVLINK_PRIO_NORMAL;
+}
+
+void MAVLinkScheduler::clear()
+{
+    memset(_queues, 0, sizeof(_queues));
+    _sending = -1;
+    _sendOffset = 0;
+    memset(_deficit, 0, sizeof(_deficit));
+    _turn = MAVLINK_PRIO_STATE;
+    _deficit[_turn] = mavlinkWeights[_turn] * MAVLINK_SCHED_QUANTUM;
+}
+
+void MAVLinkScheduler::setLinkRate(uint32_t bytesPerSec)
+{
+    if (bytesPerSec == _rate)
+        return;
+    _rate = bytesPerSec;
+    // Deep enough for the largest frame, which has to go out in one go
+    uint32_t depth = bytesPerSec * MAVLINK_SCHED_BURST_MS / 1000;
+    if (depth < MAVLINK_FRAMER_MAX_FRAME_LEN)
+        depth = MAVLINK_FRAMER_MAX_FRAME_LEN;
+    _depth = depth * 1000;
+    if (_tokens > _depth)
+        _tokens = _depth;
+}
+
+void MAVLinkScheduler::copyIn(frame_queue_t &q, uint16_t offset, const uint8_t *data, uint16_t len)
+{
+    offset %= MAVLINK_SCHED_QUEUE_LEN;
+    uint16_t const first = (len < MAVLINK_SCHED_QUEUE_LEN - offset) ? len : MAVLINK_SCHED_QUEUE_LEN - offset;
+    memcpy(&q.bytes[offset], data, first);
+    memcpy(q.bytes, &data[first], len - first);
+}
+
+void MAVLinkScheduler::copyOut(const frame_queue_t &q, uint16_t offset, uint8_t *data, uint16_t len) const
+{
+    offset %= MAVLINK_SCHED_QUEUE_LEN;
+    uint16_t const first = (len < MAVLINK_SCHED_QUEUE_LEN - offset) ? len : MAVLINK_SCHED_QUEUE_LEN - offset;
+    memcpy(data, &q.bytes[offset], first);
+    memcpy(&data[first], q.bytes, len - first);
+}
+
+void MAVLinkScheduler::coalesce(frame_queue_t &q, const frame_entry_t &entry)
+{
+    // The frame being sent can't be touched
+    uint8_t const firstFree = (_sending == MAVLINK_PRIO_STATE) ? 1 : 0;
+    for (uint8_t i = firstFree; i < q.count; ++i)
+    {
+        frame_entry_t &queued = q.frames[(q.first + i) % MAVLINK_SCHED_QUEUE_FRAMES];
+        if (!queued.stale && queued.msgid == entry.msgid && queued.sysid == entry.sysid && queued.compid == entry.compid)
+        {
+            // There is only ever one of each queued, as each newer one drops the one before
+            queued.stale = true;
+            q.stale += queued.len;
+            ++q.stats.coalesced;
+            return;
+        }
+    }
+}
+
+bool MAVLinkScheduler::push(const uint8_t *frame, uint16_t len)
+{
+    frame_entry_t entry;
+    entry.msgid = mavlinkFrameMsgId(frame);
+    entry.len = len;
+    entry.sysid = mavlinkFrameSysId(frame);
+    entry.compid = mavlinkFrameCompId(frame);
+    entry.stale = false;
+
+    mavlink_prio_e const prio = mavlinkPriority(entry.msgid);
+    frame_queue_t &q = _queues[prio];
+    if (q.count == MAVLINK_SCHED_QUEUE_FRAMES || q.used + len > MAVLINK_SCHED_QUEUE_LEN)
+    {
+        // Any older frame of the same message is kept, it's the newest state there is room for
+        ++q.stats.dropped;
+        return false;
+    }
+
+    if (prio == MAVLINK_PRIO_STATE)
+    {
+        coalesce(q, entry);
+        if (_sending != prio)
+            popStale(q);
+    }
+
+    entry.start = (q.head + q.used) % MAVLINK_SCHED_QUEUE_LEN;
+    copyIn(q, entry.start, frame, len);
+    q.frames[(q.first + q.count) % MAVLINK_SCHED_QUEUE_FRAMES] = entry;
+    ++q.count;
+    q.used += len;
+    ++q.stats.frames;
+    return true;
+}
+
+void MAVLinkScheduler::popFrame(frame_queue_t &q)
+{
+    frame_entry_t const &entry = q.frames[q.first];
+    q.head = (q.head + entry.len) % MAVLINK_SCHED_QUEUE_LEN;
+    q.used -= entry.len;
+    q.first = (q.first + 1) % MAVLINK_SCHED_QUEUE_FRAMES;
+    --q.count;
+}
+
+void MAVLinkScheduler::popStale(frame_queue_t &q)
+{
+    while (q.count > 0 && q.frames[q.first].stale)
+    {
+        q.stale -= q.frames[q.first].len;
+        popFrame(q);
+    }
+}
+
+int8_t MAVLinkScheduler::nextClass()
+{
+    if (_queues[MAVLINK_PRIO_HIGH].count > 0)
+        return MAVLINK_PRIO_HIGH;
+
+    bool waiting = false;
+    for (int8_t prio = MAVLINK_PRIO_HIGH + 1; prio < MAVLINK_PRIO_COUNT; ++prio)
+        waiting |= _queues[prio].count > 0;
+    if (!waiting)
+        return -1;
+
+    // Every round each waiting class gets its quantum, so this ends within a few rounds
+    // even for the largest frame in the class with the smallest weight
+    while (true)
+    {
+        frame_queue_t &q = _queues[_turn];
+        if (q.count == 0)
+            _deficit[_turn] = 0;
+        else if (q.frames[q.first].len <= _deficit[_turn])
+            return _turn;
+
+        _turn = (_turn + 1 < MAVLINK_PRIO_COUNT) ? _turn + 1 : MAVLINK_PRIO_HIGH + 1;
+        if (_queues[_turn].count > 0)
+            _deficit[_turn] += mavlinkWeights[_turn] * MAVLINK_SCHED_QUANTUM;
+    }
+}
+
+uint32_t MAVLinkScheduler::refill(uint32_t now)
+{
+    if (_rate == 0)
+        return UINT32_MAX;
+
+    uint32_t const elapsed = now - _lastRefillMs;
+    _lastRefillMs = now;
+    // elapsed is limited so the multiply can't overflow, the bucket is full long before
+    _tokens += ((elapsed < 60000) ? elapsed : 60000) * _rate;
+    if (_tokens > _depth)
+        _tokens = _depth;
+    return _tokens / 1000;
+}
+
+uint16_t MAVLinkScheduler::pop(uint8_t *buf, uint16_t maxLen, uint32_t now)
+{
+    uint32_t budget = refill(now);
+    uint16_t out = 0;
+
+    while (out < maxLen)
+    {
+        uint16_t const space = maxLen - out;
+        uint16_t n;
+        if (_sending >= 0)
+        {
+            // Finish the frame that was split
+            frame_queue_t &q = _queues[_sending];
+            frame_entry_t const &entry = q.frames[q.first];
+            n = entry.len - _sendOffset;
+            if (n > space)
+                n = space;
+            if (n > budget)
+                n = budget;
+            if (n == 0)
+                break;
+            copyOut(q, entry.start + _sendOffset, &buf[out], n);
+            _sendOffset += n;
+            if (_sendOffset == entry.len)
+            {
+                popFrame(q);
+                popStale(q);
+                _sending = -1;
+            }
+        }
+        else
+        {
+            int8_t const prio = nextClass();
+            if (prio < 0)
+                break;
+            // Keep half the burst for everything but bulk
+            if (prio == MAVLINK_PRIO_BULK && _rate != 0 && _tokens < _depth / 2)
+                break;
+
+            frame_queue_t &q = _queues[prio];
+            frame_entry_t const &entry = q.frames[q.first];
+            if (entry.len <= space && entry.len <= budget)
+            {
+                n = entry.len;
+                copyOut(q, entry.start, &buf[out], n);
+                if (prio != MAVLINK_PRIO_HIGH)
+                    _deficit[prio] -= entry.len;
+                popFrame(q);
+                popStale(q);
+            }
+            else if (entry.len > maxLen && out == 0 && budget >= maxLen)
+            {
+                // Too big to ever fit, split it over as many outputs as it takes
+                n = maxLen;
+                copyOut(q, entry.start, &buf[out], n);
+                if (prio != MAVLINK_PRIO_HIGH)
+                    _deficit[prio] -= entry.len;
+                _sending = prio;
+                _sendOffset = n;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        out += n;
+        budget -= n;
+        if (_rate != 0)
+            _tokens -= n * 1000;
+    }
+    return out;
+}
+
+uint16_t MAVLinkScheduler::size() const
+{
+    uint16_t used = 0;
+    for (const frame_queue_t &q : _queues)
+        used += q.used - q.stale;
+    return used - ((_sending >= 0) ? _sendOffset : 0);
+}
+
+uint8_t MAVLinkScheduler::fillPercent() const
+{
+    uint16_t used = 0;
+    for (const frame_queue_t &q : _queues)
+    {
+        uint16_t const bytes = (uint32_t)q.used * 100 / MAVLINK_SCHED_QUEUE_LEN;
+        uint16_t const frames = (uint16_t)q.count * 100 / MAVLINK_SCHED_QUEUE_FRAMES;
+        if (bytes > used)
+            used = bytes;
+        if (frames > used)
+            used = frames;
+    }
+    return used;
+}
+
+uint32_t MAVLinkScheduler::totalDropped() const
+{
+    uint32_t dropped = 0;
+    for (const frame_queue_t &q : _queues)
+        dropped += q.stats.dropped;
+    return dropped;
+}
+
+uint32_t MAVLinkScheduler::totalCoalesced() const
+{
+    uint32_t coalesced = 0;
+    for (const frame_queue_t &q : _queues)
+        coalesced += q.stats.coalesced;
+    return coalesced;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <stdint.h>
+#include "MAVLinkFramer.h"
+
+// Bytes of frames each priority class can hold
+#if !defined(MAVLINK_SCHED_QUEUE_LEN)
+#define MAVLINK_SCHED_QUEUE_LEN 320
+#endif
+static_assert(MAVLINK_SCHED_QUEUE_LEN >= MAVLINK_FRAMER_MAX_FRAME_LEN, "MAVLink scheduler queues must hold a complete frame");
+// Frames each priority class can hold
+#if !defined(MAVLINK_SCHED_QUEUE_FRAMES)
+#define MAVLINK_SCHED_QUEUE_FRAMES 12
+#endif
+// The token bucket holds this much of the link rate, so short bursts go out back to back
+#define MAVLINK_SCHED_BURST_MS 250
+// Bytes each round of the classes below high priority gets, multiplied by its weight
+#define MAVLINK_SCHED_QUANTUM 64
+
+typedef enum {
+    MAVLINK_PRIO_HIGH,   // heartbeats, commands and acks, status text
+    MAVLINK_PRIO_STATE,  // periodic vehicle state, a newer frame replaces a queued one (weight 4)
+    MAVLINK_PRIO_NORMAL, // anything not listed (weight 2)
+    MAVLINK_PRIO_BULK,   // parameters, missions, FTP and logs (weight 1)
+    MAVLINK_PRIO_COUNT
+} mavlink_prio_e;
+
+typedef struct {
+    uint32_t frames;    // frames queued
+    uint32_t coalesced; // queued frames dropped for a newer one of the same message
+    uint32_t dropped;   // frames dropped because the queue was full
+} mavlink_prio_stats_t;
+
+/**
+ * @brief Priority class of a message
+ */
+mavlink_prio_e mavlinkPriority(uint32_t msgid);
+
+/**
+ * Queues complete MAVLink frames by priority class and releases them at the
+ * rate the ELRS link can carry them.
+ *
+ * High priority frames always go first. The other classes share what is
+ * left by deficit round robin, each round a class can send
+ * MAVLINK_SCHED_QUANTUM times its weight in bytes, so state arriving faster
+ * than the link can carry it can't hold up parameter and mission downloads.
+ * When a newer frame of a queued state message from the same component
+ * arrives, the queued one is dropped and the newer one goes to the back, so
+ * a backlog never holds stale vehicle state and frames from each component
+ * still go out in the order they were sent. Output is shaped by
+ * a token bucket filled at the link rate, so the backlog stays here where it
+ * can be prioritised instead of behind a payload already given to the
+ * StubbornSender, and bulk frames are held back while the bucket is less
+ * than half full so they can't use up the burst the other classes need.
+ * Frames are output whole, only frames longer than the output are split.
+ */
+class MAVLinkScheduler
+{
+public:
+    MAVLinkScheduler() : _rate(0), _tokens(0), _depth(0), _lastRefillMs(0) { clear(); }
+
+    /**
+     * @brief Set the rate the link carries MAVLink at, 0 for no shaping
+     */
+    void setLinkRate(uint32_t bytesPerSec);
+    uint32_t getLinkRate() const { return _rate; }
+
+    /**
+     * @brief Queue a complete, validated frame
+     * @return false if it was dropped because its class is full
+     */
+    bool push(const uint8_t *frame, uint16_t len);
+
+    /**
+     * @brief Queue a block of consecutive frames as forwarded by MAVLinkFramer
+     */
+    void pushFrames(const uint8_t *data, uint16_t len)
+    {
+        while (len > 0)
+        {
+            uint16_t const frameLen = mavlinkFrameLen(data);
+            push(data, frameLen);
+            data += frameLen;
+            len -= frameLen;
+        }
+    }
+
+    /**
+     * @brief Fill buf with up to maxLen bytes of the next frames to send
+     * @return number of bytes
+     */
+    uint16_t pop(uint8_t *buf, uint16_t maxLen, uint32_t now);
+
+    /**
+     * @brief Empty the queues and reset their statistics, the link rate is kept
+     */
+    void clear();
+
+    /**
+     * @brief Bytes waiting to be sent
+     */
+    uint16_t size() const;
+
+    /**
+     * @brief Percentage of the queues in use, highest of any class
+     */
+    uint8_t fillPercent() const;
+
+    const mavlink_prio_stats_t &getStats(mavlink_prio_e prio) const { return _queues[prio].stats; }
+    uint32_t totalDropped() const;
+    uint32_t totalCoalesced() const;
+
+private:
+    typedef struct {
+        uint32_t msgid;
+        uint16_t len;
+        uint16_t start; // offset in the queue's bytes
+        uint8_t sysid;
+        uint8_t compid;
+        bool stale;     // dropped for a newer frame, its bytes are freed when it reaches the front
+    } frame_entry_t;
+
+    typedef struct {
+        uint8_t bytes[MAVLINK_SCHED_QUEUE_LEN];
+        frame_entry_t frames[MAVLINK_SCHED_QUEUE_FRAMES];
+        uint16_t head;  // first byte in use
+        uint16_t used;  // bytes in use
+        uint16_t stale; // bytes of stale frames
+        uint8_t first;  // first frame entry
+        uint8_t count;  // frame entries in use
+        mavlink_prio_stats_t stats;
+    } frame_queue_t;
+
+    void coalesce(frame_queue_t &q, const frame_entry_t &entry);
+    void copyIn(frame_queue_t &q, uint16_t offset, const uint8_t *data, uint16_t len);
+    void copyOut(const frame_queue_t &q, uint16_t offset, uint8_t *data, uint16_t len) const;
+    void popFrame(frame_queue_t &q);
+    void popStale(frame_queue_t &q);
+    int8_t nextClass();
+    uint32_t refill(uint32_t now);
+
+    frame_queue_t _queues[MAVLINK_PRIO_COUNT];
+
+    // Frame partly output, it has to be finished before any other
+    int8_t _sending;
+    uint16_t _sendOffset;
+
+    // Deficit round robin over the classes after MAVLINK_PRIO_HIGH
+    int8_t _turn;
+    uint16_t _deficit[MAVLINK_PRIO_COUNT];
+
+    uint32_t _rate;         // bytes per second, 0 for no shaping
+    uint32_t _tokens;       // in 1/1000 bytes
+    uint32_t _depth;        // in 1/1000 bytes
+    uint32_t _lastRefillMs;
+};
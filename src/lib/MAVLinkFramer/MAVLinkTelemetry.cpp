@@ -0,0 +1,223 @@
+#include "MAVLinkTelemetry.h"
+#include "CRSF.h"
+
+#define MAVLINK_COMP_ID_AUTOPILOT1 1
+#define MAVLINK_MODE_FLAG_SAFETY_ARMED 0x80
+
+static bool buildFlightMode(const int32_t *values, uint8_t *payload, mavlink_tlm_state_t &state)
+{
+    crsf_flight_mode_t *crsffm = (crsf_flight_mode_t *)payload;
+    state.flightMode(crsffm->flight_mode, values[1], (uint32_t)values[0]);
+    // if we have a good flight mode, and we're armed, suffix the flight mode with a * - see Ardupilot's AP_CRSF_Telem::calc_flight_mode()
+    size_t len = strnlen(crsffm->flight_mode, sizeof(crsffm->flight_mode));
+    if (len > 0 && (len + 1 < sizeof(crsffm->flight_mode)) && (values[2] & MAVLINK_MODE_FLAG_SAFETY_ARMED))
+    {
+        crsffm->flight_mode[len] = '*';
+        crsffm->flight_mode[len + 1] = '\0';
+    }
+    return true;
+}
+
+static bool buildGps(const int32_t *values, uint8_t *payload, mavlink_tlm_state_t &state)
+{
+    crsf_sensor_gps_t *crsfgps = (crsf_sensor_gps_t *)payload;
+    crsfgps->latitude = htobe32(values[0]);
+    crsfgps->longitude = htobe32(values[1]);
+// We use altitude relative to home for GPS altitude, by default, but we can also use GPS altitude if USE_MAVLINK_GPS_ALTITUDE is defined
+#if defined(USE_MAVLINK_GPS_ALTITUDE)
+    // mm -> meters + 1000
+    crsfgps->altitude = htobe16(values[2] / 1000 + 1000);
+#else
+    crsfgps->altitude = htobe16((uint16_t)(state.relativeAltMm / 1000 + 1000));
+#endif
+    // cm/s -> km/h / 10
+    crsfgps->groundspeed = htobe16(values[3] * 36 / 100);
+    crsfgps->gps_heading = htobe16(values[4]);
+    crsfgps->satellites_in_use = values[5];
+    return true;
+}
+
+static bool buildAttitude(const int32_t *values, uint8_t *payload, mavlink_tlm_state_t &state)
+{
+    crsf_sensor_attitude_t *crsfatt = (crsf_sensor_attitude_t *)payload;
+    crsfatt->roll = htobe16((int16_t)values[0]);
+    crsfatt->pitch = htobe16((int16_t)values[1]); // in Betaflight & INAV, CRSF positive pitch is nose down, but in Ardupilot, it's nose up - we follow Ardupilot
+    crsfatt->yaw = htobe16((int16_t)values[2]);
+    return true;
+}
+
+static bool buildVario(const int32_t *values, uint8_t *payload, mavlink_tlm_state_t &state)
+{
+    crsf_sensor_vario_t *crsfvario = (crsf_sensor_vario_t *)payload;
+    // store relative altitude for GPS Alt so we don't have 2 Alt sensors
+    state.relativeAltMm = values[0];
+    crsfvario->verticalspd = htobe16(-values[1]); // MAVLink vz is positive down
+    return true;
+}
+
+static bool buildBattery(const int32_t *values, uint8_t *payload, mavlink_tlm_state_t &state)
+{
+    if (values[3] != 0)
+        return false;
+    crsf_sensor_battery_t *crsfbatt = (crsf_sensor_battery_t *)payload;
+    // mV -> mv*100
+    crsfbatt->voltage = htobe16(values[1] / 100);
+    // cA -> mA*100
+    crsfbatt->current = htobe16(values[2] / 10);
+    // mAh, 24 bits big endian
+    crsfbatt->capacity = htobe32(values[0]) >> 8;
+    crsfbatt->remaining = values[4];
+    return true;
+}
+
+// Sorted by message ID, the offsets are from the MAVLink common dialect
+static constexpr mavlink_tlm_map_t tlmMap[] = {
+    {0, CRSF_FRAMETYPE_FLIGHT_MODE, sizeof(crsf_flight_mode_t), buildFlightMode, 3, { // HEARTBEAT
+        {0, MAVLINK_TLM_FIELD_U32, 0},  // custom_mode
+        {4, MAVLINK_TLM_FIELD_U8, 0},   // type
+        {6, MAVLINK_TLM_FIELD_U8, 0},   // base_mode
+    }},
+    {24, CRSF_FRAMETYPE_GPS, sizeof(crsf_sensor_gps_t), buildGps, 6, { // GPS_RAW_INT
+        {8, MAVLINK_TLM_FIELD_I32, 0},  // lat
+        {12, MAVLINK_TLM_FIELD_I32, 0}, // lon
+        {16, MAVLINK_TLM_FIELD_I32, 0}, // alt
+        {24, MAVLINK_TLM_FIELD_U16, 0}, // vel
+        {26, MAVLINK_TLM_FIELD_U16, 0}, // cog
+        {29, MAVLINK_TLM_FIELD_U8, 0},  // satellites_visible
+    }},
+    {30, CRSF_FRAMETYPE_ATTITUDE, sizeof(crsf_sensor_attitude_t), buildAttitude, 3, { // ATTITUDE
+        {4, MAVLINK_TLM_FIELD_F32, 10000}, // roll
+        {8, MAVLINK_TLM_FIELD_F32, 10000}, // pitch
+        {12, MAVLINK_TLM_FIELD_F32, 10000}, // yaw
+    }},
+    {33, CRSF_FRAMETYPE_VARIO, sizeof(crsf_sensor_vario_t), buildVario, 2, { // GLOBAL_POSITION_INT
+        {16, MAVLINK_TLM_FIELD_I32, 0}, // relative_alt
+        {24, MAVLINK_TLM_FIELD_I16, 0}, // vz
+    }},
+    {147, CRSF_FRAMETYPE_BATTERY_SENSOR, sizeof(crsf_sensor_battery_t), buildBattery, 5, { // BATTERY_STATUS
+        {0, MAVLINK_TLM_FIELD_I32, 0},  // current_consumed
+        {10, MAVLINK_TLM_FIELD_U16, 0}, // voltages[0]
+        {30, MAVLINK_TLM_FIELD_I16, 0}, // current_battery
+        {32, MAVLINK_TLM_FIELD_U8, 0},  // id
+        {35, MAVLINK_TLM_FIELD_I8, 0},  // battery_remaining
+    }},
+};
+
+#define TLM_MAP_COUNT (sizeof(tlmMap) / sizeof(tlmMap[0]))
+
+static constexpr bool tlmMapSorted(unsigned i)
+{
+    return i + 1 >= TLM_MAP_COUNT || (tlmMap[i].msgid < tlmMap[i + 1].msgid && tlmMapSorted(i + 1));
+}
+static_assert(tlmMapSorted(0), "MAVLink telemetry map must be sorted by message ID");
+static_assert(TLM_MAP_COUNT <= MAVLINK_TLM_MAX_ENTRIES, "MAVLink telemetry map has too many entries");
+
+static int32_t readField(const uint8_t *payload, uint8_t len, const mavlink_tlm_field_t &field)
+{
+    static const uint8_t fieldSizes[] = {1, 1, 2, 2, 4, 4, 4};
+
+    // MAVLink2 trims trailing zeros from the payload, anything past the end is zero
+    uint8_t raw[4] = {0};
+    if (field.offset < len)
+    {
+        uint8_t size = fieldSizes[field.type];
+        if (size > len - field.offset)
+            size = len - field.offset;
+        memcpy(raw, &payload[field.offset], size);
+    }
+
+    uint32_t const value = raw[0] | (raw[1] << 8) | (raw[2] << 16) | ((uint32_t)raw[3] << 24);
+    switch (field.type)
+    {
+    case MAVLINK_TLM_FIELD_I8:
+        return (int8_t)value;
+    case MAVLINK_TLM_FIELD_I16:
+        return (int16_t)value;
+    case MAVLINK_TLM_FIELD_F32: {
+        float f;
+        memcpy(&f, &value, sizeof(f));
+        return (int32_t)(f * field.scale);
+    }
+    default:
+        return (int32_t)value;
+    }
+}
+
+static int8_t findEntry(uint32_t msgid)
+{
+    uint8_t first = 0;
+    uint8_t last = TLM_MAP_COUNT;
+    while (first < last)
+    {
+        uint8_t const mid = (first + last) / 2;
+        if (tlmMap[mid].msgid < msgid)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    if (first < TLM_MAP_COUNT && tlmMap[first].msgid == msgid)
+        return first;
+    return -1;
+}
+
+MAVLinkTelemetry::MAVLinkTelemetry(mavlink_flight_mode_fn flightMode)
+{
+    _state.relativeAltMm = 0;
+    _state.flightMode = flightMode;
+}
+
+void MAVLinkTelemetry::translate(const uint8_t *data, uint16_t len)
+{
+    while (len > 0)
+    {
+        uint16_t const frameLen = mavlinkFrameLen(data);
+        translateFrame(data);
+        data += frameLen;
+        len -= frameLen;
+    }
+}
+
+void MAVLinkTelemetry::translateFrame(const uint8_t *frame)
+{
+    // Only the autopilot's telemetry, not a GCS or companion computer's
+    if (mavlinkFrameCompId(frame) != MAVLINK_COMP_ID_AUTOPILOT1)
+        return;
+    int8_t const idx = findEntry(mavlinkFrameMsgId(frame));
+    if (idx < 0)
+        return;
+
+    const mavlink_tlm_map_t &entry = tlmMap[idx];
+    const uint8_t *payload = &frame[(frame[0] == MAVLINK_STX_V2) ? MAVLINK_V2_HEADER_LEN : MAVLINK_V1_HEADER_LEN];
+    int32_t values[MAVLINK_TLM_MAX_FIELDS];
+    for (uint8_t i = 0; i < entry.fieldCount; ++i)
+        values[i] = readField(payload, frame[1], entry.fields[i]);
+
+    uint8_t crsf[MAVLINK_TLM_MAX_CRSF_LEN] = {0};
+    if (!entry.build(values, &crsf[sizeof(crsf_header_t)], _state))
+        return;
+    CRSF::SetHeaderAndCrc(crsf, entry.crsfType, CRSF_FRAME_SIZE(entry.crsfPayloadLen), CRSF_ADDRESS_CRSF_TRANSMITTER);
+    ++framesTranslated;
+
+    // Only the newest of each goes to the handset
+    if (_pending & (1 << idx))
+        ++crsfSuperseded;
+    memcpy(_frames[idx], crsf, sizeof(crsf));
+    _pending |= 1 << idx;
+}
+
+uint16_t MAVLinkTelemetry::flush(uint8_t *buf, uint16_t maxLen)
+{
+    uint16_t len = 0;
+    for (uint8_t idx = 0; idx < TLM_MAP_COUNT; ++idx)
+    {
+        if ((_pending & (1 << idx)) == 0)
+            continue;
+        uint8_t const frameLen = CRSF_FRAME_NOT_COUNTED_BYTES + _frames[idx][CRSF_TELEMETRY_LENGTH_INDEX];
+        if (len + frameLen > maxLen)
+            continue;
+        memcpy(&buf[len], _frames[idx], frameLen);
+        len += frameLen;
+        _pending &= ~(1 << idx);
+    }
+    return len;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include "MAVLinkFramer.h"
+#include "crsf_protocol.h"
+
+// Most fields any message in the map decodes
+#define MAVLINK_TLM_MAX_FIELDS 6
+// Most messages the map can hold
+#define MAVLINK_TLM_MAX_ENTRIES 8
+// Largest CRSF frame the map builds, a flight mode
+#define MAVLINK_TLM_MAX_CRSF_LEN (CRSF_FRAME_NOT_COUNTED_BYTES + CRSF_FRAME_SIZE(sizeof(crsf_flight_mode_t)))
+
+typedef enum : uint8_t {
+    MAVLINK_TLM_FIELD_U8,
+    MAVLINK_TLM_FIELD_I8,
+    MAVLINK_TLM_FIELD_U16,
+    MAVLINK_TLM_FIELD_I16,
+    MAVLINK_TLM_FIELD_U32,
+    MAVLINK_TLM_FIELD_I32,
+    MAVLINK_TLM_FIELD_F32, // multiplied by scale then truncated
+} mavlink_tlm_field_e;
+
+typedef struct {
+    uint8_t offset; // in the payload, MAVLink orders fields by size so this is fixed per message
+    mavlink_tlm_field_e type;
+    uint16_t scale; // F32 only
+} mavlink_tlm_field_t;
+
+/**
+ * @brief Name the ArduPilot flight mode of a vehicle
+ * @param name at least 16 characters, empty if the mode is not known
+ */
+typedef void (*mavlink_flight_mode_fn)(char *name, uint8_t mavType, uint32_t customMode);
+
+// Carried from one message to another
+typedef struct {
+    int32_t relativeAltMm; // GLOBAL_POSITION_INT, used as the GPS altitude
+    mavlink_flight_mode_fn flightMode;
+} mavlink_tlm_state_t;
+
+/**
+ * @brief Fill in a CRSF payload from the decoded fields of a message
+ * @return false if nothing should be sent
+ */
+typedef bool (*mavlink_tlm_build_fn)(const int32_t *values, uint8_t *payload, mavlink_tlm_state_t &state);
+
+typedef struct {
+    uint32_t msgid;
+    crsf_frame_type_e crsfType;
+    uint8_t crsfPayloadLen;
+    mavlink_tlm_build_fn build;
+    uint8_t fieldCount;
+    mavlink_tlm_field_t fields[MAVLINK_TLM_MAX_FIELDS];
+} mavlink_tlm_map_t;
+
+/**
+ * Converts MAVLink telemetry from the autopilot to CRSF telemetry for the handset
+ *
+ * Works on the frames passed on by a MAVLinkFramer, so the stream is only
+ * framed and checked once. Each message the handset can show has an entry in
+ * a map built at compile time, listing where in the payload the fields it
+ * needs are, and a builder for the CRSF frame. Only those fields are decoded,
+ * straight from the payload. Converted frames are held, one per map entry
+ * with a newer one replacing an older one, until flush() hands them over
+ * back to back so the handset output is queued in one go.
+ */
+class MAVLinkTelemetry
+{
+public:
+    explicit MAVLinkTelemetry(mavlink_flight_mode_fn flightMode);
+
+    /**
+     * @brief Convert a block of consecutive frames, as forwarded by MAVLinkFramer
+     */
+    void translate(const uint8_t *data, uint16_t len);
+
+    /**
+     * @brief Copy the CRSF frames converted since the last flush to buf, one after the other
+     * @return number of bytes, frames that don't fit are left for the next call
+     */
+    uint16_t flush(uint8_t *buf, uint16_t maxLen);
+
+    uint32_t framesTranslated = 0; // MAVLink frames converted
+    uint32_t crsfSuperseded = 0;   // CRSF frames replaced by a newer one before being flushed
+
+private:
+    void translateFrame(const uint8_t *frame);
+
+    mavlink_tlm_state_t _state;
+    uint8_t _pending = 0; // bit per map entry
+    uint8_t _frames[MAVLINK_TLM_MAX_ENTRIES][MAVLINK_TLM_MAX_CRSF_LEN];
+};
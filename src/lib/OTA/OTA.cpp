@@ -571,38 +571,31 @@ void OtaUpdateSerializers(OtaSwitchMode_e const switchMode, uint8_t packetSize)
     OtaSwitchModeCurrent = switchMode;
 }
 
-void OtaPackAirportData(OTA_Packet_s * const otaPktPtr, FIFO<AP_MAX_BUF_LEN> *inputBuffer)
+void OtaPackAirportData(OTA_Packet_s * const otaPktPtr, AirPortLink *link)
 {
     otaPktPtr->std.type = PACKET_TYPE_TLM;
 
-    inputBuffer->lock();
-    uint8_t count = inputBuffer->size();
     if (OtaIsFullRes)
     {
-        count = std::min(count, (uint8_t)ELRS8_TELEMETRY_BYTES_PER_CALL);
-        otaPktPtr->full.airport.count = count;
-        inputBuffer->popBytes(otaPktPtr->full.airport.payload, count);
+        otaPktPtr->full.airport.count = link->pack(otaPktPtr->full.airport.payload, sizeof(otaPktPtr->full.airport.payload));
     }
     else
     {
-        count = std::min(count, (uint8_t)ELRS4_TELEMETRY_BYTES_PER_CALL);
-        otaPktPtr->std.airport.count = count;
-        inputBuffer->popBytes(otaPktPtr->std.airport.payload, count);
+        otaPktPtr->std.airport.count = link->pack(otaPktPtr->std.airport.payload, sizeof(otaPktPtr->std.airport.payload));
         otaPktPtr->std.airport.type = ELRS_TELEMETRY_TYPE_DATA;
     }
-    inputBuffer->unlock();
 }
 
-void OtaUnpackAirportData(OTA_Packet_s const * const otaPktPtr, FIFO<AP_MAX_BUF_LEN> *outputBuffer)
+void OtaUnpackAirportData(OTA_Packet_s const * const otaPktPtr, AirPortLink *link)
 {
     if (OtaIsFullRes)
     {
-        uint8_t count = otaPktPtr->full.airport.count;
-        outputBuffer->atomicPushBytes(otaPktPtr->full.airport.payload, count);
+        uint8_t count = std::min((uint8_t)otaPktPtr->full.airport.count, (uint8_t)sizeof(otaPktPtr->full.airport.payload));
+        link->unpack(otaPktPtr->full.airport.payload, count);
     }
     else
     {
-        uint8_t count = otaPktPtr->std.airport.count;
-        outputBuffer->atomicPushBytes(otaPktPtr->std.airport.payload, count);
+        uint8_t count = std::min((uint8_t)otaPktPtr->std.airport.count, (uint8_t)sizeof(otaPktPtr->std.airport.payload));
+        link->unpack(otaPktPtr->std.airport.payload, count);
     }
 }
@@ -8,6 +8,7 @@
 #include "crsf_protocol.h"
 #include "telemetry_protocol.h"
 #include "FIFO.h"
+#include "AirPortLink.h"
 
 #define OTA4_PACKET_SIZE     8U
 #define OTA4_CRC_CALC_LEN    offsetof(OTA_Packet4_s, crcLow)
@@ -125,7 +126,8 @@ typedef struct {
         struct {
             uint8_t packetType; // only low 2 bits
             OTA_Sync_s sync;
-            uint8_t free[4];
+            uint8_t tlmFeatures; // OTA_TLM_FEATURE_*, what the TX can take in the downlink
+            uint8_t free[3];
         } PACKED sync;
         /** PACKET_TYPE_TLM **/
         struct {
@@ -191,8 +193,8 @@ typedef bool (*UnpackChannelData_t)(OTA_Packet_s const * const otaPktPtr, uint32
 extern UnpackChannelData_t OtaUnpackChannelData;
 #endif
 
-void OtaPackAirportData(OTA_Packet_s * const otaPktPtr, FIFO<AP_MAX_BUF_LEN> *inputBuffer);
-void OtaUnpackAirportData(OTA_Packet_s const * const otaPktPtr, FIFO<AP_MAX_BUF_LEN> *outputBuffer);
+void OtaPackAirportData(OTA_Packet_s * const otaPktPtr, AirPortLink *link);
+void OtaUnpackAirportData(OTA_Packet_s const * const otaPktPtr, AirPortLink *link);
 
 #if defined(DEBUG_RCVR_LINKSTATS)
 extern uint32_t debugRcvrLinkstatsPacketId;
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <stdint.h>
+#include "targets.h"
+
+// Number of fractional bits in the frequency offset accumulator
+#define PLL_FREQ_FRAC_BITS 8
+// Proportional gain, as a power of two divisor of the phase error (1/4)
+#define PLL_KP_SHIFT 2
+// Proportional gain while acquiring, before the connection is established (1/2)
+#define PLL_KP_ACQUIRE_SHIFT 1
+// Integral gain, in PLL_FREQ_FRAC_BITS fixed point (4/256 = 1/64)
+#define PLL_KI 4
+// Phase errors larger than this are clamped before integrating, so a single
+// outlier (late packet, multipath) can not pull the frequency estimate
+#define PLL_MAX_INTEGRATED_ERROR 32
+// Maximum frequency offset the integrator can reach, in us per half period
+#define PLL_MAX_FREQ_OFFSET 32
+// Mean absolute phase error (us) that maps to a lock quality of 0
+#define PLL_QUALITY_SPAN 50
+// The drift estimate kept through a reset is averaged over 2^PLL_DRIFT_AVG_SHIFT packets
+// to filter out the integrator movement caused by packet timing jitter
+#define PLL_DRIFT_AVG_SHIFT 5
+// Minimum window (us) for a packet to be accepted as in step with the TX after coasting
+#define PLL_COAST_MIN_WINDOW 20
+// Drift (ppm) assumed to remain uncorrected by the drift estimate while coasting
+#define PLL_COAST_RESIDUAL_PPM 20
+
+/**
+ * @brief Second order (proportional + integral) loop filter for the RX phase lock
+ *
+ * The phase error measured by the PFD is fed into update() once per packet.
+ * The proportional term is returned as a one-time phase shift for hwTimer, and the
+ * integral term accumulates a fractional frequency offset, which is the measured
+ * crystal drift between the TX and the RX. nextFreqOffset() dithers the fractional
+ * offset onto the integer hwTimer frequency offset once per timer period, so drift
+ * smaller than one timer tick per period is still tracked without a limit cycle.
+ *
+ * The loop runs in microseconds, the same as the PFD, and only the frequency offset
+ * from nextFreqOffset() is in timer ticks, so the gains and limits are the same
+ * whatever the timer resolution.
+ *
+ * The drift estimate is kept through missed packets, and an averaged drift estimate
+ * can optionally be kept through a reset so the timer continues to track the TX
+ * during fades.
+ */
+class PLL
+{
+public:
+    /**
+     * @param ticksPerUs resolution of the hwTimer frequency offset, HWTIMER_TICKS_PER_US
+     */
+    explicit PLL(uint8_t ticksPerUs = 1) : ticksPerUs(ticksPerUs) {}
+
+    /**
+     * @brief Reset the loop state
+     * @param keepDrift true to continue from the averaged drift estimate, false to clear it
+     */
+    void reset(bool keepDrift)
+    {
+        freqAccum = keepDrift ? (driftAvg >> PLL_DRIFT_AVG_SHIFT) : 0;
+        driftAvg = freqAccum << PLL_DRIFT_AVG_SHIFT;
+        freqDither = 0;
+        phaseDither = 0;
+        jitterAvg = PLL_QUALITY_SPAN << 4;
+    }
+
+    /**
+     * @brief Set the timer interval, scaling the drift estimate if the interval changed
+     * as the drift is stored per timer period
+     */
+    void setInterval(uint32_t intervalUs)
+    {
+        if (interval != 0 && intervalUs != interval)
+        {
+            freqAccum = (int32_t)((int64_t)freqAccum * intervalUs / interval);
+            driftAvg = (int32_t)((int64_t)driftAvg * intervalUs / interval);
+        }
+        interval = intervalUs;
+    }
+
+    /**
+     * @brief Run the loop filter with a new phase error measurement
+     * @param phaseError PFD result (external - internal) in microseconds
+     * @param acquiring true if the connection is not established yet, only the
+     * proportional term is applied and the drift estimate is not updated
+     * @return the phase shift to apply to the timer in microseconds
+     */
+    int32_t ICACHE_RAM_ATTR update(int32_t phaseError, bool acquiring)
+    {
+        uint32_t absError = phaseError < 0 ? -phaseError : phaseError;
+        jitterAvg += ((int32_t)(absError << 4) - jitterAvg) >> 3;
+
+        if (acquiring)
+        {
+            return phaseError / (1 << PLL_KP_ACQUIRE_SHIFT);
+        }
+
+        int32_t const freqLimit = PLL_MAX_FREQ_OFFSET << PLL_FREQ_FRAC_BITS;
+        freqAccum += constrain(phaseError, -PLL_MAX_INTEGRATED_ERROR, PLL_MAX_INTEGRATED_ERROR) * PLL_KI;
+        freqAccum = constrain(freqAccum, -freqLimit, freqLimit);
+        driftAvg += freqAccum - (driftAvg >> PLL_DRIFT_AVG_SHIFT);
+        updated = true;
+
+        // Carry the fraction of the proportional term that can not be applied to the
+        // timer over to the next update, so small errors are corrected without bias
+        int32_t shift = phaseError * (1 << (PLL_FREQ_FRAC_BITS - PLL_KP_SHIFT)) + phaseDither;
+        phaseDither = shift & ((1 << PLL_FREQ_FRAC_BITS) - 1);
+        return shift >> PLL_FREQ_FRAC_BITS;
+    }
+
+    /**
+     * @brief Get the integer frequency offset in timer ticks to apply for the next timer
+     * period, carrying the fractional remainder over to the following periods
+     */
+    int32_t ICACHE_RAM_ATTR nextFreqOffset()
+    {
+        // Missed packets run on the averaged drift, which does not carry the jitter of the last packet
+        freqDither += (updated ? freqAccum : (driftAvg >> PLL_DRIFT_AVG_SHIFT)) * ticksPerUs;
+        updated = false;
+        int32_t offset = freqDither >> PLL_FREQ_FRAC_BITS;
+        freqDither -= offset << PLL_FREQ_FRAC_BITS;
+        return offset;
+    }
+
+    /**
+     * @brief Timing uncertainty after running on the drift estimate alone for elapsedMs.
+     * A packet arriving within this many microseconds of the expected time is in step
+     * with the TX. Never wider than a quarter interval, so a packet from an adjacent
+     * slot is not accepted.
+     */
+    uint32_t getCoastWindow(uint32_t elapsedMs) const
+    {
+        uint32_t window = PLL_COAST_MIN_WINDOW + getJitter() + elapsedMs * PLL_COAST_RESIDUAL_PPM / 1000;
+        return window < (interval / 4) ? window : (interval / 4);
+    }
+
+    /**
+     * @brief Wrap a phase difference to +/- half the interval
+     */
+    int32_t wrapPhase(int32_t phase) const
+    {
+        int32_t const half = interval / 2;
+        phase %= (int32_t)interval;
+        if (phase >= half)
+            phase -= interval;
+        else if (phase < -half)
+            phase += interval;
+        return phase;
+    }
+
+    /**
+     * @brief Drift estimate in us per half period, with PLL_FREQ_FRAC_BITS fractional bits
+     */
+    int32_t getDrift() const { return freqAccum; }
+
+    /**
+     * @brief Smoothed mean absolute phase error in microseconds
+     */
+    uint32_t getJitter() const { return jitterAvg >> 4; }
+
+    /**
+     * @brief Lock quality from 0 (no lock) to 100 (no phase error)
+     */
+    uint8_t getLockQuality() const
+    {
+        uint32_t jitter = getJitter();
+        if (jitter >= PLL_QUALITY_SPAN)
+            return 0;
+        return 100 - (jitter * 100 / PLL_QUALITY_SPAN);
+    }
+
+private:
+    uint8_t ticksPerUs;
+    uint32_t interval = 0;
+    int32_t freqAccum = 0;  // integral term, Q8 us per half period
+    int32_t freqDither = 0; // fractional remainder carried between periods, Q8 timer ticks
+    int32_t phaseDither = 0; // fractional remainder of the proportional term
+    bool updated = false;   // update() has been called since the last nextFreqOffset()
+    int32_t driftAvg = 0;   // averaged integral term << PLL_DRIFT_AVG_SHIFT, used when resetting with keepDrift
+    int32_t jitterAvg = PLL_QUALITY_SPAN << 4; // Q4 mean absolute phase error
+};
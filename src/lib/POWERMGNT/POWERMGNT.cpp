@@ -21,6 +21,23 @@ uint8_t powerToCrsfPower(PowerLevels_e Power)
     }
 }
 
+uint8_t powerToDbm(PowerLevels_e Power)
+{
+    switch (Power)
+    {
+    case PWR_10mW: return 10;
+    case PWR_25mW: return 14;
+    case PWR_50mW: return 17;
+    case PWR_100mW: return 20;
+    case PWR_250mW: return 24;
+    case PWR_500mW: return 27;
+    case PWR_1000mW: return 30;
+    case PWR_2000mW: return 33;
+    default:
+        return 0;
+    }
+}
+
 PowerLevels_e crsfpowerToPower(uint8_t crsfpower)
 {
     switch (crsfpower)
@@ -38,12 +55,22 @@ PowerLevels_e crsfpowerToPower(uint8_t crsfpower)
     }
 }
 
+void powerFreqCaliBuild(int8_t *hopCali, const int8_t *segmentCali, const uint8_t *sequence, uint16_t sequenceCount, uint32_t freqCount)
+{
+    for (uint16_t i = 0; i < sequenceCount; i++)
+    {
+        int8_t const cali = segmentCali[powerFreqCaliSegment(sequence[i], freqCount)];
+        hopCali[i] = cali > POWER_FREQ_CALI_MAX ? POWER_FREQ_CALI_MAX : cali < -POWER_FREQ_CALI_MAX ? -POWER_FREQ_CALI_MAX : cali;
+    }
+}
+
 #ifndef UNIT_TEST
 
 #include "common.h"
 #include "device.h"
 #include "DAC.h"
 #include "helpers.h"
+#include "FHSS.h"
 
 /*
  * Moves the power management values and special cases out of the main code and into `targets.h`.
@@ -95,6 +122,23 @@ static const int16_t *powerValues = nullptr;
 
 static int8_t powerCaliValues[PWR_COUNT] = {0};
 
+#if defined(TARGET_TX)
+static int8_t freqCaliValues[POWER_FREQ_CALI_BANDS][POWER_FREQ_CALI_SEGMENTS] = {0};
+static int8_t hopCaliValues[POWER_FREQ_CALI_BANDS][FHSS_SEQUENCE_LEN] = {0};
+#endif
+static int8_t currFreqCorrection[POWER_FREQ_CALI_BANDS] = {0};
+
+static int8_t freqCorrected(int8_t power, uint8_t band)
+{
+    int8_t const corrected = power + currFreqCorrection[band];
+#if defined(RADIO_SX127X)
+    // SX127x takes the power as 4 bits
+    return corrected < 0 ? 0 : corrected;
+#else
+    return corrected;
+#endif
+}
+
 #if defined(PLATFORM_ESP32)
 nvs_handle POWERMGNT::handle = 0;
 #endif
@@ -123,7 +167,7 @@ void POWERMGNT::incSX1280Output()
     if (CurrentSX1280Power < 13 && CurrentSX1280Power < powerValues[CurrentPower] + 3)
     {
         CurrentSX1280Power++;
-        Radio.SetOutputPower(CurrentSX1280Power);
+        Radio.SetOutputPower(freqCorrected(CurrentSX1280Power, 0));
     }
 }
 
@@ -133,7 +177,7 @@ void POWERMGNT::decSX1280Output()
     if (CurrentSX1280Power > -18 && CurrentSX1280Power > powerValues[CurrentPower] - 3)
     {
         CurrentSX1280Power--;
-        Radio.SetOutputPower(CurrentSX1280Power);
+        Radio.SetOutputPower(freqCorrected(CurrentSX1280Power, 0));
     }
 }
 
@@ -144,19 +188,7 @@ int8_t POWERMGNT::currentSX1280Output()
 
 uint8_t POWERMGNT::getPowerIndBm()
 {
-    switch (CurrentPower)
-    {
-    case PWR_10mW: return 10;
-    case PWR_25mW: return 14;
-    case PWR_50mW: return 17;
-    case PWR_100mW: return 20;
-    case PWR_250mW: return 24;
-    case PWR_500mW: return 27;
-    case PWR_1000mW: return 30;
-    case PWR_2000mW: return 33;
-    default:
-        return 0;
-    }
+    return powerToDbm(CurrentPower);
 }
 
 void POWERMGNT::SetPowerCaliValues(int8_t *values, size_t size)
@@ -189,6 +221,90 @@ void POWERMGNT::GetPowerCaliValues(int8_t *values, size_t size)
     }
 }
 
+void POWERMGNT::SetFreqCaliValues(uint8_t band, const int8_t *values)
+{
+#if defined(TARGET_TX)
+    if (band >= POWER_FREQ_CALI_BANDS)
+    {
+        return;
+    }
+    memcpy(freqCaliValues[band], values, POWER_FREQ_CALI_SEGMENTS);
+#if defined(PLATFORM_ESP32)
+    nvs_set_blob(handle, "freqcali", &freqCaliValues, sizeof(freqCaliValues));
+    nvs_commit(handle);
+#endif
+    buildFreqCorrection();
+#else
+    UNUSED(band);
+    UNUSED(values);
+#endif
+}
+
+void POWERMGNT::GetFreqCaliValues(uint8_t band, int8_t *values)
+{
+#if defined(TARGET_TX)
+    if (band < POWER_FREQ_CALI_BANDS)
+    {
+        memcpy(values, freqCaliValues[band], POWER_FREQ_CALI_SEGMENTS);
+        return;
+    }
+#endif
+    memset(values, 0, POWER_FREQ_CALI_SEGMENTS);
+}
+
+void POWERMGNT::buildFreqCorrection()
+{
+#if defined(TARGET_TX)
+    if (FHSSconfig == nullptr)
+    {
+        return;
+    }
+    powerFreqCaliBuild(hopCaliValues[0], freqCaliValues[0], FHSSsequence, primaryBandCount, FHSSconfig->freq_count);
+#if defined(RADIO_LR1121)
+    powerFreqCaliBuild(hopCaliValues[1], freqCaliValues[1], FHSSsequence_DualBand, secondaryBandCount, FHSSconfigDualBand->freq_count);
+#endif
+#endif
+}
+
+void ICACHE_RAM_ATTR POWERMGNT::setFreqCorrection(uint8_t fhssIndex)
+{
+#if defined(TARGET_TX) && !defined(POWER_OUTPUT_DAC) && !defined(POWER_OUTPUT_ANALOG)
+    // Only where the power is set with the radio's output power, and only when it changes
+#if defined(PLATFORM_ESP32)
+    if (POWER_OUTPUT_DACWRITE)
+    {
+        return;
+    }
+#endif
+    if (POWER_OUTPUT_FIXED != -99 || powerValues == nullptr || CurrentPower == PWR_COUNT)
+    {
+        return;
+    }
+    if (FHSSusesBand(FHSS_BAND_PRIMARY, fhssIndex))
+    {
+        int8_t const corr = hopCaliValues[0][fhssIndex];
+        if (corr != currFreqCorrection[0])
+        {
+            currFreqCorrection[0] = corr;
+            Radio.SetOutputPower(freqCorrected(CurrentSX1280Power, 0));
+        }
+    }
+#if defined(RADIO_LR1121)
+    if (FHSSusesBand(FHSS_BAND_DUAL, fhssIndex) && POWER_OUTPUT_VALUES_DUAL != nullptr)
+    {
+        int8_t const corr = hopCaliValues[1][fhssIndex];
+        if (corr != currFreqCorrection[1])
+        {
+            currFreqCorrection[1] = corr;
+            Radio.SetOutputPower(freqCorrected(powerValuesDual[CurrentPower - MinPower], 1), false);
+        }
+    }
+#endif
+#else
+    UNUSED(fhssIndex);
+#endif
+}
+
 void POWERMGNT::LoadCalibration()
 {
 #if defined(PLATFORM_ESP32)
@@ -208,6 +324,11 @@ void POWERMGNT::LoadCalibration()
     {
         size_t size = sizeof(powerCaliValues);
         nvs_get_blob(handle, "powercali", &powerCaliValues, &size);
+#if defined(TARGET_TX)
+        // Added after version 1, left at 0 if it hasn't been calibrated
+        size = sizeof(freqCaliValues);
+        nvs_get_blob(handle, "freqcali", &freqCaliValues, &size);
+#endif
     }
     else
     {
@@ -218,6 +339,7 @@ void POWERMGNT::LoadCalibration()
 #else
     memset(powerCaliValues, 0, sizeof(powerCaliValues));
 #endif
+    buildFreqCorrection();
 }
 
 
@@ -307,14 +429,14 @@ void POWERMGNT::setPower(PowerLevels_e Power)
     else if (powerValues != nullptr)
     {
         CurrentSX1280Power = powerValues[Power - MinPower] + powerCaliValues[Power];
-        Radio.SetOutputPower(CurrentSX1280Power);
+        Radio.SetOutputPower(freqCorrected(CurrentSX1280Power, 0));
     }
 #endif
 
 #if defined(RADIO_LR1121)
     if (POWER_OUTPUT_VALUES_DUAL != nullptr)
     {
-        Radio.SetOutputPower(powerValuesDual[Power - MinPower], false); // Set the high frequency power setting.
+        Radio.SetOutputPower(freqCorrected(powerValuesDual[Power - MinPower], 1), false); // Set the high frequency power setting.
     }
 #endif
 
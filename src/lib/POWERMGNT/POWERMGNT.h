@@ -36,8 +36,28 @@ typedef enum
 } PowerLevels_e;
 
 uint8_t powerToCrsfPower(PowerLevels_e Power);
+uint8_t powerToDbm(PowerLevels_e Power);
 PowerLevels_e crsfpowerToPower(uint8_t crsfpower);
 
+#define POWER_FREQ_CALI_SEGMENTS    8   // calibration points across each band
+#define POWER_FREQ_CALI_BANDS       2   // the domain's band and, on LR1121, the 2.4GHz band
+#define POWER_FREQ_CALI_MAX         3   // +/-dBm, the same cap as the PDET adjustment
+
+/**
+ * @brief The calibration segment of an FHSS channel
+ */
+static inline uint8_t powerFreqCaliSegment(uint32_t channel, uint32_t freqCount)
+{
+    return channel * POWER_FREQ_CALI_SEGMENTS / freqCount;
+}
+
+/**
+ * @brief Expand the per-segment corrections to one for each entry in the FHSS sequence,
+ * so a hop is a lookup
+ * @param hopCali out, sequenceCount values
+ */
+void powerFreqCaliBuild(int8_t *hopCali, const int8_t *segmentCali, const uint8_t *sequence, uint16_t sequenceCount, uint32_t freqCount);
+
 class PowerLevelContainer
 {
 protected:
@@ -167,6 +187,24 @@ public:
 
     static void SetPowerCaliValues(int8_t *values, size_t size);
     static void GetPowerCaliValues(int8_t *values, size_t size);
+
+    /**
+     * @brief Set the dBm correction of each frequency segment of a band, which goes on
+     * top of the power level calibration as the FHSS hops across the band
+     * @param values POWER_FREQ_CALI_SEGMENTS values
+     */
+    static void SetFreqCaliValues(uint8_t band, const int8_t *values);
+    static void GetFreqCaliValues(uint8_t band, int8_t *values);
+
+    /**
+     * @brief Rebuild the per-hop corrections after the FHSS sequence or the calibration changes
+     */
+    static void buildFreqCorrection();
+
+    /**
+     * @brief Apply the correction for the FHSS index that has just been hopped to
+     */
+    static void setFreqCorrection(uint8_t fhssIndex);
 };
 
 
@@ -3,6 +3,7 @@
 #include <U8g2lib.h> // Needed for the OLED drivers, this is a arduino package. It is maintained by platformIO
 
 #include "oleddisplay.h"
+#include "screenDiff.h"
 
 #include "XBMStrings.h" // Contains all the ELRS logos and animations for the UI
 #include "options.h"
@@ -18,6 +19,20 @@ extern WiFiMode_t wifiMode;
 // OLED specific header files.
 U8G2 *u8g2;
 
+// What was last sent to the panel, largest supported panel is 128x64
+static TileShadow<16, 8> panelShadow;
+
+/**
+ * Send only the tiles of the buffer that changed since the last flush, most
+ * updates touch a line or two so this saves most of the transfer over I2C/SPI
+ */
+static void flushBuffer()
+{
+    panelShadow.flush(u8g2->getBufferPtr(), [](uint8_t tx, uint8_t ty, uint8_t tw) {
+        u8g2->updateDisplayArea(tx, ty, tw, 1);
+    });
+}
+
 #ifdef TARGET_TX_GHOST
 /**
  * helper function is used to draw xbmp on the OLED.
@@ -31,7 +46,7 @@ static void helper(int x, int y, int size, const unsigned char *image)
 {
     u8g2->clearBuffer();
     u8g2->drawXBMP(x, y, size, size, image);
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 #endif
 
@@ -51,7 +66,7 @@ static void ghostChase()
         u8g2->drawXBMP((26 + i), 0, 32, 32, ghost);
         u8g2->drawXBMP((-31 + (i * 4)), 0, 32, 32, elrs32);
 #endif
-        u8g2->sendBuffer();
+        flushBuffer();
     }
 /**
  *  Animation for the ghost logo expanding in the center of the screen.
@@ -84,6 +99,7 @@ void OLEDDisplay::init()
 
     u8g2->begin();
     u8g2->clearBuffer();
+    panelShadow.begin(u8g2->getBufferTileWidth(), u8g2->getBufferTileHeight());
 }
 
 void OLEDDisplay::doScreenBackLight(screen_backlight_t state)
@@ -97,6 +113,7 @@ void OLEDDisplay::doScreenBackLight(screen_backlight_t state)
     if (state == SCREEN_BACKLIGHT_OFF)
     {
         u8g2->clearDisplay();
+        panelShadow.invalidate();
         u8g2->setPowerSave(true);
     }
     else
@@ -142,7 +159,7 @@ void OLEDDisplay::displaySplashScreen()
         drawCentered(60, buffer);
     }
 #endif
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 void OLEDDisplay::displayIdleScreen(uint8_t changed, uint8_t rate_index, uint8_t power_index, uint8_t ratio_index, uint8_t motion_index, uint8_t fan_index, bool dynamic, uint8_t running_power_index, uint8_t temperature, message_index_t message_index)
@@ -183,7 +200,7 @@ void OLEDDisplay::displayIdleScreen(uint8_t changed, uint8_t rate_index, uint8_t
         u8g2->drawStr(0, 27, "Ver: ");
         u8g2->drawStr(38, 27, version);
     }
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 void OLEDDisplay::displayMainMenu(menu_item_t menu)
@@ -201,7 +218,7 @@ void OLEDDisplay::displayMainMenu(menu_item_t menu)
         u8g2->drawStr(0,50, main_menu_strings[menu][1]);
     }
     helperDrawImage(menu);
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 void OLEDDisplay::displayValue(menu_item_t menu, uint8_t value_index)
@@ -225,7 +242,7 @@ void OLEDDisplay::displayValue(menu_item_t menu, uint8_t value_index)
         u8g2->drawStr(0,56, "CONFIRM");
     }
     helperDrawImage(menu);
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 void OLEDDisplay::displayBLEConfirm()
@@ -245,7 +262,7 @@ void OLEDDisplay::displayBLEConfirm()
         u8g2->drawStr(0,29, "PRESS TO START");
         u8g2->drawStr(0,59, "BLE JOYSTICK");
     }
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 void OLEDDisplay::displayBLEStatus()
@@ -267,7 +284,7 @@ void OLEDDisplay::displayBLEStatus()
         u8g2->drawStr(0,33, "GAMEPAD");
         u8g2->drawStr(0,63, "RUNNING");
     }
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 void OLEDDisplay::displayWiFiConfirm()
@@ -287,7 +304,7 @@ void OLEDDisplay::displayWiFiConfirm()
         u8g2->drawStr(0,29, "PRESS TO ENTER");
         u8g2->drawStr(0,59, "WIFI UPDATE");
     }
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 void OLEDDisplay::displayWiFiStatus()
@@ -327,7 +344,7 @@ void OLEDDisplay::displayWiFiStatus()
         }
     }
 #endif
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 void OLEDDisplay::displayBindConfirm()
@@ -346,7 +363,7 @@ void OLEDDisplay::displayBindConfirm()
         u8g2->drawStr(0,29, "PRESS TO SEND");
         u8g2->drawStr(0,59, "BIND REQUEST");
     }
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 void OLEDDisplay::displayBindStatus()
@@ -362,7 +379,7 @@ void OLEDDisplay::displayBindStatus()
     {
         drawCentered(29, "BINDING...");
     }
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 void OLEDDisplay::displayRunning()
@@ -378,7 +395,7 @@ void OLEDDisplay::displayRunning()
     {
         drawCentered(29, "RUNNING...");
     }
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 void OLEDDisplay::displaySending()
@@ -394,7 +411,7 @@ void OLEDDisplay::displaySending()
     {
         drawCentered(29, "SENDING...");
     }
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 void OLEDDisplay::displayLinkstats()
@@ -449,7 +466,7 @@ void OLEDDisplay::displayLinkstats()
         u8g2->print(CRSF::LinkStatistics.active_antenna);
     }
 
-    u8g2->sendBuffer();
+    flushBuffer();
 }
 
 // helpers
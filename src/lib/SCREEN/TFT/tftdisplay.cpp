@@ -6,6 +6,7 @@
 #include "Pragma_Sans314pt7b.h"
 
 #include "tftdisplay.h"
+#include "screenDiff.h"
 
 #include "logos.h"
 #include "options.h"
@@ -188,73 +189,99 @@ void TFTDisplay::displaySplashScreen()
                         String(buffer), WHITE, BLACK);
 }
 
+typedef enum {
+    IDLE_REGION_BANNER,
+    IDLE_REGION_LINE1,
+    IDLE_REGION_LINE2,
+    IDLE_REGION_LINE3,
+    IDLE_REGION_COUNT
+} idle_region_t;
+
+typedef enum {
+    IDLE_LAYOUT_STATS,
+    IDLE_LAYOUT_BAD_RADIO,
+    IDLE_LAYOUT_NO_HANDSET,
+    IDLE_LAYOUT_INVALID
+} idle_layout_t;
+
+// What is on the idle screen, so only the regions whose content changed are sent over SPI
+static RetainedText<IDLE_REGION_COUNT> idleRegions;
+static idle_layout_t idleLayout = IDLE_LAYOUT_INVALID;
+
+static void displayIdleLine(idle_region_t region, uint32_t font_start_y, const char *text, uint16_t fgColor)
+{
+    if (idleRegions.update(region, text, fgColor, WHITE))
+    {
+        displayFontCenter(IDLE_PAGE_STAT_START_X, SCREEN_X, font_start_y, SCREEN_NORMAL_FONT_SIZE, SCREEN_NORMAL_FONT,
+                            text, fgColor, WHITE);
+    }
+}
+
 void TFTDisplay::displayIdleScreen(uint8_t changed, uint8_t rate_index, uint8_t power_index, uint8_t ratio_index, uint8_t motion_index, uint8_t fan_index, bool dynamic, uint8_t running_power_index, uint8_t temperature, message_index_t message_index)
 {
     if (changed == CHANGED_ALL)
     {
-        // Everything has changed! So clear the right side
-        gfx->fillRect(SCREEN_X/2, 0, SCREEN_X/2, SCREEN_Y, WHITE);
+        // Coming from another screen, nothing on the panel can be trusted
+        idleRegions.invalidate();
+        idleLayout = IDLE_LAYOUT_INVALID;
     }
 
-    if (changed & CHANGED_TEMP)
+    // Left side logo, version, and temp
+    char buffer[20];
+    // \367 = (char)247 = degree symbol
+    snprintf(buffer, sizeof(buffer), "%.6s %02d\367C", version, temperature);
+    uint16_t const banner_color = elrs_banner_bgColor[message_index];
+    if (idleRegions.update(IDLE_REGION_BANNER, buffer, WHITE, banner_color))
     {
-        // Left side logo, version, and temp
-        gfx->fillRect(0, 0, SCREEN_X/2, SCREEN_Y, elrs_banner_bgColor[message_index]);
+        gfx->fillRect(0, 0, SCREEN_X/2, SCREEN_Y, banner_color);
         gfx->drawBitmap(IDLE_PAGE_START_X, IDLE_PAGE_START_Y, elrs_banner_bmp, SCREEN_LARGE_ICON_SIZE, SCREEN_LARGE_ICON_SIZE,
                         WHITE);
-
-        // Update the temperature
-        char buffer[20];
-        // \367 = (char)247 = degree symbol
-        snprintf(buffer, sizeof(buffer), "%.6s %02d\367C", version, temperature);
         displayFontCenter(0, SCREEN_X/2, SCREEN_LARGE_ICON_SIZE + (SCREEN_Y - SCREEN_LARGE_ICON_SIZE - SCREEN_SMALL_FONT_SIZE)/2,
                             SCREEN_SMALL_FONT_SIZE, SCREEN_SMALL_FONT,
-                            String(buffer), WHITE, elrs_banner_bgColor[message_index]);
+                            String(buffer), WHITE, banner_color);
     }
 
     // The Radio Params right half of the screen
-    uint16_t text_color = (message_index == MSG_ARMED) ? DARKGREY : BLACK;
-
+    idle_layout_t layout = IDLE_LAYOUT_STATS;
     if (connectionState == radioFailed)
+        layout = IDLE_LAYOUT_BAD_RADIO;
+    else if (connectionState == noCrossfire)
+        layout = IDLE_LAYOUT_NO_HANDSET;
+
+    if (layout != idleLayout)
     {
-        displayFontCenter(IDLE_PAGE_STAT_START_X, SCREEN_X, MAIN_PAGE_WORD_START_Y1,  SCREEN_NORMAL_FONT_SIZE, SCREEN_NORMAL_FONT,
-            "BAD", BLACK, WHITE);
-        displayFontCenter(IDLE_PAGE_STAT_START_X, SCREEN_X, MAIN_PAGE_WORD_START_Y2,  SCREEN_NORMAL_FONT_SIZE, SCREEN_NORMAL_FONT,
-            "RADIO", BLACK, WHITE);
+        // The lines are in different places, so clear the right side
+        gfx->fillRect(SCREEN_X/2, 0, SCREEN_X/2, SCREEN_Y, WHITE);
+        idleRegions.invalidate(IDLE_REGION_LINE1);
+        idleRegions.invalidate(IDLE_REGION_LINE2);
+        idleRegions.invalidate(IDLE_REGION_LINE3);
+        idleLayout = layout;
     }
-    else if (connectionState == noCrossfire)
+
+    if (layout == IDLE_LAYOUT_BAD_RADIO)
+    {
+        displayIdleLine(IDLE_REGION_LINE1, MAIN_PAGE_WORD_START_Y1, "BAD", BLACK);
+        displayIdleLine(IDLE_REGION_LINE2, MAIN_PAGE_WORD_START_Y2, "RADIO", BLACK);
+    }
+    else if (layout == IDLE_LAYOUT_NO_HANDSET)
     {
-        displayFontCenter(IDLE_PAGE_STAT_START_X, SCREEN_X, MAIN_PAGE_WORD_START_Y1,  SCREEN_NORMAL_FONT_SIZE, SCREEN_NORMAL_FONT,
-            "NO", BLACK, WHITE);
-        displayFontCenter(IDLE_PAGE_STAT_START_X, SCREEN_X, MAIN_PAGE_WORD_START_Y2,  SCREEN_NORMAL_FONT_SIZE, SCREEN_NORMAL_FONT,
-            "HANDSET", BLACK, WHITE);
+        displayIdleLine(IDLE_REGION_LINE1, MAIN_PAGE_WORD_START_Y1, "NO", BLACK);
+        displayIdleLine(IDLE_REGION_LINE2, MAIN_PAGE_WORD_START_Y2, "HANDSET", BLACK);
     }
     else
     {
-        if (changed & CHANGED_RATE)
-        {
-            displayFontCenter(IDLE_PAGE_STAT_START_X, SCREEN_X, IDLE_PAGE_RATE_START_Y,  SCREEN_NORMAL_FONT_SIZE, SCREEN_NORMAL_FONT,
-                                getValue(STATE_PACKET, rate_index), text_color, WHITE);
-        }
+        uint16_t text_color = (message_index == MSG_ARMED) ? DARKGREY : BLACK;
 
-        if (changed & CHANGED_POWER)
+        String power = getValue(STATE_POWER, running_power_index);
+        if (dynamic || power_index != running_power_index)
         {
-            String power = getValue(STATE_POWER, running_power_index);
-            if (dynamic || power_index != running_power_index)
-            {
-                power += " *";
-            }
-            displayFontCenter(IDLE_PAGE_STAT_START_X, SCREEN_X, IDLE_PAGE_POWER_START_Y, SCREEN_NORMAL_FONT_SIZE, SCREEN_NORMAL_FONT,
-                                power, text_color, WHITE);
+            power += " *";
         }
 
-        if (changed & CHANGED_TELEMETRY)
-        {
-            displayFontCenter(IDLE_PAGE_STAT_START_X, SCREEN_X, IDLE_PAGE_RATIO_START_Y,  SCREEN_NORMAL_FONT_SIZE, SCREEN_NORMAL_FONT,
-                                getValue(STATE_TELEMETRY_CURR, ratio_index), text_color, WHITE);
-        }
+        displayIdleLine(IDLE_REGION_LINE1, IDLE_PAGE_RATE_START_Y, getValue(STATE_PACKET, rate_index), text_color);
+        displayIdleLine(IDLE_REGION_LINE2, IDLE_PAGE_POWER_START_Y, power.c_str(), text_color);
+        displayIdleLine(IDLE_REGION_LINE3, IDLE_PAGE_RATIO_START_Y, getValue(STATE_TELEMETRY_CURR, ratio_index), text_color);
     }
-
 }
 
 void TFTDisplay::displayMainMenu(menu_item_t menu)
@@ -36,6 +36,7 @@
 #define CHANGED_TELEMETRY bit(3)
 #define CHANGED_MOTION bit(4)
 #define CHANGED_FAN bit(5)
+#define CHANGED_MESSAGE bit(6)
 #define CHANGED_ALL 0xFF
 
 typedef enum fsm_state_s menu_item_t;
@@ -93,7 +93,7 @@ static void displayIdleScreen(bool init)
     uint8_t tlmIdx = __builtin_ffs(ExpressLRS_currTlmDenom) - 1;
     if (changed == 0)
     {
-        changed |= last_message != disp_message ? CHANGED_ALL : 0;
+        changed |= last_message != disp_message ? CHANGED_MESSAGE : 0;
         changed |= last_temperature != temperature ? CHANGED_TEMP : 0;
         changed |= last_rate != config.GetRate() ? CHANGED_RATE : 0;
         changed |= last_power != config.GetPower() ? CHANGED_POWER : 0;
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * In memory monochrome framebuffer in the U8g2/SSD1306 tile layout
+ *
+ * Stands in for the U8g2 buffer when there is no display, so screens can be
+ * drawn natively, compared against a snapshot, and flushed through a
+ * TileShadow to measure what a redraw would send.
+ */
+template <uint8_t Width, uint8_t Height>
+class MonoFramebuffer
+{
+    static_assert(Width % 8 == 0 && Height % 8 == 0, "Framebuffer must be a whole number of tiles");
+
+public:
+    static constexpr uint8_t tilesX = Width / 8;
+    static constexpr uint8_t tilesY = Height / 8;
+    static constexpr size_t size = (size_t)Width * Height / 8;
+
+    MonoFramebuffer() { clear(); }
+
+    void clear() { memset(_buf, 0, size); }
+
+    void setPixel(int x, int y, bool on)
+    {
+        if (x < 0 || y < 0 || x >= Width || y >= Height)
+            return;
+        uint8_t &b = _buf[(y / 8) * Width + x];
+        if (on)
+            b |= 1 << (y % 8);
+        else
+            b &= ~(1 << (y % 8));
+    }
+
+    bool getPixel(int x, int y) const
+    {
+        if (x < 0 || y < 0 || x >= Width || y >= Height)
+            return false;
+        return (_buf[(y / 8) * Width + x] >> (y % 8)) & 1;
+    }
+
+    void fillRect(int x, int y, int w, int h, bool on)
+    {
+        for (int yy = y; yy < y + h; ++yy)
+            for (int xx = x; xx < x + w; ++xx)
+                setPixel(xx, yy, on);
+    }
+
+    /**
+     * @brief Draw an XBM image, rows of (w + 7) / 8 bytes with the leftmost pixel in the LSB
+     */
+    void drawXBM(int x, int y, int w, int h, const uint8_t *bits)
+    {
+        int const stride = (w + 7) / 8;
+        for (int yy = 0; yy < h; ++yy)
+            for (int xx = 0; xx < w; ++xx)
+                if ((bits[yy * stride + xx / 8] >> (xx % 8)) & 1)
+                    setPixel(x + xx, y + yy, true);
+    }
+
+    /**
+     * @brief Render an area as text, '#' for lit and '.' for dark pixels, one line per row
+     * @return length of the text, not including the null terminator
+     */
+    size_t snapshot(char *out, size_t outLen, int x, int y, int w, int h) const
+    {
+        size_t pos = 0;
+        for (int yy = y; yy < y + h; ++yy)
+        {
+            for (int xx = x; xx < x + w && pos + 1 < outLen; ++xx)
+                out[pos++] = getPixel(xx, yy) ? '#' : '.';
+            if (pos + 1 < outLen)
+                out[pos++] = '\n';
+        }
+        if (outLen)
+            out[pos] = '\0';
+        return pos;
+    }
+
+    uint8_t *getBufferPtr() { return _buf; }
+    const uint8_t *getBufferPtr() const { return _buf; }
+
+private:
+    uint8_t _buf[size];
+};
+
+/**
+ * Model of a monochrome panel that counts what it is sent, so redraw cost can
+ * be measured natively. Each area sent costs an address window (page and
+ * column commands on the SSD1306) plus 8 bytes per tile.
+ */
+template <uint8_t Width, uint8_t Height>
+class MonoPanel
+{
+public:
+    static constexpr unsigned commandBytesPerRun = 3;
+
+    /**
+     * @brief Send the whole buffer, as U8g2 sendBuffer() does
+     */
+    void sendBuffer(const MonoFramebuffer<Width, Height> &fb)
+    {
+        for (uint8_t ty = 0; ty < fb.tilesY; ++ty)
+            updateArea(fb, 0, ty, fb.tilesX);
+    }
+
+    /**
+     * @brief Send tw tiles of row ty starting at tx, as U8g2 updateDisplayArea() does
+     */
+    void updateArea(const MonoFramebuffer<Width, Height> &fb, uint8_t tx, uint8_t ty, uint8_t tw)
+    {
+        size_t const offset = (size_t)ty * Width + tx * 8;
+        memcpy(&panel.getBufferPtr()[offset], &fb.getBufferPtr()[offset], tw * 8);
+        bytesSent += commandBytesPerRun + tw * 8;
+    }
+
+    // What is showing on the panel
+    MonoFramebuffer<Width, Height> panel;
+    uint32_t bytesSent = 0;
+};
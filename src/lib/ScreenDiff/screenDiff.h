@@ -0,0 +1,154 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Copy of what was last sent to a monochrome panel, used to only send the
+ * tiles that changed instead of the whole buffer.
+ *
+ * The buffer uses the U8g2/SSD1306 layout: the screen is split into 8x8 pixel
+ * tiles, each tile is 8 bytes (one per column, LSB at the top) and the rows
+ * of tiles are stored one after another.
+ */
+template <uint8_t MaxTilesX, uint8_t MaxTilesY>
+class TileShadow
+{
+public:
+    /**
+     * @brief Set the size of the panel in tiles, at most MaxTilesX x MaxTilesY
+     */
+    void begin(uint8_t tilesX, uint8_t tilesY)
+    {
+        _tilesX = tilesX;
+        _tilesY = tilesY;
+        invalidate();
+    }
+
+    /**
+     * @brief Forget what is on the panel, the next flush sends every tile
+     */
+    void invalidate() { _valid = false; }
+
+    /**
+     * @brief Call send(tx, ty, tw) for each horizontal run of tiles in buf that
+     * differs from what was last sent, then remember buf as the panel contents
+     * @return number of tiles sent
+     */
+    template <typename F>
+    unsigned flush(const uint8_t *buf, F send)
+    {
+        unsigned sent = 0;
+        for (uint8_t ty = 0; ty < _tilesY; ++ty)
+        {
+            uint8_t runStart = 0;
+            uint8_t runLen = 0;
+            for (uint8_t tx = 0; tx <= _tilesX; ++tx)
+            {
+                if (tx < _tilesX && tileDirty(buf, tx, ty))
+                {
+                    if (runLen == 0)
+                        runStart = tx;
+                    ++runLen;
+                }
+                else if (runLen)
+                {
+                    send(runStart, ty, runLen);
+                    sent += runLen;
+                    ++runsSent;
+                    runLen = 0;
+                }
+            }
+        }
+        memcpy(_shadow, buf, (size_t)_tilesX * _tilesY * 8);
+        _valid = true;
+
+        ++flushes;
+        tilesSent += sent;
+        return sent;
+    }
+
+    // Statistics
+    uint32_t flushes = 0;   // number of calls to flush()
+    uint32_t runsSent = 0;  // number of areas sent, each one costs an address window
+    uint32_t tilesSent = 0; // number of 8 byte tiles sent
+
+private:
+    bool tileDirty(const uint8_t *buf, uint8_t tx, uint8_t ty) const
+    {
+        if (!_valid)
+            return true;
+        size_t const offset = ((size_t)ty * _tilesX + tx) * 8;
+        return memcmp(&_shadow[offset], &buf[offset], 8) != 0;
+    }
+
+    uint8_t _shadow[MaxTilesX * MaxTilesY * 8];
+    uint8_t _tilesX = MaxTilesX;
+    uint8_t _tilesY = MaxTilesY;
+    bool _valid = false;
+};
+
+/**
+ * Text and colours last drawn into each of N fixed regions of a screen
+ * that has no local framebuffer, such as the TFT which draws straight to the
+ * panel over SPI. A region is only redrawn when its content differs from
+ * what is already on the panel.
+ * Text longer than Len - 1 characters can't be compared and is always redrawn.
+ */
+template <size_t N, size_t Len = 24>
+class RetainedText
+{
+public:
+    RetainedText() { invalidate(); }
+
+    /**
+     * @brief Forget what is on the panel, every region is drawn on the next update
+     */
+    void invalidate()
+    {
+        for (size_t i = 0; i < N; ++i)
+            _regions[i].valid = false;
+    }
+
+    /**
+     * @brief Forget what is on the panel in one region
+     */
+    void invalidate(size_t idx) { _regions[idx].valid = false; }
+
+    /**
+     * @brief Retain the new content of a region
+     * @return true if the region has to be redrawn
+     */
+    bool update(size_t idx, const char *text, uint16_t fgColor, uint16_t bgColor)
+    {
+        region_t &r = _regions[idx];
+        if (r.valid && r.fgColor == fgColor && r.bgColor == bgColor && strncmp(r.text, text, Len) == 0)
+        {
+            ++skipped;
+            return false;
+        }
+
+        strncpy(r.text, text, Len - 1);
+        r.text[Len - 1] = '\0';
+        r.fgColor = fgColor;
+        r.bgColor = bgColor;
+        r.valid = true;
+        ++redraws;
+        return true;
+    }
+
+    // Statistics
+    uint32_t redraws = 0; // number of regions that had to be drawn
+    uint32_t skipped = 0; // number of regions left alone because nothing changed
+
+private:
+    typedef struct {
+        char text[Len];
+        uint16_t fgColor;
+        uint16_t bgColor;
+        bool valid;
+    } region_t;
+
+    region_t _regions[N];
+};
@@ -7,7 +7,7 @@
 
 #include "DShotRMT.h"
 
-DShotRMT::DShotRMT(gpio_num_t gpio, rmt_channel_t rmtChannel) : gpio_num(gpio), rmt_channel(rmtChannel) {
+DShotRMT::DShotRMT(gpio_num_t gpio, rmt_channel_t rmtChannel, rmt_channel_t rxChannel) : gpio_num(gpio), rmt_channel(rmtChannel), rx_channel(rxChannel) {
 	// ...create clean packet
 	encode_dshot_to_rmt(DSHOT_NULL_PACKET);
 }
@@ -15,6 +15,11 @@ DShotRMT::DShotRMT(gpio_num_t gpio, rmt_channel_t rmtChannel) : gpio_num(gpio),
 DShotRMT::~DShotRMT() {
 	rmt_tx_stop(rmt_channel);
 	rmt_driver_uninstall(rmt_channel);
+
+	if (rx_ringbuf) {
+		rmt_rx_stop(rx_channel);
+		rmt_driver_uninstall(rx_channel);
+	}
 }
 
 bool DShotRMT::begin(dshot_mode_t dshot_mode, bool is_bidirectional) {
@@ -65,7 +70,8 @@ bool DShotRMT::begin(dshot_mode_t dshot_mode, bool is_bidirectional) {
 		.channel = rmt_channel,
 		.gpio_num = gpio_num,
 		.clk_div = DSHOT_CLK_DIVIDER,
-		.mem_block_num = uint8_t(RMT_CHANNEL_MAX - uint8_t(rmt_channel)),
+		// ...the frame fits in one block, leave the next one for capturing the reply
+		.mem_block_num = uint8_t(bidirectional ? 1 : RMT_CHANNEL_MAX - uint8_t(rmt_channel)),
 		.tx_config = {
         	.idle_level = bidirectional ? RMT_IDLE_LEVEL_HIGH : RMT_IDLE_LEVEL_LOW,
 			.carrier_en = false,
@@ -96,11 +102,56 @@ bool DShotRMT::begin(dshot_mode_t dshot_mode, bool is_bidirectional) {
 	rmt_config(&dshot_tx_rmt_config);
 
 	// ...essential step, return the result
-	return rmt_driver_install(dshot_tx_rmt_config.channel, 0, 0);
+	esp_err_t result = rmt_driver_install(dshot_tx_rmt_config.channel, 0, 0);
+
+	if (bidirectional && rx_channel != RMT_CHANNEL_MAX && result == ESP_OK) {
+		result = begin_telemetry(ticks_per_bit);
+	}
+
+	return result;
+}
+
+// ...the ESC replies on the same wire about 30us after each frame
+esp_err_t DShotRMT::begin_telemetry(uint16_t ticks_per_bit) {
+	rmt_config_t dshot_rx_rmt_config = {
+		.rmt_mode = RMT_MODE_RX,
+		.channel = rx_channel,
+		.gpio_num = gpio_num,
+		.clk_div = DSHOT_CLK_DIVIDER,
+		.mem_block_num = 1,
+		.rx_config = {
+			// ...longer than the 3 bit runs of a reply, shorter than the gap before it
+			.idle_threshold = uint16_t(ticks_per_bit * 3),
+			// ...pulses shorter than 0.5us at 80MHz are noise
+			.filter_ticks_thresh = 40,
+			.filter_en = true,
+		},
+	};
+
+	rmt_config(&dshot_rx_rmt_config);
+	esp_err_t result = rmt_driver_install(rx_channel, DSHOT_TELEMETRY_RINGBUF_SIZE, 0);
+	if (result != ESP_OK) {
+		return result;
+	}
+	rmt_get_ringbuf_handle(rx_channel, &rx_ringbuf);
+
+	// ...both channels share the pin, so neither end must drive it high
+	gpio_set_direction(gpio_num, GPIO_MODE_INPUT_OUTPUT_OD);
+	gpio_pullup_en(gpio_num);
+
+	uint16_t dshot_rate = mode == DSHOT150 ? 150 : mode == DSHOT300 ? 300 : mode == DSHOT600 ? 600 : 1200;
+	telemetry_bits_per_tick = dshotTelemetryBitsPerTick(RMT_CYCLES_PER_SEC, dshot_rate);
+
+	return rmt_rx_start(rx_channel, true);
 }
 
 // ...the config part is done, now the calculating and sending part
 void DShotRMT::send_dshot_value(uint16_t throttle_value, telemetric_request_t telemetric_request) {
+	prepare_dshot_value(throttle_value, telemetric_request);
+	output_prepared();
+}
+
+void DShotRMT::prepare_dshot_value(uint16_t throttle_value, telemetric_request_t telemetric_request) {
 	dshot_packet_t dshot_rmt_packet = { };
 
 	if (throttle_value < DSHOT_THROTTLE_MIN) {
@@ -116,7 +167,7 @@ void DShotRMT::send_dshot_value(uint16_t throttle_value, telemetric_request_t te
 	dshot_rmt_packet.telemetric_request = telemetric_request;
 	dshot_rmt_packet.checksum = this->calc_dshot_chksum(dshot_rmt_packet);
 
-	output_rmt_data(dshot_rmt_packet);
+	encode_dshot_to_rmt(prepare_rmt_data(dshot_rmt_packet));
 }
 
 rmt_item32_t* DShotRMT::encode_dshot_to_rmt(uint16_t parsed_packet) {
@@ -188,11 +239,44 @@ uint16_t DShotRMT::prepare_rmt_data(const dshot_packet_t& dshot_packet) {
 }
 
 // ...finally output using ESP32 RMT
-void DShotRMT::output_rmt_data(const dshot_packet_t& dshot_packet) {
-	encode_dshot_to_rmt(prepare_rmt_data(dshot_packet));
-
+void DShotRMT::output_prepared() {
 	rmt_tx_stop(rmt_channel);
 	rmt_fill_tx_items(rmt_channel, dshot_tx_rmt_item, DSHOT_PACKET_LENGTH, 0);
 	rmt_tx_start(rmt_channel, true);
 }
+
+bool DShotRMT::read_telemetry(dshot_telemetry_t *telemetry) {
+	if (!rx_ringbuf) {
+		return false;
+	}
+
+	bool decoded = false;
+	size_t length = 0;
+	rmt_item32_t *items;
+
+	// ...every capture since the last call, the newest reply wins
+	while ((items = (rmt_item32_t *)xRingbufferReceive(rx_ringbuf, &length, 0)) != nullptr) {
+		size_t count = length / sizeof(rmt_item32_t);
+
+		// ...our own frame is captured too, it has a pair of runs for each of its 16 bits
+		if (count > 0 && count <= (DSHOT_TELEMETRY_MAX_RUNS + 1) / 2 && items[0].level0 == LOW) {
+			uint16_t runs[DSHOT_TELEMETRY_MAX_RUNS + 1];
+			uint8_t run_count = 0;
+
+			for (size_t i = 0; i < count && items[i].duration0 != 0; i++) {
+				runs[run_count++] = items[i].duration0;
+				if (items[i].duration1 == 0) {
+					break;
+				}
+				runs[run_count++] = items[i].duration1;
+			}
+
+			decoded |= dshotTelemetryDecode(telemetry, runs, run_count, telemetry_bits_per_tick);
+		}
+
+		vRingbufferReturnItem(rx_ringbuf, items);
+	}
+
+	return decoded;
+}
 #endif
\ No newline at end of file
@@ -13,6 +13,7 @@
 
 // ...utilizing the IR Module library for generating the DShot signal
 #include <driver/rmt.h>
+#include "DShotTelemetry.h"
 
 constexpr auto DSHOT_CLK_DIVIDER = 8; // ...slow down RMT clock to 0.1 microseconds / 100 nanoseconds per cycle
 constexpr auto DSHOT_PACKET_LENGTH = 18; // ...last packet is the pause followed by RMT end marker
@@ -24,6 +25,8 @@ constexpr auto DSHOT_NULL_PACKET = 0b0000000000000000;
 constexpr auto DSHOT_PAUSE = 21; // ...21bit is recommended, but to be sure
 constexpr auto DSHOT_PAUSE_BIT = 16;
 
+constexpr auto DSHOT_TELEMETRY_RINGBUF_SIZE = 512; // ...room for a few captures of the reply and our own frame
+
 constexpr auto F_CPU_RMT = APB_CLK_FREQ;
 constexpr auto RMT_CYCLES_PER_SEC = (F_CPU_RMT / DSHOT_CLK_DIVIDER);
 constexpr auto RMT_CYCLES_PER_ESP_CYCLE = (F_CPU / RMT_CYCLES_PER_SEC);
@@ -90,16 +93,27 @@ typedef struct dshot_config_s {
 
 class DShotRMT {
 public:
-	DShotRMT(gpio_num_t gpio, rmt_channel_t rmtChannel);
+	// ...bidirectional mode captures the replies with a second channel, rxChannel
+	DShotRMT(gpio_num_t gpio, rmt_channel_t rmtChannel, rmt_channel_t rxChannel = RMT_CHANNEL_MAX);
 	~DShotRMT();
 
 	// ...safety first ...no parameters, no DShot
 	bool begin(dshot_mode_t dshot_mode = DSHOT_OFF, bool is_bidirectional = false);
 	void send_dshot_value(uint16_t throttle_value, telemetric_request_t telemetric_request = NO_TELEMETRIC);
 
+	// ...send_dshot_value() in two halves, so several channels can be encoded first then started back to back
+	void prepare_dshot_value(uint16_t throttle_value, telemetric_request_t telemetric_request = NO_TELEMETRIC);
+	void output_prepared();
+
+	// ...decode the replies captured since the last call, bidirectional mode only
+	bool read_telemetry(dshot_telemetry_t *telemetry);
+
 private:
 	gpio_num_t gpio_num;
 	rmt_channel_t rmt_channel;
+	rmt_channel_t rx_channel;
+	RingbufHandle_t rx_ringbuf = nullptr;
+	uint32_t telemetry_bits_per_tick = 0;
 	rmt_item32_t dshot_tx_rmt_item[DSHOT_PACKET_LENGTH + 1];
 
 	dshot_mode_t mode = DSHOT_OFF;
@@ -113,6 +127,6 @@ private:
 	uint16_t calc_dshot_chksum(const dshot_packet_t& dshot_packet);
 	uint16_t prepare_rmt_data(const dshot_packet_t& dshot_packet);
 
-	void output_rmt_data(const dshot_packet_t& dshot_packet);
+	esp_err_t begin_telemetry(uint16_t ticks_per_bit);
 };
 #endif
\ No newline at end of file
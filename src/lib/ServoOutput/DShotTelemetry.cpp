@@ -0,0 +1,124 @@
+#include "DShotTelemetry.h"
+
+#define GCR_INVALID 0xFF
+
+// GCR quintet to nibble, the quintets never have more than two 0s in a row
+static const uint8_t gcrDecode[32] = {
+    GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID,
+    GCR_INVALID, 0x9, 0xA, 0xB, GCR_INVALID, 0xD, 0xE, 0xF,
+    GCR_INVALID, GCR_INVALID, 0x2, 0x3, GCR_INVALID, 0x5, 0x6, 0x7,
+    GCR_INVALID, 0x0, 0x8, 0x1, GCR_INVALID, 0x4, 0xC, GCR_INVALID,
+};
+
+// Extended DShot Telemetry types, the high nibble of the value
+#define EDT_TEMPERATURE 0x2
+#define EDT_VOLTAGE     0x4
+#define EDT_CURRENT     0x6
+
+uint32_t dshotTelemetryBitsPerTick(uint32_t tickHz, uint16_t dshotRate)
+{
+    // rate * 1000 * 5/4 bits per second
+    return (uint32_t)(((uint64_t)dshotRate * 1250U << 16) / tickHz);
+}
+
+uint32_t dshotTelemetryRunsToGcr(const uint16_t *runs, uint8_t count, uint32_t bitsPerTickQ16)
+{
+    uint32_t raw = 0;
+    uint8_t bits = 0;
+    uint8_t level = 0;
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        uint8_t const len = (runs[i] * bitsPerTickQ16 + 0x8000) >> 16;
+        if (len == 0 || bits + len > DSHOT_TELEMETRY_BITS)
+        {
+            return DSHOT_TELEMETRY_INVALID;
+        }
+        raw = (raw << len) | (level ? (1U << len) - 1 : 0);
+        bits += len;
+        level ^= 1;
+    }
+    if (bits == 0)
+    {
+        return DSHOT_TELEMETRY_INVALID;
+    }
+    // The rest is the run which was still going when the capture ended
+    uint8_t const pad = DSHOT_TELEMETRY_BITS - bits;
+    raw = (raw << pad) | (level ? (1U << pad) - 1 : 0);
+
+    // A 1 is a change of level
+    return (raw ^ (raw >> 1)) & 0xFFFFF;
+}
+
+uint32_t dshotTelemetryDecodeGcr(uint32_t gcr)
+{
+    uint32_t value = 0;
+    for (int8_t shift = 15; shift >= 0; shift -= 5)
+    {
+        uint8_t const nibble = gcrDecode[(gcr >> shift) & 0x1F];
+        if (nibble == GCR_INVALID)
+        {
+            return DSHOT_TELEMETRY_INVALID;
+        }
+        value = (value << 4) | nibble;
+    }
+
+    // The CRC nibble is the inverted XOR of the other three
+    if (((value ^ (value >> 4) ^ (value >> 8) ^ (value >> 12)) & 0xF) != 0xF)
+    {
+        return DSHOT_TELEMETRY_INVALID;
+    }
+    return value >> 4;
+}
+
+void dshotTelemetryProcess(dshot_telemetry_t *tlm, uint16_t value)
+{
+    uint8_t const type = value >> 8;
+    uint8_t const data = value & 0xFF;
+
+    // eRPM is sent normalized so its mantissa's top bit is set unless the exponent
+    // is 0, which leaves an even non-zero high nibble free for EDT
+    if ((type & 1) == 0 && type != 0)
+    {
+        switch (type)
+        {
+        case EDT_TEMPERATURE:
+            tlm->temperature = data;
+            tlm->updated |= DSHOT_TLM_TEMPERATURE;
+            break;
+        case EDT_VOLTAGE:
+            tlm->voltage = data * 25U;
+            tlm->updated |= DSHOT_TLM_VOLTAGE;
+            break;
+        case EDT_CURRENT:
+            tlm->current = data;
+            tlm->updated |= DSHOT_TLM_CURRENT;
+            break;
+        default:
+            // Debug, stress and status are not used
+            break;
+        }
+        return;
+    }
+
+    // 3 bit exponent, 9 bit mantissa of the period in us. All 1s is stopped
+    uint32_t const period = (uint32_t)(value & 0x1FF) << (value >> 9);
+    tlm->erpm = (value == 0xFFF || period == 0) ? 0 : 60000000U / period;
+    tlm->updated |= DSHOT_TLM_ERPM;
+}
+
+bool dshotTelemetryDecode(dshot_telemetry_t *tlm, const uint16_t *runs, uint8_t count, uint32_t bitsPerTickQ16)
+{
+    uint32_t value = dshotTelemetryRunsToGcr(runs, count, bitsPerTickQ16);
+    if (value != DSHOT_TELEMETRY_INVALID)
+    {
+        value = dshotTelemetryDecodeGcr(value);
+    }
+    if (value == DSHOT_TELEMETRY_INVALID)
+    {
+        ++tlm->errors;
+        return false;
+    }
+    ++tlm->frames;
+    dshotTelemetryProcess(tlm, value);
+    return true;
+}
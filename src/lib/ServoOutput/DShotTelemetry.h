@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+
+// A reply is 21 bits, a start bit then 4 GCR quintets where a 1 is a transition
+#define DSHOT_TELEMETRY_BITS 21
+// Each run is at least one bit long
+#define DSHOT_TELEMETRY_MAX_RUNS DSHOT_TELEMETRY_BITS
+#define DSHOT_TELEMETRY_INVALID 0xFFFFFFFFU
+
+// Bits of dshot_telemetry_t::updated
+#define DSHOT_TLM_ERPM          (1 << 0)
+#define DSHOT_TLM_TEMPERATURE   (1 << 1)
+#define DSHOT_TLM_VOLTAGE       (1 << 2)
+#define DSHOT_TLM_CURRENT       (1 << 3)
+
+/**
+ * The latest values one ESC has replied with. Temperature, voltage and current
+ * are only sent by ESCs with Extended DShot Telemetry (EDT) enabled.
+ */
+typedef struct {
+    uint32_t erpm;          // electrical RPM, divide by the pole pairs for RPM
+    uint16_t voltage;       // centivolts
+    uint8_t temperature;    // degrees C
+    uint8_t current;        // amps
+    uint8_t updated;        // DSHOT_TLM_x set for each value received, cleared by the reader
+    uint32_t frames;        // replies decoded
+    uint32_t errors;        // replies with bad timing, GCR or CRC
+} dshot_telemetry_t;
+
+/**
+ * @brief The reply's bits per capture tick, Q16
+ * @param tickHz the capture clock
+ * @param dshotRate DShot rate in kbit/s, e.g. 300, the reply is at 5/4 of it
+ */
+uint32_t dshotTelemetryBitsPerTick(uint32_t tickHz, uint16_t dshotRate);
+
+/**
+ * @brief Turn a capture into the 20 GCR bits
+ * @param runs duration of each level in ticks, starting with the low start bit.
+ *        The last high run merges into the idle line so can be missing.
+ * @return the GCR bits or DSHOT_TELEMETRY_INVALID if the timing doesn't fit a reply
+ */
+uint32_t dshotTelemetryRunsToGcr(const uint16_t *runs, uint8_t count, uint32_t bitsPerTickQ16);
+
+/**
+ * @brief Decode the GCR bits and check the CRC
+ * @return the 12 bit value or DSHOT_TELEMETRY_INVALID
+ */
+uint32_t dshotTelemetryDecodeGcr(uint32_t gcr);
+
+/**
+ * @brief Store a decoded 12 bit value as eRPM or the EDT value it carries
+ */
+void dshotTelemetryProcess(dshot_telemetry_t *tlm, uint16_t value);
+
+/**
+ * @brief All of the above, counting frames and errors
+ * @return true if the capture was a valid reply
+ */
+bool dshotTelemetryDecode(dshot_telemetry_t *tlm, const uint16_t *runs, uint8_t count, uint32_t bitsPerTickQ16);
@@ -0,0 +1,61 @@
+#include "ServoTransform.h"
+
+void servoTransformInit(servo_transform_t *t, uint8_t inputChannel, bool inverted, eServoOutputMode mode,
+                        bool narrow, eServoOutputFailsafeMode failsafeMode, uint16_t failsafeUs)
+{
+    t->inputChannel = inputChannel;
+    t->mode = mode;
+    t->failsafeMode = failsafeMode;
+
+    if (inverted)
+    {
+        // Flip the output around the mid-value, 3000 - us. The Q16 value is never a
+        // whole number so 3000 - floor(x) is floor(3001 - x)
+        t->usMul = -SERVO_CRSF_TO_US_MUL;
+        t->usAdd = (3001 << 16) - SERVO_CRSF_TO_US_ADD;
+    }
+    else
+    {
+        t->usMul = SERVO_CRSF_TO_US_MUL;
+        t->usAdd = SERVO_CRSF_TO_US_ADD;
+    }
+
+    switch (mode)
+    {
+    case somOnOff:
+        // 1 above 1500us
+        t->outMul = 1;
+        t->outAdd = -1500;
+        t->outShift = 0;
+        t->outMin = 0;
+        t->outMax = 1;
+        break;
+    case som10KHzDuty:
+        // 1000-2000us to 0-1000 tenths of a percent
+        t->outMul = 1;
+        t->outAdd = -1000;
+        t->outShift = 0;
+        t->outMin = 0;
+        t->outMax = 1000;
+        break;
+    case somDShot:
+        // 1000-2000us to the DShot throttle range
+        t->outMul = 2;
+        t->outAdd = 47 - 2000;
+        t->outShift = 0;
+        t->outMin = 48;
+        t->outMax = 2047;
+        break;
+    default:
+        // Servo PWM in us, halved in narrow mode
+        t->outMul = 1;
+        t->outAdd = 0;
+        t->outShift = narrow ? 1 : 0;
+        t->outMin = 0;
+        t->outMax = UINT16_MAX;
+        break;
+    }
+
+    // No pulses writes 0us, which every mode turns into its lowest output
+    t->failsafe = servoTransformOutput(t, failsafeMode == PWMFAILSAFE_SET_POSITION ? failsafeUs : 0);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+#include "targets.h"
+#include "common.h"
+
+// CRSF_to_US() as a Q16 multiply and add, us = (crsf * mul + add) >> 16
+#define SERVO_CRSF_TO_US_MUL ((((2012 - 988) << 16) + (1811 - 172) / 2) / (1811 - 172))
+#define SERVO_CRSF_TO_US_ADD ((988 << 16) + (1 << 15) - 172 * SERVO_CRSF_TO_US_MUL)
+// Failsafe positions are stored as an offset from this
+#define SERVO_FAILSAFE_MIN 988U
+
+/**
+ * Everything needed to turn a CRSF channel value into the value written to
+ * one output, worked out from the output's config when it changes:
+ *   us     = (crsf * usMul + usAdd) >> 16         CRSF_to_US() and inversion
+ *   output = clamp((us * outMul + outAdd) >> outShift, outMin, outMax)
+ * where the second step is the unit the output mode is written in.
+ */
+typedef struct {
+    int32_t usMul;
+    int32_t usAdd;
+    int16_t outAdd;
+    uint8_t outMul;
+    uint8_t outShift;
+    uint16_t outMin;
+    uint16_t outMax;
+    uint16_t failsafe;    // output value, not us
+    uint8_t inputChannel;
+    eServoOutputMode mode;
+    eServoOutputFailsafeMode failsafeMode;
+} servo_transform_t;
+
+/**
+ * @brief Build the transform for one output
+ * @param failsafeUs position for PWMFAILSAFE_SET_POSITION, absolute so it isn't inverted
+ */
+void servoTransformInit(servo_transform_t *t, uint8_t inputChannel, bool inverted, eServoOutputMode mode,
+                        bool narrow, eServoOutputFailsafeMode failsafeMode, uint16_t failsafeUs);
+
+/**
+ * @brief Convert microseconds to the value written to the output
+ */
+static inline uint16_t ICACHE_RAM_ATTR servoTransformOutput(const servo_transform_t *t, int32_t us)
+{
+    int32_t out = (us * t->outMul + t->outAdd) >> t->outShift;
+    out = out < t->outMin ? t->outMin : out;
+    out = out > t->outMax ? t->outMax : out;
+    return out;
+}
+
+/**
+ * @brief Convert a CRSF channel value to the value written to the output
+ */
+static inline uint16_t ICACHE_RAM_ATTR servoTransformApply(const servo_transform_t *t, uint32_t crsf)
+{
+    return servoTransformOutput(t, ((int32_t)crsf * t->usMul + t->usAdd) >> 16);
+}
+
+/**
+ * @brief Convert the channels for every output in one pass
+ * @param out output values, one per transform
+ * @return bit per output, set if its input channel has been received (isn't 0)
+ */
+static inline uint32_t ICACHE_RAM_ATTR servoTransformAll(const servo_transform_t *t, uint8_t count,
+                                                        const uint32_t *channelData, uint16_t *out)
+{
+    uint32_t valid = 0;
+    for (uint8_t ch = 0; ch < count; ++ch)
+    {
+        uint32_t const crsf = channelData[t[ch].inputChannel];
+        out[ch] = servoTransformApply(&t[ch], crsf);
+        valid |= (uint32_t)(crsf != 0) << ch;
+    }
+    return valid;
+}
@@ -1,19 +1,53 @@
 #if defined(GPIO_PIN_PWM_OUTPUTS)
 
 #include "devServoOutput.h"
+#include "ServoTransform.h"
 #include "PWM.h"
 #include "CRSF.h"
 #include "config.h"
 #include "logging.h"
 #include "rxtx_intf.h"
+#if defined(PLATFORM_ESP32) && defined(USE_DSHOT_TELEMETRY)
+#include "telemetry.h"
+
+/* Shameful externs */
+extern Telemetry telemetry;
+#endif
 
 static int8_t servoPins[PWM_MAX_CHANNELS];
 static pwm_channel_t pwmChannels[PWM_MAX_CHANNELS];
 static uint16_t pwmChannelValues[PWM_MAX_CHANNELS];
+// Worked out from the config, so the channels to output step doesn't need it
+static servo_transform_t servoTransforms[PWM_MAX_CHANNELS];
 
 #if (defined(PLATFORM_ESP32))
 static DShotRMT *dshotInstances[PWM_MAX_CHANNELS] = {nullptr};
-const uint8_t RMT_MAX_CHANNELS = 8;
+#if defined(USE_DSHOT_TELEMETRY)
+#if !defined(DSHOT_MOTOR_POLES)
+#define DSHOT_MOTOR_POLES 14
+#endif
+// Each output captures the ESC's replies with a second RMT channel
+#if SOC_RMT_TX_CANDIDATES_PER_GROUP == SOC_RMT_CHANNELS_PER_GROUP
+// Any channel can transmit or receive (ESP32), the replies go to the channel after the output's
+const uint8_t RMT_MAX_CHANNELS = SOC_RMT_CHANNELS_PER_GROUP;
+const uint8_t DSHOT_RMT_CHANNELS = 2;
+static rmt_channel_t dshotRxChannel(uint8_t txChannel) { return (rmt_channel_t)(txChannel + 1); }
+#else
+// The first channels only transmit and the rest only receive (S3 and C3), the replies go to the
+// receive channel in the same place as the output's transmit channel
+const uint8_t RMT_MAX_CHANNELS = SOC_RMT_TX_CANDIDATES_PER_GROUP < SOC_RMT_RX_CANDIDATES_PER_GROUP ? SOC_RMT_TX_CANDIDATES_PER_GROUP : SOC_RMT_RX_CANDIDATES_PER_GROUP;
+const uint8_t DSHOT_RMT_CHANNELS = 1;
+static rmt_channel_t dshotRxChannel(uint8_t txChannel) { return (rmt_channel_t)(SOC_RMT_TX_CANDIDATES_PER_GROUP + txChannel); }
+#endif
+const bool DSHOT_BIDIRECTIONAL = true;
+// How often the ESC telemetry is sent to the TX
+static constexpr uint32_t DSHOT_TELEMETRY_INTERVAL_MS = 200U;
+static dshot_telemetry_t dshotTelemetry[PWM_MAX_CHANNELS];
+#else
+const uint8_t RMT_MAX_CHANNELS = SOC_RMT_TX_CANDIDATES_PER_GROUP;
+const uint8_t DSHOT_RMT_CHANNELS = 1;
+const bool DSHOT_BIDIRECTIONAL = false;
+#endif
 #endif
 
 // true when the RX has a new channels packet
@@ -49,58 +83,85 @@ uint16_t servoOutputModeToFrequency(eServoOutputMode mode)
     }
 }
 
-static void servoWrite(uint8_t ch, uint16_t us)
+static void servosConfigure()
+{
+    for (int ch = 0 ; ch < GPIO_PIN_PWM_OUTPUTS_COUNT ; ++ch)
+    {
+        const rx_config_pwm_t *chConfig = config.GetPwmChannel(ch);
+        servoTransformInit(&servoTransforms[ch], chConfig->val.inputChannel, chConfig->val.inverted,
+                           (eServoOutputMode)chConfig->val.mode, chConfig->val.narrow,
+                           (eServoOutputFailsafeMode)chConfig->val.failsafeMode, chConfig->val.failsafe + SERVO_FAILSAFE_MIN);
+    }
+}
+
+/**
+ * @brief Write the outputs which have their bit set in mask
+ * @param values in the unit of each output's mode, from the servo_transform_t
+ */
+static void servosWrite(const uint16_t *values, uint32_t mask)
 {
-    const rx_config_pwm_t *chConfig = config.GetPwmChannel(ch);
 #if defined(PLATFORM_ESP32)
-    if ((eServoOutputMode)chConfig->val.mode == somDShot)
+    // Encode every DShot frame before starting any of them, so they go out together
+    for (int ch = 0 ; ch < GPIO_PIN_PWM_OUTPUTS_COUNT ; ++ch)
     {
-        // DBGLN("Writing DShot output: us: %u, ch: %d", us, ch);
-        if (dshotInstances[ch])
+        if ((mask & (1 << ch)) && dshotInstances[ch])
         {
-            dshotInstances[ch]->send_dshot_value(((us - 1000) * 2) + 47); // Convert PWM signal in us to DShot value
+            dshotInstances[ch]->prepare_dshot_value(values[ch]);
         }
     }
-    else
 #endif
-    if (servoPins[ch] != UNDEF_PIN && pwmChannelValues[ch] != us)
+    for (int ch = 0 ; ch < GPIO_PIN_PWM_OUTPUTS_COUNT ; ++ch)
     {
-        pwmChannelValues[ch] = us;
-        if ((eServoOutputMode)chConfig->val.mode == somOnOff)
+        if ((mask & (1 << ch)) == 0)
         {
-            digitalWrite(servoPins[ch], us > 1500);
+            continue;
         }
-        else if ((eServoOutputMode)chConfig->val.mode == som10KHzDuty)
+        uint16_t const value = values[ch];
+        eServoOutputMode const mode = servoTransforms[ch].mode;
+#if defined(PLATFORM_ESP32)
+        if (mode == somDShot)
         {
-            PWM.setDuty(pwmChannels[ch], constrain(us, 1000, 2000) - 1000);
+            if (dshotInstances[ch])
+            {
+                dshotInstances[ch]->output_prepared();
+            }
         }
         else
+#endif
+        if (servoPins[ch] != UNDEF_PIN && pwmChannelValues[ch] != value)
         {
-            PWM.setMicroseconds(pwmChannels[ch], us / (chConfig->val.narrow + 1));
+            pwmChannelValues[ch] = value;
+            if (mode == somOnOff)
+            {
+                digitalWrite(servoPins[ch], value);
+            }
+            else if (mode == som10KHzDuty)
+            {
+                PWM.setDuty(pwmChannels[ch], value);
+            }
+            else
+            {
+                PWM.setMicroseconds(pwmChannels[ch], value);
+            }
         }
     }
 }
 
 static void servosFailsafe()
 {
-    constexpr unsigned SERVO_FAILSAFE_MIN = 988U;
+    uint16_t values[PWM_MAX_CHANNELS];
+    uint32_t mask = 0;
     for (int ch = 0 ; ch < GPIO_PIN_PWM_OUTPUTS_COUNT ; ++ch)
     {
-        const rx_config_pwm_t *chConfig = config.GetPwmChannel(ch);
-        if (chConfig->val.failsafeMode == PWMFAILSAFE_SET_POSITION) {
-            // Note: Failsafe values do not respect the inverted flag, failsafe values are absolute
-            uint16_t us = chConfig->val.failsafe + SERVO_FAILSAFE_MIN;
-            // Always write the failsafe position even if the servo has never been started,
-            // so all the servos go to their expected position
-            servoWrite(ch, us);
-        }
-        else if (chConfig->val.failsafeMode == PWMFAILSAFE_NO_PULSES) {
-            servoWrite(ch, 0);
-        }
-        else if (chConfig->val.failsafeMode == PWMFAILSAFE_LAST_POSITION) {
-            // do nothing
+        // Always write the failsafe position even if the servo has never been started,
+        // so all the servos go to their expected position. Last position does nothing
+        values[ch] = servoTransforms[ch].failsafe;
+        if (servoTransforms[ch].failsafeMode != PWMFAILSAFE_LAST_POSITION)
+        {
+            mask |= 1 << ch;
         }
     }
+    servosWrite(values, mask);
 }
 
 static void servosUpdate(unsigned long now)
@@ -110,27 +171,12 @@ static void servosUpdate(unsigned long now)
     {
         newChannelsAvailable = false;
         lastUpdate = now;
-        for (int ch = 0 ; ch < GPIO_PIN_PWM_OUTPUTS_COUNT ; ++ch)
-        {
-            const rx_config_pwm_t *chConfig = config.GetPwmChannel(ch);
-            const unsigned crsfVal = ChannelData[chConfig->val.inputChannel];
-            // crsfVal might 0 if this is a switch channel, and it has not been
-            // received yet. Delay initializing the servo until the channel is valid
-            if (crsfVal == 0)
-            {
-                continue;
-            }
-
-            uint16_t us = CRSF_to_US(crsfVal);
-            // Flip the output around the mid-value if inverted
-            // (1500 - usOutput) + 1500
-            if (chConfig->val.inverted)
-            {
-                us = 3000U - us;
-            }
-            servoWrite(ch, us);
-        } /* for each servo */
-    }     /* if newChannelsAvailable */
+        uint16_t values[PWM_MAX_CHANNELS];
+        // A channel might be 0 if this is a switch channel, and it has not been
+        // received yet. Delay initializing the servo until the channel is valid
+        uint32_t const valid = servoTransformAll(servoTransforms, GPIO_PIN_PWM_OUTPUTS_COUNT, ChannelData, values);
+        servosWrite(values, valid);
+    }
 
     // LQ goes to 0 (100 packets missed in a row)
     // OR last update older than FAILSAFE_ABS_TIMEOUT_MS
@@ -142,6 +188,83 @@ static void servosUpdate(unsigned long now)
     }
 }
 
+#if defined(PLATFORM_ESP32) && defined(USE_DSHOT_TELEMETRY)
+static bool dshotSendsBattery()
+{
+#if defined(USE_ANALOG_VBAT)
+    if (GPIO_ANALOG_VBAT != UNDEF_PIN)
+    {
+        return false;
+    }
+#endif
+    return !telemetry.GetCrsfBatterySensorDetected();
+}
+
+/**
+ * @brief Decode the ESC replies, and send them as CRSF RPM, TEMP and battery frames.
+ * Every DShot output is in the frames in order, with its latest value
+ */
+static void servosUpdateTelemetry(unsigned long now)
+{
+    static uint32_t lastSent;
+    uint8_t updated = 0;
+    for (int ch = 0 ; ch < GPIO_PIN_PWM_OUTPUTS_COUNT ; ++ch)
+    {
+        if (dshotInstances[ch])
+        {
+            dshotInstances[ch]->read_telemetry(&dshotTelemetry[ch]);
+            updated |= dshotTelemetry[ch].updated;
+        }
+    }
+    if (updated == 0 || connectionState != connected || now - lastSent < DSHOT_TELEMETRY_INTERVAL_MS)
+    {
+        return;
+    }
+    lastSent = now;
+
+    constexpr uint8_t maxMotors = sizeof(crsf_sensor_rpm_t::rpm) / sizeof(crsf_sensor_rpm_t::rpm[0]);
+    CRSF_MK_FRAME_T(crsf_sensor_rpm_t) crsfRpm = {0};
+    CRSF_MK_FRAME_T(crsf_sensor_temp_t) crsfTemp = {0};
+    uint8_t motors = 0;
+    uint16_t voltage = 0;
+    uint16_t current = 0;
+    for (int ch = 0 ; ch < GPIO_PIN_PWM_OUTPUTS_COUNT && motors < maxMotors ; ++ch)
+    {
+        if (!dshotInstances[ch])
+        {
+            continue;
+        }
+        dshot_telemetry_t *tlm = &dshotTelemetry[ch];
+        uint32_t const rpm = tlm->erpm * 2 / DSHOT_MOTOR_POLES;
+        crsfRpm.p.rpm[motors][0] = rpm >> 16;
+        crsfRpm.p.rpm[motors][1] = rpm >> 8;
+        crsfRpm.p.rpm[motors][2] = rpm;
+        crsfTemp.p.temperature[motors] = htobe16(tlm->temperature * 10);
+        // The ESCs share a battery
+        voltage = tlm->voltage > voltage ? tlm->voltage : voltage;
+        current += tlm->current;
+        tlm->updated = 0;
+        ++motors;
+    }
+
+    telemetry.AppendSensorPayload((uint8_t *)&crsfRpm, CRSF_FRAMETYPE_RPM, CRSF_FRAME_SIZE(1 + 3 * motors));
+
+    // Temperature, voltage and current need EDT
+    if (updated & DSHOT_TLM_TEMPERATURE)
+    {
+        telemetry.AppendSensorPayload((uint8_t *)&crsfTemp, CRSF_FRAMETYPE_TEMP, CRSF_FRAME_SIZE(1 + 2 * motors));
+    }
+    if ((updated & DSHOT_TLM_VOLTAGE) && dshotSendsBattery())
+    {
+        CRSF_MK_FRAME_T(crsf_sensor_battery_t) crsfBatt = {0};
+        // Values are MSB first (BigEndian), in 0.1V and 0.1A
+        crsfBatt.p.voltage = htobe16(voltage / 10);
+        crsfBatt.p.current = htobe16(current * 10);
+        telemetry.AppendSensorPayload((uint8_t *)&crsfBatt, CRSF_FRAMETYPE_BATTERY_SENSOR, CRSF_FRAME_SIZE(sizeof(crsf_sensor_battery_t)));
+    }
+}
+#endif
+
 static void initialize()
 {
     if (!OPT_HAS_SERVO_OUTPUT)
@@ -173,14 +296,18 @@ static void initialize()
 #if defined(PLATFORM_ESP32)
         else if (mode == somDShot)
         {
-            if (rmtCH < RMT_MAX_CHANNELS)
+            if (rmtCH + DSHOT_RMT_CHANNELS <= RMT_MAX_CHANNELS)
             {
                 auto gpio = (gpio_num_t)pin;
                 auto rmtChannel = (rmt_channel_t)rmtCH;
                 DBGLN("Initializing DShot: gpio: %u, ch: %d, rmtChannel: %u", gpio, ch, rmtChannel);
                 pinMode(pin, OUTPUT);
+#if defined(USE_DSHOT_TELEMETRY)
+                dshotInstances[ch] = new DShotRMT(gpio, rmtChannel, dshotRxChannel(rmtCH));
+#else
                 dshotInstances[ch] = new DShotRMT(gpio, rmtChannel); // Initialize the DShotRMT instance
-                rmtCH++;
+#endif
+                rmtCH += DSHOT_RMT_CHANNELS;
             }
             pin = UNDEF_PIN;
         }
@@ -206,6 +333,7 @@ static void initialize()
 
 static int start()
 {
+    servosConfigure();
     for (int ch = 0; ch < GPIO_PIN_PWM_OUTPUTS_COUNT; ++ch)
     {
         const rx_config_pwm_t *chConfig = config.GetPwmChannel(ch);
@@ -217,7 +345,7 @@ static int start()
 #if defined(PLATFORM_ESP32)
         else if (((eServoOutputMode)chConfig->val.mode) == somDShot)
         {
-            dshotInstances[ch]->begin(DSHOT300, false); // Set DShot protocol and bidirectional dshot bool
+            dshotInstances[ch]->begin(DSHOT300, DSHOT_BIDIRECTIONAL); // Set DShot protocol and bidirectional dshot bool
             dshotInstances[ch]->send_dshot_value(0);         // Set throttle low so the ESC can continue initialsation
         }
 #endif
@@ -227,6 +355,11 @@ static int start()
 
 static int event()
 {
+    if (OPT_HAS_SERVO_OUTPUT)
+    {
+        // The config may have changed
+        servosConfigure();
+    }
     if (!OPT_HAS_SERVO_OUTPUT || connectionState == disconnected)
     {
         // Disconnected should come after failsafe on the RX,
@@ -259,6 +392,9 @@ static int event()
 static int timeout()
 {
     servosUpdate(millis());
+#if defined(PLATFORM_ESP32) && defined(USE_DSHOT_TELEMETRY)
+    servosUpdateTelemetry(millis());
+#endif
     return DURATION_IMMEDIATELY;
 }
 
@@ -94,6 +94,11 @@ bool StubbornReceiver::HasFinishedData()
     return finishedData;
 }
 
+uint8_t StubbornReceiver::GetReceivedLength()
+{
+    return currentOffset;
+}
+
 void StubbornReceiver::Unlock()
 {
     if (finishedData)
@@ -11,6 +11,7 @@ public:
     void SetDataToReceive(uint8_t* dataToReceive, uint8_t maxLength);
     void ReceiveData(uint8_t const packageIndex, uint8_t const * const receiveData, uint8_t dataLen);
     bool HasFinishedData();
+    uint8_t GetReceivedLength();
     void Unlock();
     bool GetCurrentConfirm();
 private:
@@ -4,7 +4,7 @@
 #include "stubborn_sender.h"
 
 StubbornSender::StubbornSender()
-    : data(nullptr), length(0)
+    : data(nullptr), length(0), deliveredCount(0)
 {
     ResetState();
 }
@@ -114,7 +114,10 @@ void StubbornSender::ConfirmCurrentPayload(bool telemetryConfirmValue)
             if (currentPackage == 1)
                 nextSenderState = WAIT_UNTIL_NEXT_CONFIRM;
             else
+            {
                 nextSenderState = SENDER_IDLE;
+                ++deliveredCount;
+            }
         }
 
         currentPackage++;
@@ -129,6 +132,9 @@ void StubbornSender::ConfirmCurrentPayload(bool telemetryConfirmValue)
         {
             nextSenderState = (senderState == RESYNC_THEN_SEND) ? SENDING : SENDER_IDLE;
             telemetryConfirmExpectedValue = !telemetryConfirmValue;
+            // Only the wait after a single package message is the end of a message
+            if (senderState == WAIT_UNTIL_NEXT_CONFIRM)
+                ++deliveredCount;
         }
         // switch to resync if tx does not confirm value fast enough
         else if (senderState == WAIT_UNTIL_NEXT_CONFIRM)
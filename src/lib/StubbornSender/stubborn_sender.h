@@ -25,6 +25,10 @@ public:
     uint8_t GetCurrentPayload(uint8_t *outData, uint8_t maxLen);
     void ConfirmCurrentPayload(bool telemetryConfirmValue);
     bool IsActive() const { return senderState != SENDER_IDLE; }
+    /**
+     * @return count of messages the receiver confirmed all of, which does not move when one is given up on
+     */
+    uint8_t GetDeliveredCount() const { return deliveredCount; }
     uint16_t GetMaxPacketsBeforeResync() const { return maxWaitCount; }
 private:
     uint8_t *data;
@@ -36,5 +40,6 @@ private:
     uint16_t waitCount;
     uint16_t maxWaitCount;
     uint8_t maxPackageIndex;
+    uint8_t deliveredCount;
     stubborn_sender_state_e senderState;
 };
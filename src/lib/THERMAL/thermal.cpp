@@ -44,14 +44,16 @@ void Thermal::init()
     }
 #endif
     DBGLN("Thermal OK!");
-    temp_value = 0;
     thermal_status = THERMAL_STATUS_NORMAL;
+    temp_value = read_temp();
+    temp_filter.fill(temp_value);
     update_threshold(0);
 }
 
 void Thermal::handle()
 {
-    temp_value = read_temp();
+    temp_filter.add(read_temp());
+    temp_value = temp_filter.calc();
 }
 
 uint8_t Thermal::read_temp()
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "targets.h"
+#include "median.h"
 
 typedef enum
 {
@@ -12,6 +13,8 @@ class Thermal
 {
 private:
     uint8_t temp_value;
+    // Median of the last 3 readings, drops a single bad read from the sensor
+    MedianFilter<uint8_t, 3> temp_filter;
 
 public:
     void init();
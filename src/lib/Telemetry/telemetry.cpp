@@ -81,7 +81,7 @@ void Telemetry::CheckCrsfBaroSensorDetected()
     }
 }
 
-PAYLOAD_DATA(GPS, BATTERY_SENSOR, ATTITUDE, DEVICE_INFO, FLIGHT_MODE, VARIO, BARO_ALTITUDE);
+PAYLOAD_DATA(GPS, BATTERY_SENSOR, ATTITUDE, DEVICE_INFO, FLIGHT_MODE, VARIO, BARO_ALTITUDE, RPM, TEMP);
 
 bool Telemetry::GetNextPayload(uint8_t* nextPayloadSize, uint8_t **payloadData)
 {
@@ -89,10 +89,21 @@ bool Telemetry::GetNextPayload(uint8_t* nextPayloadSize, uint8_t **payloadData)
     uint8_t oldPayloadIndex = currentPayloadIndex;
     uint8_t realLength = 0;
 
-    if (payloadTypes[currentPayloadIndex].locked)
+    crsf_telemetry_package_t &sent = payloadTypes[currentPayloadIndex];
+    if (sent.locked)
     {
-        payloadTypes[currentPayloadIndex].locked = false;
-        payloadTypes[currentPayloadIndex].updated = false;
+        sent.locked = false;
+        sent.updated = false;
+        if (sent.sparePending)
+        {
+            // A newer frame came in while this one was being sent, it is next
+            uint8_t *newest = sent.spare;
+            sent.spare = sent.data;
+            sent.data = newest;
+            sent.crcPending = sent.spareCrcPending;
+            sent.sparePending = false;
+            sent.updated = true;
+        }
     }
 
     do
@@ -103,9 +114,17 @@ bool Telemetry::GetNextPayload(uint8_t* nextPayloadSize, uint8_t **payloadData)
 
     if (payloadTypes[currentPayloadIndex].updated)
     {
-        payloadTypes[currentPayloadIndex].locked = true;
+        crsf_telemetry_package_t &next = payloadTypes[currentPayloadIndex];
+        next.locked = true;
+        ++next.sends;
 
-        realLength = CRSF_FRAME_SIZE(payloadTypes[currentPayloadIndex].data[CRSF_TELEMETRY_LENGTH_INDEX]);
+        realLength = CRSF_FRAME_SIZE(next.data[CRSF_TELEMETRY_LENGTH_INDEX]);
+        if (next.crcPending)
+        {
+            // Only the frame which is sent needs its CRC, not every one merged into it
+            next.data[realLength - 1] = crsf_crc.calc(next.data + CRSF_FRAME_NOT_COUNTED_BYTES, next.data[CRSF_TELEMETRY_LENGTH_INDEX] - CRSF_TELEMETRY_CRC_LENGTH);
+            next.crcPending = false;
+        }
         if (realLength > 0)
         {
             *nextPayloadSize = realLength;
@@ -154,6 +173,12 @@ void Telemetry::ResetState()
         payloadTypes[i].locked = false;
         payloadTypes[i].updated = false;
         payloadTypes[i].data = PayloadData + offset;
+        // The two general slots are a FIFO of separate messages, only sensor frames are merged
+        payloadTypes[i].spare = i < payloadTypesCount - 2 ? PayloadSpare + offset : nullptr;
+        payloadTypes[i].sparePending = false;
+        payloadTypes[i].crcPending = false;
+        payloadTypes[i].updates = 0;
+        payloadTypes[i].sends = 0;
         offset += payloadTypes[i].size;
 
         #if defined(UNIT_TEST)
@@ -283,6 +308,34 @@ bool Telemetry::AppendTelemetryPackage(uint8_t *package)
     if (processInternalTelemetryPackage(package))
         return true;
 
+    return appendPackage(package, false);
+}
+
+bool Telemetry::AppendSensorPayload(uint8_t *frame, crsf_frame_type_e frameType, uint8_t frameSize)
+{
+    crsf_header_t *header = (crsf_header_t *)frame;
+    header->device_addr = CRSF_ADDRESS_CRSF_TRANSMITTER;
+    header->frame_size = frameSize;
+    header->type = frameType;
+    return appendPackage(frame, true);
+}
+
+bool Telemetry::GetPayloadStats(uint8_t type, uint32_t *updates, uint32_t *sends)
+{
+    for (int8_t i = 0; i < payloadTypesCount - 2; i++)
+    {
+        if (payloadTypes[i].type == type)
+        {
+            *updates = payloadTypes[i].updates;
+            *sends = payloadTypes[i].sends;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Telemetry::appendPackage(uint8_t *package, bool crcPending)
+{
     const crsf_header_t *header = (crsf_header_t *) package;
     uint8_t targetIndex = 0;
     bool targetFound = false;
@@ -372,12 +425,27 @@ bool Telemetry::AppendTelemetryPackage(uint8_t *package)
         }
     }
 
-    if (targetFound && !payloadTypes[targetIndex].locked)
+    if (!targetFound)
     {
-        memcpy(payloadTypes[targetIndex].data, package, CRSF_FRAME_SIZE(package[CRSF_TELEMETRY_LENGTH_INDEX]));
-        payloadTypes[targetIndex].updated = true;
+        return false;
     }
 
-    return targetFound;
+    crsf_telemetry_package_t &target = payloadTypes[targetIndex];
+    ++target.updates;
+    if (!target.locked)
+    {
+        memcpy(target.data, package, CRSF_FRAME_SIZE(package[CRSF_TELEMETRY_LENGTH_INDEX]));
+        target.crcPending = crcPending;
+        target.updated = true;
+    }
+    else if (target.spare != nullptr)
+    {
+        // Keep the newest until this one has been sent, rather than dropping it
+        memcpy(target.spare, package, CRSF_FRAME_SIZE(package[CRSF_TELEMETRY_LENGTH_INDEX]));
+        target.spareCrcPending = crcPending;
+        target.sparePending = true;
+    }
+
+    return true;
 }
 #endif
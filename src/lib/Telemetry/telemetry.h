@@ -22,9 +22,15 @@ typedef struct crsf_telemetry_package_t {
     volatile bool locked;
     volatile bool updated;
     uint8_t *data;
+    uint8_t *spare;             // the newest frame while data is being sent, sensor types only
+    volatile bool sparePending;
+    bool crcPending;            // data needs its CRC before it is sent
+    bool spareCrcPending;
+    uint32_t updates;           // frames given for this type
+    uint32_t sends;             // frames sent, the rest were merged into a newer one
 } crsf_telemetry_package_t;
 
-#define PAYLOAD_DATA(type0, type1, type2, type3, type4, type5, type6)\
+#define PAYLOAD_DATA(type0, type1, type2, type3, type4, type5, type6, type7, type8)\
     uint8_t PayloadData[\
         CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type0##_PAYLOAD_SIZE) + \
         CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type1##_PAYLOAD_SIZE) + \
@@ -33,8 +39,11 @@ typedef struct crsf_telemetry_package_t {
         CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type4##_PAYLOAD_SIZE) + \
         CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type5##_PAYLOAD_SIZE) + \
         CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type6##_PAYLOAD_SIZE) + \
+        CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type7##_PAYLOAD_SIZE) + \
+        CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type8##_PAYLOAD_SIZE) + \
         CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_GENERAL_RESP_PAYLOAD_SIZE) + \
         CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_GENERAL_RESP_PAYLOAD_SIZE)]; \
+    uint8_t PayloadSpare[sizeof(PayloadData) - 2 * CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_GENERAL_RESP_PAYLOAD_SIZE)]; \
     crsf_telemetry_package_t payloadTypes[] = {\
     {CRSF_FRAMETYPE_##type0, CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type0##_PAYLOAD_SIZE), false, false, 0},\
     {CRSF_FRAMETYPE_##type1, CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type1##_PAYLOAD_SIZE), false, false, 0},\
@@ -43,6 +52,8 @@ typedef struct crsf_telemetry_package_t {
     {CRSF_FRAMETYPE_##type4, CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type4##_PAYLOAD_SIZE), false, false, 0},\
     {CRSF_FRAMETYPE_##type5, CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type5##_PAYLOAD_SIZE), false, false, 0},\
     {CRSF_FRAMETYPE_##type6, CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type6##_PAYLOAD_SIZE), false, false, 0},\
+    {CRSF_FRAMETYPE_##type7, CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type7##_PAYLOAD_SIZE), false, false, 0},\
+    {CRSF_FRAMETYPE_##type8, CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_##type8##_PAYLOAD_SIZE), false, false, 0},\
     {0, CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_GENERAL_RESP_PAYLOAD_SIZE), false, false, 0},\
     {0, CRSF_TELEMETRY_TOTAL_SIZE(CRSF_FRAME_GENERAL_RESP_PAYLOAD_SIZE), false, false, 0}};\
     const uint8_t payloadTypesCount = (sizeof(payloadTypes)/sizeof(crsf_telemetry_package_t))
@@ -68,8 +79,19 @@ public:
     uint8_t UpdatedPayloadCount();
     uint8_t ReceivedPackagesCount();
     bool AppendTelemetryPackage(uint8_t *package);
+    /**
+     * @brief Queue a sensor frame made on the RX. The header is filled in here, frames of
+     * the same type are merged until one is sent, and only the CRC is left until it is.
+     * @param frame a CRSF_MK_FRAME_T() with the payload filled in
+     */
+    bool AppendSensorPayload(uint8_t *frame, crsf_frame_type_e frameType, uint8_t frameSize);
+    /**
+     * @return false if the type has no slot of its own
+     */
+    bool GetPayloadStats(uint8_t type, uint32_t *updates, uint32_t *sends);
 private:
     bool processInternalTelemetryPackage(uint8_t *package);
+    bool appendPackage(uint8_t *package, bool crcPending);
     void AppendToPackage(volatile crsf_telemetry_package_t *current);
     uint8_t CRSFinBuffer[CRSF_MAX_PACKET_LEN];
     telemetry_state_s telemetry_state;
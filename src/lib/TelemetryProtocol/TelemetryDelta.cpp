@@ -0,0 +1,237 @@
+#include "TelemetryDelta.h"
+#include <string.h>
+#include "crsf_protocol.h"
+#include "crc.h"
+
+extern GENERIC_CRC8 crsf_crc;
+
+static const tlm_delta_layout_t layouts[TLM_DELTA_TYPES] = {
+    {CRSF_FRAMETYPE_GPS, 6, {4, 4, 2, 2, 2, 1}},
+    {CRSF_FRAMETYPE_BATTERY_SENSOR, 4, {2, 2, 3, 1}},
+    {CRSF_FRAMETYPE_ATTITUDE, 3, {2, 2, 2}},
+    {CRSF_FRAMETYPE_BARO_ALTITUDE, 2, {2, 2}},
+    {CRSF_FRAMETYPE_VARIO, 1, {2}},
+};
+
+/**
+ * @return the layout for the frame, or -1 if it is not one which is delta encoded
+ */
+static int8_t findLayout(const uint8_t *frame)
+{
+    for (uint8_t i = 0; i < TLM_DELTA_TYPES; i++)
+    {
+        if (frame[CRSF_TELEMETRY_TYPE_INDEX] != layouts[i].type)
+            continue;
+        // Only frames with exactly these fields, some FCs send shorter baro frames
+        uint8_t payloadLen = 0;
+        for (uint8_t f = 0; f < layouts[i].fieldCount; f++)
+            payloadLen += layouts[i].widths[f];
+        return frame[CRSF_TELEMETRY_LENGTH_INDEX] == payloadLen + 2 ? i : -1;
+    }
+    return -1;
+}
+
+static uint32_t readField(const uint8_t *p, uint8_t width)
+{
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < width; i++)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+static void writeField(uint8_t *p, uint8_t width, uint32_t v)
+{
+    for (uint8_t i = width; i > 0; i--)
+    {
+        p[i - 1] = (uint8_t)v;
+        v >>= 8;
+    }
+}
+
+static uint8_t checkOf(const uint8_t *frame, uint8_t refCrc)
+{
+    return crsf_crc.calc(&frame[CRSF_TELEMETRY_TYPE_INDEX], frame[CRSF_TELEMETRY_LENGTH_INDEX] - CRSF_TELEMETRY_CRC_LENGTH, refCrc);
+}
+
+void TelemetryDeltaEncoder::reset()
+{
+    memset(_refValid, 0, sizeof(_refValid));
+    memset(_sinceKeyframe, 0, sizeof(_sinceKeyframe));
+    memset(_pendingValid, 0, sizeof(_pendingValid));
+}
+
+uint8_t TelemetryDeltaEncoder::encode(const uint8_t *frame, uint8_t *out)
+{
+    uint8_t const frameLen = CRSF_FRAME_SIZE(frame[CRSF_TELEMETRY_LENGTH_INDEX]);
+    int8_t const idx = findLayout(frame);
+    if (idx < 0)
+    {
+        memcpy(out, frame, frameLen);
+        return frameLen;
+    }
+
+    // Against the frame of this type earlier in the same message if there is one, the TX
+    // has that by the time it gets to this one
+    bool const refValid = _pendingValid[idx] || _refValid[idx];
+    const uint8_t *ref = _pendingValid[idx] ? _pending[idx] : _ref[idx];
+    uint8_t const sinceKeyframe = _pendingValid[idx] ? _pendingSinceKeyframe[idx] : _sinceKeyframe[idx];
+    uint8_t len = 0;
+    if (refValid && sinceKeyframe < TLM_DELTA_KEYFRAME_INTERVAL)
+    {
+        const tlm_delta_layout_t &layout = layouts[idx];
+        uint8_t mask = 0;
+        len = TLM_DELTA_HEADER_LEN;
+        uint8_t pos = sizeof(crsf_header_t);
+        for (uint8_t f = 0; f < layout.fieldCount && len < frameLen; f++)
+        {
+            uint8_t const width = layout.widths[f];
+            uint8_t const bits = width * 8;
+            uint32_t diff = readField(&frame[pos], width) - readField(&ref[pos], width);
+            pos += width;
+            // Sign extend from the width of the field, so small steps either way are small
+            if (bits < 32)
+            {
+                diff &= (1UL << bits) - 1;
+                if (diff & (1UL << (bits - 1)))
+                    diff |= ~((1UL << bits) - 1);
+            }
+            if (diff == 0)
+                continue;
+            mask |= 1 << f;
+            uint32_t zigzag = (diff << 1) ^ (uint32_t)((int32_t)diff >> 31);
+            while (zigzag >= 0x80 && len < frameLen)
+            {
+                out[len++] = (uint8_t)zigzag | 0x80;
+                zigzag >>= 7;
+            }
+            if (len < frameLen)
+                out[len++] = (uint8_t)zigzag;
+        }
+        if (len < frameLen)
+        {
+            out[0] = TLM_DELTA_ADDRESS;
+            out[1] = len - 2;
+            out[2] = frame[CRSF_TELEMETRY_TYPE_INDEX];
+            out[3] = checkOf(frame, ref[CRSF_FRAME_SIZE(ref[CRSF_TELEMETRY_LENGTH_INDEX]) - 1]);
+            out[4] = mask;
+            _pendingSinceKeyframe[idx] = sinceKeyframe + 1;
+        }
+        else
+        {
+            len = 0;
+        }
+    }
+
+    if (len == 0)
+    {
+        // No frame to work from, time for a full one, or the delta is no smaller
+        memcpy(out, frame, frameLen);
+        _pendingSinceKeyframe[idx] = 0;
+        len = frameLen;
+    }
+    memcpy(_pending[idx], frame, frameLen);
+    _pendingValid[idx] = true;
+    return len;
+}
+
+void TelemetryDeltaEncoder::setMessageHeader(uint8_t *msg, uint8_t len)
+{
+    msg[0] = TLM_DELTA_ADDRESS;
+    msg[1] = len - TLM_DELTA_MSG_HEADER_LEN;
+}
+
+void TelemetryDeltaEncoder::confirm(bool delivered)
+{
+    for (uint8_t idx = 0; idx < TLM_DELTA_TYPES; idx++)
+    {
+        if (!_pendingValid[idx])
+            continue;
+        _pendingValid[idx] = false;
+        if (delivered)
+        {
+            memcpy(_ref[idx], _pending[idx], CRSF_FRAME_SIZE(_pending[idx][CRSF_TELEMETRY_LENGTH_INDEX]));
+            _sinceKeyframe[idx] = _pendingSinceKeyframe[idx];
+        }
+        // There's no knowing if the TX got a message that was given up on, so the next frame
+        // of each type in it goes whole rather than against a frame the TX might not have
+        _refValid[idx] = delivered;
+    }
+}
+
+void TelemetryDeltaDecoder::reset()
+{
+    memset(_refValid, 0, sizeof(_refValid));
+}
+
+bool TelemetryDeltaDecoder::decode(const uint8_t *in, uint8_t *frame)
+{
+    if (in[0] == TLM_DELTA_ADDRESS)
+    {
+        return rebuild(in, frame);
+    }
+
+    uint8_t const frameLen = CRSF_FRAME_SIZE(in[CRSF_TELEMETRY_LENGTH_INDEX]);
+    memcpy(frame, in, frameLen);
+    int8_t const idx = findLayout(in);
+    if (idx >= 0)
+    {
+        memcpy(_ref[idx], in, frameLen);
+        _refValid[idx] = true;
+    }
+    return true;
+}
+
+bool TelemetryDeltaDecoder::rebuild(const uint8_t *delta, uint8_t *frame)
+{
+    int8_t idx = -1;
+    for (uint8_t i = 0; i < TLM_DELTA_TYPES; i++)
+    {
+        if (layouts[i].type == delta[2])
+            idx = i;
+    }
+    if (idx < 0 || !_refValid[idx])
+    {
+        return false;
+    }
+
+    uint8_t *ref = _ref[idx];
+    uint8_t const frameLen = CRSF_FRAME_SIZE(ref[CRSF_TELEMETRY_LENGTH_INDEX]);
+    memcpy(frame, ref, frameLen);
+
+    const tlm_delta_layout_t &layout = layouts[idx];
+    uint8_t const end = delta[1] + 2;
+    uint8_t in = TLM_DELTA_HEADER_LEN;
+    uint8_t pos = sizeof(crsf_header_t);
+    bool ok = true;
+    for (uint8_t f = 0; f < layout.fieldCount && ok; f++)
+    {
+        uint8_t const width = layout.widths[f];
+        if (delta[4] & (1 << f))
+        {
+            uint32_t zigzag = 0;
+            uint8_t shift = 0;
+            do
+            {
+                ok = in < end && shift <= 28;
+                if (!ok)
+                    break;
+                zigzag |= (uint32_t)(delta[in] & 0x7F) << shift;
+                shift += 7;
+            } while (delta[in++] & 0x80);
+            uint32_t const diff = (zigzag >> 1) ^ (0 - (zigzag & 1));
+            writeField(&frame[pos], width, readField(&frame[pos], width) + diff);
+        }
+        pos += width;
+    }
+
+    if (!ok || in != end || checkOf(frame, ref[frameLen - 1]) != delta[3])
+    {
+        // Not against the frame this side has, nothing more of this type can be rebuilt
+        // until the next full frame
+        _refValid[idx] = false;
+        return false;
+    }
+    frame[frameLen - 1] = crsf_crc.calc(&frame[CRSF_TELEMETRY_TYPE_INDEX], frame[CRSF_TELEMETRY_LENGTH_INDEX] - CRSF_TELEMETRY_CRC_LENGTH);
+    memcpy(ref, frame, frameLen);
+    return true;
+}
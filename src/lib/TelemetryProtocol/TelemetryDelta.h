@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+
+#define TLM_DELTA_ADDRESS           0x8A    // in place of the CRSF address for a delta message or frame, CRSF_ADDRESS_RESERVED1
+#define TLM_DELTA_MSG_HEADER_LEN    2       // address, length
+#define TLM_DELTA_MSG_MAX           130     // the header and two of the largest CRSF frames
+#define TLM_DELTA_HEADER_LEN        5       // address, length, type, check, field mask
+#define TLM_DELTA_MAX_FIELDS        8
+#define TLM_DELTA_TYPES             5       // GPS, battery, attitude, baro altitude and vario
+#define TLM_DELTA_MAX_FRAME         19      // the largest frame which is delta encoded, GPS
+#define TLM_DELTA_KEYFRAME_INTERVAL 16      // a full frame of each type at least this often, in case the two sides disagree
+
+// Flags in the full res SYNC packet for what the TX can take
+#define OTA_TLM_FEATURE_DELTA       0x01
+
+typedef struct {
+    uint8_t type;
+    uint8_t fieldCount;
+    uint8_t widths[TLM_DELTA_MAX_FIELDS];   // bytes, big endian
+} tlm_delta_layout_t;
+
+/**
+ * Sensor frames which only change a little from one to the next are sent as the difference
+ * of each field from the last frame of the same type, zigzag and varint encoded. A field
+ * which has not changed takes no bytes at all. All the frames waiting to go are sent in
+ * one message, as the stubborn sender takes at least two packets for each message however
+ * short it is.
+ *
+ * A message is TLM_DELTA_ADDRESS, the length of what follows, then the frames. Each frame
+ * is either a whole CRSF frame, or a delta frame of
+ *   TLM_DELTA_ADDRESS, length of what follows, frame type,
+ *   check: CRC8 of the rebuilt type and payload, starting from the CRC of the reference frame,
+ *   field mask: bit per field which changed,
+ *   the changes
+ * The check is also what finds a delta against a frame the TX never got, so it is dropped
+ * rather than a wrong frame being passed to the handset.
+ */
+class TelemetryDeltaEncoder
+{
+public:
+    void reset();
+    /**
+     * @brief Add a CRSF frame to a message, against the last frame of its type the TX has
+     * @param out at least as large as the frame
+     * @return bytes added to out, a copy of the frame if it is better sent whole
+     */
+    uint8_t encode(const uint8_t *frame, uint8_t *out);
+    /**
+     * @brief Fill in the header of a message of frames added with encode()
+     * @param len of the whole message
+     */
+    static void setMessageHeader(uint8_t *msg, uint8_t len);
+    /**
+     * @brief The message has gone, or been given up on
+     * @param delivered the TX has it, so its frames are what the next of their types are against
+     */
+    void confirm(bool delivered);
+
+private:
+    uint8_t _ref[TLM_DELTA_TYPES][TLM_DELTA_MAX_FRAME];
+    bool _refValid[TLM_DELTA_TYPES];
+    uint8_t _sinceKeyframe[TLM_DELTA_TYPES];
+    uint8_t _pending[TLM_DELTA_TYPES][TLM_DELTA_MAX_FRAME];
+    bool _pendingValid[TLM_DELTA_TYPES];
+    uint8_t _pendingSinceKeyframe[TLM_DELTA_TYPES];
+};
+
+class TelemetryDeltaDecoder
+{
+public:
+    void reset();
+    /**
+     * @brief Get a whole CRSF frame from one frame of a message, keeping it for the deltas after it
+     * @param frame at least as large as the largest CRSF frame
+     * @return false if it is a delta against a frame this side does not have, and has to be dropped
+     */
+    bool decode(const uint8_t *in, uint8_t *frame);
+
+private:
+    bool rebuild(const uint8_t *delta, uint8_t *frame);
+
+    uint8_t _ref[TLM_DELTA_TYPES][TLM_DELTA_MAX_FRAME];
+    bool _refValid[TLM_DELTA_TYPES];
+};
@@ -0,0 +1,144 @@
+#include "VtxPowerControl.h"
+
+// Fraction of the calibrated slope used per step, /4. Less than all of it so the
+// VPD filter's lag and a calibration that is a little off don't make it overshoot
+#define VTX_POWER_KP_QUARTERS 3
+
+uint16_t vtxInterpolate(uint16_t freq, const uint16_t *freqs, const uint16_t *values, uint8_t count)
+{
+    if (freq <= freqs[0])
+    {
+        return values[0];
+    }
+    for (uint8_t i = 0; i < count - 1; i++)
+    {
+        if (freq < freqs[i + 1])
+        {
+            int32_t const span = freqs[i + 1] - freqs[i];
+            int32_t const delta = (int32_t)values[i + 1] - values[i];
+            return values[i] + (delta * (freq - freqs[i]) + (delta < 0 ? -span / 2 : span / 2)) / span;
+        }
+    }
+    return values[count - 1];
+}
+
+void vtxPowerCalibrate(vtx_power_cal_t *cal, uint16_t freq, const uint16_t *calFreqs, uint8_t calCount,
+                       const uint16_t *const vpd[VTX_POWER_CAL_LEVELS], const uint16_t *const pwm[VTX_POWER_CAL_LEVELS])
+{
+    for (uint8_t level = 0; level < VTX_POWER_CAL_LEVELS; level++)
+    {
+        cal->vpd[level] = vtxInterpolate(freq, calFreqs, vpd[level], calCount);
+        cal->pwm[level] = vtxInterpolate(freq, calFreqs, pwm[level], calCount);
+    }
+
+    // More VPD has to have taken less PWM, otherwise the arrays are no help
+    if (cal->vpd[VTX_POWER_CAL_LEVELS - 1] > cal->vpd[0] && cal->pwm[0] > cal->pwm[VTX_POWER_CAL_LEVELS - 1])
+    {
+        uint16_t const vpdRise = cal->vpd[VTX_POWER_CAL_LEVELS - 1] - cal->vpd[0];
+        uint16_t const pwmFall = cal->pwm[0] - cal->pwm[VTX_POWER_CAL_LEVELS - 1];
+        uint32_t const gain = ((uint32_t)pwmFall << 8) / vpdRise;
+        cal->gain = gain == 0 ? 1 : gain > UINT16_MAX ? UINT16_MAX : gain;
+    }
+    else
+    {
+        cal->gain = VTX_POWER_DEFAULT_GAIN;
+    }
+}
+
+void VtxPowerTable::build(const uint16_t *calFreqs, uint8_t calCount,
+                          const uint16_t *const vpd[VTX_POWER_CAL_LEVELS], const uint16_t *const pwm[VTX_POWER_CAL_LEVELS])
+{
+    _calFreqs = calFreqs;
+    _calCount = calCount;
+    _vpd = vpd;
+    _pwm = pwm;
+
+    // Sorted by frequency so get() can bisect
+    for (uint8_t i = 0; i < FREQ_TABLE_SIZE; i++)
+    {
+        uint16_t const freq = channelFreqTable[i];
+        uint8_t pos = i;
+        for (; pos > 0 && _freqs[pos - 1] > freq; pos--)
+        {
+            _freqs[pos] = _freqs[pos - 1];
+        }
+        _freqs[pos] = freq;
+    }
+    for (uint8_t i = 0; i < FREQ_TABLE_SIZE; i++)
+    {
+        vtxPowerCalibrate(&_table[i], _freqs[i], calFreqs, calCount, vpd, pwm);
+    }
+}
+
+void VtxPowerTable::get(uint16_t freq, vtx_power_cal_t *cal) const
+{
+    uint8_t lo = 0;
+    uint8_t hi = FREQ_TABLE_SIZE;
+    while (lo < hi)
+    {
+        uint8_t const mid = (lo + hi) / 2;
+        if (_freqs[mid] < freq)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < FREQ_TABLE_SIZE && _freqs[lo] == freq)
+    {
+        *cal = _table[lo];
+        return;
+    }
+    vtxPowerCalibrate(cal, freq, _calFreqs, _calCount, _vpd, _pwm);
+}
+
+void VtxPowerController::start(uint16_t setPoint, uint16_t pwm, uint16_t gain, uint16_t pwmMin, uint16_t pwmMax, uint16_t buffer)
+{
+    _setPoint = setPoint;
+    _pwm = pwm;
+    _gain = gain;
+    _pwmMin = pwmMin;
+    _pwmMax = pwmMax;
+    _buffer = buffer;
+    _vpd = 0;
+    _stepped = true;
+    _iterations = 0;
+    _settleIterations = 0;
+    _inBuffer = 0;
+    _errorAvg = 0;
+}
+
+uint16_t VtxPowerController::update(uint16_t vpdReading)
+{
+    // The PA has settled by the next reading, so only average readings taken at the same PWM.
+    // Averaging across a step would count the old PWM's error twice and ring
+    _vpd = _stepped ? vpdReading : (_vpd + vpdReading) / 2;
+    _stepped = false;
+    if (_iterations < UINT16_MAX)
+    {
+        ++_iterations;
+    }
+
+    int32_t const error = (int32_t)_setPoint - _vpd;
+    if (error > _buffer || error < -(int32_t)_buffer)
+    {
+        int32_t step = error * _gain * VTX_POWER_KP_QUARTERS / (4 << 8);
+        if (step == 0)
+        {
+            step = error > 0 ? 1 : -1;
+        }
+        int32_t const pwm = (int32_t)_pwm - step;
+        _pwm = pwm < _pwmMin ? _pwmMin : pwm > _pwmMax ? _pwmMax : pwm;
+        _stepped = true;
+        _inBuffer = 0;
+    }
+    else if (!isSettled() && ++_inBuffer >= VTX_POWER_SETTLED_COUNT)
+    {
+        _settleIterations = _iterations - VTX_POWER_SETTLED_COUNT + 1;
+        _errorAvg = error * 8;
+    }
+
+    if (isSettled())
+    {
+        _errorAvg += error - _errorAvg / 8;
+    }
+    return _pwm;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdint.h>
+#include "freqTable.h"
+
+#define VTX_POWER_CAL_LEVELS            2   // 25mW and 100mW have calibration arrays
+#define VTX_POWER_DEFAULT_GAIN          256 // Q8 PWM per VPD count, when the calibration doesn't give one
+#define VTX_POWER_SETTLED_COUNT         3   // readings in a row within the buffer to count as settled
+
+/**
+ * The calibration of one frequency. A higher VPD is more power, which needs a lower PWM.
+ */
+typedef struct {
+    uint16_t vpd[VTX_POWER_CAL_LEVELS];
+    uint16_t pwm[VTX_POWER_CAL_LEVELS];
+    uint16_t gain; // Q8 PWM decrease per VPD count increase, the slope between the levels
+} vtx_power_cal_t;
+
+/**
+ * @brief Linear interpolation of values[] between the points of freqs[], which must be ascending.
+ * Outside of freqs[] the nearest end is used.
+ */
+uint16_t vtxInterpolate(uint16_t freq, const uint16_t *freqs, const uint16_t *values, uint8_t count);
+
+/**
+ * @brief Work out the calibration at freq from the calibration arrays
+ */
+void vtxPowerCalibrate(vtx_power_cal_t *cal, uint16_t freq, const uint16_t *calFreqs, uint8_t calCount,
+                       const uint16_t *const vpd[VTX_POWER_CAL_LEVELS], const uint16_t *const pwm[VTX_POWER_CAL_LEVELS]);
+
+/**
+ * Calibration of every channel in channelFreqTable, built once at startup so
+ * a power or channel change is a lookup rather than interpolating the arrays.
+ */
+class VtxPowerTable
+{
+public:
+    void build(const uint16_t *calFreqs, uint8_t calCount,
+               const uint16_t *const vpd[VTX_POWER_CAL_LEVELS], const uint16_t *const pwm[VTX_POWER_CAL_LEVELS]);
+    /**
+     * @brief The calibration at freq, interpolated if it isn't a channel in the table
+     */
+    void get(uint16_t freq, vtx_power_cal_t *cal) const;
+
+private:
+    const uint16_t *_calFreqs;
+    const uint16_t *const *_vpd;
+    const uint16_t *const *_pwm;
+    uint8_t _calCount;
+    uint16_t _freqs[FREQ_TABLE_SIZE]; // channelFreqTable, ascending
+    vtx_power_cal_t _table[FREQ_TABLE_SIZE];
+};
+
+/**
+ * Proportional control of the PA PWM to bring the VPD to its setpoint. The
+ * step is the error times the slope between the calibrated levels, so it gets
+ * there in a few readings rather than one PWM unit per reading.
+ */
+class VtxPowerController
+{
+public:
+    /**
+     * @brief Start on a new setpoint
+     * @param pwm the starting PWM, from the calibration
+     * @param gain Q8 PWM per VPD count, from the calibration
+     * @param buffer +/-VPD counts which count as on the setpoint
+     */
+    void start(uint16_t setPoint, uint16_t pwm, uint16_t gain, uint16_t pwmMin, uint16_t pwmMax, uint16_t buffer);
+    /**
+     * @brief Move the setpoint without restarting, keeping the filtered VPD and PWM
+     */
+    void setSetPoint(uint16_t setPoint) { _setPoint = setPoint; }
+
+    /**
+     * @brief Add a VPD reading
+     * @return the new PWM
+     */
+    uint16_t update(uint16_t vpdReading);
+
+    uint16_t getPwm() const { return _pwm; }
+    uint16_t getVpd() const { return _vpd; }
+    bool isSettled() const { return _settleIterations != 0; }
+    /**
+     * @return readings from start() until the VPD was within the buffer and stayed there, 0 if not yet
+     */
+    uint16_t getSettleIterations() const { return _settleIterations; }
+    /**
+     * @return average of setpoint - VPD since it settled
+     */
+    int16_t getSteadyStateError() const { return _errorAvg / 8; }
+
+private:
+    uint16_t _setPoint;
+    uint16_t _pwm;
+    uint16_t _gain;
+    uint16_t _pwmMin;
+    uint16_t _pwmMax;
+    uint16_t _buffer;
+    uint16_t _vpd;
+    bool _stepped;
+    uint16_t _iterations;
+    uint16_t _settleIterations;
+    uint8_t _inBuffer;
+    int32_t _errorAvg; // x8
+};
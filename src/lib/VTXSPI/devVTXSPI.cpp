@@ -8,6 +8,7 @@
 #include "logging.h"
 #include <SPI.h>
 #include "PWM.h"
+#include "VtxPowerControl.h"
 
 #define SYNTHESIZER_REGISTER_A                  0x00
 #define SYNTHESIZER_REGISTER_B                  0x01
@@ -66,7 +67,10 @@ static uint16_t vtxMinPWM = MIN_PWM;
 static uint16_t vtxMaxPWM = MAX_PWM;
 
 static uint16_t VpdSetPoint = 0;
-static uint16_t Vpd = 0;
+static bool VpdSetPointStale = false;
+
+static VtxPowerTable vtxPowerTable;
+static VtxPowerController vtxPowerController;
 
 static bool stopVtxMonitoring = false;
 
@@ -86,6 +90,8 @@ uint16_t PwmArray100mW[] = PWM_VALUES_100MW;
 
 uint16_t VpdFreqArray[] = {5650, 5750, 5850, 5950};
 uint8_t VpdSetPointCount =  ARRAY_SIZE(VpdFreqArray);
+static const uint16_t *VpdSetPointArrays[VTX_POWER_CAL_LEVELS];
+static const uint16_t *PwmArrays[VTX_POWER_CAL_LEVELS];
 
 static SPIClass *vtxSPI;
 
@@ -191,72 +197,11 @@ void VTxOutputMinimum()
     setPWM();
 }
 
-static void VTxOutputIncrease()
-{
-    if (vtxSPIPWM > vtxMinPWM) vtxSPIPWM -= 1;
-    setPWM();
-}
-
-static void VTxOutputDecrease()
-{
-    if (vtxSPIPWM < vtxMaxPWM) vtxSPIPWM += 1;
-    setPWM();
-}
-
-static uint16_t LinearInterpVpdSetPointArray(const uint16_t VpdSetPointArray[])
-{
-    uint16_t newVpd = 0;
-
-    if (vtxSPIFrequencyCurrent <= VpdFreqArray[0])
-    {
-        newVpd = VpdSetPointArray[0];
-    }
-    else if (vtxSPIFrequencyCurrent >= VpdFreqArray[VpdSetPointCount - 1])
-    {
-        newVpd = VpdSetPointArray[VpdSetPointCount - 1];
-    }
-    else
-    {
-        for (uint8_t i = 0; i < (VpdSetPointCount - 1); i++)
-        {
-            if (vtxSPIFrequencyCurrent < VpdFreqArray[i + 1])
-            {
-                newVpd = VpdSetPointArray[i] + ((VpdSetPointArray[i + 1]-VpdSetPointArray[i])/(VpdFreqArray[i + 1]-VpdFreqArray[i])) * (vtxSPIFrequencyCurrent - VpdFreqArray[i]);
-            }
-        }
-    }
-
-    return newVpd;
-}
-
-static uint16_t LinearInterpSetPwm(const uint16_t PwmArray[])
-{
-    uint16_t newPwm = 0;
-
-    if (vtxSPIFrequencyCurrent <= VpdFreqArray[0])
-    {
-        newPwm = PwmArray[0];
-    }
-    else if (vtxSPIFrequencyCurrent >= VpdFreqArray[VpdSetPointCount - 1])
-    {
-        newPwm = PwmArray[VpdSetPointCount - 1];
-    }
-    else
-    {
-        for (uint8_t i = 0; i < (VpdSetPointCount - 1); i++)
-        {
-            if (vtxSPIFrequencyCurrent < VpdFreqArray[i + 1])
-            {
-                newPwm = PwmArray[i] + ((PwmArray[i + 1]-PwmArray[i])/(VpdFreqArray[i + 1]-VpdFreqArray[i])) * (vtxSPIFrequencyCurrent - VpdFreqArray[i]);
-            }
-        }
-    }
-
-    return newPwm;
-}
-
 static void SetVpdSetPoint()
 {
+    vtx_power_cal_t cal;
+    vtxPowerTable.get(vtxSPIFrequencyCurrent, &cal);
+
     switch (vtxSPIPowerIdx)
     {
     case 1: // 0 mW
@@ -266,13 +211,13 @@ static void SetVpdSetPoint()
 
     case 2: // RCE
     case 3: // 25 mW
-        VpdSetPoint = LinearInterpVpdSetPointArray(VpdSetPointArray25mW);
-        vtxSPIPWM = LinearInterpSetPwm(PwmArray25mW);
+        VpdSetPoint = cal.vpd[0];
+        vtxSPIPWM = cal.pwm[0];
         break;
 
     case 4: // 100 mW
-        VpdSetPoint = LinearInterpVpdSetPointArray(VpdSetPointArray100mW);
-        vtxSPIPWM = LinearInterpSetPwm(PwmArray100mW);
+        VpdSetPoint = cal.vpd[1];
+        vtxSPIPWM = cal.pwm[1];
         break;
 
     default: // YOLO mW
@@ -281,6 +226,7 @@ static void SetVpdSetPoint()
         break;
     }
 
+    vtxPowerController.start(VpdSetPoint, vtxSPIPWM, cal.gain, vtxMinPWM, vtxMaxPWM, VPD_BUFFER);
     setPWM();
     DBGLN("VTX: Setting new VPD setpoint: %d, initial PWM: %d", VpdSetPoint, vtxSPIPWM);
 }
@@ -297,19 +243,22 @@ static void checkOutputPower()
 
         uint16_t VpdReading = analogRead(GPIO_PIN_RF_AMP_VPD); // WARNING - Max input 1.0V !!!!
 
-        Vpd = (8 * Vpd + 2 * VpdReading) / 10; // IIR filter
+        vtxSPIPWM = vtxPowerController.update(VpdReading);
+        setPWM();
 
-        if (Vpd < (VpdSetPoint - VPD_BUFFER))
-        {
-            VTxOutputIncrease();
-        }
-        else if (Vpd > (VpdSetPoint + VPD_BUFFER))
-        {
-            VTxOutputDecrease();
-        }
+        //DBGLN("VTX: VPD setpoint=%d, raw=%d, filtered=%d, PWM=%d", VpdSetPoint, VpdReading, vtxPowerController.getVpd(), vtxSPIPWM);
+    }
+}
 
-        //DBGLN("VTX: VPD setpoint=%d, raw=%d, filtered=%d, PWM=%d", VpdSetPoint, VpdReading, Vpd, vtxSPIPWM);
+bool VTxSPIGetPowerStats(uint16_t *settleMs, int16_t *error)
+{
+    if (!vtxPowerController.isSettled())
+    {
+        return false;
     }
+    *settleMs = vtxPowerController.getSettleIterations() * VTX_POWER_INTERVAL_MS;
+    *error = vtxPowerController.getSteadyStateError();
+    return true;
 }
 
 #if defined(VTX_OUTPUT_CALIBRATION)
@@ -323,10 +272,11 @@ static int gatherOutputCalibrationData()
     {
         sampleCount++;
         checkOutputPower();
-        DBGLN("VTX Freq=%d, VPD setpoint=%d, VPD=%d, PWM=%d, sample=%d", VpdFreqArray[calibFreqIndex], VpdSetPoint, Vpd, vtxSPIPWM, sampleCount);
+        DBGLN("VTX Freq=%d, VPD setpoint=%d, VPD=%d, PWM=%d, sample=%d", VpdFreqArray[calibFreqIndex], VpdSetPoint, vtxPowerController.getVpd(), vtxSPIPWM, sampleCount);
         if (sampleCount >= CALIB_SAMPLES)
         {
             VpdSetPoint += VPD_BUFFER;
+            vtxPowerController.setSetPoint(VpdSetPoint);
             sampleCount = 0;
         }
 
@@ -335,6 +285,7 @@ static int gatherOutputCalibrationData()
             calibFreqIndex++;
             rtc6705SetFrequency(VpdFreqArray[calibFreqIndex]);
             VpdSetPoint = VPD_BUFFER;
+            vtxPowerController.start(VpdSetPoint, vtxMaxPWM, VTX_POWER_DEFAULT_GAIN, vtxMinPWM, vtxMaxPWM, VPD_BUFFER);
             return RTC6705_PLL_SETTLE_TIME_MS;
         }
         return VTX_POWER_INTERVAL_MS;
@@ -358,6 +309,10 @@ static void initialize()
     PwmArray25mW = PWM_VALUES_25MW;
     PwmArray100mW = PWM_VALUES_100MW;
     #endif
+    VpdSetPointArrays[0] = VpdSetPointArray25mW;
+    VpdSetPointArrays[1] = VpdSetPointArray100mW;
+    PwmArrays[0] = PwmArray25mW;
+    PwmArrays[1] = PwmArray100mW;
 
     if (GPIO_PIN_SPI_VTX_NSS != UNDEF_PIN)
     {
@@ -398,6 +353,10 @@ static void initialize()
             analogWriteResolution(12); // 0 - 4095
         #endif
         setPWM();
+
+        vtxPowerTable.build(VpdFreqArray, VpdSetPointCount, VpdSetPointArrays, PwmArrays);
+        // Hold the output at the minimum until a power is set
+        vtxPowerController.start(VpdSetPoint, vtxSPIPWM, VTX_POWER_DEFAULT_GAIN, vtxMinPWM, vtxMaxPWM, VPD_BUFFER);
     }
 }
 
@@ -412,6 +371,7 @@ static int start()
     rtc6705SetFrequency(VpdFreqArray[calibFreqIndex]); // Set to the first calib frequency
     vtxSPIPitmodeCurrent = 0;
     VpdSetPoint = VPD_SETPOINT_0_MW;
+    vtxPowerController.start(VpdSetPoint, vtxMaxPWM, VTX_POWER_DEFAULT_GAIN, vtxMinPWM, vtxMaxPWM, VPD_BUFFER);
     rtc6705PowerAmpOn();
     return RTC6705_PLL_SETTLE_TIME_MS;
 #endif
@@ -441,6 +401,8 @@ static int timeout()
         rtc6705SetFrequency(vtxSPIFrequency);
         vtxSPIFrequencyCurrent = vtxSPIFrequency;
         vtxPowerAmpEnable = true;
+        // Setting the frequency turned the output down, start again from the new channel's calibration
+        VpdSetPointStale = vtxSPIPowerIdxCurrent != 0;
 
         DBGLN("VTX: Set frequency: %d", vtxSPIFrequency);
 
@@ -460,11 +422,12 @@ static int timeout()
         return VTX_POWER_INTERVAL_MS;
     }
 
-    if (vtxSPIPowerIdxCurrent != vtxSPIPowerIdx)
+    if (vtxSPIPowerIdxCurrent != vtxSPIPowerIdx || VpdSetPointStale)
     {
         DBGLN("VTX: Set power: %d", vtxSPIPowerIdx);
         SetVpdSetPoint();
         vtxSPIPowerIdxCurrent = vtxSPIPowerIdx;
+        VpdSetPointStale = false;
     }
 
     if (vtxSPIPitmodeCurrent != vtxSPIPitmode)
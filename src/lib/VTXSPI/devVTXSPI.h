@@ -10,3 +10,8 @@ extern uint8_t vtxSPIPitmode;
 
 void VTxOutputMinimum();
 void disableVTxSpi();
+/**
+ * @brief How long the output took to reach the VPD setpoint, and the average error since
+ * @return false if it hasn't got there yet
+ */
+bool VTxSPIGetPowerStats(uint16_t *settleMs, int16_t *error);
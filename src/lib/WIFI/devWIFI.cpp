@@ -872,6 +872,16 @@ static void WebUpdateGetFirmware(AsyncWebServerRequest *request) {
   request->send(response);
 }
 
+// The band's center, or with a segment argument the channel in the middle of that power calibration segment
+static uint32_t ContinuousWaveFrequency(AsyncWebServerRequest *request, const fhss_config_t *fhss) {
+  if (!request->hasArg("segment")) {
+    return fhss->freq_center;
+  }
+  uint32_t segment = request->arg("segment").toInt() % POWER_FREQ_CALI_SEGMENTS;
+  uint32_t channel = (segment * 2 + 1) * fhss->freq_count / (POWER_FREQ_CALI_SEGMENTS * 2);
+  return fhss->freq_start + (fhss->freq_stop - fhss->freq_start) / (fhss->freq_count - 1) * channel;
+}
+
 static void HandleContinuousWave(AsyncWebServerRequest *request) {
   if (request->hasArg("radio")) {
     SX12XX_Radio_Number_t radio = request->arg("radio").toInt() == 1 ? SX12XX_Radio_1 : SX12XX_Radio_2;
@@ -893,9 +903,9 @@ static void HandleContinuousWave(AsyncWebServerRequest *request) {
     POWERMGNT::setPower(POWERMGNT::getMinPower());
 
 #if defined(RADIO_LR1121)
-    Radio.startCWTest(setSubGHz ? FHSSconfig->freq_center : FHSSconfigDualBand->freq_center, radio);
+    Radio.startCWTest(ContinuousWaveFrequency(request, setSubGHz ? FHSSconfig : FHSSconfigDualBand), radio);
 #else
-    Radio.startCWTest(FHSSconfig->freq_center, radio);
+    Radio.startCWTest(ContinuousWaveFrequency(request, FHSSconfig), radio);
 #if defined(RADIO_SX127X)
     deferExecutionMillis(50, [radio](){ Radio.cwRepeat(radio); });
 #endif
@@ -910,6 +920,42 @@ static void HandleContinuousWave(AsyncWebServerRequest *request) {
   }
 }
 
+#if defined(TARGET_TX)
+static void GetPowerCalibration(AsyncWebServerRequest *request)
+{
+  AsyncJsonResponse *response = new AsyncJsonResponse();
+  JsonObject json = response->getRoot();
+  JsonArray bands = json["bands"].to<JsonArray>();
+  for (uint8_t band = 0 ; band < POWER_FREQ_CALI_BANDS ; band++)
+  {
+    int8_t values[POWER_FREQ_CALI_SEGMENTS];
+    POWERMGNT::GetFreqCaliValues(band, values);
+    JsonArray segments = bands.add<JsonArray>();
+    copyArray(values, POWER_FREQ_CALI_SEGMENTS, segments);
+  }
+  response->setLength();
+  request->send(response);
+}
+
+static void UpdatePowerCalibration(AsyncWebServerRequest *request, JsonVariant &json)
+{
+  uint8_t band = json["band"] | 0;
+  const JsonArray &array = json["values"].as<JsonArray>();
+  if (band >= POWER_FREQ_CALI_BANDS || array.size() != POWER_FREQ_CALI_SEGMENTS)
+  {
+    request->send(400, "text/plain", "Expected a band and " + String(POWER_FREQ_CALI_SEGMENTS) + " values");
+    return;
+  }
+  int8_t values[POWER_FREQ_CALI_SEGMENTS];
+  for (uint8_t segment = 0 ; segment < POWER_FREQ_CALI_SEGMENTS ; segment++)
+  {
+    values[segment] = constrain((int)array[segment], -POWER_FREQ_CALI_MAX, POWER_FREQ_CALI_MAX);
+  }
+  POWERMGNT::SetFreqCaliValues(band, values);
+  request->send(200, "text/plain", "Power calibration saved");
+}
+#endif
+
 static void initialize()
 {
   wifiStarted = false;
@@ -1107,6 +1153,8 @@ static void startServices()
   #if defined(TARGET_TX)
     server.addHandler(new AsyncCallbackJsonWebHandler("/buttons", WebUpdateButtonColors));
     server.addHandler(new AsyncCallbackJsonWebHandler("/import", ImportConfiguration, 32768U));
+    server.on("/powercal", HTTP_GET, GetPowerCalibration);
+    server.addHandler(new AsyncCallbackJsonWebHandler("/powercal", UpdatePowerCalibration));
   #endif
 
   #if defined(RADIO_LR1121)
@@ -9,51 +9,77 @@
 
 #include "common.h"
 #include "SPIEx.h"
+#include "LR1121Updater.h"
 #include "logging.h"
 
-struct lr1121UpdateState_s {
-    size_t expectedFilesize;
-    size_t totalSize;
-    SX12XX_Radio_Number_t updatingRadio;
-    size_t left_over;
-    struct {
-        uint8_t header[6];
-        uint8_t buffer[256];
-    } __attribute__((packed)) packet;
-};
-static lr1121UpdateState_s *lr1121UpdateState;
-
 extern LR1121Hal hal;
 
-static void writeLR1121Bytes(uint8_t *data, uint32_t data_size) {
-    lr1121UpdateState->packet.header[0] = (uint8_t)(LR11XX_BL_WRITE_FLASH_ENCRYPTED_OC >> 8);
-    lr1121UpdateState->packet.header[1] = (uint8_t)(LR11XX_BL_WRITE_FLASH_ENCRYPTED_OC);
-    lr1121UpdateState->packet.header[2] = (uint8_t)(lr1121UpdateState->totalSize >> 24);
-    lr1121UpdateState->packet.header[3] = (uint8_t)(lr1121UpdateState->totalSize >> 16);
-    lr1121UpdateState->packet.header[4] = (uint8_t)(lr1121UpdateState->totalSize >> 8);
-    lr1121UpdateState->packet.header[5] = (uint8_t)(lr1121UpdateState->totalSize);
+#define LR1121_UPDATE_IDLE_SLEEP_MS 2       // waiting on BUSY longer than this sleeps rather than yields
+#define LR1121_UPDATE_STALL_MS      2000    // no upload data for this long and the upload is taken to have stopped
 
-    uint32_t write_size = lr1121UpdateState->left_over;
-    if (data != nullptr)
+class LR1121SPIPort : public LR1121UpdatePort
+{
+public:
+    void startWrite(uint8_t *packet, uint32_t size) override
+    {
+        // Have to do this the OLD way, so we can pump out more than 64 bytes in one message
+        digitalWrite(radio == SX12XX_Radio_1 ? GPIO_PIN_NSS : GPIO_PIN_NSS_2, LOW);
+        SPIEx.transferBytes(packet, nullptr, size);
+        digitalWrite(radio == SX12XX_Radio_1 ? GPIO_PIN_NSS : GPIO_PIN_NSS_2, HIGH);
+        writeStartMs = millis();
+    }
+    bool isBusy() override { return digitalRead(radio == SX12XX_Radio_1 ? GPIO_PIN_BUSY : GPIO_PIN_BUSY_2) == HIGH; }
+    void idle() override
     {
-        DBGLN("new %x", data_size);
-        memcpy(lr1121UpdateState->packet.buffer + lr1121UpdateState->left_over, data, data_size);
-        write_size += data_size;
+        // This is on the web server task, so let everything else run rather than spinning.
+        // A packet normally takes well under a millisecond, only sleep if it is taking longer.
+        if (millis() - writeStartMs < LR1121_UPDATE_IDLE_SLEEP_MS)
+            delay(0);
+        else
+            delay(1);
     }
-    DBGLN("flashing %x at %x", write_size, lr1121UpdateState->totalSize);
+    uint32_t getMillis() override { return millis(); }
 
-    // Have to do this the OLD way, so we can pump out more than 64 bytes in one message
-    digitalWrite(lr1121UpdateState->updatingRadio == SX12XX_Radio_1 ? GPIO_PIN_NSS : GPIO_PIN_NSS_2, LOW);
-    SPIEx.transferBytes(lr1121UpdateState->packet.header, nullptr, 6 + write_size);
-    digitalWrite(lr1121UpdateState->updatingRadio == SX12XX_Radio_1 ? GPIO_PIN_NSS : GPIO_PIN_NSS_2, HIGH);
+    SX12XX_Radio_Number_t radio;
+    uint32_t writeStartMs;
+};
 
-    while (digitalRead(lr1121UpdateState->updatingRadio == SX12XX_Radio_1 ? GPIO_PIN_BUSY : GPIO_PIN_BUSY_2) == HIGH)
+struct lr1121UpdateState_s {
+    lr1121UpdateState_s() : updater(port, LR11XX_BL_WRITE_FLASH_ENCRYPTED_OC), softwareCs(false), progressLogged(0), lastDataMs(0)
     {
-        delay(1);
+        port.radio = SX12XX_Radio_1;
+        port.writeStartMs = 0;
     }
-    lr1121UpdateState->totalSize += write_size;
-    lr1121UpdateState->left_over = 0;
-    DBGLN("flashed");
+    LR1121SPIPort port;
+    LR1121Updater updater;
+    bool softwareCs;
+    uint8_t progressLogged;
+    uint32_t lastDataMs;
+};
+// Kept after an upload stops part way, so the rest of the file can be uploaded to carry on
+static lr1121UpdateState_s *lr1121UpdateState;
+
+static void beginFlashWrites()
+{
+    SX12XX_Radio_Number_t const radio = lr1121UpdateState->port.radio;
+    SPIEx.setHwCs(false);
+    pinMode(radio == SX12XX_Radio_1 ? GPIO_PIN_NSS : GPIO_PIN_NSS_2, OUTPUT);
+    digitalWrite(radio == SX12XX_Radio_1 ? GPIO_PIN_NSS : GPIO_PIN_NSS_2, HIGH);
+    lr1121UpdateState->softwareCs = true;
+}
+
+static void endFlashWrites()
+{
+    if (!lr1121UpdateState->softwareCs)
+    {
+        return;
+    }
+    SPIEx.setHwCs(true);
+    if (GPIO_PIN_NSS_2 != UNDEF_PIN)
+    {
+        spiAttachSS(SPIEx.bus(), 1, GPIO_PIN_NSS_2);
+    }
+    lr1121UpdateState->softwareCs = false;
 }
 
 static void readRegister(SX12XX_Radio_Number_t radio, uint16_t reg, uint8_t *buffer, uint32_t buffer_len)
@@ -68,20 +94,30 @@ static void readRegister(SX12XX_Radio_Number_t radio, uint16_t reg, uint8_t *buf
     hal.WaitOnBusy(radio);
 }
 
-static void WebUploadLR1121ResponseHandler(AsyncWebServerRequest *request) {
-    // Complete upload and set error flag
-    bool uploadError = false;
-    uint8_t param = 0;
-    writeLR1121Bytes(nullptr, 0);
-    lr1121UpdateState->totalSize += lr1121UpdateState->left_over;
+static void sendUploadError(AsyncWebServerRequest *request, const char *msg)
+{
+    AsyncWebServerResponse *response = request->beginResponse(200, "application/json", String(R"({"status": "error", "msg": ")") + msg + R"("})");
+    response->addHeader("Connection", "close");
+    request->send(response);
+    request->client()->close();
+}
 
-    SPIEx.setHwCs(true);
-    if (GPIO_PIN_NSS_2 != UNDEF_PIN)
+static void WebUploadLR1121ResponseHandler(AsyncWebServerRequest *request) {
+    if (lr1121UpdateState == nullptr || !lr1121UpdateState->softwareCs)
     {
-        spiAttachSS(SPIEx.bus(), 1, GPIO_PIN_NSS_2);
+        // The upload was turned down before any of it was written
+        return;
     }
 
-    if (lr1121UpdateState->totalSize == lr1121UpdateState->expectedFilesize)
+    // Complete upload and set error flag
+    bool uploadError = false;
+    LR1121Updater &updater = lr1121UpdateState->updater;
+    SX12XX_Radio_Number_t const radio = lr1121UpdateState->port.radio;
+    updater.finish();
+    endFlashWrites();
+    DBGLN("flashed %u bytes at %u bytes/s", updater.getFlashed(), updater.getThroughput());
+
+    if (updater.isComplete())
     {
         DBGLN("reboot 1121");
         uint8_t reboot_cmd[] = {
@@ -89,12 +125,12 @@ static void WebUploadLR1121ResponseHandler(AsyncWebServerRequest *request) {
             (uint8_t)LR11XX_BL_REBOOT_OC,
             0
         };
-        SPIEx.write(lr1121UpdateState->updatingRadio, reboot_cmd, 3);
-        while(!hal.WaitOnBusy(lr1121UpdateState->updatingRadio));
+        SPIEx.write(radio, reboot_cmd, 3);
+        while(!hal.WaitOnBusy(radio));
 
         DBGLN("check not in BL mode");
         uint8_t packet[5];
-        readRegister(lr1121UpdateState->updatingRadio, LR11XX_SYSTEM_GET_VERSION_OC, packet, 5);
+        readRegister(radio, LR11XX_SYSTEM_GET_VERSION_OC, packet, 5);
         uploadError = (packet[2] != 3);
         DBGLN("hardware %x", packet[1]);
         DBGLN("type %x", packet[2]);
@@ -102,12 +138,16 @@ static void WebUploadLR1121ResponseHandler(AsyncWebServerRequest *request) {
     }
 
     String msg;
-    if (!uploadError && lr1121UpdateState->totalSize == lr1121UpdateState->expectedFilesize) {
-        msg = String(R"({"status": "ok", "msg": "Update complete. Refresh page to see new version information."})");
+    if (!uploadError && updater.isComplete()) {
+        msg = String(R"({"status": "ok", "msg": "Update complete at )") + (updater.getThroughput() / 1024) + R"( KB/s. Refresh page to see new version information."})";
         DBGLN("Update complete");
     } else {
         StreamString p = StreamString();
-        if (lr1121UpdateState->totalSize != lr1121UpdateState->expectedFilesize) {
+        if (updater.canResume()) {
+            p.print("Not enough data uploaded! Upload the same file again to carry on from ");
+            p.print(updater.getResumeOffset());
+            p.println(" bytes.");
+        } else if (!updater.isComplete()) {
             p.println("Not enough data uploaded!");
         } else {
             p.println("Update failed, refresh and try again.");
@@ -118,8 +158,11 @@ static void WebUploadLR1121ResponseHandler(AsyncWebServerRequest *request) {
     AsyncWebServerResponse *response = request->beginResponse(200, "application/json", msg);
     response->addHeader("Connection", "close");
     request->send(response);
-    delete lr1121UpdateState;
-    lr1121UpdateState = nullptr;
+    if (!updater.canResume())
+    {
+        delete lr1121UpdateState;
+        lr1121UpdateState = nullptr;
+    }
 }
 
 static void WebUploadLR1121DataHandler(AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) {
@@ -127,67 +170,84 @@ static void WebUploadLR1121DataHandler(AsyncWebServerRequest *request, const Str
 #ifdef HAS_WIFI_JOYSTICK
         WifiJoystick::StopJoystickService();
 #endif
-        lr1121UpdateState = new lr1121UpdateState_s;
-        lr1121UpdateState->expectedFilesize = request->header("X-FileSize").toInt();
-        lr1121UpdateState->updatingRadio = request->header("X-Radio").toInt();
-        DBGLN("Update: '%s' size %u on radio %d", filename.c_str(), lr1121UpdateState->expectedFilesize, lr1121UpdateState->updatingRadio);
-        lr1121UpdateState->totalSize = 0;
-
-        // Reboot to BL mode
-        DBGLN("Reboot 1121 to bootloader mode");
-        uint8_t reboot_cmd[] = {
-            (uint8_t)(LR11XX_SYSTEM_REBOOT_OC >> 8),
-            (uint8_t)LR11XX_SYSTEM_REBOOT_OC,
-            3
-        };
-        SPIEx.write(lr1121UpdateState->updatingRadio, reboot_cmd, 3);
-        while(!hal.WaitOnBusy(lr1121UpdateState->updatingRadio)) {
-            DBGLN("Waiting...");
-            delay(10);
-        }
+        size_t const fileSize = request->header("X-FileSize").toInt();
+        SX12XX_Radio_Number_t const radio = request->header("X-Radio").toInt();
+        size_t const offset = request->header("X-Offset").toInt();
+        DBGLN("Update: '%s' size %u on radio %d from %u", filename.c_str(), fileSize, radio, offset);
 
-        // Ensure we're in BL mode
-        DBGLN("Ensure BL mode");
-        uint8_t packet[5];
-        readRegister(lr1121UpdateState->updatingRadio, LR11XX_BL_GET_VERSION_OC, packet, 5);
-        if (packet[2] != 0xDF) {
-            AsyncWebServerResponse *response = request->beginResponse(200, "application/json", R"({"status": "error", "msg": "Not in bootloader mode"})");
-            response->addHeader("Connection", "close");
-            request->send(response);
-            request->client()->close();
-            return;
+        if (lr1121UpdateState == nullptr)
+        {
+            lr1121UpdateState = new lr1121UpdateState_s;
         }
+        // Either starting again or carrying on, the bootloader commands need the hardware CS
+        endFlashWrites();
 
-        // Erase flash
-        DBGLN("Erasing");
-        packet[0] = LR11XX_BL_ERASE_FLASH_OC >> 8;
-        packet[1] = (uint8_t)LR11XX_BL_ERASE_FLASH_OC;
-        SPIEx.write(lr1121UpdateState->updatingRadio, packet, 2);
-        while(!hal.WaitOnBusy(lr1121UpdateState->updatingRadio))
+        if (offset != 0)
         {
-            DBGLN("Waiting...");
-            delay(100);
+            // Carry on from where the last upload of this file stopped, the LR1121 is still in
+            // the bootloader with the flash written up to there
+            uint8_t packet[5];
+            readRegister(radio, LR11XX_BL_GET_VERSION_OC, packet, 5);
+            if (radio != lr1121UpdateState->port.radio || packet[2] != 0xDF || !lr1121UpdateState->updater.resume(fileSize, offset))
+            {
+                sendUploadError(request, "Nothing to carry on from, upload the whole file");
+                return;
+            }
+            DBGLN("Resuming at %u", offset);
         }
-        DBGLN("Erased");
+        else
+        {
+            lr1121UpdateState->port.radio = radio;
+            lr1121UpdateState->updater.reset();
 
-        lr1121UpdateState->left_over = 0;
-        SPIEx.setHwCs(false);
+            // Reboot to BL mode
+            DBGLN("Reboot 1121 to bootloader mode");
+            uint8_t reboot_cmd[] = {
+                (uint8_t)(LR11XX_SYSTEM_REBOOT_OC >> 8),
+                (uint8_t)LR11XX_SYSTEM_REBOOT_OC,
+                3
+            };
+            SPIEx.write(radio, reboot_cmd, 3);
+            while(!hal.WaitOnBusy(radio)) {
+                DBGLN("Waiting...");
+                delay(10);
+            }
 
-        pinMode(lr1121UpdateState->updatingRadio == SX12XX_Radio_1 ? GPIO_PIN_NSS : GPIO_PIN_NSS_2, OUTPUT);
-        digitalWrite(lr1121UpdateState->updatingRadio == SX12XX_Radio_1 ? GPIO_PIN_NSS : GPIO_PIN_NSS_2, HIGH);
+            // Ensure we're in BL mode
+            DBGLN("Ensure BL mode");
+            uint8_t packet[5];
+            readRegister(radio, LR11XX_BL_GET_VERSION_OC, packet, 5);
+            if (packet[2] != 0xDF) {
+                sendUploadError(request, "Not in bootloader mode");
+                return;
+            }
+
+            // Erase flash
+            DBGLN("Erasing");
+            packet[0] = LR11XX_BL_ERASE_FLASH_OC >> 8;
+            packet[1] = (uint8_t)LR11XX_BL_ERASE_FLASH_OC;
+            SPIEx.write(radio, packet, 2);
+            while(!hal.WaitOnBusy(radio))
+            {
+                DBGLN("Waiting...");
+                delay(100);
+            }
+            DBGLN("Erased");
+            lr1121UpdateState->updater.begin(fileSize);
+        }
+        lr1121UpdateState->progressLogged = 0;
+        lr1121UpdateState->lastDataMs = millis();
+        beginFlashWrites();
     }
-    if (len) {
-        DBGLN("writing %x", len);
-        // Write len bytes to LR1121 from data
-        while (len >= 256 - lr1121UpdateState->left_over)
+    if (len && lr1121UpdateState != nullptr && lr1121UpdateState->softwareCs) {
+        LR1121Updater &updater = lr1121UpdateState->updater;
+        updater.write(data, len);
+        lr1121UpdateState->lastDataMs = millis();
+        if (updater.getProgress() >= lr1121UpdateState->progressLogged + 10)
         {
-            uint32_t chunk_size = len > 256 - lr1121UpdateState->left_over ? 256 - lr1121UpdateState->left_over : len;
-            writeLR1121Bytes(data, chunk_size);
-            len -= chunk_size;
-            data += chunk_size;
+            lr1121UpdateState->progressLogged = updater.getProgress();
+            DBGLN("%u%% flashed, %u bytes/s", updater.getProgress(), updater.getThroughput());
         }
-        memcpy(lr1121UpdateState->packet.buffer, data, len);
-        lr1121UpdateState->left_over = len;
     }
 }
 
@@ -211,11 +271,34 @@ static void ReadStatusForRadio(JsonObject json, SX12XX_Radio_Number_t radio)
 
 static void GetLR1121Status(AsyncWebServerRequest *request)
 {
+    if (lr1121UpdateState != nullptr && lr1121UpdateState->softwareCs)
+    {
+        if (millis() - lr1121UpdateState->lastDataMs < LR1121_UPDATE_STALL_MS)
+        {
+            // An upload is still writing to the flash, leave the SPI alone until it is done
+            request->send(503, "text/plain", "Upload in progress");
+            return;
+        }
+        // The upload stopped without finishing, so the bootloader commands need the hardware CS back
+        endFlashWrites();
+    }
+
     AsyncJsonResponse *response = new AsyncJsonResponse();
     JsonObject json = response->getRoot();
-    hal.end();
-    hal.init();
-    hal.reset();
+    if (lr1121UpdateState != nullptr && lr1121UpdateState->updater.canResume())
+    {
+        // Leave the LR1121 in the bootloader so the upload can carry on
+        JsonObject resume = json["resume"].to<JsonObject>();
+        resume["radio"] = lr1121UpdateState->port.radio;
+        resume["size"] = lr1121UpdateState->updater.getFileSize();
+        resume["offset"] = lr1121UpdateState->updater.getResumeOffset();
+    }
+    else
+    {
+        hal.end();
+        hal.init();
+        hal.reset();
+    }
 
     ReadStatusForRadio(json["radio1"].to<JsonObject>(), SX12XX_Radio_1);
     if (GPIO_PIN_NSS_2 != UNDEF_PIN)
@@ -0,0 +1,74 @@
+# This script measures the output power of an ExpressLRS TX across its band and stores
+# per-frequency corrections so every hop comes out at the same power.
+# The TX should be in WiFi mode and reachable at --host. For each calibration segment the
+# TX is put into continuous wave on the channel in the middle of that segment, and the
+# reading from a power meter is entered (in dBm). Segments are corrected towards the mean,
+# so the weak channels come up and the strong ones come down rather than everything
+# being raised to cover the weakest.
+#
+# The values are saved in the TX's NVS and are applied on top of the power level
+# calibration. They can be read back with `curl http://10.0.0.1/powercal`.
+# Reboot the TX afterwards to leave continuous wave mode.
+import argparse
+import json
+import time
+import urllib.request
+
+SEGMENTS = 8        # POWER_FREQ_CALI_SEGMENTS
+MAX_CORRECTION = 3  # POWER_FREQ_CALI_MAX
+
+def startCW(args, segment):
+    url = f'http://{args.host}/cw?radio={args.radio}&segment={segment}'
+    if args.band == 0 and args.lr1121:
+        url += '&subGHz=1'
+    urllib.request.urlopen(url, timeout=5).close()
+    time.sleep(0.5)
+
+def readPower(segment):
+    while True:
+        try:
+            return float(input(f'Segment {segment} power (dBm): '))
+        except ValueError:
+            pass
+
+def calcCorrections(readings):
+    mean = sum(readings) / len(readings)
+    return [max(-MAX_CORRECTION, min(MAX_CORRECTION, round(mean - r))) for r in readings]
+
+def saveCorrections(args, values):
+    body = json.dumps({'band': args.band, 'values': values}).encode('ascii')
+    req = urllib.request.Request(f'http://{args.host}/powercal', data=body,
+        headers={'Content-Type': 'application/json'}, method='POST')
+    with urllib.request.urlopen(req, timeout=5) as resp:
+        print(resp.read().decode('ascii'))
+
+def runSweep(args):
+    readings = []
+    print('segment,dBm')
+    for segment in range(SEGMENTS):
+        startCW(args, segment)
+        readings.append(readPower(segment))
+        print(f'{segment},{readings[-1]:0.1f}')
+
+    values = calcCorrections(readings)
+    print('corrections:', values)
+    if not args.dry_run:
+        saveCorrections(args, values)
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        description="Measure output power across the band on an ELRS TX and store per-frequency power corrections")
+    parser.add_argument("-b", "--band", type=int, default=0,
+        help="Calibration band, 0 for the regulatory domain's band, 1 for the LR1121 2.4GHz band")
+    parser.add_argument("-H", "--host", type=str, default='10.0.0.1',
+        help="Address of the TX in WiFi mode")
+    parser.add_argument("-l", "--lr1121", action='store_true',
+        help="The TX has an LR1121, so the band needs selecting for continuous wave")
+    parser.add_argument("-n", "--dry-run", action='store_true',
+        help="Only print the corrections, don't save them")
+    parser.add_argument("-r", "--radio", type=int, default=1,
+        help="Radio to transmit on, 1 or 2")
+
+    args = parser.parse_args()
+
+    runSweep(args)
@@ -3,6 +3,7 @@
 #if defined(TARGET_TX)
 #include <handset.h>
 #include <LBT.h>
+#include <LinkBudget.h>
 
 // LQ-based boost defines
 #define DYNPOWER_LQ_BOOST_THRESH_DIFF 20  // If LQ is dropped suddenly for this amount (relative), immediately boost to the max power configured.
@@ -10,13 +11,10 @@
 #define DYNPOWER_LQ_MOVING_AVG_K      8   // Number of previous values for calculating moving average. Best with power of 2.
 #define DYNPOWER_LQ_THRESH_UP         85  // Below this LQ, the RSSI/SNR code will increase the power if RSSI/SNR did nothing
 
-// RSSI-based increment defines
-#define DYNPOWER_RSSI_CNT 5               // Number of RSSI readings to average (straight average) to make an RSSI-based adjustment
+// Link budget defines
 #define DYNPOWER_RSSI_THRESH_UP 15        // RSSI < (Sensitivity+Up) -> raise power
 #define DYNPOWER_RSSI_THRESH_DN 21        // RSSI > (Sensitivity+Dn) >- lower power
-
-// SNR-based increment defines
-#define DYNPOWER_LQ_THRESH_DN 95          // Min LQ for lowering power using SNR-based power lowering
+#define DYNPOWER_LQ_THRESH_DN 95          // Min LQ for lowering power using the link budget
 
 template<uint8_t K, uint8_t SHIFT>
 class MovingAvg
@@ -33,7 +31,7 @@ private:
 };
 
 static MovingAvg<DYNPOWER_LQ_MOVING_AVG_K, 16> dynpower_mavg_lq;
-static MeanAccumulator<int32_t, int8_t, -128> dynpower_mean_rssi;
+static LinkBudget dynpower_budget(DYNPOWER_RSSI_THRESH_UP, DYNPOWER_RSSI_THRESH_DN - DYNPOWER_RSSI_THRESH_UP);
 static int8_t dynpower_updated;
 static uint32_t dynpower_last_linkstats_millis;
 
@@ -45,6 +43,7 @@ static void DynamicPower_SetToConfigPower()
 void DynamicPower_Init()
 {
     dynpower_mavg_lq = 100;
+    dynpower_budget.reset();
     dynpower_updated = DYNPOWER_UPDATE_NOUPDATE;
 }
 
@@ -122,6 +121,12 @@ void DynamicPower_Update(uint32_t now)
     return;
   dynpower_last_linkstats_millis = now;
 
+  // Keep the path loss up to date even when boosted, the budget skips the report after a power change
+  dynpower_budget.update(POWERMGNT::getPowerIndBm(), rssi, snrScaled,
+    ExpressLRS_currAirRate_RFperfParams->RXsensitivity,
+    ExpressLRS_currAirRate_RFperfParams->DynpowerSnrThreshUp,
+    ExpressLRS_currAirRate_RFperfParams->DynpowerSnrThreshDn);
+
   // =============  LQ-based power boost up ==============
   // Quick boost up of power when detected any emergency LQ drops.
   // It should be useful for bando or sudden lost of LoS cases.
@@ -141,52 +146,22 @@ void DynamicPower_Update(uint32_t now)
       return;
   }
 
+  // =============  Link budget ==============
+  // Go straight to the lowest power which leaves the fade margin over the sensitivity
+  // (or the SNR threshold), rather than one step per RSSI average or SNR report
   PowerLevels_e startPowerLevel = POWERMGNT::currPower();
-  if (ExpressLRS_currAirRate_RFperfParams->DynpowerSnrThreshUp == DYNPOWER_SNR_THRESH_NONE)
+  PowerLevels_e newPowerLevel = dynpower_budget.selectPower(startPowerLevel, POWERMGNT::getMinPower(), (PowerLevels_e)config.GetPower());
+  if (newPowerLevel > startPowerLevel)
   {
-    // =============  RSSI-based power increment ==============
-    // a simple threshold compared against N sample average of
-    // rssi vs the sensitivity limit +/- some thresholds
-    dynpower_mean_rssi.add(rssi);
-
-    if (dynpower_mean_rssi.getCount() >= DYNPOWER_RSSI_CNT)
-    {
-      int32_t expected_RXsensitivity = ExpressLRS_currAirRate_RFperfParams->RXsensitivity;
-      int8_t rssi_inc_threshold = expected_RXsensitivity + DYNPOWER_RSSI_THRESH_UP;
-      int8_t rssi_dec_threshold = expected_RXsensitivity + DYNPOWER_RSSI_THRESH_DN;
-      int8_t avg_rssi = dynpower_mean_rssi.mean(); // resets it too
-      if ((avg_rssi < rssi_inc_threshold) && (powerHeadroom > 0))
-      {
-        DBGLN("+power (rssi)");
-        POWERMGNT::incPower();
-      }
-      else if (avg_rssi > rssi_dec_threshold && lq_avg >= DYNPOWER_LQ_THRESH_DN)
-      {
-        DBGVLN("-power (rssi)"); // Verbose because this spams when idle
-        POWERMGNT::decPower();
-      }
-    }
-  } // ^^ if RSSI-based
-  else
+    DBGLN("+power (budget)");
+    POWERMGNT::setPower(newPowerLevel);
+    powerHeadroom = (uint8_t)config.GetPower() - (uint8_t)newPowerLevel;
+  }
+  else if (newPowerLevel < startPowerLevel && lq_avg >= DYNPOWER_LQ_THRESH_DN)
   {
-    // =============  SNR-based power increment ==============
-    // Decrease the power if SNR above threshold and LQ is good
-    // Increase the power for each (X) SNR below the threshold
-    if (snrScaled >= ExpressLRS_currAirRate_RFperfParams->DynpowerSnrThreshDn && lq_avg >= DYNPOWER_LQ_THRESH_DN)
-    {
-      DBGVLN("-power (snr)"); // Verbose because this spams when idle
-      POWERMGNT::decPower();
-    }
-
-    while ((snrScaled <= ExpressLRS_currAirRate_RFperfParams->DynpowerSnrThreshUp) && (powerHeadroom > 0))
-    {
-      DBGLN("+power (snr)");
-      POWERMGNT::incPower();
-      // Every power doubling will theoretically increase the SNR by 3dB, but closer to 2dB in testing
-      snrScaled += SNR_SCALE(2);
-      --powerHeadroom;
-    }
-  } // ^^ if SNR-based
+    DBGVLN("-power (budget)"); // Verbose because this spams when idle
+    POWERMGNT::setPower(newPowerLevel);
+  }
 
   // If instant LQ is low, but the SNR/RSSI did nothing, inc power by one step
   if ((powerHeadroom > 0) && (startPowerLevel == POWERMGNT::currPower()) && (lq_current <= DYNPOWER_LQ_THRESH_UP))
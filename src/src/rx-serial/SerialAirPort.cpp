@@ -7,7 +7,17 @@
 // Variables / constants for Airport //
 FIFO<AP_MAX_BUF_LEN> apInputBuffer;
 FIFO<AP_MAX_BUF_LEN> apOutputBuffer;
+AirPortLink apLink(apInputBuffer, apOutputBuffer);
 
+SerialAirPort::SerialAirPort(Stream &out, Stream &in) : SerialIO(&out, &in)
+{
+    // RTS is active low, ready to receive
+    if (GPIO_PIN_SERIAL_RTS != UNDEF_PIN)
+    {
+        pinMode(GPIO_PIN_SERIAL_RTS, OUTPUT);
+        digitalWrite(GPIO_PIN_SERIAL_RTS, LOW);
+    }
+}
 
 uint32_t SerialAirPort::sendRCFrame(bool frameAvailable, bool frameMissed, uint32_t *channelData)
 {
@@ -29,6 +39,18 @@ void SerialAirPort::processBytes(uint8_t *bytes, u_int16_t size)
 
 void SerialAirPort::sendQueuedData(uint32_t maxBytesToSend)
 {
+    if (apLink.updateFlowControl())
+    {
+        bool const paused = apLink.isInputPaused();
+        if (GPIO_PIN_SERIAL_RTS != UNDEF_PIN)
+        {
+            digitalWrite(GPIO_PIN_SERIAL_RTS, paused ? HIGH : LOW);
+        }
+#if defined(AIRPORT_FLOW_XONXOFF)
+        _outputPort->write(paused ? AIRPORT_XOFF : AIRPORT_XON);
+#endif
+    }
+
     auto size = apOutputBuffer.size();
     if (size != 0)
     {
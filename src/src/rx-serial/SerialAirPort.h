@@ -1,14 +1,16 @@
 #include "SerialIO.h"
 #include "FIFO.h"
 #include "telemetry_protocol.h"
+#include "AirPortLink.h"
 
 // Variables / constants for Airport //
 extern FIFO<AP_MAX_BUF_LEN> apInputBuffer;
 extern FIFO<AP_MAX_BUF_LEN> apOutputBuffer;
+extern AirPortLink apLink;
 
 class SerialAirPort : public SerialIO {
 public:
-    explicit SerialAirPort(Stream &out, Stream &in) : SerialIO(&out, &in) {}
+    explicit SerialAirPort(Stream &out, Stream &in);
     virtual ~SerialAirPort() {}
 
     void queueLinkStatisticsPacket() override {}
@@ -4,9 +4,11 @@
 #include "device.h"
 #include "common.h"
 #include "CRSF.h"
+#include "helpers.h"
+#include "logging.h"
 
 // Variables / constants for Mavlink //
-FIFO<MAV_INPUT_BUF_LEN> mavlinkInputBuffer;
+MAVLinkScheduler mavlinkDownlink;
 FIFO<MAV_OUTPUT_BUF_LEN> mavlinkOutputBuffer;
 
 #if defined(PLATFORM_STM32)
@@ -42,11 +44,29 @@ void SerialMavlink::sendQueuedData(uint32_t maxBytesToSend)
 
 #else // ESP-based targets
 
-#define MAVLINK_COMM_NUM_BUFFERS 1
-#include "common/mavlink.h"
+#include "MAVLink.h"
+#include "MAVLinkFramer.h"
 
 #define MAV_FTP_OPCODE_OPENFILERO 4
 
+// Frames from the TX going to the flight controller
+static MAVLinkFramer uplinkFramer(mavlinkCrcExtra);
+// Frames from the flight controller going over the air
+static MAVLinkFramer downlinkFramer(mavlinkCrcExtra);
+
+#if defined(MAVLINK_DOWNLINK_DECIMATE)
+// High rate streams which are decimated before they take up downlink bandwidth
+static const mavlink_filter_t downlinkFilters[] = {
+    {MAVLINK_MSG_ID_ATTITUDE, 200},
+    {MAVLINK_MSG_ID_GLOBAL_POSITION_INT, 200},
+    {MAVLINK_MSG_ID_VFR_HUD, 200},
+    {MAVLINK_MSG_ID_RAW_IMU, 1000},
+    {MAVLINK_MSG_ID_SCALED_PRESSURE, 1000},
+    {MAVLINK_MSG_ID_RC_CHANNELS, 1000},
+    {MAVLINK_MSG_ID_SERVO_OUTPUT_RAW, 1000},
+};
+#endif
+
 SerialMavlink::SerialMavlink(Stream &out, Stream &in):
     SerialIO(&out, &in),
     // 255 is typically used by the GCS, for RC override to work in ArduPilot `SYSID_MYGCS` must be set to this value (255 is the default)
@@ -58,6 +78,9 @@ SerialMavlink::SerialMavlink(Stream &out, Stream &in):
     // Send to AutoPilot component
     target_component_id(MAV_COMPONENT::MAV_COMP_ID_AUTOPILOT1)
 {
+#if defined(MAVLINK_DOWNLINK_DECIMATE)
+    downlinkFramer.setFilters(downlinkFilters, ARRAY_SIZE(downlinkFilters));
+#endif
 }
 
 uint32_t SerialMavlink::sendRCFrame(bool frameAvailable, bool frameMissed, uint32_t *channelData)
@@ -98,14 +121,24 @@ uint32_t SerialMavlink::sendRCFrame(bool frameAvailable, bool frameMissed, uint3
 
 int SerialMavlink::getMaxSerialReadSize()
 {
-    return MAV_INPUT_BUF_LEN - mavlinkInputBuffer.size();
+    // Frames are queued or dropped by the scheduler as they are framed, so the framer never backs up
+    return downlinkFramer.space();
 }
 
 void SerialMavlink::processBytes(uint8_t *bytes, u_int16_t size)
 {
     if (connectionState == connected)
     {
-        mavlinkInputBuffer.atomicPushBytes(bytes, size);
+        const uint32_t now = millis();
+        while (size > 0)
+        {
+            uint16_t taken = downlinkFramer.append(bytes, size);
+            bytes += taken;
+            size -= taken;
+            downlinkFramer.process(now, [](const uint8_t *data, uint16_t len) {
+                mavlinkDownlink.pushFrames(data, len);
+            });
+        }
     }
 }
 
@@ -119,11 +152,11 @@ void SerialMavlink::sendQueuedData(uint32_t maxBytesToSend)
         lastSentFlowCtrl = now; 
 
         // Software-based flow control for mavlink
-        uint8_t percentage_remaining = ((MAV_INPUT_BUF_LEN - mavlinkInputBuffer.size()) * 100) / MAV_INPUT_BUF_LEN;
+        uint8_t percentage_remaining = 100 - mavlinkDownlink.fillPercent();
 
-        // Populate radio status packet
+        // Populate radio status packet, the error count wraps like a SiK radio's does
         const mavlink_radio_status_t radio_status {
-            rxerrors: 0,
+            rxerrors: (uint16_t)mavlinkDownlink.totalDropped(),
             fixed: 0,
             rssi: (uint8_t)((float)CRSF::LinkStatistics.uplink_Link_quality * 2.55),
             remrssi: CRSF::LinkStatistics.uplink_RSSI_1,
@@ -137,38 +170,32 @@ void SerialMavlink::sendQueuedData(uint32_t maxBytesToSend)
         mavlink_msg_radio_status_encode(this_system_id, this_component_id, &msg, &radio_status);
         uint16_t len = mavlink_msg_to_send_buffer(buf, &msg);
         _outputPort->write(buf, len);
+
+        // Coalesced frames are replaced by a newer one of the same message, they aren't errors
+        // so they don't go in RADIO_STATUS
+        if (mavlinkDownlink.totalCoalesced() != lastCoalesced)
+        {
+            lastCoalesced = mavlinkDownlink.totalCoalesced();
+            DBGVLN("MAVLink coalesced %u", lastCoalesced);
+        }
     }
 
-    auto size = mavlinkOutputBuffer.size();
+    // Pop straight into the framer and forward the frames from there as they arrived
+    uint16_t size = std::min(mavlinkOutputBuffer.size(), uplinkFramer.space());
     if (size == 0)
     {
         // nothing to send
         return;
     }
 
-    uint8_t apBuf[size];
     mavlinkOutputBuffer.lock();
-    mavlinkOutputBuffer.popBytes(apBuf, size);
+    mavlinkOutputBuffer.popBytes(uplinkFramer.writePtr(), size);
     mavlinkOutputBuffer.unlock();
+    uplinkFramer.commit(size);
 
-    for (uint8_t i = 0; i < size; ++i)
-    {
-        uint8_t c = apBuf[i];
-
-        mavlink_message_t msg;
-        mavlink_status_t status;
-
-        // Try parse a mavlink message
-        if (mavlink_frame_char(MAVLINK_COMM_0, c, &msg, &status))
-        {
-            // Message decoded successfully
-
-            // Forward message to the UART
-            uint8_t buf[MAVLINK_MAX_PACKET_LEN];
-            uint16_t len = mavlink_msg_to_send_buffer(buf, &msg);
-            _outputPort->write(buf, len);
-        }
-    }
+    uplinkFramer.process(now, [this](const uint8_t *data, uint16_t len) {
+        _outputPort->write(data, len);
+    });
 }
 
 #endif // defined(PLATFORM_STM32)
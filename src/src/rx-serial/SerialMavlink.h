@@ -1,12 +1,13 @@
 #include "SerialIO.h"
 #include "FIFO.h"
 #include "telemetry_protocol.h"
+#include "MAVLinkScheduler.h"
 
-#define MAV_INPUT_BUF_LEN   1024
 #define MAV_OUTPUT_BUF_LEN  512
 
 // Variables / constants
-extern FIFO<MAV_INPUT_BUF_LEN> mavlinkInputBuffer;
+// Frames from the flight controller waiting to go over the air
+extern MAVLinkScheduler mavlinkDownlink;
 extern FIFO<MAV_OUTPUT_BUF_LEN> mavlinkOutputBuffer;
 
 class SerialMavlink : public SerialIO {
@@ -31,4 +32,5 @@ private:
     const uint8_t target_component_id;
 
     uint32_t lastSentFlowCtrl = 0;
+    uint32_t lastCoalesced = 0;
 };
@@ -6,11 +6,13 @@
 #include "telemetry.h"
 #include "stubborn_sender.h"
 #include "stubborn_receiver.h"
+#include "TelemetryDelta.h"
 
 #include "lua.h"
 #include "msp.h"
 #include "msptypes.h"
 #include "PFD.h"
+#include "PLL.h"
 #include "options.h"
 #include "dynpower.h"
 #include "MeanAccumulator.h"
@@ -73,6 +75,9 @@
 #define DIVERSITY_ANTENNA_INTERVAL 5
 #define DIVERSITY_ANTENNA_RSSI_TRIGGER 5
 #define PACKET_TO_TOCK_SLACK 200 // Desired buffer time between Packet ISR and Tock ISR
+#if !defined(RX_COAST_TIMEOUT_MS)
+#define RX_COAST_TIMEOUT_MS 5000 // Time to keep hopping in step after DisconnectTimeoutMs, 0 to disable
+#endif
 ///////////////////
 
 device_affinity_t ui_devices[] = {
@@ -120,6 +125,7 @@ uint8_t antenna = 0;    // which antenna is currently in use
 uint8_t geminiMode = 0;
 
 PFD PFDloop;
+PLL PhaseLock(HWTIMER_TICKS_PER_US);
 Crc2Byte ota_crc;
 ELRS_EEPROM eeprom;
 RxConfig config;
@@ -180,6 +186,9 @@ SerialIO *serialIO = nullptr;
 StubbornSender TelemetrySender;
 static uint8_t telemetryBurstCount;
 static uint8_t telemetryBurstMax;
+static TelemetryDeltaEncoder TelemetryDelta;
+static bool TelemetryDeltaEnabled;
+static uint8_t telemetryDeltaDelivered;
 
 StubbornReceiver MspReceiver;
 uint8_t MspData[ELRS_MSP_BUFFER];
@@ -210,6 +219,8 @@ RXtimerState_e RXtimerState;
 uint32_t GotConnectionMillis = 0;
 const uint32_t ConsiderConnGoodMillis = 1000; // minimum time before we can consider a connection to be 'good'
 bool doStartTimer = false;
+static volatile bool RXcoasting = false; // Disconnected, but the timer and FHSS are still running in step with the TX
+static volatile bool CoastReconnectPending = false; // Reconnected from the ISR, loop() does the rest of GotConnection()
 
 ///////////////////////////////////////////////
 
@@ -362,9 +373,10 @@ void SetRFLinkRate(uint8_t index, bool bindMode) // Set speed of RF link
 #endif
 
     hwTimer::updateInterval(interval);
+    PhaseLock.setInterval(interval);
 
-    FHSSusePrimaryFreqBand = !(ModParams->radio_type == RADIO_TYPE_LR1121_LORA_2G4) && !(ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4);
-    FHSSuseDualBand = ModParams->radio_type == RADIO_TYPE_LR1121_LORA_DUAL;
+    FHSSconfigureBands(!(ModParams->radio_type == RADIO_TYPE_LR1121_LORA_2G4) && !(ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4),
+                       ModParams->radio_type == RADIO_TYPE_LR1121_LORA_DUAL);
 
     Radio.Config(ModParams->bw, ModParams->sf, ModParams->cr, FHSSgetInitialFreq(),
                  ModParams->PreambleLen, invertIQ, ModParams->PayloadLength, 0
@@ -411,7 +423,7 @@ bool ICACHE_RAM_ATTR HandleFHSS()
 {
     uint8_t modresultFHSS = (OtaNonce + 1) % ExpressLRS_currAirRate_Modparams->FHSShopInterval;
 
-    if ((ExpressLRS_currAirRate_Modparams->FHSShopInterval == 0) || alreadyFHSS == true || InBindingMode || (modresultFHSS != 0) || (connectionState == disconnected))
+    if ((ExpressLRS_currAirRate_Modparams->FHSShopInterval == 0) || alreadyFHSS == true || InBindingMode || (modresultFHSS != 0) || (connectionState == disconnected && !RXcoasting))
     {
         return false;
     }
@@ -491,7 +503,7 @@ bool ICACHE_RAM_ATTR HandleSendTelemetryResponse()
     alreadyTLMresp = true;
     otaPkt.std.type = PACKET_TYPE_TLM;
 
-    bool noAirportDataQueued = firmwareOptions.is_airport && apOutputBuffer.size() == 0;
+    bool noAirportDataQueued = firmwareOptions.is_airport && !apLink.hasPending();
     bool noTlmQueued = !TelemetrySender.IsActive() && noAirportDataQueued;
 
     if (NextTelemetryType == ELRS_TELEMETRY_TYPE_LINK || noTlmQueued)
@@ -548,7 +560,7 @@ bool ICACHE_RAM_ATTR HandleSendTelemetryResponse()
         }
         else if (firmwareOptions.is_airport)
         {
-            OtaPackAirportData(&otaPkt, &apInputBuffer);
+            OtaPackAirportData(&otaPkt, &apLink);
         }
     }
 
@@ -634,45 +646,29 @@ int32_t ICACHE_RAM_ATTR HandleFreqCorr(bool value)
 
 void ICACHE_RAM_ATTR updatePhaseLock()
 {
-    if (connectionState != disconnected && PFDloop.hasResult())
+    bool const timerInStep = connectionState != disconnected || RXcoasting;
+    if (timerInStep && PFDloop.hasResult())
     {
         int32_t RawOffset = PFDloop.calcResult();
         int32_t Offset = LPF_Offset.update(RawOffset);
         int32_t OffsetDx = LPF_OffsetDx.update(RawOffset - PfdPrevRawOffset);
         PfdPrevRawOffset = RawOffset;
 
-        if (RXtimerState == tim_locked)
-        {
-            // limit rate of freq offset adjustment, use slot 1
-            // because telemetry can fall on slot 1 and will
-            // never get here
-            if (OtaNonce % 8 == 1)
-            {
-                if (Offset > 0)
-                {
-                    hwTimer::incFreqOffset();
-                }
-                else if (Offset < 0)
-                {
-                    hwTimer::decFreqOffset();
-                }
-            }
-        }
-
-        if (connectionState != connected)
-        {
-            hwTimer::phaseShift(RawOffset >> 1);
-        }
-        else
-        {
-            hwTimer::phaseShift(Offset >> 2);
-        }
+        hwTimer::phaseShift(PhaseLock.update(RawOffset, connectionState != connected));
 
-        DBGVLN("%d:%d:%d:%d:%d", Offset, RawOffset, OffsetDx, hwTimer::getFreqOffset(), uplinkLQ);
-        UNUSED(OffsetDx); // complier warning if no debug
+        DBGVLN("%d:%d:%d:%d:%d:%u", Offset, RawOffset, OffsetDx, PhaseLock.getDrift(), uplinkLQ, PhaseLock.getLockQuality());
+        UNUSED(Offset); // complier warning if no debug
+        UNUSED(OffsetDx);
     }
 
     PFDloop.reset();
+
+    // Apply the drift estimate every period, even if no packet was received,
+    // so the timer keeps tracking the TX through missed packets
+    if (timerInStep)
+    {
+        hwTimer::setFreqOffset(PhaseLock.nextFreqOffset());
+    }
 }
 
 void ICACHE_RAM_ATTR HWtimerCallbackTick() // this is 180 out of phase with the other callback, occurs mid-packet reception
@@ -798,6 +794,13 @@ void ICACHE_RAM_ATTR HWtimerCallbackTock()
 {
     PFDloop.intEvent(micros()); // our internal osc just fired
 
+    // Hop first so the LBT RSSI settling time runs while the RC frame goes out and the telemetry is built
+    if (!didFHSS)
+    {
+        HandleFHSS();
+    }
+    didFHSS = false;
+
     if (ExpressLRS_currAirRate_Modparams->numOfSends > 1 && !(OtaNonce % ExpressLRS_currAirRate_Modparams->numOfSends))
     {
         if (LQCalcDVDA.currentIsSet())
@@ -819,12 +822,6 @@ void ICACHE_RAM_ATTR HWtimerCallbackTock()
         }
     }
 
-    if (!didFHSS)
-    {
-        HandleFHSS();
-    }
-    didFHSS = false;
-
     Radio.isFirstRxIrq = true;
     updateDiversity();
     tlmSent = HandleSendTelemetryResponse();
@@ -838,15 +835,42 @@ void ICACHE_RAM_ATTR HWtimerCallbackTock()
     #endif
 }
 
+/**
+ * Send every frame waiting in one message, delta encoded against the frames the TX has
+ */
+static void SetTelemetryDeltaToTransmit()
+{
+    static uint8_t telemetryDeltaMsg[TLM_DELTA_MSG_MAX];
+    uint8_t *nextPayload;
+    uint8_t nextPlayloadSize;
+    uint8_t len = TLM_DELTA_MSG_HEADER_LEN;
+    // Each frame is copied into the message, so it is done with before the next is taken
+    while (len <= TLM_DELTA_MSG_MAX - CRSF_MAX_PACKET_LEN && telemetry.GetNextPayload(&nextPlayloadSize, &nextPayload))
+    {
+        len += TelemetryDelta.encode(nextPayload, &telemetryDeltaMsg[len]);
+    }
+    if (len > TLM_DELTA_MSG_HEADER_LEN)
+    {
+        TelemetryDeltaEncoder::setMessageHeader(telemetryDeltaMsg, len);
+        TelemetrySender.SetDataToTransmit(telemetryDeltaMsg, len);
+        telemetryDeltaDelivered = TelemetrySender.GetDeliveredCount();
+    }
+}
+
 void LostConnection(bool resumeRx)
 {
-    DBGLN("lost conn fc=%d fo=%d", FreqCorrection, hwTimer::getFreqOffset());
+    DBGLN("lost conn fc=%d fo=%d lq=%u", FreqCorrection, PhaseLock.getDrift(), PhaseLock.getLockQuality());
 
     // Use this rate as the initial rate next time if we connected on it
     if (connectionState == connected)
         config.SetRateInitialIdx(ExpressLRS_nextAirRateIndex);
 
     RFmodeCycleMultiplier = 1;
+    RXcoasting = false;
+    CoastReconnectPending = false;
+    // Keep the measured drift if the timer had locked, it is a property of the
+    // TX and RX crystals and will be valid on reconnect
+    PhaseLock.reset(RXtimerState == tim_locked);
     connectionState = disconnected; //set lost connection
     RXtimerState = tim_disconnected;
     hwTimer::resetFreqOffset();
@@ -859,6 +883,8 @@ void LostConnection(bool resumeRx)
     LPF_OffsetDx.init(0);
     alreadyTLMresp = false;
     alreadyFHSS = false;
+    TelemetryDeltaEnabled = false;
+    TelemetryDelta.reset();
 
     if (!InBindingMode)
     {
@@ -876,15 +902,56 @@ void LostConnection(bool resumeRx)
     }
 }
 
+/**
+ * Short fade past DisconnectTimeoutMs: report the connection as lost, but keep the
+ * timer and FHSS running on the drift estimate so the first packet received in step
+ * with the TX can resume the connection without waiting for a SYNC on the sync channel
+ */
+static void CoastConnection()
+{
+    DBGLN("coasting fo=%d", PhaseLock.getDrift());
+
+    if (connectionState == connected)
+        config.SetRateInitialIdx(ExpressLRS_nextAirRateIndex);
+
+    connectionState = disconnected;
+    RXcoasting = true;
+    uplinkLQ = 0;
+    LQCalc.reset();
+    LQCalcDVDA.reset();
+}
+
+static bool ICACHE_RAM_ATTR CoastPacketInStep(uint32_t const packetTime, unsigned long const now)
+{
+    // The tock for this packet has not fired yet, so the phase is measured from the
+    // previous tock and wrapped, as the timer is running the phase error is always small
+    int32_t phase = PhaseLock.wrapPhase(packetTime - PFDloop.getIntEventTime());
+    uint32_t window = PhaseLock.getCoastWindow(now - LastValidPacket);
+    return (uint32_t)abs(phase) <= window;
+}
+
+static void ICACHE_RAM_ATTR CoastReconnect(unsigned long now)
+{
+    RXcoasting = false;
+    connectionState = connected;
+    RXtimerState = tim_tentative;
+    GotConnectionMillis = now;
+    // A new connection as far as the TX is concerned, which may have seen it drop,
+    // the rest of it is done in loop()
+    CoastReconnectPending = true;
+}
+
 void ICACHE_RAM_ATTR TentativeConnection(unsigned long now)
 {
     PFDloop.reset();
+    RXcoasting = false;
     connectionState = tentative;
     connectionHasModelMatch = false;
     RXtimerState = tim_disconnected;
     DBGLN("tentative conn");
     PfdPrevRawOffset = 0;
     LPF_Offset.init(0);
+    PhaseLock.reset(true);
     SnrMean.reset();
     RFmodeLastCycled = now; // give another 3 sec for lock to occur
 
@@ -892,28 +959,36 @@ void ICACHE_RAM_ATTR TentativeConnection(unsigned long now)
     // the timer ISR will fire immediately and preempt any other code
 }
 
-void GotConnection(unsigned long now)
+/**
+ * @brief The parts of a new connection which are done from loop(), for both GotConnection()
+ * and a reconnect from coasting
+ */
+static void StartConnection()
 {
-    if (connectionState == connected)
-    {
-        return; // Already connected
-    }
-
     LockRFmode = firmwareOptions.lock_on_first_connection;
 
-    connectionState = connected; //we got a packet, therefore no lost connection
-    RXtimerState = tim_tentative;
-    GotConnectionMillis = now;
     #if defined(PLATFORM_ESP32) || defined(PLATFORM_ESP8266)
     webserverPreventAutoStart = true;
     #endif
 
     if (firmwareOptions.is_airport)
     {
-        apInputBuffer.flush();
-        apOutputBuffer.flush();
+        apLink.reset();
+    }
+}
+
+void GotConnection(unsigned long now)
+{
+    if (connectionState == connected)
+    {
+        return; // Already connected
     }
 
+    connectionState = connected; //we got a packet, therefore no lost connection
+    RXtimerState = tim_tentative;
+    GotConnectionMillis = now;
+    StartConnection();
+
     DBGLN("got conn");
 }
 
@@ -1052,7 +1127,7 @@ static void ICACHE_RAM_ATTR updateSwitchModePendingFromOta(uint8_t newSwitchMode
     }
 }
 
-static bool ICACHE_RAM_ATTR ProcessRfPacket_SYNC(uint32_t const now, OTA_Sync_s const * const otaSync)
+static bool ICACHE_RAM_ATTR ProcessRfPacket_SYNC(uint32_t const now, OTA_Sync_s const * const otaSync, uint8_t const tlmFeatures)
 {
     // Verify the first two of three bytes of the binding ID, which should always match
     if (otaSync->UID3 != UID[3] || otaSync->UID4 != UID[4])
@@ -1065,6 +1140,7 @@ static bool ICACHE_RAM_ATTR ProcessRfPacket_SYNC(uint32_t const now, OTA_Sync_s
         return false;
 
     LastSyncPacket = now;
+    TelemetryDeltaEnabled = tlmFeatures & OTA_TLM_FEATURE_DELTA;
 #if defined(DEBUG_RX_SCOREBOARD)
     DBGW('s');
 #endif
@@ -1132,7 +1208,17 @@ bool ICACHE_RAM_ATTR ProcessRFPacket(SX12xxDriverCommon::rx_status const status)
     doStartTimer = false;
     unsigned long now = millis();
 
-    LastValidPacket = now;
+    // Any valid packet arriving in step while coasting resumes the connection
+    if (RXcoasting && CoastPacketInStep(beginProcessing + PACKET_TO_TOCK_SLACK, now))
+    {
+        CoastReconnect(now);
+    }
+
+    // Packets out of step do not extend the coast, only a SYNC can recover from them
+    if (!RXcoasting)
+    {
+        LastValidPacket = now;
+    }
 
     switch (otaPktPtr->std.type)
     {
@@ -1144,13 +1230,14 @@ bool ICACHE_RAM_ATTR ProcessRFPacket(SX12xxDriverCommon::rx_status const status)
         break;
     case PACKET_TYPE_SYNC: //sync packet from master
         doStartTimer = ProcessRfPacket_SYNC(now,
-            OtaIsFullRes ? &otaPktPtr->full.sync.sync : &otaPktPtr->std.sync)
+            OtaIsFullRes ? &otaPktPtr->full.sync.sync : &otaPktPtr->std.sync,
+            OtaIsFullRes ? otaPktPtr->full.sync.tlmFeatures : 0)
             && !InBindingMode;
         break;
     case PACKET_TYPE_TLM:
         if (firmwareOptions.is_airport)
         {
-            OtaUnpackAirportData(otaPktPtr, &apOutputBuffer);
+            OtaUnpackAirportData(otaPktPtr, &apLink);
         }
         break;
     default:
@@ -1704,6 +1791,12 @@ static void updateTelemetryBurst()
 
     // Notify the sender to adjust its expected throughput
     TelemetrySender.UpdateTelemetryRate(hz, ExpressLRS_currTlmDenom, telemetryBurstMax);
+
+    // MAVLink is shaped to what the telemetry slots can carry, with no telemetry nothing goes anyway
+    uint32_t mavlinkRate = 0;
+    if (ExpressLRS_currTlmDenom > 1)
+        mavlinkRate = (uint32_t)hz / ExpressLRS_currTlmDenom * (OtaIsFullRes ? ELRS8_TELEMETRY_BYTES_PER_CALL : ELRS4_TELEMETRY_BYTES_PER_CALL);
+    mavlinkDownlink.setLinkRate(mavlinkRate);
 }
 
 /* If not connected will rotate through the RF modes looking for sync
@@ -1711,7 +1804,7 @@ static void updateTelemetryBurst()
  */
 static void cycleRfMode(unsigned long now)
 {
-    if (connectionState == connected || connectionState == wifiUpdate || InBindingMode)
+    if (connectionState == connected || connectionState == wifiUpdate || InBindingMode || RXcoasting)
         return;
 
     // Actually cycle the RF mode if not LOCK_ON_FIRST_CONNECTION
@@ -2191,7 +2284,18 @@ void loop()
     uint32_t localLastValidPacket = LastValidPacket; // Required to prevent race condition due to LastValidPacket getting updated from ISR
     if ((connectionState == connected) && ((int32_t)ExpressLRS_currAirRate_RFperfParams->DisconnectTimeoutMs < (int32_t)(now - localLastValidPacket))) // check if we lost conn.
     {
+        // Only coast if the drift estimate can be trusted
+        if (RX_COAST_TIMEOUT_MS && RXtimerState == tim_locked)
+            CoastConnection();
+        else
+            LostConnection(true);
+    }
+
+    if (RXcoasting && ((int32_t)(ExpressLRS_currAirRate_RFperfParams->DisconnectTimeoutMs + RX_COAST_TIMEOUT_MS) < (int32_t)(now - localLastValidPacket)))
+    {
+        DBGLN("coast expired");
         LostConnection(true);
+        RFmodeLastCycled = now;
     }
 
     if ((connectionState == tentative) && (abs(LPF_OffsetDx.value()) <= 10) && (LPF_Offset.value() < 100) && (LQCalc.getLQRaw() > minLqForChaos())) //detects when we are connected
@@ -2199,30 +2303,45 @@ void loop()
         GotConnection(now);
     }
 
+    if (CoastReconnectPending)
+    {
+        CoastReconnectPending = false;
+        StartConnection();
+        DBGLN("coast reconnect");
+    }
+
     checkSendLinkStatsToFc(now);
 
     if ((RXtimerState == tim_tentative) && ((now - GotConnectionMillis) > ConsiderConnGoodMillis) && (abs(LPF_OffsetDx.value()) <= 5))
     {
         RXtimerState = tim_locked;
-        DBGLN("Timer locked");
+        DBGLN("Timer locked q=%u", PhaseLock.getLockQuality());
     }
 
     uint8_t *nextPayload = 0;
     uint8_t nextPlayloadSize = 0;
-    if (!TelemetrySender.IsActive() && telemetry.GetNextPayload(&nextPlayloadSize, &nextPayload))
+    if (!TelemetrySender.IsActive())
     {
-        TelemetrySender.SetDataToTransmit(nextPayload, nextPlayloadSize);
+        // The last message has gone or been given up on, what the TX has is what the next deltas are against
+        TelemetryDelta.confirm(TelemetrySender.GetDeliveredCount() != telemetryDeltaDelivered);
+        if (TelemetryDeltaEnabled)
+        {
+            SetTelemetryDeltaToTransmit();
+        }
+        else if (telemetry.GetNextPayload(&nextPlayloadSize, &nextPayload))
+        {
+            TelemetrySender.SetDataToTransmit(nextPayload, nextPlayloadSize);
+        }
     }
 
-    uint16_t count = mavlinkInputBuffer.size();
-    if (count > 0 && !TelemetrySender.IsActive())
+    // Constrain to CRSF max payload size to match SS, the scheduler decides which frames go next
+    uint16_t count = TelemetrySender.IsActive() ? 0 : mavlinkDownlink.pop(mavlinkSSBuffer + CRSF_FRAME_NOT_COUNTED_BYTES, CRSF_PAYLOAD_SIZE_MAX, now);
+    if (count > 0)
     {
-        count = std::min(count, (uint16_t)CRSF_PAYLOAD_SIZE_MAX); // Constrain to CRSF max payload size to match SS
         // First 2 bytes conform to crsf_header_s format
         mavlinkSSBuffer[0] = CRSF_ADDRESS_USB; // device_addr - used on TX to differentiate between std tlm and mavlink
         mavlinkSSBuffer[1] = count;
         // Following n bytes are just raw mavlink
-        mavlinkInputBuffer.popBytes(mavlinkSSBuffer + CRSF_FRAME_NOT_COUNTED_BYTES, count);
         nextPayload = mavlinkSSBuffer;
         nextPlayloadSize = count + CRSF_FRAME_NOT_COUNTED_BYTES;
         TelemetrySender.SetDataToTransmit(nextPayload, nextPlayloadSize);
@@ -8,6 +8,7 @@
 #include "telemetry_protocol.h"
 #include "stubborn_receiver.h"
 #include "stubborn_sender.h"
+#include "TelemetryDelta.h"
 
 #include "devHandset.h"
 #include "devLED.h"
@@ -24,6 +25,7 @@
 #include "devBackpack.h"
 
 #include "MAVLink.h"
+#include "MAVLinkScheduler.h"
 
 #if defined(PLATFORM_ESP32_S3)
 #include "USB.h"
@@ -43,11 +45,17 @@ Stream *TxUSB;
 // Variables / constants for Airport //
 FIFO<AP_MAX_BUF_LEN> apInputBuffer;
 FIFO<AP_MAX_BUF_LEN> apOutputBuffer;
+AirPortLink apLink(apInputBuffer, apOutputBuffer);
 
 #define UART_INPUT_BUF_LEN 1024
 FIFO<UART_INPUT_BUF_LEN> uartInputBuffer;
 
 uint8_t mavlinkSSBuffer[CRSF_MAX_PACKET_LEN]; // Buffer for current stubbon sender packet (mavlink only)
+#if !defined(PLATFORM_STM32)
+// Frames from the GCS waiting to go over the air
+static MAVLinkFramer mavlinkUplinkFramer(mavlinkCrcExtra);
+static MAVLinkScheduler mavlinkUplink;
+#endif
 
 #if defined(PLATFORM_ESP8266) || defined(PLATFORM_ESP32)
 unsigned long rebootTime = 0;
@@ -89,7 +97,8 @@ static uint32_t lastPTRValidTimeMs;
 static TxTlmRcvPhase_e TelemetryRcvPhase = ttrpTransmitting;
 StubbornReceiver TelemetryReceiver;
 StubbornSender MspSender;
-uint8_t CRSFinBuffer[CRSF_MAX_PACKET_LEN+1];
+uint8_t CRSFinBuffer[TLM_DELTA_MSG_MAX];
+static TelemetryDeltaDecoder TelemetryDecoder;
 
 device_affinity_t ui_devices[] = {
   {&Handset_device, 1},
@@ -231,7 +240,11 @@ bool ICACHE_RAM_ATTR ProcessTLMpacket(SX12xxDriverCommon::rx_status const status
     {
       if (firmwareOptions.is_airport)
       {
-        OtaUnpackAirportData(otaPktPtr, &apOutputBuffer);
+        // The RX starts over when it connects, and so do we
+        if (connectionState == connected)
+        {
+          OtaUnpackAirportData(otaPktPtr, &apLink);
+        }
         return true;
       }
       telemPtr = ota8->tlm_dl.payload;
@@ -252,7 +265,10 @@ bool ICACHE_RAM_ATTR ProcessTLMpacket(SX12xxDriverCommon::rx_status const status
       case ELRS_TELEMETRY_TYPE_DATA:
         if (firmwareOptions.is_airport)
         {
-          OtaUnpackAirportData(otaPktPtr, &apOutputBuffer);
+          if (connectionState == connected)
+          {
+            OtaUnpackAirportData(otaPktPtr, &apLink);
+          }
           return true;
         }
         TelemetryReceiver.ReceiveData(otaPktPtr->std.tlm_dl.packageIndex & ELRS4_TELEMETRY_MAX_PACKAGES,
@@ -305,8 +321,9 @@ expresslrs_tlm_ratio_e ICACHE_RAM_ATTR UpdateTlmRatioEffective()
   return retVal;
 }
 
-void ICACHE_RAM_ATTR GenerateSyncPacketData(OTA_Sync_s * const syncPtr)
+void ICACHE_RAM_ATTR GenerateSyncPacketData(OTA_Packet_s * const otaPktPtr)
 {
+  OTA_Sync_s * const syncPtr = OtaIsFullRes ? &otaPktPtr->full.sync.sync : &otaPktPtr->std.sync;
   const uint8_t SwitchEncMode = config.GetSwitchMode();
   const uint8_t Index = (syncSpamCounter) ? config.GetRate() : ExpressLRS_currAirRate_Modparams->index;
 
@@ -338,6 +355,12 @@ void ICACHE_RAM_ATTR GenerateSyncPacketData(OTA_Sync_s * const syncPtr)
   {
     syncPtr->UID5 ^= (~CRSFHandset::getModelID()) & MODELMATCH_MASK;
   }
+
+  // Only the full res sync has room to tell the RX it can send delta encoded telemetry
+  if (OtaIsFullRes)
+  {
+    otaPktPtr->full.sync.tlmFeatures = OTA_TLM_FEATURE_DELTA;
+  }
 }
 
 uint8_t adjustPacketRateForBaud(uint8_t rateIndex)
@@ -366,8 +389,8 @@ void SetRFLinkRate(uint8_t index) // Set speed of RF link
 #endif
   hwTimer::updateInterval(interval);
 
-  FHSSusePrimaryFreqBand = !(ModParams->radio_type == RADIO_TYPE_LR1121_LORA_2G4) && !(ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4);
-  FHSSuseDualBand = ModParams->radio_type == RADIO_TYPE_LR1121_LORA_DUAL;
+  FHSSconfigureBands(!(ModParams->radio_type == RADIO_TYPE_LR1121_LORA_2G4) && !(ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4),
+                     ModParams->radio_type == RADIO_TYPE_LR1121_LORA_DUAL);
 
   Radio.Config(ModParams->bw, ModParams->sf, ModParams->cr, FHSSgetInitialFreq(),
                ModParams->PreambleLen, invertIQ, ModParams->PayloadLength, ModParams->interval
@@ -440,6 +463,7 @@ void ICACHE_RAM_ATTR HandleFHSS()
     {
       Radio.SetFrequencyReg(FHSSgetNextFreq());
     }
+    POWERMGNT::setFreqCorrection(FHSSgetCurrIndex());
   }
 }
 
@@ -534,7 +558,7 @@ void ICACHE_RAM_ATTR SendRCdataToRF()
   if ((syncSpamCounter || (syncSpamCounterAfterRateChange && FHSSonSyncChannel())) && (NonceFHSSresult == 1 || NonceFHSSresult == 2))
   {
     otaPkt.std.type = PACKET_TYPE_SYNC;
-    GenerateSyncPacketData(OtaIsFullRes ? &otaPkt.full.sync.sync : &otaPkt.std.sync);
+    GenerateSyncPacketData(&otaPkt);
     syncSlot = 0; // reset the sync slot in case the new rate (after the syncspam) has a lower FHSShopInterval
   }
   // Regular sync rotates through 4x slots, twice on each slot, and telemetry pushes it to the next slot up
@@ -542,12 +566,13 @@ void ICACHE_RAM_ATTR SendRCdataToRF()
   else if ((!skipSync) && ((syncSlot / 2) <= NonceFHSSresult) && (now - SyncPacketLastSent > SyncInterval) && FHSSonSyncChannel())
   {
     otaPkt.std.type = PACKET_TYPE_SYNC;
-    GenerateSyncPacketData(OtaIsFullRes ? &otaPkt.full.sync.sync : &otaPkt.std.sync);
+    GenerateSyncPacketData(&otaPkt);
     syncSlot = (syncSlot + 1) % (ExpressLRS_currAirRate_Modparams->FHSShopInterval * 2);
   }
   else
   {
-    if ((NextPacketIsMspData && MspSender.IsActive()) || dontSendChannelData)
+    bool const mspDue = (NextPacketIsMspData && MspSender.IsActive()) || dontSendChannelData;
+    if (mspDue)
     {
       otaPkt.std.type = PACKET_TYPE_MSPDATA;
       if (OtaIsFullRes)
@@ -581,8 +606,15 @@ void ICACHE_RAM_ATTR SendRCdataToRF()
       // always enable msp after a channel package since the slot is only used if MspSender has data to send
       NextPacketIsMspData = true;
 
-      injectBackpackPanTiltRollData(now);
-      OtaPackChannelData(&otaPkt, ChannelData, TelemetryReceiver.GetCurrentConfirm(), ExpressLRS_currTlmDenom);
+      if (firmwareOptions.is_airport && connectionState == connected && apLink.takesUplinkSlot(mspDue))
+      {
+        OtaPackAirportData(&otaPkt, &apLink);
+      }
+      else
+      {
+        injectBackpackPanTiltRollData(now);
+        OtaPackChannelData(&otaPkt, ChannelData, TelemetryReceiver.GetCurrentConfirm(), ExpressLRS_currTlmDenom);
+      }
     }
   }
 
@@ -901,9 +933,9 @@ static void UpdateConnectDisconnectStatus()
       CRSFHandset::ForwardDevicePings = true;
       DBGLN("got downlink conn");
 
-      apInputBuffer.flush();
-      apOutputBuffer.flush();
+      apLink.reset();
       uartInputBuffer.flush();
+      TelemetryDecoder.reset();
     }
   }
   // If past RX_LOSS_CNT, or in awaitingModelId state for longer than DisconnectTimeoutMs, go to disconnected
@@ -1007,7 +1039,7 @@ static void EnterBindingMode()
   SetRFLinkRate(enumRatetoIndex(RATE_BINDING));
 
 #if defined(RADIO_LR1121)
-  FHSSuseDualBand = true;
+  FHSSconfigureBands(FHSSusePrimaryFreqBand, true);
   expresslrs_mod_settings_s *const dualBandBindingModParams = get_elrs_airRateConfig(RATE_DUALBAND_BINDING); // 2.4GHz 50Hz
   Radio.Config(dualBandBindingModParams->bw2, dualBandBindingModParams->sf2, dualBandBindingModParams->cr2, FHSSgetInitialGeminiFreq(),
                dualBandBindingModParams->PreambleLen2, true, dualBandBindingModParams->PayloadLength, dualBandBindingModParams->interval,
@@ -1103,6 +1135,12 @@ static void HandleUARTout()
 {
   if (firmwareOptions.is_airport)
   {
+#if defined(AIRPORT_FLOW_XONXOFF)
+    if (apLink.updateFlowControl())
+    {
+      TxUSB->write(apLink.isInputPaused() ? AIRPORT_XOFF : AIRPORT_XON);
+    }
+#endif
     auto size = apOutputBuffer.size();
     if (size)
     {
@@ -1115,6 +1153,26 @@ static void HandleUARTout()
   }
 }
 
+static void forwardMAVLinkDownlink(const uint8_t *data, uint16_t len)
+{
+  TxUSB->write(data, len);
+  // If we have a backpack
+  if (TxUSB != TxBackpack)
+  {
+    TxBackpack->write(data, len);
+  }
+}
+
+#if !defined(PLATFORM_STM32)
+static uint32_t mavlinkUplinkRate()
+{
+  // MSP data can go in every other packet which isn't telemetry
+  uint32_t const hz = 1000000 / ExpressLRS_currAirRate_Modparams->interval;
+  uint32_t const tlmHz = (ExpressLRS_currTlmDenom > 1) ? hz / ExpressLRS_currTlmDenom : 0;
+  return (hz - tlmHz) / 2 * (OtaIsFullRes ? ELRS8_MSP_BYTES_PER_CALL : ELRS4_MSP_BYTES_PER_CALL);
+}
+#endif
+
 static void HandleUARTin()
 {
   // Read from the USB serial port
@@ -1390,6 +1448,7 @@ void setup()
 
     setupBindingFromConfig();
     FHSSrandomiseFHSSsequence(uidMacSeedGet());
+    POWERMGNT::buildFreqCorrection();
 
     Radio.RXdoneCallback = &RXdoneISR;
     Radio.TXdoneCallback = &TXdoneISR;
@@ -1528,15 +1587,26 @@ void loop()
       {
         if (config.GetLinkMode() == TX_MAVLINK_MODE)
         {
-          // raw mavlink data - forward to USB rather than handset
+          // raw mavlink data - forward to USB rather than handset, and convert to CRSF telemetry where we can
           uint8_t count = CRSFinBuffer[1];
-          // Convert to CRSF telemetry where we can
-          convert_mavlink_to_crsf_telem(CRSFinBuffer, count, handset);
-          TxUSB->write(CRSFinBuffer + CRSF_FRAME_NOT_COUNTED_BYTES, count);
-          // If we have a backpack
-          if (TxUSB != TxBackpack)
+          processMAVLinkDownlink(CRSFinBuffer + CRSF_FRAME_NOT_COUNTED_BYTES, count, now, handset, forwardMAVLinkDownlink);
+        }
+      }
+      else if (CRSFinBuffer[0] == TLM_DELTA_ADDRESS)
+      {
+        // Every frame the RX had waiting, each rebuilt to the CRSF frame the RX got.
+        // The length came over the air, so only walk what was actually received
+        uint8_t frame[TLM_DELTA_MSG_MAX];
+        uint16_t const end = std::min<uint16_t>(CRSFinBuffer[1] + TLM_DELTA_MSG_HEADER_LEN, TelemetryReceiver.GetReceivedLength());
+        for (uint16_t pos = TLM_DELTA_MSG_HEADER_LEN; pos + 1 < end && pos + CRSFinBuffer[pos + 1] + 2 <= end; pos += CRSFinBuffer[pos + 1] + 2)
+        {
+          // Every CRSF frame has at least a type and CRC, anything shorter is corrupt
+          if (CRSFinBuffer[pos + 1] < 2)
+            break;
+          if (TelemetryDecoder.decode(&CRSFinBuffer[pos], frame))
           {
-            TxBackpack->write(CRSFinBuffer + CRSF_FRAME_NOT_COUNTED_BYTES, count);
+            handset->sendTelemetryToTX(frame);
+            crsfTelemToMSPOut(frame);
           }
         }
       }
@@ -1587,6 +1657,31 @@ void loop()
     // Use MspSender for MAVLINK uplink data
     uint8_t *nextPayload = 0;
     uint8_t nextPlayloadSize = 0;
+#if !defined(PLATFORM_STM32)
+    // Frame and queue everything from the GCS, the scheduler decides which frames go next
+    uint16_t count = std::min(uartInputBuffer.size(), mavlinkUplinkFramer.space());
+    if (count > 0)
+    {
+        uartInputBuffer.lock();
+        uartInputBuffer.popBytes(mavlinkUplinkFramer.writePtr(), count);
+        uartInputBuffer.unlock();
+        mavlinkUplinkFramer.commit(count);
+        mavlinkUplinkFramer.process(now, [](const uint8_t *data, uint16_t len) {
+            mavlinkUplink.pushFrames(data, len);
+        });
+    }
+    count = 0;
+    if (!MspSender.IsActive())
+    {
+        mavlinkUplink.setLinkRate(mavlinkUplinkRate());
+        count = mavlinkUplink.pop(mavlinkSSBuffer + CRSF_FRAME_NOT_COUNTED_BYTES, CRSF_PAYLOAD_SIZE_MAX, now);
+    }
+    if (count > 0)
+    {
+        mavlinkSSBuffer[0] = MSP_ELRS_MAVLINK_TLM; // Used on RX to differentiate between std msp opcodes and mavlink
+        mavlinkSSBuffer[1] = count;
+        // Following n bytes are just raw mavlink
+#else
     uint16_t count = uartInputBuffer.size();
     if (count > 0 && !MspSender.IsActive())
     {
@@ -1597,6 +1692,7 @@ void loop()
         uartInputBuffer.lock();
         uartInputBuffer.popBytes(mavlinkSSBuffer + CRSF_FRAME_NOT_COUNTED_BYTES, count);
         uartInputBuffer.unlock();
+#endif
         nextPayload = mavlinkSSBuffer;
         nextPlayloadSize = count + CRSF_FRAME_NOT_COUNTED_BYTES;
         MspSender.SetDataToTransmit(nextPayload, nextPlayloadSize);
@@ -0,0 +1,330 @@
+#include <cstdint>
+#include <vector>
+#include <unity.h>
+#include "AirPortLink.h"
+
+using namespace std;
+
+#define STD_PAYLOAD ELRS4_TELEMETRY_BYTES_PER_CALL
+#define FULL_PAYLOAD ELRS8_TELEMETRY_BYTES_PER_CALL
+
+// One end of the link, the UART side reads from source and writes to received
+class End
+{
+public:
+    explicit End(bool reliable) : link(input, output, reliable) {}
+
+    FIFO<AP_MAX_BUF_LEN> input;
+    FIFO<AP_MAX_BUF_LEN> output;
+    AirPortLink link;
+    uint32_t sourcePos = 0;
+    vector<uint8_t> received;
+
+    static uint8_t sourceByte(uint32_t pos) { return (uint8_t)(pos * 7 + (pos >> 8)); }
+
+    // Read as much as there is room for, like SerialAirPort::getMaxSerialReadSize() does
+    void uartIn(uint32_t maxBytes)
+    {
+        while (maxBytes-- && input.free() > 0)
+            input.push(sourceByte(sourcePos++));
+    }
+
+    void uartOut(uint32_t maxBytes)
+    {
+        while (maxBytes-- && output.size() > 0)
+            received.push_back(output.pop());
+    }
+
+    bool receivedIntact(uint32_t from = 0, uint32_t sourceFrom = 0) const
+    {
+        for (uint32_t i = from; i < received.size(); ++i)
+            if (received[i] != sourceByte(sourceFrom + i - from))
+                return false;
+        return true;
+    }
+
+    // Whether what was received after from carries on unbroken from somewhere in the other end's source
+    bool receivedIntactAfter(uint32_t from, uint32_t sourceLimit) const
+    {
+        for (uint32_t sourceFrom = 0; sourceFrom < sourceLimit; ++sourceFrom)
+            if (receivedIntact(from, sourceFrom))
+                return true;
+        return false;
+    }
+};
+
+// Deterministic packet loss
+class Channel
+{
+public:
+    explicit Channel(uint8_t lossPercent) : _lossPercent(lossPercent), _state(12345) {}
+    bool lost()
+    {
+        _state = _state * 1103515245 + 12345;
+        return ((_state >> 16) % 100) < _lossPercent;
+    }
+private:
+    uint8_t _lossPercent;
+    uint32_t _state;
+};
+
+static void sendPacket(End &from, End &to, uint8_t payloadLen, Channel &channel)
+{
+    if (!from.link.hasPending())
+        return;
+    uint8_t payload[FULL_PAYLOAD];
+    uint8_t count = from.link.pack(payload, payloadLen);
+    if (!channel.lost())
+        to.link.unpack(payload, count);
+}
+
+// TX and RX take turns, as they do with the telemetry ratio at 1:2
+static void runLink(End &tx, End &rx, uint8_t payloadLen, uint8_t lossPercent, uint32_t slots, uint32_t uartBytesPerSlot, bool duplex)
+{
+    Channel channel(lossPercent);
+    for (uint32_t slot = 0; slot < slots; ++slot)
+    {
+        tx.uartIn(uartBytesPerSlot);
+        if (duplex)
+            rx.uartIn(uartBytesPerSlot);
+        sendPacket(tx, rx, payloadLen, channel);
+        sendPacket(rx, tx, payloadLen, channel);
+        tx.uartOut(uartBytesPerSlot);
+        rx.uartOut(uartBytesPerSlot);
+    }
+}
+
+void test_raw_mode_unchanged(void)
+{
+    End tx(false), rx(false);
+    const uint8_t data[] = {1, 2, 3, 4, 5, 6, 7};
+    tx.input.pushBytes(data, sizeof(data));
+    TEST_ASSERT_TRUE(tx.link.hasPending());
+
+    uint8_t payload[STD_PAYLOAD];
+    TEST_ASSERT_EQUAL(STD_PAYLOAD, tx.link.pack(payload, sizeof(payload)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, payload, STD_PAYLOAD);
+    rx.link.unpack(payload, STD_PAYLOAD);
+    TEST_ASSERT_EQUAL(2, tx.link.pack(payload, sizeof(payload)));
+    rx.link.unpack(payload, 2);
+    TEST_ASSERT_FALSE(tx.link.hasPending());
+
+    rx.uartOut(100);
+    TEST_ASSERT_EQUAL(sizeof(data), rx.received.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, rx.received.data(), sizeof(data));
+}
+
+void test_reliable_in_order(void)
+{
+    End tx(true), rx(true);
+    runLink(tx, rx, STD_PAYLOAD, 0, 100, 100, false);
+
+    // 4 bytes of data in every packet
+    TEST_ASSERT_EQUAL(100 * (STD_PAYLOAD - 1), rx.received.size());
+    TEST_ASSERT_TRUE(rx.receivedIntact());
+    TEST_ASSERT_EQUAL(0, tx.link.segmentsResent);
+    TEST_ASSERT_EQUAL(0, rx.link.duplicates);
+}
+
+void test_selective_resend(void)
+{
+    End tx(true), rx(true);
+    const uint8_t data[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    tx.input.pushBytes(data, sizeof(data));
+
+    // Send three segments, the first is lost
+    uint8_t seg[3][STD_PAYLOAD];
+    for (unsigned i = 0; i < 3; ++i)
+        TEST_ASSERT_EQUAL(STD_PAYLOAD, tx.link.pack(seg[i], STD_PAYLOAD));
+    TEST_ASSERT_EQUAL(3, tx.link.segmentsSent);
+    rx.link.unpack(seg[1], STD_PAYLOAD);
+    rx.link.unpack(seg[2], STD_PAYLOAD);
+    TEST_ASSERT_EQUAL(0, rx.output.size());
+
+    // The ack selectively acknowledges 1 and 2, so only 0 is sent again
+    uint8_t payload[STD_PAYLOAD];
+    TEST_ASSERT_EQUAL(1, rx.link.pack(payload, STD_PAYLOAD));
+    tx.link.unpack(payload, 1);
+    TEST_ASSERT_EQUAL(STD_PAYLOAD, tx.link.pack(payload, STD_PAYLOAD));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(seg[0], payload, STD_PAYLOAD);
+    TEST_ASSERT_EQUAL(1, tx.link.segmentsResent);
+    rx.link.unpack(payload, STD_PAYLOAD);
+
+    rx.uartOut(100);
+    TEST_ASSERT_EQUAL(sizeof(data), rx.received.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, rx.received.data(), sizeof(data));
+
+    // The cumulative ack frees the window
+    TEST_ASSERT_EQUAL(1, rx.link.pack(payload, STD_PAYLOAD));
+    tx.link.unpack(payload, 1);
+    TEST_ASSERT_FALSE(tx.link.hasPending());
+}
+
+void test_slow_output_holds_sender(void)
+{
+    End tx(true), rx(true);
+    // The far UART only takes one byte per slot, nothing is lost
+    Channel channel(0);
+    for (unsigned slot = 0; slot < 1000; ++slot)
+    {
+        tx.uartIn(100);
+        sendPacket(tx, rx, FULL_PAYLOAD, channel);
+        sendPacket(rx, tx, FULL_PAYLOAD, channel);
+        rx.uartOut(1);
+    }
+    TEST_ASSERT_EQUAL(1000, rx.received.size());
+    TEST_ASSERT_TRUE(rx.receivedIntact());
+    TEST_ASSERT_TRUE(rx.link.outputStalls > 0);
+}
+
+void test_flow_control(void)
+{
+    End end(true);
+    TEST_ASSERT_FALSE(end.link.updateFlowControl());
+    end.uartIn(AIRPORT_FLOW_STOP - 1);
+    TEST_ASSERT_FALSE(end.link.updateFlowControl());
+    end.uartIn(1);
+    TEST_ASSERT_TRUE(end.link.updateFlowControl());
+    TEST_ASSERT_TRUE(end.link.isInputPaused());
+
+    // Hysteresis, it carries on only once the buffer has drained
+    while (end.input.size() > AIRPORT_FLOW_RESUME + 1)
+        end.input.pop();
+    TEST_ASSERT_FALSE(end.link.updateFlowControl());
+    end.input.pop();
+    TEST_ASSERT_TRUE(end.link.updateFlowControl());
+    TEST_ASSERT_FALSE(end.link.isInputPaused());
+}
+
+void test_reset_restarts_sequence(void)
+{
+    End tx(true), rx(true);
+    runLink(tx, rx, STD_PAYLOAD, 20, 50, 100, true);
+    tx.link.reset();
+    rx.link.reset();
+    tx.received.clear();
+    rx.received.clear();
+    tx.sourcePos = 0;
+    rx.sourcePos = 0;
+    // Only the reset handshake to send
+    TEST_ASSERT_TRUE(tx.link.hasPending());
+    runLink(tx, rx, STD_PAYLOAD, 0, 2, 0, false);
+    TEST_ASSERT_FALSE(tx.link.hasPending());
+    TEST_ASSERT_FALSE(rx.link.hasPending());
+
+    runLink(tx, rx, STD_PAYLOAD, 0, 10, 100, false);
+    TEST_ASSERT_EQUAL(10 * (STD_PAYLOAD - 1), rx.received.size());
+    TEST_ASSERT_TRUE(rx.receivedIntact());
+}
+
+void test_one_side_reset(void)
+{
+    // Only one end sees the connection drop, e.g. the TX on a reconnect the RX coasted through
+    for (bool resetTx : {true, false})
+    {
+        End tx(true), rx(true);
+        runLink(tx, rx, STD_PAYLOAD, 10, 500, 100, true);
+        End &restarted = resetTx ? tx : rx;
+        End &other = resetTx ? rx : tx;
+        restarted.link.reset();
+        uint32_t const restartedMark = restarted.received.size();
+        uint32_t const otherMark = other.received.size();
+
+        runLink(tx, rx, STD_PAYLOAD, 10, 500, 100, true);
+        TEST_ASSERT_EQUAL(1, other.link.resyncs);
+        // Both ways carry on, from wherever each source got to without a gap after that
+        TEST_ASSERT_TRUE(restarted.received.size() - restartedMark > 250 * (STD_PAYLOAD - 1));
+        TEST_ASSERT_TRUE(other.received.size() - otherMark > 250 * (STD_PAYLOAD - 1));
+        TEST_ASSERT_TRUE(restarted.receivedIntactAfter(restartedMark, other.sourcePos));
+        TEST_ASSERT_TRUE(other.receivedIntactAfter(otherMark, restarted.sourcePos));
+    }
+}
+
+void test_msp_not_starved(void)
+{
+    // Nothing comes back from the RX, so the window stays full and there is always something to send
+    End tx(true), rx(true);
+    Channel none(0);
+    tx.uartIn(AP_MAX_BUF_LEN);
+    sendPacket(tx, rx, STD_PAYLOAD, none);
+    sendPacket(rx, tx, STD_PAYLOAD, none);
+    for (int i = 0; i < AIRPORT_WINDOW; ++i)
+        sendPacket(tx, rx, STD_PAYLOAD, none);
+    TEST_ASSERT_TRUE(tx.link.hasPending());
+
+    // The data slot choice in SendRCdataToRF() with MSP always having something to send
+    bool nextPacketIsMspData = false;
+    uint32_t mspPackets = 0;
+    uint32_t airportPackets = 0;
+    for (int slot = 0; slot < 100; ++slot)
+    {
+        bool const mspDue = nextPacketIsMspData;
+        if (mspDue)
+        {
+            ++mspPackets;
+            nextPacketIsMspData = false;
+        }
+        else
+        {
+            nextPacketIsMspData = true;
+            TEST_ASSERT_TRUE(tx.link.takesUplinkSlot(mspDue));
+            uint8_t payload[FULL_PAYLOAD];
+            tx.link.pack(payload, STD_PAYLOAD);
+            ++airportPackets;
+        }
+        TEST_ASSERT_TRUE(tx.link.hasPending());
+    }
+    TEST_ASSERT_EQUAL(50, mspPackets);
+    TEST_ASSERT_EQUAL(50, airportPackets);
+    TEST_ASSERT_FALSE(tx.link.takesUplinkSlot(true));
+}
+
+// Goodput against loss rate, in data bytes per packet sent in each direction
+void test_goodput_vs_loss(void)
+{
+    const uint8_t losses[] = {0, 5, 10, 20, 30, 50};
+    const uint32_t slots = 20000;
+
+    for (uint8_t payloadLen : {(uint8_t)STD_PAYLOAD, (uint8_t)FULL_PAYLOAD})
+    {
+        for (uint8_t loss : losses)
+        {
+            End rawTx(false), rawRx(false);
+            runLink(rawTx, rawRx, payloadLen, loss, slots, 100, false);
+
+            End tx(true), rx(true);
+            runLink(tx, rx, payloadLen, loss, slots, 100, true);
+            float const goodput = (float)rx.received.size() / slots;
+
+            // Nothing is lost or out of order in either direction
+            TEST_ASSERT_TRUE(rx.receivedIntact());
+            TEST_ASSERT_TRUE(tx.receivedIntact());
+            // Close to the ideal of the data bytes times the chance both the segment and its ack get through
+            float const ideal = (payloadLen - 1) * (100 - loss) / 100.0f;
+            TEST_ASSERT_TRUE(goodput >= ideal * 0.8f);
+            if (loss > 0)
+                TEST_ASSERT_FALSE(rawRx.receivedIntact());
+        }
+    }
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_raw_mode_unchanged);
+    RUN_TEST(test_reliable_in_order);
+    RUN_TEST(test_selective_resend);
+    RUN_TEST(test_slow_output_holds_sender);
+    RUN_TEST(test_flow_control);
+    RUN_TEST(test_reset_restarts_sequence);
+    RUN_TEST(test_one_side_reset);
+    RUN_TEST(test_msp_not_starved);
+    RUN_TEST(test_goodput_vs_loss);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <cstdint>
+#include <cmath>
+#include <unity.h>
+#include "baro_math.h"
+
+// SPL06 scale factors for the oversampling BaroSPL06 uses, 32x pressure and 8x temperature
+#define SPL06_SCALE_PRESSURE    516096
+#define SPL06_SCALE_TEMPERATURE 7864320
+
+// Coefficients read from a couple of SPL06-001 parts
+static const spl06_calib_t calibs[] = {
+    {204, -261, 80469, -54937, -2733, 1254, -10527, 131, -1150},
+    {198, -258, 78752, -52144, -2895, 1087, -9984, 47, -1306},
+};
+
+static double refAltitude(uint32_t pressuredPa)
+{
+    return 4433000 * (1.0 - pow(pressuredPa / 1013250.0, 0.1903));
+}
+
+static double refTemperature(const spl06_calib_t &c, int32_t rawTemp)
+{
+    double const t = (double)rawTemp / SPL06_SCALE_TEMPERATURE;
+    return (c.c0 / 2.0 + t * c.c1) * 100;
+}
+
+static double refPressure(const spl06_calib_t &c, int32_t rawPress, int32_t rawTemp)
+{
+    double const t = (double)rawTemp / SPL06_SCALE_TEMPERATURE;
+    double const p = (double)rawPress / SPL06_SCALE_PRESSURE;
+    double const cal = c.c00 + p * (c.c10 + p * (c.c20 + p * c.c30));
+    double const tcomp = t * (c.c01 + p * (c.c11 + p * c.c21));
+    return (cal + tcomp) * 10;
+}
+
+void test_altitude_accuracy(void)
+{
+    double worstFlight = 0;
+    double worstLow = 0;
+    int32_t last = INT32_MAX;
+    for (uint32_t p = 200000; p <= 1100000; p++)
+    {
+        int32_t const alt = baroPressureToAltitude(p);
+        double const err = fabs(alt - refAltitude(p));
+        if (p >= 900000)
+            worstLow = err > worstLow ? err : worstLow;
+        else
+            worstFlight = err > worstFlight ? err : worstFlight;
+        // Never goes up with pressure, or vario gets a kick at the table points
+        TEST_ASSERT_TRUE(alt <= last);
+        last = alt;
+    }
+    TEST_ASSERT_TRUE(worstFlight <= 30);
+    TEST_ASSERT_TRUE(worstLow <= 2);
+
+    // On the table points it is the curve
+    for (uint32_t i = BARO_ALT_LUT_FIRST; i < BARO_ALT_LUT_FIRST + BARO_ALT_LUT_COUNT; i++)
+        TEST_ASSERT_TRUE(fabs(baroPressureToAltitude(i << BARO_ALT_LUT_SHIFT) - refAltitude(i << BARO_ALT_LUT_SHIFT)) <= 0.5);
+    // Outside the table it carries on
+    TEST_ASSERT_TRUE(fabs(baroPressureToAltitude(190000) - refAltitude(190000)) < 500);
+    TEST_ASSERT_TRUE(fabs(baroPressureToAltitude(1120000) - refAltitude(1120000)) < 100);
+}
+
+void test_spl06_compensation(void)
+{
+    uint32_t const pRecip = spl06ScaleReciprocal(SPL06_SCALE_PRESSURE);
+    uint32_t const tRecip = spl06ScaleReciprocal(SPL06_SCALE_TEMPERATURE);
+    for (const spl06_calib_t &c : calibs)
+    {
+        double worstPress = 0;
+        double worstTemp = 0;
+        uint32_t checked = 0;
+        // -40C to 85C
+        for (int32_t rawTemp = -2500000; rawTemp <= 2500000; rawTemp += 25000)
+        {
+            int32_t const tSc = spl06Scale(rawTemp, tRecip);
+            double const temp = refTemperature(c, rawTemp);
+            double const tErr = fabs(spl06Temperature(c, tSc) - temp);
+            worstTemp = tErr > worstTemp ? tErr : worstTemp;
+
+            for (int32_t rawPress = -(1 << 23); rawPress < (1 << 23); rawPress += 997)
+            {
+                double const ref = refPressure(c, rawPress, rawTemp);
+                // The range the altitude curve is made for
+                if (ref < 200000 || ref > 1100000)
+                    continue;
+                double const err = fabs(spl06Pressure(c, spl06Scale(rawPress, pRecip), tSc) - ref);
+                worstPress = err > worstPress ? err : worstPress;
+                ++checked;
+            }
+        }
+        TEST_ASSERT_TRUE(checked > 100000);
+        // Half a dPa rounding and a little of the fractions shifted out
+        TEST_ASSERT_TRUE(worstPress <= 1);
+        TEST_ASSERT_TRUE(worstTemp <= 1);
+    }
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_altitude_accuracy);
+    RUN_TEST(test_spl06_compensation);
+    UNITY_END();
+
+    return 0;
+}
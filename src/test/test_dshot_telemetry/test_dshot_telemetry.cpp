@@ -0,0 +1,168 @@
+#include <cstdint>
+#include <unity.h>
+#include "DShotTelemetry.h"
+
+// The DShotRMT capture clock, 80MHz APB / 8
+#define TICK_HZ 10000000U
+// DShot300 replies at 375kbit/s
+#define TICKS_PER_BIT (TICK_HZ / 375000.0)
+
+static uint32_t bitsPerTick;
+
+static const uint8_t gcrEncode[16] = {
+    0x19, 0x1B, 0x12, 0x13, 0x1D, 0x15, 0x16, 0x17, 0x1A, 0x09, 0x0A, 0x0B, 0x1E, 0x0D, 0x0E, 0x0F,
+};
+
+// What the ESC sends, as the run lengths in bits. The last run merges into the idle line
+static uint8_t encodeRuns(uint16_t value, uint8_t *runs, bool badCrc = false)
+{
+    uint16_t crc = (~(value ^ (value >> 4) ^ (value >> 8))) & 0xF;
+    if (badCrc)
+        crc ^= 1;
+    uint16_t const packet = (value << 4) | crc;
+    uint32_t gcr = 0;
+    for (int shift = 12; shift >= 0; shift -= 4)
+        gcr = (gcr << 5) | gcrEncode[(packet >> shift) & 0xF];
+
+    uint8_t count = 0;
+    runs[0] = 1; // start bit
+    for (int bit = 19; bit >= 0; --bit)
+    {
+        if ((gcr >> bit) & 1)
+            runs[++count] = 1;
+        else
+            ++runs[count];
+    }
+    return count + 1;
+}
+
+static uint8_t encodeCapture(uint16_t value, uint16_t *ticks, int8_t jitter = 0, uint32_t seed = 0, bool badCrc = false)
+{
+    uint8_t runs[DSHOT_TELEMETRY_MAX_RUNS];
+    uint8_t const count = encodeRuns(value, runs, badCrc);
+    // Each edge is off by up to +/-jitter ticks
+    double edge = 0;
+    double lastEdge = 0;
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        edge += runs[i] * TICKS_PER_BIT;
+        seed = seed * 1103515245 + 12345;
+        double const noisyEdge = edge + (jitter ? (int)((seed >> 16) % (2 * jitter + 1)) - jitter : 0);
+        ticks[i] = (uint16_t)(noisyEdge - lastEdge + 0.5);
+        lastEdge = noisyEdge;
+    }
+    // A high last run is never captured, it carries on into the idle line
+    return (count & 1) == 0 ? count - 1 : count;
+}
+
+void test_all_values(void)
+{
+    uint16_t ticks[DSHOT_TELEMETRY_MAX_RUNS];
+    for (uint16_t value = 0; value < 4096; ++value)
+    {
+        uint8_t const count = encodeCapture(value, ticks);
+        uint32_t const gcr = dshotTelemetryRunsToGcr(ticks, count, bitsPerTick);
+        TEST_ASSERT_NOT_EQUAL(DSHOT_TELEMETRY_INVALID, gcr);
+        TEST_ASSERT_EQUAL(value, dshotTelemetryDecodeGcr(gcr));
+    }
+}
+
+void test_edge_jitter(void)
+{
+    // An edge up to 1/3 of a bit early or late still rounds to the right length
+    dshot_telemetry_t tlm = {0};
+    uint16_t ticks[DSHOT_TELEMETRY_MAX_RUNS];
+    for (uint32_t seed = 1; seed < 5000; ++seed)
+    {
+        uint16_t const value = (seed * 2654435761U) >> 20;
+        uint8_t const count = encodeCapture(value, ticks, 4, seed);
+        TEST_ASSERT_TRUE(dshotTelemetryDecode(&tlm, ticks, count, bitsPerTick));
+    }
+    TEST_ASSERT_EQUAL(4999, tlm.frames);
+    TEST_ASSERT_EQUAL(0, tlm.errors);
+}
+
+void test_rejects_bad_captures(void)
+{
+    dshot_telemetry_t tlm = {0};
+    uint16_t ticks[DSHOT_TELEMETRY_MAX_RUNS];
+
+    uint8_t count = encodeCapture(0x3F4, ticks, 0, 0, true);
+    TEST_ASSERT_FALSE(dshotTelemetryDecode(&tlm, ticks, count, bitsPerTick));
+
+    // A glitch shorter than half a bit
+    count = encodeCapture(0x3F4, ticks);
+    ticks[3] = 5;
+    TEST_ASSERT_FALSE(dshotTelemetryDecode(&tlm, ticks, count, bitsPerTick));
+
+    // Longer than a reply, such as the capture of the DShot frame itself
+    uint16_t frame[32];
+    for (uint8_t i = 0; i < 32; ++i)
+        frame[i] = (i & 1) ? 20 : 12;
+    TEST_ASSERT_FALSE(dshotTelemetryDecode(&tlm, frame, 32, bitsPerTick));
+
+    TEST_ASSERT_FALSE(dshotTelemetryDecode(&tlm, ticks, 0, bitsPerTick));
+    TEST_ASSERT_EQUAL(4, tlm.errors);
+    TEST_ASSERT_EQUAL(0, tlm.frames);
+    TEST_ASSERT_EQUAL(0, tlm.updated);
+}
+
+void test_erpm_and_edt(void)
+{
+    dshot_telemetry_t tlm = {0};
+    // 1000us period is 500 << 1
+    dshotTelemetryProcess(&tlm, (1 << 9) | 500);
+    TEST_ASSERT_EQUAL(60000, tlm.erpm);
+    TEST_ASSERT_EQUAL(DSHOT_TLM_ERPM, tlm.updated);
+    // Not normalized, exponent 0
+    dshotTelemetryProcess(&tlm, 200);
+    TEST_ASSERT_EQUAL(300000, tlm.erpm);
+    // Stopped
+    dshotTelemetryProcess(&tlm, 0xFFF);
+    TEST_ASSERT_EQUAL(0, tlm.erpm);
+
+    tlm.updated = 0;
+    dshotTelemetryProcess(&tlm, 0x200 | 45);
+    TEST_ASSERT_EQUAL(45, tlm.temperature);
+    dshotTelemetryProcess(&tlm, 0x400 | 64);
+    TEST_ASSERT_EQUAL(1600, tlm.voltage);
+    dshotTelemetryProcess(&tlm, 0x600 | 12);
+    TEST_ASSERT_EQUAL(12, tlm.current);
+    TEST_ASSERT_EQUAL(DSHOT_TLM_TEMPERATURE | DSHOT_TLM_VOLTAGE | DSHOT_TLM_CURRENT, tlm.updated);
+    // Status is ignored
+    dshotTelemetryProcess(&tlm, 0xE00 | 0x80);
+    TEST_ASSERT_EQUAL(0, tlm.erpm);
+}
+
+void test_captures(void)
+{
+    // RMT captures in 0.1us ticks, worked out by hand from the spec with some edge jitter
+    const uint16_t erpm60000[] = {26, 81, 27, 54, 26, 28, 27, 26, 27, 28, 52, 27, 54, 27, 26};
+    const uint16_t temperature45[] = {28, 79, 53, 81, 79, 27, 54, 26, 81};
+
+    dshot_telemetry_t tlm = {0};
+    TEST_ASSERT_TRUE(dshotTelemetryDecode(&tlm, erpm60000, sizeof(erpm60000) / sizeof(erpm60000[0]), bitsPerTick));
+    TEST_ASSERT_EQUAL(60000, tlm.erpm);
+    TEST_ASSERT_TRUE(dshotTelemetryDecode(&tlm, temperature45, sizeof(temperature45) / sizeof(temperature45[0]), bitsPerTick));
+    TEST_ASSERT_EQUAL(45, tlm.temperature);
+}
+
+// Unity setup/teardown
+void setUp()
+{
+    bitsPerTick = dshotTelemetryBitsPerTick(TICK_HZ, 300);
+}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_all_values);
+    RUN_TEST(test_edge_jitter);
+    RUN_TEST(test_rejects_bad_captures);
+    RUN_TEST(test_erpm_and_edt);
+    RUN_TEST(test_captures);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include <cstdint>
+#include <set>
+#include <unity.h>
+#include "FHSS.h"
+
+// The LR1121 bands, frequencies in Hz as the LR1121 takes them
+#define LOW_START       903500000   // FCC915
+#define LOW_STOP        926900000
+#define LOW_COUNT       40
+#define HIGH_START      2400400000U // ISM2G4
+#define HIGH_STOP       2479400000U
+#define HIGH_COUNT      80
+
+#define SIM_HOPS        10000
+
+static uint8_t lowSequence[FHSS_SEQUENCE_LEN];
+static uint8_t highSequence[FHSS_SEQUENCE_LEN];
+static fhss_band_t bands[FHSS_BAND_COUNT];
+static FHSSHopPlan plan;
+
+static const uint8_t patternLow[] = {FHSS_BAND_PRIMARY};
+static const uint8_t patternHigh[] = {FHSS_BAND_DUAL};
+static const uint8_t patternInterleaved[] = {FHSS_BAND_PRIMARY, FHSS_BAND_DUAL};
+
+static uint16_t bandCount(uint8_t freqCount)
+{
+    return (FHSS_SEQUENCE_LEN / freqCount) * freqCount;
+}
+
+void setUp()
+{
+    FHSSrandomiseFHSSsequenceBuild(0x01020304L, LOW_COUNT, LOW_COUNT / 2 + 1, lowSequence);
+    FHSSrandomiseFHSSsequenceBuild(0x01020304L, HIGH_COUNT, HIGH_COUNT / 2 + 1, highSequence);
+    bands[FHSS_BAND_PRIMARY] = {LOW_START, (LOW_STOP - LOW_START) / (LOW_COUNT - 1), 1, LOW_COUNT, LOW_COUNT / 2 + 1, lowSequence};
+    bands[FHSS_BAND_DUAL] = {HIGH_START, (HIGH_STOP - HIGH_START) / (HIGH_COUNT - 1), 1, HIGH_COUNT, HIGH_COUNT / 2 + 1, highSequence};
+}
+
+void tearDown() {}
+
+static uint32_t freqOf(const fhss_band_t &band, uint8_t channel)
+{
+    return band.freqStart + band.freqSpread * channel;
+}
+
+void test_plan_single_band(void)
+{
+    plan.build(bands, patternLow, 1, FHSS_RADIO2_GEMINI, bandCount(LOW_COUNT));
+    TEST_ASSERT_EQUAL(240, plan.getCount());
+    for (uint16_t i = 0; i < plan.getCount(); i++)
+    {
+        // The sequence, and for radio 2 the Gemini offset
+        uint8_t const channel = lowSequence[i];
+        TEST_ASSERT_EQUAL(freqOf(bands[0], channel), plan.getFreq(0, i));
+        TEST_ASSERT_EQUAL(freqOf(bands[0], (channel + LOW_COUNT / 2) % LOW_COUNT), plan.getFreq(1, i));
+        TEST_ASSERT_EQUAL(i % LOW_COUNT == 0, (plan.getFlags(i) & FHSS_HOP_SYNC) != 0);
+        TEST_ASSERT_EQUAL(FHSS_HOP_USES_PRIMARY, plan.getFlags(i) & ~FHSS_HOP_SYNC);
+        TEST_ASSERT_EQUAL(FHSS_BAND_PRIMARY, plan.getBand(0, i));
+        TEST_ASSERT_EQUAL(FHSS_BAND_PRIMARY, plan.getBand(1, i));
+    }
+
+    plan.build(bands, patternHigh, 1, FHSS_RADIO2_GEMINI, bandCount(HIGH_COUNT));
+    TEST_ASSERT_EQUAL(240, plan.getCount());
+    TEST_ASSERT_EQUAL(freqOf(bands[1], HIGH_COUNT / 2 + 1), plan.getFreq(0, 0));
+    TEST_ASSERT_EQUAL(FHSS_HOP_USES_DUAL | FHSS_HOP_SYNC | FHSS_HOP_RADIO1_DUAL | FHSS_HOP_RADIO2_DUAL, plan.getFlags(0));
+}
+
+void test_plan_dual_band(void)
+{
+    plan.build(bands, patternLow, 1, FHSS_RADIO2_OTHER_BAND, bandCount(LOW_COUNT));
+    for (uint16_t i = 0; i < plan.getCount(); i++)
+    {
+        TEST_ASSERT_EQUAL(freqOf(bands[0], lowSequence[i]), plan.getFreq(0, i));
+        TEST_ASSERT_EQUAL(freqOf(bands[1], highSequence[i]), plan.getFreq(1, i));
+        TEST_ASSERT_EQUAL(FHSS_BAND_PRIMARY, plan.getBand(0, i));
+        TEST_ASSERT_EQUAL(FHSS_BAND_DUAL, plan.getBand(1, i));
+        TEST_ASSERT_EQUAL(FHSS_HOP_USES_PRIMARY | FHSS_HOP_USES_DUAL, plan.getFlags(i) & (FHSS_HOP_USES_PRIMARY | FHSS_HOP_USES_DUAL));
+        TEST_ASSERT_FALSE(plan.getFlags(i) & FHSS_HOP_BAND_CHANGE);
+    }
+    // Both start on their sync channel
+    TEST_ASSERT_EQUAL(freqOf(bands[1], HIGH_COUNT / 2 + 1), plan.getFreq(1, 0));
+}
+
+void test_plan_interleaved(void)
+{
+    // One radio alternating between the bands, each band still gets its whole sequence
+    plan.build(bands, patternInterleaved, 2, FHSS_RADIO2_GEMINI, 2 * LOW_COUNT * 3);
+    std::set<uint32_t> lowFreqs;
+    std::set<uint32_t> highFreqs;
+    uint16_t lowHops = 0;
+    for (uint16_t i = 0; i < plan.getCount(); i++)
+    {
+        uint8_t const flags = plan.getFlags(i);
+        TEST_ASSERT_TRUE(flags & FHSS_HOP_BAND_CHANGE);
+        if (i % 2 == 0)
+        {
+            TEST_ASSERT_EQUAL(FHSS_BAND_PRIMARY, plan.getBand(0, i));
+            TEST_ASSERT_EQUAL(freqOf(bands[0], lowSequence[lowHops]), plan.getFreq(0, i));
+            // No repeats within a block of the sequence
+            if (lowHops % LOW_COUNT == 0)
+                lowFreqs.clear();
+            TEST_ASSERT_TRUE(lowFreqs.insert(plan.getFreq(0, i)).second);
+            ++lowHops;
+        }
+        else
+        {
+            TEST_ASSERT_EQUAL(FHSS_BAND_DUAL, plan.getBand(0, i));
+            highFreqs.insert(plan.getFreq(0, i));
+        }
+    }
+    TEST_ASSERT_EQUAL(LOW_COUNT, lowFreqs.size());
+    TEST_ASSERT_EQUAL(HIGH_COUNT, highFreqs.size());
+
+    // With two radios the other band is on the other radio, and both change every hop
+    plan.build(bands, patternInterleaved, 2, FHSS_RADIO2_OTHER_BAND, bandCount(LOW_COUNT));
+    for (uint16_t i = 0; i < plan.getCount(); i++)
+    {
+        TEST_ASSERT_NOT_EQUAL(plan.getBand(0, i), plan.getBand(1, i));
+        TEST_ASSERT_TRUE(plan.getFlags(i) & FHSS_HOP_BAND_CHANGE);
+        uint32_t const low = plan.getBand(0, i) == FHSS_BAND_PRIMARY ? plan.getFreq(0, i) : plan.getFreq(1, i);
+        TEST_ASSERT_EQUAL(freqOf(bands[0], lowSequence[i]), low);
+    }
+}
+
+typedef struct {
+    const char *name;
+    bool lowJammed;         // the whole sub-GHz band, e.g. another 900MHz system close by
+    bool highJammed;        // the whole 2.4GHz band, e.g. a 2.4GHz video transmitter close by
+    uint32_t wifiFrom;      // part of the 2.4GHz band taken by WiFi
+    uint32_t wifiTo;
+} interference_t;
+
+static bool clear(const interference_t &noise, uint32_t freq)
+{
+    if (freq < HIGH_START)
+        return !noise.lowJammed;
+    return !noise.highJammed && (freq < noise.wifiFrom || freq > noise.wifiTo);
+}
+
+// Fraction of packets through, and the most in a row lost
+static void simulate(const interference_t &noise, bool radio2, uint32_t &delivered, uint32_t &longestOutage)
+{
+    delivered = 0;
+    longestOutage = 0;
+    uint32_t outage = 0;
+    for (uint32_t hop = 0; hop < SIM_HOPS; hop++)
+    {
+        uint16_t const i = hop % plan.getCount();
+        bool const ok = clear(noise, plan.getFreq(0, i)) || (radio2 && clear(noise, plan.getFreq(1, i)));
+        delivered += ok;
+        outage = ok ? 0 : outage + 1;
+        longestOutage = outage > longestOutage ? outage : longestOutage;
+    }
+}
+
+void test_availability(void)
+{
+    static const interference_t noises[] = {
+        {"sub-GHz jammed", true, false, 0, 0},
+        {"2.4GHz jammed", false, true, 0, 0},
+        {"WiFi ch1-6", false, false, 2401000000U, 2448000000U},
+    };
+
+    for (const interference_t &noise : noises)
+    {
+        uint32_t inter, interOut, dual, dualOut;
+        plan.build(bands, patternInterleaved, 2, FHSS_RADIO2_GEMINI, 2 * LOW_COUNT * 3);
+        simulate(noise, false, inter, interOut);
+        plan.build(bands, patternLow, 1, FHSS_RADIO2_OTHER_BAND, bandCount(LOW_COUNT));
+        simulate(noise, true, dual, dualOut);
+
+        // A single radio alternating bands is never out for more than a packet with either
+        // band gone, and two radios on both bands never lose one
+        TEST_ASSERT_TRUE(inter >= SIM_HOPS / 2);
+        TEST_ASSERT_TRUE(interOut <= 1);
+        TEST_ASSERT_EQUAL(SIM_HOPS, dual);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_plan_single_band);
+    RUN_TEST(test_plan_dual_band);
+    RUN_TEST(test_plan_interleaved);
+    RUN_TEST(test_availability);
+    UNITY_END();
+
+    return 0;
+}
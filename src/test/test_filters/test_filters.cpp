@@ -0,0 +1,177 @@
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <unity.h>
+#include "median.h"
+#include "ema.h"
+#include "biquad.h"
+
+// Reference: sort a copy of the window
+template <typename T, size_t N>
+static T refMedian(const T (&window)[N])
+{
+    T sorted[N];
+    std::copy(window, window + N, sorted);
+    std::sort(sorted, sorted + N);
+    if (N % 2)
+        return sorted[N / 2];
+    return (sorted[N / 2 - 1] + sorted[N / 2]) / 2;
+}
+
+template <typename T, size_t N>
+static T refTrimmedSum(const T (&window)[N], size_t trim)
+{
+    T sorted[N];
+    std::copy(window, window + N, sorted);
+    std::sort(sorted, sorted + N);
+    T sum = 0;
+    for (size_t i = trim; i < N - trim; ++i)
+        sum += sorted[i];
+    return sum;
+}
+
+template <typename T, size_t N>
+static void checkAgainstReference(T range, T offset)
+{
+    MedianFilter<T, N> median;
+    TrimmedMeanFilter<T, N, N / 4> trimmed;
+    T window[N] = {};
+    unsigned idx = 0;
+    srand(N);
+    for (int i = 0; i < 2000; ++i)
+    {
+        // Plenty of repeated values to exercise the equal element paths
+        T val = (T)(rand() % range) + offset;
+        window[idx] = val;
+        idx = (idx + 1) % N;
+        median.add(val);
+        trimmed.add(val);
+        TEST_ASSERT_EQUAL(refMedian(window), median.calc());
+        TEST_ASSERT_EQUAL(refTrimmedSum(window, N / 4), trimmed.calc_scaled());
+        TEST_ASSERT_EQUAL(*std::min_element(window, window + N), median.lowest());
+        TEST_ASSERT_EQUAL(*std::max_element(window, window + N), median.highest());
+    }
+}
+
+void test_median_matches_reference(void)
+{
+    checkAgainstReference<uint16_t, 3>(20, 0);
+    checkAgainstReference<uint16_t, 5>(4096, 0);
+    checkAgainstReference<int32_t, 8>(50, -25);
+    checkAgainstReference<int32_t, 32>(100000, -50000);
+    checkAgainstReference<uint8_t, 9>(3, 20);
+}
+
+void test_median_avg_drops_extremes(void)
+{
+    // The sum less the lowest and highest, including the zero filled start
+    MedianAvgFilter<uint16_t, 5> filter;
+    uint16_t window[5] = {};
+    srand(1);
+    for (int i = 0; i < 500; ++i)
+    {
+        uint16_t val = 1800 + rand() % 400;
+        window[i % 5] = val;
+        unsigned idx = filter.add(val);
+        TEST_ASSERT_EQUAL((i + 1) % 5, idx);
+        TEST_ASSERT_EQUAL(refTrimmedSum(window, 1), filter.calc_scaled());
+        TEST_ASSERT_EQUAL(refTrimmedSum(window, 1) / 3, filter.calc());
+    }
+    TEST_ASSERT_EQUAL(3, filter.scale());
+
+    filter.clear();
+    TEST_ASSERT_EQUAL(0, filter.calc_scaled());
+    TEST_ASSERT_EQUAL(1, filter.add(100));
+}
+
+void test_median_rejects_spikes(void)
+{
+    MedianFilter<uint8_t, 3> filter;
+    filter.fill(40);
+    TEST_ASSERT_EQUAL(40, filter.calc());
+    filter.add(255); // bad read
+    TEST_ASSERT_EQUAL(40, filter.calc());
+    filter.add(41);
+    TEST_ASSERT_EQUAL(41, filter.calc());
+    filter.add(42);
+    TEST_ASSERT_EQUAL(42, filter.calc());
+}
+
+void test_ema_tracks_small_steps(void)
+{
+    // An integer (y * 3 + x) / 4 would stall up to 3 counts short of the input
+    EmaFilter<2> ema;
+    ema.update(0);
+    for (int i = 0; i < 50; ++i)
+        ema.update(3);
+    TEST_ASSERT_EQUAL(3, ema.value());
+
+    for (int i = 0; i < 50; ++i)
+        ema.update(-7);
+    TEST_ASSERT_EQUAL(-7, ema.value());
+}
+
+void test_ema_step_response(void)
+{
+    EmaFilter<2> ema;
+    TEST_ASSERT_EQUAL(100, ema.update(100)); // first sample initializes
+    TEST_ASSERT_EQUAL(75, ema.update(0));
+    TEST_ASSERT_EQUAL(56, ema.update(0));
+    ema.reset();
+    TEST_ASSERT_EQUAL(-20, ema.update(-20));
+}
+
+static int32_t biquadAmplitude(float freqHz, float sampleHz, float cutoffHz)
+{
+    BiquadFilter<> lpf;
+    lpf.setLowpass(cutoffHz, sampleHz);
+    int32_t peak = 0;
+    for (int i = 0; i < 2000; ++i)
+    {
+        int32_t x = lroundf(1000.0f * sinf(2.0f * (float)M_PI * freqHz * i / sampleHz));
+        int32_t y = lpf.update(x);
+        if (i > 1000)
+            peak = std::max(peak, abs(y));
+    }
+    return peak;
+}
+
+void test_biquad_lowpass(void)
+{
+    // Passband, cutoff (-3dB) and stopband
+    TEST_ASSERT_INT_WITHIN(20, 1000, biquadAmplitude(1.0f, 100.0f, 10.0f));
+    TEST_ASSERT_INT_WITHIN(30, 707, biquadAmplitude(10.0f, 100.0f, 10.0f));
+    TEST_ASSERT_LESS_THAN(50, biquadAmplitude(40.0f, 100.0f, 10.0f));
+}
+
+void test_biquad_settles(void)
+{
+    BiquadFilter<> lpf;
+    lpf.setLowpass(2.0f, 100.0f);
+    TEST_ASSERT_EQUAL(500, lpf.update(500)); // first sample initializes
+    for (int i = 0; i < 500; ++i)
+        lpf.update(503);
+    TEST_ASSERT_EQUAL(503, lpf.value());
+    for (int i = 0; i < 500; ++i)
+        lpf.update(-12345);
+    TEST_ASSERT_EQUAL(-12345, lpf.value());
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_median_matches_reference);
+    RUN_TEST(test_median_avg_drops_extremes);
+    RUN_TEST(test_median_rejects_spikes);
+    RUN_TEST(test_ema_tracks_small_steps);
+    RUN_TEST(test_ema_step_response);
+    RUN_TEST(test_biquad_lowpass);
+    RUN_TEST(test_biquad_settles);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <unity.h>
+#include "gsensor_motion.h"
+
+// devGsensor samples every second
+#define SAMPLE_MS       1000
+
+typedef struct {
+    float x, y, z;
+} accel_t;
+
+static uint32_t seed = 1;
+
+static float gauss(float sigma)
+{
+    // Box-Muller from two LCG uniforms
+    seed = seed * 1103515245 + 12345;
+    float const u1 = ((seed >> 8) + 1) / 16777217.0f;
+    seed = seed * 1103515245 + 12345;
+    float const u2 = (seed >> 8) / 16777216.0f;
+    return sigma * sqrtf(-2 * logf(u1)) * cosf(2 * M_PI * u2);
+}
+
+// A radio sat on a desk, tilted back with the screen up, and the STK8xxx's noise
+static void onDesk(std::vector<accel_t> &trace, uint32_t ms, accel_t g = {0.05f, 0.42f, -0.9f})
+{
+    for (uint32_t t = 0; t < ms; t += SAMPLE_MS)
+        trace.push_back({g.x + gauss(0.003f), g.y + gauss(0.003f), g.z + gauss(0.003f)});
+}
+
+// Held in both hands, sways slowly and shakes a little with the sticks being moved
+static void inHands(std::vector<accel_t> &trace, uint32_t ms)
+{
+    for (uint32_t t = 0; t < ms; t += SAMPLE_MS)
+    {
+        float const sway = 0.08f * sinf(t * 0.0021f);
+        trace.push_back({0.1f + sway + gauss(0.02f), 0.6f + gauss(0.02f), -0.75f + sway / 2 + gauss(0.02f)});
+    }
+}
+
+class TraceGsensor : public GsensorMotion
+{
+public:
+    void update(const accel_t &a) { GsensorMotion::update(a.x, a.y, a.z); }
+};
+
+// ms from the start of the trace until the state is first seen, 0 if never
+static uint32_t replayUntil(TraceGsensor &sensor, const std::vector<accel_t> &trace, size_t from, uint32_t sampleMs, int state)
+{
+    for (size_t i = from; i < trace.size(); i++)
+    {
+        sensor.update(trace[i]);
+        if (sensor.getState() == state)
+            return (i - from + 1) * sampleMs;
+    }
+    return 0;
+}
+
+void test_quiet_on_desk(void)
+{
+    seed = 1;
+    std::vector<accel_t> trace;
+    onDesk(trace, 60000);
+
+    TraceGsensor motion;
+    motion.reset();
+    uint32_t const quietMs = replayUntil(motion, trace, 0, SAMPLE_MS, GSENSOR_SYSTEM_STATE_QUIET);
+    TEST_ASSERT_EQUAL(GSENSOR_QUIET_SAMPLES * SAMPLE_MS, quietMs);
+    // And stays there, the noise is no bump
+    for (size_t i = quietMs / SAMPLE_MS; i < trace.size(); i++)
+        motion.update(trace[i]);
+    TEST_ASSERT_EQUAL(GSENSOR_SYSTEM_STATE_QUIET, motion.getState());
+    TEST_ASSERT_EQUAL(0, motion.getBumpCount());
+    TEST_ASSERT_FALSE(motion.isFlipped());
+}
+
+void test_in_hands(void)
+{
+    seed = 2;
+    std::vector<accel_t> trace;
+    onDesk(trace, 30000);
+    inHands(trace, 120000);
+
+    TraceGsensor motion;
+    motion.reset();
+    TEST_ASSERT_NOT_EQUAL(0, replayUntil(motion, trace, 0, SAMPLE_MS, GSENSOR_SYSTEM_STATE_QUIET));
+    // Picked up, it moves once the next sample isn't back on the desk
+    uint32_t const movingMs = replayUntil(motion, trace, 30000 / SAMPLE_MS, SAMPLE_MS, GSENSOR_SYSTEM_STATE_MOVING);
+    TEST_ASSERT_EQUAL((GSENSOR_BUMP_SAMPLES + 1) * SAMPLE_MS, movingMs);
+    // Never quiet while it is being flown
+    TEST_ASSERT_EQUAL(0, replayUntil(motion, trace, 30000 / SAMPLE_MS + GSENSOR_BUMP_SAMPLES + 1, SAMPLE_MS, GSENSOR_SYSTEM_STATE_QUIET));
+    TEST_ASSERT_TRUE(motion.getStillSamples() < GSENSOR_QUIET_SAMPLES);
+}
+
+void test_bump(void)
+{
+    seed = 3;
+    std::vector<accel_t> trace;
+    onDesk(trace, 30000);
+    // Knocked, one sample off
+    trace.push_back({0.05f, 0.7f, -0.6f});
+    onDesk(trace, 3000);
+    // Knocked twice in a row is picked up
+    trace.push_back({0.05f, 0.7f, -0.6f});
+    trace.push_back({0.2f, 0.5f, -0.7f});
+    onDesk(trace, 1000);
+
+    TraceGsensor motion;
+    motion.reset();
+    for (size_t i = 0; i < 30000 / SAMPLE_MS + 1 + 3000 / SAMPLE_MS; i++)
+        motion.update(trace[i]);
+    TEST_ASSERT_EQUAL(GSENSOR_SYSTEM_STATE_QUIET, motion.getState());
+    TEST_ASSERT_EQUAL(1, motion.getBumpCount());
+
+    motion.update(trace[30000 / SAMPLE_MS + 1 + 3000 / SAMPLE_MS]);
+    TEST_ASSERT_EQUAL(GSENSOR_SYSTEM_STATE_QUIET, motion.getState());
+    motion.update(trace[30000 / SAMPLE_MS + 2 + 3000 / SAMPLE_MS]);
+    TEST_ASSERT_EQUAL(GSENSOR_SYSTEM_STATE_MOVING, motion.getState());
+    TEST_ASSERT_EQUAL(1, motion.getBumpCount());
+}
+
+void test_flip(void)
+{
+    seed = 4;
+    std::vector<accel_t> trace;
+    onDesk(trace, 5000);
+    // Turned over slowly and put face down, z goes through 0.2g with the noise on it
+    for (uint32_t t = 0; t <= 4000; t += SAMPLE_MS)
+    {
+        float const angle = M_PI * t / 4000;
+        trace.push_back({0.05f + gauss(0.03f), 0.42f * cosf(angle) + gauss(0.03f), -0.9f * cosf(angle) + gauss(0.03f)});
+    }
+    onDesk(trace, 5000, {0.05f, -0.42f, 0.9f});
+
+    TraceGsensor motion;
+    motion.reset();
+    uint8_t changes = 0;
+    bool flipped = false;
+    for (const accel_t &a : trace)
+    {
+        motion.update(a);
+        changes += motion.isFlipped() != flipped;
+        flipped = motion.isFlipped();
+    }
+    TEST_ASSERT_TRUE(flipped);
+    TEST_ASSERT_EQUAL(1, changes);
+}
+
+void test_reaction(void)
+{
+    seed = 5;
+    // Flown, put down for a minute between packs, picked up again
+    std::vector<accel_t> trace;
+    inHands(trace, 60000);
+    onDesk(trace, 60000);
+    inHands(trace, 30000);
+
+    TraceGsensor motion;
+    motion.reset();
+    uint32_t const quietMs = replayUntil(motion, trace, 0, SAMPLE_MS, GSENSOR_SYSTEM_STATE_QUIET) - 60000;
+    uint32_t const movingMs = replayUntil(motion, trace, 120000 / SAMPLE_MS, SAMPLE_MS, GSENSOR_SYSTEM_STATE_MOVING);
+
+    TEST_ASSERT_TRUE(quietMs <= GSENSOR_QUIET_SAMPLES * SAMPLE_MS);
+    TEST_ASSERT_TRUE(movingMs <= 2 * SAMPLE_MS);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_quiet_on_desk);
+    RUN_TEST(test_in_hands);
+    RUN_TEST(test_bump);
+    RUN_TEST(test_flip);
+    RUN_TEST(test_reaction);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <cstdint>
+#include <vector>
+#include <unity.h>
+#include "HandsetBaud.h"
+
+// AutoDetect's RMT clock and the most runs it looks at in one capture
+#define TICKS_PER_US 10
+#define MAX_RUNS 64
+
+static uint32_t seed = 1;
+
+static uint32_t rnd()
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+// One CRSF RC frame, 8N1 LSB first, as the run lengths the RMT would capture.
+// The handset's clock is off by ppm and every edge is moved by up to jitterNs,
+// then the edges are put on the RMT's ticks
+static std::vector<uint16_t> crsfCapture(uint32_t baud, int32_t ppm, uint32_t jitterNs)
+{
+    std::vector<uint8_t> bits;
+    for (uint8_t b = 0; b < 26; b++)
+    {
+        uint8_t const byte = b == 0 ? 0xEE : b == 1 ? 24 : b == 2 ? 0x16 : rnd();
+        bits.push_back(0);
+        for (uint8_t i = 0; i < 8; i++)
+            bits.push_back((byte >> i) & 1);
+        bits.push_back(1);
+    }
+
+    double const bitNs = 1e9 / (baud * (1.0 + ppm / 1e6));
+    std::vector<uint16_t> runs;
+    uint32_t lastEdge = 0;
+    for (size_t i = 1; i < bits.size(); i++)
+    {
+        if (bits[i] == bits[i - 1])
+            continue;
+        double const jitter = jitterNs ? (int32_t)(rnd() % (2 * jitterNs + 1)) - (int32_t)jitterNs : 0;
+        uint32_t const edge = (uint32_t)((i * bitNs + jitter) * TICKS_PER_US / 1000);
+        if (edge > lastEdge)
+        {
+            runs.push_back(edge - lastEdge);
+            lastEdge = edge;
+        }
+    }
+    // The last stop bit runs into the idle line and ends the capture
+    if (runs.size() > MAX_RUNS)
+        runs.resize(MAX_RUNS);
+    return runs;
+}
+
+void test_nearest(void)
+{
+    TEST_ASSERT_EQUAL(400000, handsetBaudNearest(416666));
+    TEST_ASSERT_EQUAL(115200, handsetBaudNearest(100000));
+    TEST_ASSERT_EQUAL(5250000, handsetBaudNearest(6000000));
+    TEST_ASSERT_EQUAL(1870000, handsetBaudNearest(1900000));
+    TEST_ASSERT_EQUAL(2250000, handsetBaudNearest(2200000));
+
+    TEST_ASSERT_TRUE(handsetBaudSupported(5250000));
+    TEST_ASSERT_TRUE(handsetBaudSupported(921600));
+    TEST_ASSERT_FALSE(handsetBaudSupported(1000000));
+    TEST_ASSERT_FALSE(handsetBaudSupported(0));
+}
+
+void test_detect_one_frame(void)
+{
+    static const int32_t ppms[] = {-10000, 0, 10000};
+    for (int32_t baud : TxToHandsetBauds)
+    {
+        for (int32_t ppm : ppms)
+        {
+            uint16_t wrong = 0;
+            for (uint16_t i = 0; i < 200; i++)
+            {
+                std::vector<uint16_t> const runs = crsfCapture(baud, ppm, 30);
+                wrong += handsetBaudDetect(runs.data(), runs.size(), TICKS_PER_US) != (uint32_t)baud;
+            }
+            // A bit at 5250000 is under two ticks, the rest are all right
+            TEST_ASSERT_TRUE(wrong <= (baud >= 3750000 ? 200 / 20 : 0));
+        }
+    }
+}
+
+void test_vote(void)
+{
+    static const int32_t ppms[] = {-10000, 0, 10000};
+    for (int32_t baud : TxToHandsetBauds)
+    {
+        for (int32_t ppm : ppms)
+        {
+            HandsetBaudVote vote;
+            vote.reset();
+            uint16_t agreedAt = 0;
+            for (uint16_t i = 1; i <= 200; i++)
+            {
+                std::vector<uint16_t> const runs = crsfCapture(baud, ppm, 30);
+                uint32_t const agreed = vote.update(handsetBaudDetect(runs.data(), runs.size(), TICKS_PER_US));
+                // Never a wrong one, even with the odd capture wrong
+                TEST_ASSERT_TRUE(agreed == 0 || agreed == (uint32_t)baud);
+                if (agreed && !agreedAt)
+                    agreedAt = i;
+            }
+            TEST_ASSERT_TRUE(agreedAt >= HANDSET_BAUD_AGREE && agreedAt <= 4);
+        }
+    }
+
+    HandsetBaudVote vote;
+    vote.reset();
+    TEST_ASSERT_EQUAL(0, vote.update(400000));
+    TEST_ASSERT_EQUAL(0, vote.update(0));
+    TEST_ASSERT_EQUAL(400000, vote.update(400000));
+    // One odd one doesn't change it, two do
+    TEST_ASSERT_EQUAL(400000, vote.update(1870000));
+    TEST_ASSERT_EQUAL(400000, vote.update(400000));
+    TEST_ASSERT_EQUAL(400000, vote.update(1870000));
+    TEST_ASSERT_EQUAL(1870000, vote.update(1870000));
+}
+
+void test_detect_not_serial(void)
+{
+    // Too few runs
+    const uint16_t short_capture[] = {19, 38, 19, 57};
+    TEST_ASSERT_EQUAL(0, handsetBaudDetect(short_capture, 4, TICKS_PER_US));
+    // PPM channels, nothing like bits
+    const uint16_t ppm[] = {4000, 6000, 4000, 8000, 4000, 11000, 4000, 7000, 4000, 9000};
+    TEST_ASSERT_EQUAL(0, handsetBaudDetect(ppm, 10, TICKS_PER_US));
+    // Runs which are not multiples of any bit width
+    const uint16_t noise[] = {40, 67, 101, 53, 140, 71, 95, 126, 48, 111, 83, 59};
+    TEST_ASSERT_EQUAL(0, handsetBaudDetect(noise, 12, TICKS_PER_US));
+}
+
+void test_time_to_first_frame(void)
+{
+    static const uint32_t intervals[] = {4000, 2000, 1000};
+    uint32_t worstDetect = 0;
+    for (uint32_t baud : TxToHandsetBauds)
+    {
+        for (uint32_t interval : intervals)
+        {
+            // 115200 can't keep up with 1kHz
+            if (baud == 115200 && interval < 4000)
+                continue;
+
+            // The detector gets a capture every frame, the next frame after they agree is received
+            HandsetBaudVote vote;
+            vote.reset();
+            uint32_t detectUs = 0;
+            for (uint8_t frame = 1; frame < 20; frame++)
+            {
+                std::vector<uint16_t> const runs = crsfCapture(baud, 10000, 30);
+                if (vote.update(handsetBaudDetect(runs.data(), runs.size(), TICKS_PER_US)) == (uint32_t)baud)
+                {
+                    detectUs = (frame + 1) * interval;
+                    break;
+                }
+            }
+            TEST_ASSERT_NOT_EQUAL(0, detectUs);
+            worstDetect = detectUs / 1000 > worstDetect ? detectUs / 1000 : worstDetect;
+        }
+    }
+    // Five frames at the slowest rate
+    TEST_ASSERT_TRUE(worstDetect <= 5 * 4);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_nearest);
+    RUN_TEST(test_detect_one_frame);
+    RUN_TEST(test_vote);
+    RUN_TEST(test_detect_not_serial);
+    RUN_TEST(test_time_to_first_frame);
+    UNITY_END();
+
+    return 0;
+}
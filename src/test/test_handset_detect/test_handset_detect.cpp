@@ -0,0 +1,248 @@
+#include <cstdint>
+#include <vector>
+#include <unity.h>
+#include "HandsetDetect.h"
+
+// AutoDetect's RMT clock
+#define TICKS_PER_US 10
+// AutoDetect's idle thresholds, while detecting and while decoding PPM
+#define DETECT_IDLE_US 100
+#define PPM_IDLE_US 4000
+
+typedef std::vector<uint16_t> capture_t;
+
+struct trace_t {
+    std::vector<capture_t> captures;
+    std::vector<uint32_t> endMs; // when each capture would come out of the ringbuffer
+};
+
+// Cut a level trace, given as the run lengths in ticks, into captures the way the RMT does:
+// a capture starts at an edge and ends when the line has been still for the idle threshold
+static void capture(trace_t &trace, const std::vector<uint32_t> &runs, uint32_t idleUs, double &nowUs)
+{
+    capture_t current;
+    bool capturing = false;
+    for (uint32_t run : runs)
+    {
+        nowUs += run / (double)TICKS_PER_US;
+        if (run >= idleUs * TICKS_PER_US)
+        {
+            if (capturing)
+            {
+                // The run that hit the threshold is the 0 duration end marker, not a run
+                trace.captures.push_back(current);
+                trace.endMs.push_back((uint32_t)(nowUs / 1000));
+                current.clear();
+            }
+            // The edge at the end of it starts the next capture
+            capturing = true;
+            continue;
+        }
+        if (capturing)
+            current.push_back(run);
+    }
+}
+
+// PPM: a 400us pulse then the rest of each channel, then the sync gap, 22.5ms frames
+static void ppmFrames(trace_t &trace, uint8_t channels, uint16_t frames, uint32_t idleUs, double &nowUs, uint32_t seed = 1)
+{
+    std::vector<uint32_t> runs;
+    for (uint16_t f = 0; f < frames; f++)
+    {
+        uint32_t used = 0;
+        for (uint8_t ch = 0; ch < channels; ch++)
+        {
+            seed = seed * 1103515245 + 12345;
+            uint32_t const us = 1000 + (seed >> 16) % 1001;
+            runs.push_back(400 * TICKS_PER_US);
+            runs.push_back((us - 400) * TICKS_PER_US);
+            used += us;
+        }
+        runs.push_back(400 * TICKS_PER_US);
+        runs.push_back((22500 - used - 400) * TICKS_PER_US);
+    }
+    capture(trace, runs, idleUs, nowUs);
+}
+
+// CRSF RC frames, 8N1 LSB first, idle high between frames
+static void crsfFrames(trace_t &trace, uint32_t baud, uint32_t intervalUs, uint16_t frames, uint32_t idleUs, double &nowUs, uint32_t seed = 1)
+{
+    std::vector<uint32_t> runs;
+    double const bitTicks = 1e6 * TICKS_PER_US / baud;
+    for (uint16_t f = 0; f < frames; f++)
+    {
+        std::vector<uint8_t> bits;
+        for (uint8_t b = 0; b < 26; b++)
+        {
+            seed = seed * 1103515245 + 12345;
+            uint8_t const byte = b == 0 ? 0xEE : b == 1 ? 24 : b == 2 ? 0x16 : (seed >> 16);
+            bits.push_back(0);
+            for (uint8_t i = 0; i < 8; i++)
+                bits.push_back((byte >> i) & 1);
+            bits.push_back(1);
+        }
+        // Runs of the same level, then idle high until the next frame
+        uint8_t level = bits[0];
+        uint32_t len = 0;
+        double used = 0;
+        for (uint8_t bit : bits)
+        {
+            if (bit != level)
+            {
+                runs.push_back((uint32_t)(len * bitTicks + 0.5));
+                used += len * bitTicks;
+                level = bit;
+                len = 0;
+            }
+            ++len;
+        }
+        // The trailing high runs on into the idle line
+        runs.push_back((uint32_t)(intervalUs * TICKS_PER_US - used));
+    }
+    // The trace is cut at an edge, start with the idle line
+    runs.insert(runs.begin(), intervalUs * TICKS_PER_US);
+    capture(trace, runs, idleUs, nowUs);
+}
+
+// Feed a trace to a detector, returning when it decided on the signal
+static uint32_t detect(HandsetDetector &detector, const trace_t &trace, handset_signal_e expected)
+{
+    for (size_t i = 0; i < trace.captures.size(); i++)
+    {
+        const capture_t &c = trace.captures[i];
+        handset_capture_e const cls = handsetClassifyCapture(c.data(), c.size(), TICKS_PER_US);
+        if (detector.update(cls, trace.endMs[i]) == expected)
+            return trace.endMs[i];
+    }
+    return UINT32_MAX;
+}
+
+void test_classify(void)
+{
+    double now = 0;
+    trace_t edges;
+    ppmFrames(edges, 8, 1, DETECT_IDLE_US, now);
+    TEST_ASSERT_EQUAL(17, edges.captures.size());
+    for (const capture_t &c : edges.captures)
+        TEST_ASSERT_EQUAL(HANDSET_CAPTURE_EDGE, handsetClassifyCapture(c.data(), c.size(), TICKS_PER_US));
+
+    trace_t frames;
+    ppmFrames(frames, 8, 3, PPM_IDLE_US, now);
+    // The first frame starts mid-sync
+    TEST_ASSERT_EQUAL(2, frames.captures.size());
+    for (const capture_t &c : frames.captures)
+        TEST_ASSERT_EQUAL(HANDSET_CAPTURE_PPM_FRAME, handsetClassifyCapture(c.data(), c.size(), TICKS_PER_US));
+
+    static const uint32_t bauds[] = {115200, 400000, 921600, 1870000, 5250000};
+    for (uint32_t baud : bauds)
+    {
+        trace_t serial;
+        crsfFrames(serial, baud, 4000, 4, DETECT_IDLE_US, now);
+        TEST_ASSERT_EQUAL(4, serial.captures.size());
+        for (const capture_t &c : serial.captures)
+            TEST_ASSERT_EQUAL(HANDSET_CAPTURE_SERIAL, handsetClassifyCapture(c.data(), c.size(), TICKS_PER_US));
+    }
+
+    // Not enough channels to be PPM
+    const uint16_t short_frame[] = {4000, 6000, 4000, 8000, 4000};
+    TEST_ASSERT_EQUAL(HANDSET_CAPTURE_UNKNOWN, handsetClassifyCapture(short_frame, 5, TICKS_PER_US));
+}
+
+void test_detect_time(void)
+{
+    HandsetDetector detector;
+
+    detector.reset();
+    double now = 0;
+    trace_t ppm;
+    ppmFrames(ppm, 8, 10, DETECT_IDLE_US, now);
+    uint32_t const ppmAt = detect(detector, ppm, HANDSET_SIGNAL_PPM);
+    TEST_ASSERT_NOT_EQUAL(UINT32_MAX, ppmAt);
+    // Within two frames
+    TEST_ASSERT_TRUE(detector.getDetectMs() <= 2 * 22500 / 1000);
+
+    static const uint32_t bauds[] = {115200, 400000, 1870000, 5250000};
+    static const uint32_t intervals[] = {4000, 2000, 1000};
+    for (uint32_t baud : bauds)
+    {
+        for (uint32_t interval : intervals)
+        {
+            // 115200 can't keep up with 1kHz
+            if (baud == 115200 && interval < 4000)
+                continue;
+            detector.reset();
+            now = 0;
+            trace_t serial;
+            crsfFrames(serial, baud, interval, 20, DETECT_IDLE_US, now);
+            TEST_ASSERT_NOT_EQUAL(UINT32_MAX, detect(detector, serial, HANDSET_SIGNAL_SERIAL));
+            // Within five frames
+            TEST_ASSERT_TRUE(detector.getDetectMs() <= 5 * interval / 1000);
+        }
+    }
+}
+
+void test_switch_live(void)
+{
+    HandsetDetector detector;
+    detector.reset();
+    double now = 0;
+
+    trace_t trace;
+    crsfFrames(trace, 400000, 4000, 20, DETECT_IDLE_US, now);
+    TEST_ASSERT_NOT_EQUAL(UINT32_MAX, detect(detector, trace, HANDSET_SIGNAL_SERIAL));
+
+    // Plugged into a PPM radio without the signal going away for long
+    trace = trace_t();
+    ppmFrames(trace, 8, 10, DETECT_IDLE_US, now);
+    TEST_ASSERT_NOT_EQUAL(UINT32_MAX, detect(detector, trace, HANDSET_SIGNAL_PPM));
+    TEST_ASSERT_TRUE(detector.getDetectMs() <= 3 * 22500 / 1000);
+
+    // While decoding PPM the idle threshold is long, and frames keep it there
+    trace = trace_t();
+    ppmFrames(trace, 8, 10, PPM_IDLE_US, now, 7);
+    for (size_t i = 0; i < trace.captures.size(); i++)
+    {
+        const capture_t &c = trace.captures[i];
+        TEST_ASSERT_EQUAL(HANDSET_SIGNAL_PPM, detector.update(handsetClassifyCapture(c.data(), c.size(), TICKS_PER_US), trace.endMs[i]));
+    }
+
+    // And back, serial through the long idle threshold at 1kHz never ends a capture
+    uint32_t const lastPpm = trace.endMs.back();
+    TEST_ASSERT_EQUAL(HANDSET_SIGNAL_PPM, detector.update(HANDSET_CAPTURE_NONE, lastPpm + HANDSET_DETECT_LOST_MS));
+    TEST_ASSERT_EQUAL(HANDSET_SIGNAL_NONE, detector.update(HANDSET_CAPTURE_NONE, lastPpm + HANDSET_DETECT_LOST_MS + 1));
+    trace = trace_t();
+    now = (lastPpm + HANDSET_DETECT_LOST_MS + 1) * 1000.0;
+    crsfFrames(trace, 1870000, 1000, 20, DETECT_IDLE_US, now);
+    TEST_ASSERT_NOT_EQUAL(UINT32_MAX, detect(detector, trace, HANDSET_SIGNAL_SERIAL));
+}
+
+void test_noise(void)
+{
+    HandsetDetector detector;
+    detector.reset();
+    // A mix which doesn't favour either side never decides
+    uint32_t now = 0;
+    for (uint16_t i = 0; i < 1000; i++)
+    {
+        now += 5;
+        uint8_t const phase = i % 8;
+        handset_capture_e const cls = phase == 0 ? HANDSET_CAPTURE_SERIAL : phase == 7 ? HANDSET_CAPTURE_UNKNOWN : HANDSET_CAPTURE_EDGE;
+        TEST_ASSERT_EQUAL(HANDSET_SIGNAL_NONE, detector.update(cls, now));
+    }
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_classify);
+    RUN_TEST(test_detect_time);
+    RUN_TEST(test_switch_live);
+    RUN_TEST(test_noise);
+    UNITY_END();
+
+    return 0;
+}
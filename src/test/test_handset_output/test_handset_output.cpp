@@ -0,0 +1,227 @@
+#include <cstdint>
+#include <deque>
+#include <unity.h>
+#include "HandsetOutputScheduler.h"
+
+#define RC_FRAME_BYTES 26
+#define TELEMETRY_FIFO_SIZE 128 // HANDSET_TELEMETRY_FIFO_SIZE
+#define LUA_CHUNK_QUERY_SIZE 26
+
+struct frame_t {
+    uint8_t bytes;
+    uint32_t queued; // period it was queued in
+};
+
+struct result_t {
+    uint32_t bytesPerSec; // complete frames delivered
+    double latency;       // periods from queued to the last byte being written
+    uint32_t splits;
+    uint16_t maxWritten;  // most written after one RC frame
+};
+
+// The Lua chunk size from CRSFHandset::adjustMaxPacketSize
+static int luaChunkBytes(uint32_t baud, int32_t intervalUs)
+{
+    int maxPeriodBytes = (int)(baud / 10 / (1000000 / intervalUs) * 87 / 100);
+    if (maxPeriodBytes > TELEMETRY_FIFO_SIZE)
+        maxPeriodBytes = TELEMETRY_FIFO_SIZE;
+    int const half = maxPeriodBytes / 2 > LUA_CHUNK_QUERY_SIZE ? maxPeriodBytes / 2 : LUA_CHUNK_QUERY_SIZE;
+    int const maxPacketBytes = maxPeriodBytes - half < 64 ? maxPeriodBytes - half : 64;
+    return maxPacketBytes < 10 ? 10 : maxPacketBytes;
+}
+
+#define OUT_FIFO_SIZE 256 // CRSF_SERIAL_OUT_FIFO_SIZE, each frame has a length byte
+
+static uint16_t queuedBytes(const std::deque<frame_t> &queue)
+{
+    uint16_t bytes = 0;
+    for (const frame_t &f : queue)
+        bytes += f.bytes + 1;
+    return bytes;
+}
+
+// Like FIFO::ensure, the oldest frames make way
+static void push(std::deque<frame_t> &queue, uint8_t bytes, uint32_t period)
+{
+    while (queuedBytes(queue) + bytes + 1 > OUT_FIFO_SIZE)
+        queue.pop_front();
+    queue.push_back({bytes, period});
+}
+
+// The telemetry a busy link sends to EdgeTX: link stats, battery, GPS, attitude and an MSP
+// response now and then, while the Lua script loads parameters as fast as they go out
+static void queueTelemetry(std::deque<frame_t> &queue, uint32_t period, uint32_t periodsPerSec, int maxPacketBytes)
+{
+    uint32_t const every = periodsPerSec / 50; // 50 frames/s of each
+    if (period % every == 0)
+        push(queue, 14, period);  // link statistics
+    if (period % every == 1)
+        push(queue, 12, period);  // battery
+    if (period % every == 2)
+        push(queue, 19, period);  // GPS
+    if (period % every == 3)
+        push(queue, 10, period);  // attitude
+    if (period % (periodsPerSec / 10) == 5)
+        push(queue, 64, period);  // MSP
+    // Lua chunks whenever there is room for one
+    while (queuedBytes(queue) + maxPacketBytes + 1 <= OUT_FIFO_SIZE)
+        queue.push_back({(uint8_t)maxPacketBytes, period});
+}
+
+static result_t run(uint32_t baud, int32_t intervalUs)
+{
+    int const maxPacketBytes = luaChunkBytes(baud, intervalUs);
+
+    HandsetOutputScheduler scheduler;
+    scheduler.configure(baud, intervalUs, TELEMETRY_FIFO_SIZE);
+    scheduler.setHalfDuplex(true);
+
+    std::deque<frame_t> queue;
+    uint32_t const periodsPerSec = 1000000 / intervalUs;
+    uint32_t const periods = periodsPerSec * 10;
+    uint16_t remaining = 0;
+    frame_t current = {};
+    result_t r = {};
+    uint64_t latencySum = 0, delivered = 0, bytes = 0;
+    for (uint32_t p = 0; p < periods; p++)
+    {
+        queueTelemetry(queue, p, periodsPerSec, maxPacketBytes);
+
+        uint16_t written = 0;
+        scheduler.startWindow(RC_FRAME_BYTES);
+        for (;;)
+        {
+            bool const continuing = remaining != 0;
+            if (!continuing)
+            {
+                if (queue.empty())
+                    break;
+                current = queue.front();
+                remaining = current.bytes;
+            }
+            uint16_t const n = scheduler.take(remaining, continuing);
+            if (n == 0)
+            {
+                // The rest of a split frame stays for the next window, a whole one stays queued
+                if (!continuing)
+                    remaining = 0;
+                break;
+            }
+            if (!continuing)
+                queue.pop_front();
+            written += n;
+            remaining -= n;
+            if (remaining == 0)
+            {
+                latencySum += p - current.queued;
+                ++delivered;
+                bytes += current.bytes;
+            }
+        }
+        if (written > r.maxWritten)
+            r.maxWritten = written;
+    }
+    r.bytesPerSec = bytes / 10;
+    r.latency = delivered ? latencySum / (double)delivered : 0;
+    r.splits = scheduler.getSplitCount();
+    return r;
+}
+
+void test_window(void)
+{
+    HandsetOutputScheduler scheduler;
+    scheduler.configure(1870000, 1000, TELEMETRY_FIFO_SIZE);
+    scheduler.setHalfDuplex(true);
+    // 870us less 139us for the RC frame at 187 bytes/ms is 136, more than the handset's FIFO
+    TEST_ASSERT_EQUAL(128, scheduler.windowBytes(26));
+    scheduler.configure(921600, 1000, TELEMETRY_FIFO_SIZE);
+    TEST_ASSERT_EQUAL(54, scheduler.windowBytes(26));
+    scheduler.configure(400000, 1000, TELEMETRY_FIFO_SIZE);
+    TEST_ASSERT_EQUAL(10, scheduler.windowBytes(26));
+    scheduler.configure(400000, 4000, TELEMETRY_FIFO_SIZE);
+    TEST_ASSERT_EQUAL(113, scheduler.windowBytes(26));
+    // Full duplex always has the whole FIFO
+    scheduler.setHalfDuplex(false);
+    TEST_ASSERT_EQUAL(128, scheduler.windowBytes(26));
+}
+
+void test_half_duplex_after_configure(void)
+{
+    // The packet interval is set before the port is started and knows it is half duplex
+    HandsetOutputScheduler scheduler;
+    scheduler.configure(400000, 1000, TELEMETRY_FIFO_SIZE);
+    TEST_ASSERT_EQUAL(128, scheduler.windowBytes(26));
+    scheduler.setHalfDuplex(true);
+    scheduler.startWindow(26);
+    TEST_ASSERT_EQUAL(10, scheduler.take(64, true));
+
+    // and stays half duplex through later baud and rate changes
+    scheduler.configure(400000, 4000, TELEMETRY_FIFO_SIZE);
+    TEST_ASSERT_EQUAL(113, scheduler.windowBytes(26));
+}
+
+void test_take(void)
+{
+    HandsetOutputScheduler scheduler;
+    scheduler.configure(400000, 4000, TELEMETRY_FIFO_SIZE);
+    scheduler.setHalfDuplex(true);
+    scheduler.startWindow(26);  // 113 bytes
+    TEST_ASSERT_EQUAL(64, scheduler.take(64, false));
+    TEST_ASSERT_EQUAL(40, scheduler.take(40, false));
+    // Doesn't fit the 9 left, wait for the next window
+    TEST_ASSERT_EQUAL(0, scheduler.take(14, false));
+    TEST_ASSERT_EQUAL(0, scheduler.getSplitCount());
+
+    scheduler.configure(400000, 1000, TELEMETRY_FIFO_SIZE);
+    scheduler.startWindow(26);  // 10 bytes
+    // Bigger than any window, split from the start of one
+    TEST_ASSERT_EQUAL(10, scheduler.take(14, false));
+    TEST_ASSERT_EQUAL(1, scheduler.getSplitCount());
+    scheduler.startWindow(26);
+    TEST_ASSERT_EQUAL(4, scheduler.take(4, true));
+    TEST_ASSERT_EQUAL(70, scheduler.getWindowUse());
+}
+
+void test_throughput(void)
+{
+    static const uint32_t bauds[] = {400000, 921600, 1870000, 5250000};
+    static const int32_t intervals[] = {4000, 2000, 1000};
+    for (uint32_t baud : bauds)
+    {
+        for (int32_t interval : intervals)
+        {
+            // CRSFHandset::getMinPacketInterval
+            if (baud == 400000 && interval < 2000)
+                continue;
+            HandsetOutputScheduler scheduler;
+            scheduler.configure(baud, interval, TELEMETRY_FIFO_SIZE);
+            scheduler.setHalfDuplex(true);
+            uint16_t const window = scheduler.windowBytes(RC_FRAME_BYTES);
+            result_t const r = run(baud, interval);
+            // Never writes past the window, which would run into the next RC frame
+            TEST_ASSERT_TRUE(r.maxWritten <= window);
+            // Whole frames leave some of the window empty, but not much
+            TEST_ASSERT_TRUE(r.bytesPerSec * 100 >= window * (1000000 / interval) * 60);
+            // Only the 64 byte MSP frames are split, when they are larger than the window
+            if (window >= 64)
+                TEST_ASSERT_EQUAL(0, r.splits);
+            TEST_ASSERT_TRUE(r.latency < 6);
+        }
+    }
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_window);
+    RUN_TEST(test_half_duplex_after_configure);
+    RUN_TEST(test_take);
+    RUN_TEST(test_throughput);
+    UNITY_END();
+
+    return 0;
+}
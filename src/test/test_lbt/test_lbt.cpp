@@ -0,0 +1,119 @@
+#include <cstdint>
+#include <unity.h>
+#include "LBTChannelStats.h"
+
+// RSSI settling time from RX start, from SpreadingFactorToRSSIvalidDelayUs()
+typedef struct {
+    const char *name;
+    uint32_t dwellUs;
+} lbt_mode_t;
+
+static const lbt_mode_t modes[] = {
+    {"SF5", 100},
+    {"SF6", 141},
+    {"SF7", 218},
+    {"SF8", 480},
+    {"FLRC", 80},
+};
+
+#define RSSI_READ_US    10  // GetRssiInst over SPI
+
+#define CHANNELS        80
+#define BUSY_CHANNELS   10  // a WiFi network over part of the band
+
+static LBTChannelStats stats;
+static uint32_t seed = 1;
+
+static uint32_t rnd()
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+void test_skip_busy(void)
+{
+    stats.reset();
+
+    // Busy now and then is never skipped
+    for (uint16_t i = 0; i < 200; i++)
+    {
+        TEST_ASSERT_TRUE(stats.shouldAssess(1));
+        stats.update(1, i % 4 != 0);
+    }
+    TEST_ASSERT_TRUE(stats.getBusyScore(1) < LBT_BUSY_SKIP);
+
+    // Busy every time is, after a couple of dozen visits
+    uint16_t visits = 0;
+    while (stats.shouldAssess(2))
+    {
+        stats.update(2, false);
+        ++visits;
+    }
+    TEST_ASSERT_TRUE(visits >= 16 && visits <= 24);
+
+    // Still listened to now and then, a busy result keeps it skipped
+    for (uint8_t i = 1; i < LBT_PROBE_INTERVAL - 1; i++)
+        TEST_ASSERT_FALSE(stats.shouldAssess(2));
+    TEST_ASSERT_TRUE(stats.shouldAssess(2));
+    stats.update(2, false);
+    TEST_ASSERT_FALSE(stats.shouldAssess(2));
+
+    // One clear result and it is back
+    for (uint8_t i = 1; i < LBT_PROBE_INTERVAL - 1; i++)
+        TEST_ASSERT_FALSE(stats.shouldAssess(2));
+    TEST_ASSERT_TRUE(stats.shouldAssess(2));
+    stats.update(2, true);
+    TEST_ASSERT_TRUE(stats.shouldAssess(2));
+
+    // Other channels aren't affected, and ones out of range are always listened to
+    TEST_ASSERT_EQUAL(0, stats.getBusyScore(3));
+    TEST_ASSERT_TRUE(stats.shouldAssess(3));
+    stats.update(LBT_CHANNELS, false);
+    TEST_ASSERT_TRUE(stats.shouldAssess(LBT_CHANNELS));
+}
+
+void test_busy_band_timing(void)
+{
+    for (const lbt_mode_t &mode : modes)
+    {
+        stats.reset();
+        seed = 1;
+        // Time spent listening, and the TX slots lost, in 10000 hops against listening on every one
+        uint64_t waitEvery = 0;
+        uint64_t waitAssessed = 0;
+        uint32_t sentEvery = 0;
+        uint32_t sentAssessed = 0;
+        for (uint32_t hop = 0; hop < 10000; hop++)
+        {
+            uint8_t const channel = rnd() % CHANNELS;
+            bool const clear = channel >= BUSY_CHANNELS && rnd() % 100 >= 2;
+
+            waitEvery += mode.dwellUs + RSSI_READ_US;
+            sentEvery += clear;
+            if (stats.shouldAssess(channel))
+            {
+                waitAssessed += mode.dwellUs + RSSI_READ_US;
+                stats.update(channel, clear);
+                sentAssessed += clear;
+            }
+        }
+        // Nothing sent is lost, and most of the visits to the busy channels are skipped
+        TEST_ASSERT_EQUAL(sentEvery, sentAssessed);
+        TEST_ASSERT_TRUE(stats.getSkippedCount() > 10000 * BUSY_CHANNELS / CHANNELS * 3 / 4);
+        TEST_ASSERT_TRUE(waitAssessed * CHANNELS < waitEvery * (CHANNELS - BUSY_CHANNELS * 3 / 4));
+    }
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_skip_busy);
+    RUN_TEST(test_busy_band_timing);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include <cstdint>
+#include <cmath>
+#include <unity.h>
+#include "common.h"
+#include "LinkBudget.h"
+
+// The thresholds from dynpower.cpp
+#define DYNPOWER_LQ_BOOST_THRESH_DIFF 20
+#define DYNPOWER_LQ_BOOST_THRESH_MIN  50
+#define DYNPOWER_LQ_THRESH_UP         85
+#define DYNPOWER_RSSI_THRESH_UP       15
+#define DYNPOWER_RSSI_THRESH_DN       21
+#define DYNPOWER_LQ_THRESH_DN         95
+
+// A 900MHz rate which uses RSSI, and a 2.4GHz one which uses SNR
+static const expresslrs_rf_pref_params_s rssiRate = {0, -120, 18560, 4000, 2500, 600, 5000, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE};
+static const expresslrs_rf_pref_params_s snrRate = {0, -108, 3300, 3000, 2500, 6, 5000, SNR_SCALE(3), SNR_SCALE(9.5)};
+
+static const PowerLevels_e minPower = PWR_10mW;
+static const PowerLevels_e maxPower = PWR_1000mW;
+// One link statistics report every half a second
+static const float reportInterval = 0.5f;
+
+// The SX1280's SNR doesn't read higher than this
+static const float snrCeiling = 12.0f;
+
+// The LQ guards from dynpower.cpp
+class LqGuard
+{
+public:
+    void reset() { lqAvg = 100 << 16; }
+    // true if the LQ has dropped enough to go straight to max power
+    bool update(uint8_t lq, uint32_t &avg)
+    {
+        avg = lqAvg >> 16;
+        int32_t const diff = (int32_t)avg - lq;
+        lqAvg = (7 * lqAvg + ((uint32_t)lq << 16)) / 8;
+        return diff >= DYNPOWER_LQ_BOOST_THRESH_DIFF || lq <= DYNPOWER_LQ_BOOST_THRESH_MIN;
+    }
+private:
+    uint32_t lqAvg;
+};
+
+// DynamicPower_Update() with the link budget
+class BudgetController
+{
+public:
+    BudgetController() : budget(DYNPOWER_RSSI_THRESH_UP, DYNPOWER_RSSI_THRESH_DN - DYNPOWER_RSSI_THRESH_UP) {}
+    void reset() { guard.reset(); budget.reset(); }
+    void update(PowerLevels_e &power, int8_t rssi, int8_t snrScaled, uint8_t lq, const expresslrs_rf_pref_params_s *rate)
+    {
+        uint32_t lqAvg;
+        budget.update(powerToDbm(power), rssi, snrScaled, rate->RXsensitivity, rate->DynpowerSnrThreshUp, rate->DynpowerSnrThreshDn);
+        if (guard.update(lq, lqAvg))
+        {
+            power = maxPower;
+            return;
+        }
+        PowerLevels_e const start = power;
+        PowerLevels_e const wanted = budget.selectPower(power, minPower, maxPower);
+        if (wanted > power || lqAvg >= DYNPOWER_LQ_THRESH_DN)
+            power = wanted;
+        if (power < maxPower && start == power && lq <= DYNPOWER_LQ_THRESH_UP)
+            power = (PowerLevels_e)(power + 1);
+    }
+private:
+    LqGuard guard;
+    LinkBudget budget;
+};
+
+typedef float (*pathLossFn)(float t);
+
+// 900MHz free space plus 20dB of losses
+static float pathLossAt(float metres)
+{
+    return 20.0f * log10f(metres) + 31.7f + 20.0f;
+}
+static float approach(float t) { return pathLossAt(5000.0f - t * 41.0f); }
+static float departure(float t) { return pathLossAt(80.0f + t * 41.0f); }
+static float occlusion(float t) { return pathLossAt(800.0f) + ((t >= 40.0f && t < 60.0f) ? 25.0f : 0.0f); }
+
+typedef struct {
+    float powerSeconds; // mW.s
+    uint8_t minLq;
+    float secondsBelow90;
+    uint32_t changes;
+} sim_result_t;
+
+static sim_result_t simulate(pathLossFn pathLoss, const expresslrs_rf_pref_params_s *rate)
+{
+    static const float mW[] = {10, 25, 50, 100, 250, 500, 1000, 2000};
+    sim_result_t result = {0, 100, 0, 0};
+    PowerLevels_e power = maxPower;
+    PowerLevels_e measuredAt = maxPower;
+    uint32_t seed = 1;
+    BudgetController ctrl;
+    ctrl.reset();
+
+    for (float t = 0; t < 120.0f; t += reportInterval)
+    {
+        // Fading over the report, -6 to +2dB
+        seed = seed * 1103515245 + 12345;
+        float const fade = ((seed >> 16) % 81) / 10.0f - 6.0f;
+        // The report lags a report behind, it was measured before the last power change
+        float const signal = powerToDbm(measuredAt) - pathLoss(t) + fade;
+
+        // What the receiver reports, the RSSI is the signal plus the noise
+        float const noiseFloor = rate == &rssiRate ? -111.0f : -109.0f;
+        float const rssi = 10.0f * log10f(powf(10.0f, signal / 10.0f) + powf(10.0f, noiseFloor / 10.0f));
+        float const snr = fminf(signal - noiseFloor, snrCeiling);
+        float const margin = signal - rate->RXsensitivity;
+        uint8_t const lq = (uint8_t)(100.0f / (1.0f + expf(-(margin + 1.0f))) + 0.5f);
+
+        result.powerSeconds += mW[power] * reportInterval;
+        result.minLq = lq < result.minLq ? lq : result.minLq;
+        if (lq < 90)
+            result.secondsBelow90 += reportInterval;
+
+        PowerLevels_e const before = power;
+        measuredAt = power;
+        ctrl.update(power, (int8_t)lroundf(rssi), SNR_SCALE(snr), lq, rate);
+        result.changes += power != before;
+    }
+    return result;
+}
+
+typedef struct {
+    pathLossFn pathLoss;
+    const expresslrs_rf_pref_params_s *rate;
+    float maxPowerSeconds;
+    float maxSecondsBelow90;
+    uint32_t maxChanges;
+} sim_case_t;
+
+// Starting from max power over two minutes of reports
+static const sim_case_t simCases[] = {
+    {approach, &rssiRate, 20000, 0, 5},
+    {departure, &rssiRate, 10000, 0, 5},
+    {occlusion, &rssiRate, 24000, 1.0f, 8},
+    {approach, &snrRate, 17000, 6.0f, 24},
+    {departure, &snrRate, 23000, 7.0f, 32},
+    {occlusion, &snrRate, 31000, 12.0f, 14},
+};
+
+void test_jumps_to_needed_power(void)
+{
+    LinkBudget budget(DYNPOWER_RSSI_THRESH_UP, DYNPOWER_RSSI_THRESH_DN - DYNPOWER_RSSI_THRESH_UP);
+    TEST_ASSERT_EQUAL(PWR_100mW, budget.selectPower(PWR_100mW, minPower, maxPower));
+
+    // 20dBm and -115dBm is 135dB of path loss, 10dB short of -120 + 15
+    budget.update(20, -115, SNR_SCALE(10), -120, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE);
+    TEST_ASSERT_EQUAL(-10 * 4, budget.margin(20));
+    TEST_ASSERT_EQUAL(PWR_1000mW, budget.selectPower(PWR_100mW, minPower, maxPower));
+    // Limited to the configured power
+    TEST_ASSERT_EQUAL(PWR_250mW, budget.selectPower(PWR_100mW, minPower, PWR_250mW));
+
+    // 30dB spare at 100mW, drop to the lowest level with 6dB spare over the target
+    budget.reset();
+    budget.update(20, -75, SNR_SCALE(10), -120, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE);
+    TEST_ASSERT_EQUAL(PWR_10mW, budget.selectPower(PWR_100mW, minPower, maxPower));
+    budget.reset();
+    budget.update(20, -91, SNR_SCALE(10), -120, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE);
+    // 14dB spare, 14dBm leaves 8
+    TEST_ASSERT_EQUAL(PWR_25mW, budget.selectPower(PWR_100mW, minPower, maxPower));
+    // Within the hysteresis nothing changes
+    budget.reset();
+    budget.update(20, -100, SNR_SCALE(10), -120, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE);
+    TEST_ASSERT_EQUAL(PWR_100mW, budget.selectPower(PWR_100mW, minPower, maxPower));
+}
+
+void test_snr_below_noise(void)
+{
+    LinkBudget budget(DYNPOWER_RSSI_THRESH_UP, DYNPOWER_RSSI_THRESH_DN - DYNPOWER_RSSI_THRESH_UP);
+    // The RSSI reads the noise floor, the signal is 8dB under it
+    budget.update(20, -112, SNR_SCALE(-8), -120, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE);
+    TEST_ASSERT_EQUAL((20 + 120) * 4, budget.getPathLoss());
+
+    // On an SNR rate the SNR is kept above DynpowerSnrThreshUp, whatever the RSSI
+    budget.reset();
+    budget.update(20, -80, SNR_SCALE(1), -108, SNR_SCALE(3), SNR_SCALE(9.5));
+    TEST_ASSERT_EQUAL(-2 * 4, budget.margin(20));
+    TEST_ASSERT_EQUAL(PWR_250mW, budget.selectPower(PWR_100mW, minPower, maxPower));
+    // Up at the ceiling the SNR only says there is at least 9dB spare
+    budget.update(20, -80, SNR_SCALE(12), -108, SNR_SCALE(3), SNR_SCALE(9.5));
+    TEST_ASSERT_EQUAL(9 * 4, budget.margin(20));
+    TEST_ASSERT_EQUAL(PWR_50mW, budget.selectPower(PWR_100mW, minPower, maxPower));
+}
+
+void test_loss_is_averaged(void)
+{
+    LinkBudget budget(DYNPOWER_RSSI_THRESH_UP, DYNPOWER_RSSI_THRESH_DN - DYNPOWER_RSSI_THRESH_UP);
+    budget.update(20, -100, SNR_SCALE(10), -120, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE);
+    TEST_ASSERT_EQUAL(120 * 4, budget.getPathLoss());
+    // A quarter of the way each report
+    budget.update(20, -110, SNR_SCALE(10), -120, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE);
+    TEST_ASSERT_EQUAL(120 * 4 + 10, budget.getPathLoss());
+    budget.update(20, -90, SNR_SCALE(10), -120, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE);
+    TEST_ASSERT_EQUAL(120 * 4 + 10 - 12, budget.getPathLoss());
+
+    // The SNR at its ceiling can only lower the estimate
+    budget.reset();
+    budget.update(20, -90, SNR_SCALE(5), -108, SNR_SCALE(3), SNR_SCALE(9.5));
+    TEST_ASSERT_EQUAL(2 * 4, budget.margin(20));
+    budget.update(20, -90, SNR_SCALE(12), -108, SNR_SCALE(3), SNR_SCALE(9.5));
+    TEST_ASSERT_EQUAL(9 * 4, budget.margin(20));
+    budget.update(24, -86, SNR_SCALE(12), -108, SNR_SCALE(3), SNR_SCALE(9.5));
+    budget.update(24, -86, SNR_SCALE(12), -108, SNR_SCALE(3), SNR_SCALE(9.5));
+    TEST_ASSERT_EQUAL(9 * 4, budget.margin(20));
+}
+
+void test_skips_report_after_power_change(void)
+{
+    LinkBudget budget(DYNPOWER_RSSI_THRESH_UP, DYNPOWER_RSSI_THRESH_DN - DYNPOWER_RSSI_THRESH_UP);
+    budget.update(20, -100, SNR_SCALE(10), -120, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE);
+    TEST_ASSERT_EQUAL(120 * 4, budget.getPathLoss());
+    // Raised to 30dBm, but the report is still the one measured at 20
+    budget.update(30, -100, SNR_SCALE(10), -120, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE);
+    TEST_ASSERT_EQUAL(120 * 4, budget.getPathLoss());
+    budget.update(30, -90, SNR_SCALE(10), -120, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE);
+    TEST_ASSERT_EQUAL(120 * 4, budget.getPathLoss());
+    budget.update(30, -86, SNR_SCALE(10), -120, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE);
+    TEST_ASSERT_EQUAL(120 * 4 - 4, budget.getPathLoss());
+}
+
+void test_simulation(void)
+{
+    for (const sim_case_t &c : simCases)
+    {
+        sim_result_t const r = simulate(c.pathLoss, c.rate);
+        TEST_ASSERT_TRUE(r.powerSeconds < c.maxPowerSeconds);
+        TEST_ASSERT_TRUE(r.secondsBelow90 <= c.maxSecondsBelow90);
+        TEST_ASSERT_TRUE(r.changes <= c.maxChanges);
+    }
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_jumps_to_needed_power);
+    RUN_TEST(test_snr_below_noise);
+    RUN_TEST(test_loss_is_averaged);
+    RUN_TEST(test_skips_report_after_power_change);
+    RUN_TEST(test_simulation);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <unity.h>
+#include "LR1121Updater.h"
+
+#define WRITE_FLASH_OC  0x8003  // LR11XX_BL_WRITE_FLASH_ENCRYPTED_OC
+#define FIRMWARE_SIZE   245000  // about the size of an LR1121 firmware image
+
+// Timings in us for the mock, SPI at 10MHz and the LR1121 writing 256 bytes of flash
+#define SPI_US_PER_BYTE 1
+#define FLASH_US        2500
+#define IDLE_US         50
+// The web upload hands over one TCP segment at a time, with the WiFi in between
+#define SEGMENT         1436
+#define SEGMENT_US      1500
+
+/**
+ * The LR1121 bootloader as seen from the SPI bus, which takes the encrypted image in
+ * writes at any offset and is BUSY for a while after each one
+ */
+class MockBootloader : public LR1121UpdatePort
+{
+public:
+    MockBootloader() : flash(FIRMWARE_SIZE + 1024, 0xFF) {}
+
+    void startWrite(uint8_t *packet, uint32_t size) override
+    {
+        now += size * SPI_US_PER_BYTE;
+        if (now < busyUntil)
+            ++writesWhileBusy;
+        if (packet[0] != (WRITE_FLASH_OC >> 8) || packet[1] != (WRITE_FLASH_OC & 0xFF) || size > 6 + 256)
+            ++badWrites;
+        uint32_t const offset = (packet[2] << 24) | (packet[3] << 16) | (packet[4] << 8) | packet[5];
+        memcpy(&flash[offset], packet + 6, size - 6);
+        ++writes;
+        busyUntil = now + FLASH_US;
+    }
+    bool isBusy() override { return now < busyUntil; }
+    void idle() override { now += IDLE_US; }
+    uint32_t getMillis() override { return now / 1000; }
+
+    uint64_t now = 0;
+    uint64_t busyUntil = 0;
+    std::vector<uint8_t> flash;
+    uint32_t writes = 0;
+    uint32_t writesWhileBusy = 0;
+    uint32_t badWrites = 0;
+};
+
+static std::vector<uint8_t> firmware(size_t size)
+{
+    std::vector<uint8_t> image(size);
+    uint32_t seed = size;
+    for (uint8_t &b : image)
+    {
+        seed = seed * 1103515245 + 12345;
+        b = seed >> 16;
+    }
+    return image;
+}
+
+// Hands the file over like the web upload does, as it comes in off the network
+static void upload(MockBootloader &lr1121, LR1121Updater &updater, const std::vector<uint8_t> &image, size_t from, size_t to)
+{
+    for (size_t pos = from; pos < to; pos += SEGMENT)
+    {
+        lr1121.now += SEGMENT_US;
+        updater.write(&image[pos], pos + SEGMENT < to ? SEGMENT : to - pos);
+    }
+}
+
+static void assertFlashed(const MockBootloader &lr1121, const std::vector<uint8_t> &image)
+{
+    TEST_ASSERT_EQUAL(0, lr1121.writesWhileBusy);
+    TEST_ASSERT_EQUAL(0, lr1121.badWrites);
+    TEST_ASSERT_EQUAL_MEMORY(image.data(), lr1121.flash.data(), image.size());
+    // Nothing past the end
+    TEST_ASSERT_EQUAL(0xFF, lr1121.flash[image.size()]);
+}
+
+void test_whole_file(void)
+{
+    // Sizes which end on a packet, a segment, and neither
+    static const size_t sizes[] = {FIRMWARE_SIZE, 256 * 40, SEGMENT * 7, 1, 300};
+    for (size_t size : sizes)
+    {
+        std::vector<uint8_t> const image = firmware(size);
+        MockBootloader lr1121;
+        LR1121Updater updater(lr1121, WRITE_FLASH_OC);
+        updater.begin(size);
+        upload(lr1121, updater, image, 0, size);
+        TEST_ASSERT_EQUAL(size, updater.getReceived());
+        updater.finish();
+
+        assertFlashed(lr1121, image);
+        TEST_ASSERT_TRUE(updater.isComplete());
+        TEST_ASSERT_EQUAL(100, updater.getProgress());
+        TEST_ASSERT_EQUAL((size + 255) / 256, lr1121.writes);
+        TEST_ASSERT_FALSE(updater.canResume());
+    }
+}
+
+void test_odd_writes(void)
+{
+    // Whatever sizes the upload comes in, the packets are all 256 bytes but the last
+    std::vector<uint8_t> const image = firmware(20000);
+    MockBootloader lr1121;
+    LR1121Updater updater(lr1121, WRITE_FLASH_OC);
+    updater.begin(image.size());
+    size_t pos = 0;
+    for (size_t len = 1; pos < image.size(); len = len * 7 % 2000 + 1)
+    {
+        len = pos + len < image.size() ? len : image.size() - pos;
+        updater.write(&image[pos], len);
+        pos += len;
+        lr1121.now += 300;
+    }
+    updater.finish();
+    assertFlashed(lr1121, image);
+    TEST_ASSERT_EQUAL((image.size() + 255) / 256, lr1121.writes);
+}
+
+void test_resume(void)
+{
+    std::vector<uint8_t> const image = firmware(FIRMWARE_SIZE);
+    MockBootloader lr1121;
+    LR1121Updater updater(lr1121, WRITE_FLASH_OC);
+    updater.begin(image.size());
+    // The connection drops part way through a segment
+    upload(lr1121, updater, image, 0, 100000);
+    updater.write(&image[100000], 700);
+    TEST_ASSERT_TRUE(updater.canResume());
+    size_t const offset = updater.getResumeOffset();
+    TEST_ASSERT_EQUAL(0, offset % 256);
+    TEST_ASSERT_TRUE(offset <= 100700);
+    TEST_ASSERT_TRUE(offset >= 100700 - 256 * LR1121_UPDATE_RING);
+
+    // Only the same file from where it got to
+    TEST_ASSERT_FALSE(updater.resume(image.size() + 1, offset));
+    TEST_ASSERT_FALSE(updater.resume(image.size(), 0));
+
+    // Then the rest of it is uploaded, straight away while the last write is still going
+    TEST_ASSERT_TRUE(updater.resume(image.size(), offset));
+    TEST_ASSERT_EQUAL(offset, updater.getReceived());
+    upload(lr1121, updater, image, offset, image.size());
+    updater.finish();
+    assertFlashed(lr1121, image);
+    TEST_ASSERT_TRUE(updater.isComplete());
+    TEST_ASSERT_FALSE(updater.canResume());
+    TEST_ASSERT_FALSE(updater.resume(image.size(), updater.getResumeOffset()));
+}
+
+void test_throughput(void)
+{
+    std::vector<uint8_t> const image = firmware(FIRMWARE_SIZE);
+    MockBootloader lr1121;
+    LR1121Updater updater(lr1121, WRITE_FLASH_OC);
+    updater.begin(image.size());
+    upload(lr1121, updater, image, 0, image.size());
+    updater.finish();
+    assertFlashed(lr1121, image);
+
+    // The network overlaps the flash writes, so the upload takes little longer than writing
+    // the packets back to back
+    uint64_t const flashUs = (uint64_t)lr1121.writes * (FLASH_US + (6 + 256) * SPI_US_PER_BYTE);
+    TEST_ASSERT_TRUE(lr1121.now * 100 < flashUs * 102);
+    uint32_t const expected = (uint64_t)FIRMWARE_SIZE * 1000000 / lr1121.now;
+    TEST_ASSERT_UINT32_WITHIN(expected / 50, expected, updater.getThroughput());
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_whole_file);
+    RUN_TEST(test_odd_writes);
+    RUN_TEST(test_resume);
+    RUN_TEST(test_throughput);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,320 @@
+#include <cstdint>
+#include <cstring>
+#include <unity.h>
+#include "targets.h"
+#include "helpers.h"
+#include "lua.h"
+#include "luaParamCache.h"
+
+// Handset max packet 64 bytes - 6 bytes CRSF header/CRC - 2 bytes FieldId, ChunksRemain
+#define CHUNK_MAX (CRSF_MAX_PACKET_LEN - 6 - 2)
+
+static char packetRates[] = "50Hz(-115dBm);100Hz Full(-112dBm);150Hz(-112dBm);250Hz(-108dBm);333Hz Full(-105dBm);500Hz(-105dBm);D250(-104dBm);D500(-104dBm);F500(-104dBm);F1000(-104dBm)";
+static char tlmBandwidth[12] = " (1:128)";
+static char modelMatchUnit[] = " (ID: 00)";
+static char badGood[10] = "0/0";
+static char pwrFolderName[] = "TX Power (100)";
+static const char dvrAux[] = "Off;AUX1" LUASYM_ARROW_UP ";AUX1" LUASYM_ARROW_DN ";AUX2" LUASYM_ARROW_UP ";AUX2" LUASYM_ARROW_DN ";AUX3" LUASYM_ARROW_UP ";AUX3" LUASYM_ARROW_DN ";AUX4" LUASYM_ARROW_UP ";AUX4" LUASYM_ARROW_DN ";AUX5" LUASYM_ARROW_UP ";AUX5" LUASYM_ARROW_DN ";AUX6" LUASYM_ARROW_UP ";AUX6" LUASYM_ARROW_DN ";AUX7" LUASYM_ARROW_UP ";AUX7" LUASYM_ARROW_DN ";AUX8" LUASYM_ARROW_UP ";AUX8" LUASYM_ARROW_DN;
+static const char dvrDelay[] = "0s;5s;15s;30s;45s;1min;2min";
+
+static struct luaItem_folder luaRoot = {{"HooJ", CRSF_FOLDER}};
+static struct luaItem_selection luaAirRate = {{"Packet Rate", CRSF_TEXT_SELECTION}, 0, packetRates, ""};
+static struct luaItem_selection luaTlmRate = {{"Telem Ratio", CRSF_TEXT_SELECTION}, 0, "Std;Off;1:128;1:64;1:32;1:16;1:8;1:4;1:2;Race", tlmBandwidth};
+static struct luaItem_folder luaPowerFolder = {{"TX Power", CRSF_FOLDER}, pwrFolderName};
+static struct luaItem_selection luaPower = {{"Max Power", CRSF_TEXT_SELECTION}, 0, "10;25;50;100;250;500;1000", "mW"};
+static struct luaItem_selection luaDynamicPower = {{"Dynamic", CRSF_TEXT_SELECTION}, 0, "Off;Dyn;AUX9;AUX10;AUX11;AUX12", ""};
+static struct luaItem_selection luaSwitch = {{"Switch Mode", CRSF_TEXT_SELECTION}, 0, "Wide;Hybrid", ""};
+static struct luaItem_selection luaLinkMode = {{"Link Mode", CRSF_TEXT_SELECTION}, 0, "Normal;MAVLink", ""};
+static struct luaItem_selection luaModelMatch = {{"Model Match", CRSF_TEXT_SELECTION}, 0, "Off;On", modelMatchUnit};
+static struct luaItem_command luaBind = {{"Bind", CRSF_COMMAND}, lcsIdle, ""};
+static struct luaItem_string luaInfo = {{"Bad/Good", (crsf_value_type_e)(CRSF_INFO | CRSF_FIELD_ELRS_HIDDEN)}, badGood};
+static struct luaItem_string luaVersion = {{"3.5.0 ISM2G4", CRSF_INFO}, "1a2b3c"};
+static struct luaItem_folder luaWiFiFolder = {{"WiFi Connectivity", CRSF_FOLDER}};
+static struct luaItem_command luaWebUpdate = {{"Enable WiFi", CRSF_COMMAND}, lcsIdle, ""};
+static struct luaItem_command luaRxWebUpdate = {{"Enable Rx WiFi", CRSF_COMMAND}, lcsIdle, ""};
+static struct luaItem_folder luaVtxFolder = {{"VTX Administrator", CRSF_FOLDER}};
+static struct luaItem_selection luaVtxBand = {{"Band", CRSF_TEXT_SELECTION}, 0, "Off;A;B;E;F;R;L", ""};
+static struct luaItem_int8 luaVtxChannel = {{"Channel", CRSF_UINT8}, {{1, 1, 8}}, ""};
+static struct luaItem_selection luaVtxPwr = {{"Pwr Lvl", CRSF_TEXT_SELECTION}, 0, "-;1;2;3;4;5;6;7;8", ""};
+static struct luaItem_command luaVtxSend = {{"Send VTx", CRSF_COMMAND}, lcsIdle, ""};
+static struct luaItem_folder luaBackpackFolder = {{"Backpack", CRSF_FOLDER}};
+static struct luaItem_selection luaDvrAux = {{"DVR Rec", CRSF_TEXT_SELECTION}, 0, dvrAux, ""};
+static struct luaItem_selection luaDvrStartDelay = {{"DVR Srt Dly", CRSF_TEXT_SELECTION}, 0, dvrDelay, ""};
+static struct luaItem_selection luaDvrStopDelay = {{"DVR Stp Dly", CRSF_TEXT_SELECTION}, 0, dvrDelay, ""};
+static struct luaItem_int16 luaRangeInt16 = {{"Range", CRSF_UINT16}, {{0x0100, 0, 0x2000}}, "m"};
+
+static struct luaPropertiesCommon *menu[LUA_MAX_PARAMS];
+static uint8_t menuCount;
+
+static uint8_t addParam(void *definition, uint8_t parent = 0)
+{
+    struct luaPropertiesCommon *p = (struct luaPropertiesCommon *)definition;
+    p->id = menuCount;
+    p->parent = parent;
+    menu[menuCount++] = p;
+    return p->id;
+}
+
+// The same menu layout as the TX module
+static void buildMenu()
+{
+    menuCount = 0;
+    addParam(&luaRoot);
+    addParam(&luaAirRate);
+    addParam(&luaTlmRate);
+    uint8_t power = addParam(&luaPowerFolder);
+    addParam(&luaPower, power);
+    addParam(&luaDynamicPower, power);
+    addParam(&luaSwitch);
+    addParam(&luaLinkMode);
+    addParam(&luaModelMatch);
+    addParam(&luaBind);
+    addParam(&luaInfo);
+    uint8_t wifi = addParam(&luaWiFiFolder);
+    addParam(&luaWebUpdate, wifi);
+    addParam(&luaRxWebUpdate, wifi);
+    uint8_t vtx = addParam(&luaVtxFolder);
+    addParam(&luaVtxBand, vtx);
+    addParam(&luaVtxChannel, vtx);
+    addParam(&luaVtxPwr, vtx);
+    addParam(&luaVtxSend, vtx);
+    uint8_t backpack = addParam(&luaBackpackFolder);
+    addParam(&luaDvrAux, backpack);
+    addParam(&luaDvrStartDelay, backpack);
+    addParam(&luaDvrStopDelay, backpack);
+    addParam(&luaRangeInt16);
+    addParam(&luaVersion);
+}
+
+// Reassemble a parameter from the cache the way the handset does, chunk by chunk
+static uint16_t readParam(struct luaPropertiesCommon *p, uint8_t *out, uint8_t *chunks)
+{
+    uint16_t total = 0;
+    uint8_t chunk = 0;
+    uint8_t remaining;
+    do
+    {
+        uint16_t len;
+        const uint8_t *image = luaParamCache.getImage(p, chunk, len);
+        if (image == nullptr)
+            return 0;
+        uint8_t chunkCnt = luaImageChunkCount(len, CHUNK_MAX);
+        uint16_t chunkSize = std::min((uint16_t)(len - chunk * CHUNK_MAX), (uint16_t)CHUNK_MAX);
+        memcpy(&out[total], &image[chunk * CHUNK_MAX], chunkSize);
+        total += chunkSize;
+        remaining = chunkCnt - (chunk + 1);
+        ++chunk;
+    } while (remaining);
+    if (chunks)
+        *chunks = chunk;
+    return total;
+}
+
+void test_lua_image_selection(void)
+{
+    buildMenu();
+    setLuaTextSelectionValue(&luaSwitch, 1);
+
+    uint8_t image[LUA_IMAGE_MAX_SIZE];
+    uint16_t len = luaBuildParamImage(&luaSwitch.common, image);
+
+    const uint8_t expected[] = {
+        0, CRSF_TEXT_SELECTION,
+        'S','w','i','t','c','h',' ','M','o','d','e',0,
+        'W','i','d','e',';','H','y','b','r','i','d',0,
+        1, 0, 1, 0, // value, min, max, default
+        0 // units
+    };
+    TEST_ASSERT_EQUAL(sizeof(expected), len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, image, sizeof(expected));
+}
+
+void test_lua_image_types(void)
+{
+    buildMenu();
+    uint8_t image[LUA_IMAGE_MAX_SIZE];
+
+    // Folders send the dynamic name in place of the name, with no data
+    uint16_t len = luaBuildParamImage(&luaPowerFolder.common, image);
+    TEST_ASSERT_EQUAL(2 + sizeof(pwrFolderName), len);
+    TEST_ASSERT_EQUAL_STRING(pwrFolderName, (char *)&image[2]);
+
+    // The type byte does not carry the hidden flags, they are added as the frame is sent
+    len = luaBuildParamImage(&luaInfo.common, image);
+    TEST_ASSERT_EQUAL(CRSF_INFO, image[1]);
+    TEST_ASSERT_EQUAL(2 + sizeof("Bad/Good") + strlen(badGood) + 1, len);
+
+    len = luaBuildParamImage(&luaVtxChannel.common, image);
+    const uint8_t expectedInt8[] = { luaVtxFolder.common.id, CRSF_UINT8, 'C','h','a','n','n','e','l',0, 1, 1, 8, 0, 0 };
+    TEST_ASSERT_EQUAL(sizeof(expectedInt8), len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedInt8, image, sizeof(expectedInt8));
+
+    len = luaBuildParamImage(&luaRangeInt16.common, image);
+    const uint8_t expectedInt16[] = { 0, CRSF_UINT16, 'R','a','n','g','e',0, 0x00,0x01, 0,0, 0x00,0x20, 0,0, 'm',0 };
+    TEST_ASSERT_EQUAL(sizeof(expectedInt16), len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedInt16, image, sizeof(expectedInt16));
+
+    len = luaBuildParamImage(&luaBind.common, image);
+    const uint8_t expectedCmd[] = { 0, CRSF_COMMAND, 'B','i','n','d',0, lcsIdle, 200, 0 };
+    TEST_ASSERT_EQUAL(sizeof(expectedCmd), len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedCmd, image, sizeof(expectedCmd));
+
+    struct luaItem_float luaFloat = {{"Float", CRSF_FLOAT}, {0, 0, 0, 0, 0, 0}, ""};
+    TEST_ASSERT_EQUAL(0, luaBuildParamImage(&luaFloat.common, image));
+}
+
+void test_lua_cache_hit_until_value_changes(void)
+{
+    buildMenu();
+    uint8_t out[LUA_IMAGE_MAX_SIZE];
+    readParam(&luaLinkMode.common, out, nullptr);
+
+    uint32_t builds = luaParamCache.imageBuilds;
+    readParam(&luaLinkMode.common, out, nullptr);
+    TEST_ASSERT_EQUAL(builds, luaParamCache.imageBuilds);
+
+    // Setting the same value does not invalidate the image
+    setLuaTextSelectionValue(&luaLinkMode, luaLinkMode.value);
+    readParam(&luaLinkMode.common, out, nullptr);
+    TEST_ASSERT_EQUAL(builds, luaParamCache.imageBuilds);
+
+    setLuaTextSelectionValue(&luaLinkMode, 1 - luaLinkMode.value);
+    uint16_t len = readParam(&luaLinkMode.common, out, nullptr);
+    TEST_ASSERT_EQUAL(builds + 1, luaParamCache.imageBuilds);
+    TEST_ASSERT_EQUAL(luaLinkMode.value, out[len - 5]);
+}
+
+void test_lua_cache_rebuilds_text_on_first_chunk(void)
+{
+    buildMenu();
+    uint8_t out[LUA_IMAGE_MAX_SIZE];
+    strcpy(badGood, "0/0");
+    readParam(&luaInfo.common, out, nullptr);
+
+    // The info string is rewritten in place, without going through a setter
+    strcpy(badGood, "12/250");
+    uint16_t len = readParam(&luaInfo.common, out, nullptr);
+    TEST_ASSERT_EQUAL_STRING("12/250", (char *)&out[len - 7]);
+}
+
+void test_lua_cache_chunks_consistent(void)
+{
+    buildMenu();
+    uint8_t out[LUA_IMAGE_MAX_SIZE];
+    uint8_t chunks;
+    setLuaTextSelectionValue(&luaDvrAux, 0);
+    uint16_t fullLen = readParam(&luaDvrAux.common, out, &chunks);
+    TEST_ASSERT_GREATER_THAN(1, chunks);
+
+    // Value changes after the first chunk has been sent
+    uint16_t len;
+    const uint8_t *image = luaParamCache.getImage(&luaDvrAux.common, 0, len);
+    TEST_ASSERT_EQUAL(0, image[fullLen - 5]);
+    setLuaTextSelectionValue(&luaDvrAux, 3);
+
+    // The remaining chunks come from the same image as the first
+    image = luaParamCache.getImage(&luaDvrAux.common, 1, len);
+    TEST_ASSERT_EQUAL(fullLen, len);
+    TEST_ASSERT_EQUAL(0, image[fullLen - 5]);
+
+    // Reading the parameter again picks up the new value
+    readParam(&luaDvrAux.common, out, nullptr);
+    TEST_ASSERT_EQUAL(3, out[fullLen - 5]);
+}
+
+void test_lua_cache_image_grows(void)
+{
+    buildMenu();
+    uint8_t out[LUA_IMAGE_MAX_SIZE];
+    uint8_t expected[LUA_IMAGE_MAX_SIZE];
+    readParam(&luaAirRate.common, out, nullptr);
+    readParam(&luaTlmRate.common, out, nullptr);
+
+    // The units are changed in place and grow past the space of the first image
+    strcpy(tlmBandwidth, " (12345bps)");
+    luaParamInvalidate(&luaTlmRate.common);
+    uint16_t len = readParam(&luaTlmRate.common, out, nullptr);
+    TEST_ASSERT_EQUAL(luaBuildParamImage(&luaTlmRate.common, expected), len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, out, len);
+
+    // Neighbouring images are not overwritten
+    len = readParam(&luaAirRate.common, out, nullptr);
+    TEST_ASSERT_EQUAL(luaBuildParamImage(&luaAirRate.common, expected), len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, out, len);
+    strcpy(tlmBandwidth, " (1:128)");
+    luaParamInvalidate(&luaTlmRate.common);
+}
+
+struct menuLoadStats {
+    uint32_t responseFrames;
+    uint32_t serializedBytes;
+};
+
+// Load every field the way the EdgeTX Lua script does: one PARAMETER_READ per chunk,
+// sent after the response to the previous one has been received
+static void loadMenu(menuLoadStats &uncached, menuLoadStats &cached)
+{
+    uint8_t image[LUA_IMAGE_MAX_SIZE];
+    uint8_t out[LUA_IMAGE_MAX_SIZE];
+    for (uint8_t i = 1; i < menuCount; ++i)
+    {
+        // Uncached: the image is rebuilt for every chunk
+        uint16_t len = luaBuildParamImage(menu[i], image);
+        uint8_t chunks = luaImageChunkCount(len, CHUNK_MAX);
+        uncached.responseFrames += chunks;
+        uncached.serializedBytes += chunks * len;
+
+        uint32_t built = luaParamCache.imageBytesBuilt;
+        uint16_t cachedLen = readParam(menu[i], out, &chunks);
+        TEST_ASSERT_EQUAL(len, cachedLen);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(image, out, len);
+        cached.responseFrames += chunks;
+        cached.serializedBytes += luaParamCache.imageBytesBuilt - built;
+    }
+}
+
+void test_lua_menu_load_replay(void)
+{
+    buildMenu();
+    for (uint8_t i = 0; i < menuCount; ++i)
+        luaParamInvalidate(menu[i]);
+
+    menuLoadStats uncached = {};
+    menuLoadStats cached = {};
+
+    // Open the menu, change the packet rate, which updates the telemetry bandwidth
+    // label, and the menu is reloaded. Close and open the menu again.
+    loadMenu(uncached, cached);
+    setLuaTextSelectionValue(&luaAirRate, 3);
+    strcpy(tlmBandwidth, " (1:64)");
+    luaParamInvalidate(&luaTlmRate.common);
+    loadMenu(uncached, cached);
+    loadMenu(uncached, cached);
+
+    // The handset receives exactly the same responses
+    TEST_ASSERT_EQUAL(uncached.responseFrames, cached.responseFrames);
+    // Only the changed and free-text parameters are serialized again after the first load
+    TEST_ASSERT_LESS_THAN(uncached.serializedBytes / 2, cached.serializedBytes);
+
+    strcpy(tlmBandwidth, " (1:128)");
+    luaParamInvalidate(&luaTlmRate.common);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_lua_image_selection);
+    RUN_TEST(test_lua_image_types);
+    RUN_TEST(test_lua_cache_hit_until_value_changes);
+    RUN_TEST(test_lua_cache_rebuilds_text_on_first_chunk);
+    RUN_TEST(test_lua_cache_chunks_consistent);
+    RUN_TEST(test_lua_cache_image_grows);
+    RUN_TEST(test_lua_menu_load_replay);
+    UNITY_END();
+
+    return 0;
+}
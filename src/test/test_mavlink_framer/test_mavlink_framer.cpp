@@ -0,0 +1,304 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unity.h>
+#include "MAVLinkFramer.h"
+
+using namespace std;
+
+// CRC_EXTRA of the common dialect messages an ArduPilot vehicle streams
+static const struct {
+    uint32_t msgid;
+    uint8_t crcExtra;
+} crcExtras[] = {
+    {0, 50},    // HEARTBEAT
+    {1, 124},   // SYS_STATUS
+    {2, 137},   // SYSTEM_TIME
+    {22, 220},  // PARAM_VALUE
+    {24, 24},   // GPS_RAW_INT
+    {27, 144},  // RAW_IMU
+    {30, 39},   // ATTITUDE
+    {33, 104},  // GLOBAL_POSITION_INT
+    {36, 222},  // SERVO_OUTPUT_RAW
+    {42, 28},   // MISSION_CURRENT
+    {65, 118},  // RC_CHANNELS
+    {74, 20},   // VFR_HUD
+    {147, 154}, // BATTERY_STATUS
+};
+
+static bool testCrcExtra(uint32_t msgid, uint8_t *crcExtra)
+{
+    for (const auto &e : crcExtras)
+    {
+        if (e.msgid == msgid)
+        {
+            *crcExtra = e.crcExtra;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint16_t crcAccumulate(uint8_t data, uint16_t crc)
+{
+    uint8_t tmp = data ^ (uint8_t)(crc & 0xFF);
+    tmp ^= (tmp << 4);
+    return (crc >> 8) ^ (tmp << 8) ^ (tmp << 3) ^ (tmp >> 4);
+}
+
+static uint8_t crcExtraFor(uint32_t msgid)
+{
+    uint8_t crcExtra = 0;
+    testCrcExtra(msgid, &crcExtra);
+    return crcExtra;
+}
+
+static void appendFrame(vector<uint8_t> &out, bool v2, uint32_t msgid, uint8_t len, uint8_t seq, bool sign = false)
+{
+    size_t start = out.size();
+    if (v2)
+    {
+        uint8_t hdr[] = {0xFD, len, (uint8_t)(sign ? 1 : 0), 0, seq, 1, 1,
+                         (uint8_t)msgid, (uint8_t)(msgid >> 8), (uint8_t)(msgid >> 16)};
+        out.insert(out.end(), hdr, hdr + sizeof(hdr));
+    }
+    else
+    {
+        uint8_t hdr[] = {0xFE, len, seq, 1, 1, (uint8_t)msgid};
+        out.insert(out.end(), hdr, hdr + sizeof(hdr));
+    }
+    // Nothing trailing zero, so the reparse doesn't truncate it
+    for (unsigned i = 0; i < len; ++i)
+        out.push_back((uint8_t)(rand() | 1));
+
+    uint16_t crc = 0xFFFF;
+    for (size_t i = start + 1; i < out.size(); ++i)
+        crc = crcAccumulate(out[i], crc);
+    crc = crcAccumulate(crcExtraFor(msgid), crc);
+    out.push_back(crc & 0xFF);
+    out.push_back(crc >> 8);
+
+    if (sign)
+        for (unsigned i = 0; i < 13; ++i)
+            out.push_back((uint8_t)rand());
+}
+
+typedef struct {
+    uint32_t ms;
+    vector<uint8_t> bytes;
+} stream_chunk_t;
+
+/**
+ * An ArduPilot telemetry stream at typical SRx_ rates, as UART reads of 1-64
+ * bytes each. AHRS (163) is an ardupilotmega message the framer has no
+ * CRC_EXTRA for.
+ */
+static vector<stream_chunk_t> arduPilotStream(unsigned seconds, vector<uint8_t> &all)
+{
+    static const struct {
+        uint32_t msgid;
+        uint8_t len;
+        uint8_t hz;
+    } streams[] = {
+        {0, 9, 1}, {1, 31, 2}, {2, 12, 1}, {24, 30, 2}, {27, 26, 2}, {30, 28, 10}, {33, 28, 5},
+        {36, 21, 2}, {42, 2, 1}, {65, 42, 2}, {74, 20, 5}, {147, 36, 1}, {163, 28, 2},
+    };
+
+    srand(42);
+    all.clear();
+    vector<stream_chunk_t> chunks;
+    uint8_t seq = 0;
+    for (uint32_t ms = 0; ms < seconds * 1000; ms += 10)
+    {
+        vector<uint8_t> tick;
+        for (const auto &s : streams)
+            if (ms % (1000 / s.hz) == 0)
+                appendFrame(tick, true, s.msgid, s.len, seq++);
+        all.insert(all.end(), tick.begin(), tick.end());
+
+        size_t pos = 0;
+        while (pos < tick.size())
+        {
+            size_t n = std::min(tick.size() - pos, (size_t)(1 + rand() % 64));
+            chunks.push_back({ms, vector<uint8_t>(tick.begin() + pos, tick.begin() + pos + n)});
+            pos += n;
+        }
+    }
+    return chunks;
+}
+
+static vector<uint8_t> runFramer(MAVLinkFramer &framer, const vector<stream_chunk_t> &chunks, unsigned *calls = nullptr)
+{
+    vector<uint8_t> out;
+    unsigned forwards = 0;
+    for (const auto &c : chunks)
+    {
+        const uint8_t *data = c.bytes.data();
+        uint16_t len = c.bytes.size();
+        while (len)
+        {
+            uint16_t taken = framer.append(data, len);
+            data += taken;
+            len -= taken;
+            framer.process(c.ms, [&](const uint8_t *frame, uint16_t frameLen) {
+                out.insert(out.end(), frame, frame + frameLen);
+                ++forwards;
+            });
+        }
+    }
+    if (calls)
+        *calls = forwards;
+    return out;
+}
+
+void test_stream_forwarded_unchanged(void)
+{
+    vector<uint8_t> all;
+    auto chunks = arduPilotStream(5, all);
+    MAVLinkFramer framer(testCrcExtra);
+    unsigned calls;
+    auto out = runFramer(framer, chunks, &calls);
+
+    TEST_ASSERT_EQUAL(all.size(), out.size());
+    TEST_ASSERT_EQUAL_MEMORY(all.data(), out.data(), all.size());
+    TEST_ASSERT_EQUAL(all.size(), framer.bytesForwarded);
+    TEST_ASSERT_EQUAL(0, framer.bytesDiscarded);
+    TEST_ASSERT_EQUAL(0, framer.framesBadCrc);
+    TEST_ASSERT_EQUAL(0, framer.pending());
+    // AHRS is passed on without a CRC check
+    TEST_ASSERT_EQUAL(10, framer.framesUnchecked);
+    // Frames completed in the same buffer go out in one block
+    TEST_ASSERT_LESS_THAN(framer.framesForwarded, calls);
+}
+
+void test_garbage_and_bad_crc_discarded(void)
+{
+    srand(1);
+    vector<uint8_t> in, expected;
+    appendFrame(expected, true, 0, 9, 0);
+    in = expected;
+
+    // Line noise, including something that looks like a start of frame
+    uint8_t noise[] = {0x00, 0x55, 0xFD, 0x03, 0x00};
+    in.insert(in.end(), noise, noise + sizeof(noise));
+
+    // Corrupted ATTITUDE
+    vector<uint8_t> bad;
+    appendFrame(bad, true, 30, 28, 1);
+    bad[15] ^= 0x40;
+    in.insert(in.end(), bad.begin(), bad.end());
+
+    vector<uint8_t> good;
+    appendFrame(good, false, 74, 20, 2); // v1
+    appendFrame(good, true, 33, 28, 3, true); // signed
+    in.insert(in.end(), good.begin(), good.end());
+    expected.insert(expected.end(), good.begin(), good.end());
+
+    MAVLinkFramer framer(testCrcExtra);
+    vector<uint8_t> out;
+    framer.append(in.data(), in.size());
+    framer.process(0, [&](const uint8_t *frame, uint16_t len) { out.insert(out.end(), frame, frame + len); });
+
+    TEST_ASSERT_EQUAL(expected.size(), out.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected.data(), out.data(), expected.size());
+    TEST_ASSERT_EQUAL(3, framer.framesForwarded);
+    TEST_ASSERT_EQUAL(1, framer.framesBadCrc);
+    TEST_ASSERT_EQUAL(sizeof(noise) + bad.size(), framer.bytesDiscarded);
+    TEST_ASSERT_EQUAL(0, framer.pending());
+}
+
+void test_incomplete_frame_kept(void)
+{
+    srand(2);
+    vector<uint8_t> frame;
+    appendFrame(frame, true, 65, 42, 0);
+
+    MAVLinkFramer framer(testCrcExtra);
+    unsigned forwards = 0;
+    auto count = [&](const uint8_t *, uint16_t) { ++forwards; };
+
+    // One byte at a time
+    for (size_t i = 0; i < frame.size() - 1; ++i)
+    {
+        framer.append(&frame[i], 1);
+        framer.process(0, count);
+    }
+    TEST_ASSERT_EQUAL(0, forwards);
+    TEST_ASSERT_EQUAL(frame.size() - 1, framer.pending());
+    framer.append(&frame.back(), 1);
+    framer.process(0, count);
+    TEST_ASSERT_EQUAL(1, forwards);
+    TEST_ASSERT_EQUAL(0, framer.pending());
+}
+
+void test_message_stats(void)
+{
+    vector<uint8_t> all;
+    auto chunks = arduPilotStream(5, all);
+    MAVLinkFramer framer(testCrcExtra);
+    runFramer(framer, chunks);
+
+    TEST_ASSERT_EQUAL(13, framer.getStatsCount());
+    const mavlink_msg_stats_t *attitude = framer.getStats(30);
+    TEST_ASSERT_NOT_NULL(attitude);
+    TEST_ASSERT_EQUAL(50, attitude->frames);
+    TEST_ASSERT_EQUAL(50 * (28 + 12), attitude->bytes);
+    TEST_ASSERT_EQUAL(10, attitude->rateHz);
+    TEST_ASSERT_EQUAL(0, attitude->dropped);
+    TEST_ASSERT_EQUAL(1, framer.getStats(0)->rateHz);
+    TEST_ASSERT_NULL(framer.getStats(99));
+
+    framer.resetStats();
+    TEST_ASSERT_EQUAL(0, framer.getStatsCount());
+    TEST_ASSERT_EQUAL(0, framer.framesForwarded);
+}
+
+void test_filters(void)
+{
+    vector<uint8_t> all;
+    auto chunks = arduPilotStream(10, all);
+    MAVLinkFramer framer(testCrcExtra);
+    const mavlink_filter_t filters[] = {
+        {30, 200},                 // ATTITUDE 10Hz -> 5Hz
+        {74, 1000},                // VFR_HUD 5Hz -> 1Hz
+        {27, MAVLINK_FILTER_DROP}, // RAW_IMU
+    };
+    framer.setFilters(filters, sizeof(filters) / sizeof(filters[0]));
+    auto out = runFramer(framer, chunks);
+
+    const mavlink_msg_stats_t *attitude = framer.getStats(30);
+    TEST_ASSERT_EQUAL(100, attitude->frames);
+    TEST_ASSERT_EQUAL(50, attitude->dropped);
+    TEST_ASSERT_EQUAL(40, framer.getStats(74)->dropped);
+    TEST_ASSERT_EQUAL(20, framer.getStats(27)->dropped);
+    // Statistics count every frame seen, forwarded or not
+    TEST_ASSERT_EQUAL(10, attitude->rateHz);
+    TEST_ASSERT_EQUAL(110, framer.framesFiltered);
+
+    size_t saved = 50 * (28 + 12) + 40 * (20 + 12) + 20 * (26 + 12);
+    TEST_ASSERT_EQUAL(all.size() - saved, out.size());
+    TEST_ASSERT_EQUAL(out.size(), framer.bytesForwarded);
+
+    // Filters survive a reset of the statistics
+    framer.resetStats();
+    TEST_ASSERT_EQUAL(3, framer.getStatsCount());
+    TEST_ASSERT_EQUAL(MAVLINK_FILTER_DROP, framer.getStats(27)->minIntervalMs);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_stream_forwarded_unchanged);
+    RUN_TEST(test_garbage_and_bad_crc_discarded);
+    RUN_TEST(test_incomplete_frame_kept);
+    RUN_TEST(test_message_stats);
+    RUN_TEST(test_filters);
+    UNITY_END();
+
+    return 0;
+}
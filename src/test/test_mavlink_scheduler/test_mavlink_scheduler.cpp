@@ -0,0 +1,271 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <unity.h>
+#include "MAVLinkScheduler.h"
+
+using namespace std;
+
+#define MSG_HEARTBEAT 0
+#define MSG_PARAM_VALUE 22
+#define MSG_ATTITUDE 30
+#define MSG_NAMED_VALUE_FLOAT 251
+
+// The scheduler only looks at the header, the payload is filled with seq so frames can be told apart
+static vector<uint8_t> makeFrame(uint32_t msgid, uint8_t len, uint8_t seq, uint8_t sysid = 1)
+{
+    vector<uint8_t> frame = {0xFD, len, 0, 0, seq, sysid, 1,
+                             (uint8_t)msgid, (uint8_t)(msgid >> 8), (uint8_t)(msgid >> 16)};
+    frame.insert(frame.end(), len, seq);
+    frame.push_back(0x55);
+    frame.push_back(0xAA);
+    return frame;
+}
+
+static bool push(MAVLinkScheduler &sched, const vector<uint8_t> &frame)
+{
+    return sched.push(frame.data(), frame.size());
+}
+
+// Pops everything and returns the msgid and seq of each frame in the order they came out
+static vector<pair<uint32_t, uint8_t>> popFrames(MAVLinkScheduler &sched, uint16_t maxLen, uint32_t now)
+{
+    vector<uint8_t> out;
+    uint8_t buf[MAVLINK_FRAMER_MAX_FRAME_LEN];
+    uint16_t n;
+    while ((n = sched.pop(buf, maxLen, now)) != 0)
+        out.insert(out.end(), buf, buf + n);
+
+    vector<pair<uint32_t, uint8_t>> frames;
+    for (size_t pos = 0; pos < out.size(); pos += mavlinkFrameLen(&out[pos]))
+        frames.push_back(make_pair(mavlinkFrameMsgId(&out[pos]), out[pos + 4]));
+    return frames;
+}
+
+void test_priority_table(void)
+{
+    TEST_ASSERT_EQUAL(MAVLINK_PRIO_HIGH, mavlinkPriority(0));
+    TEST_ASSERT_EQUAL(MAVLINK_PRIO_HIGH, mavlinkPriority(253));
+    TEST_ASSERT_EQUAL(MAVLINK_PRIO_STATE, mavlinkPriority(1));
+    TEST_ASSERT_EQUAL(MAVLINK_PRIO_STATE, mavlinkPriority(245));
+    TEST_ASSERT_EQUAL(MAVLINK_PRIO_BULK, mavlinkPriority(22));
+    TEST_ASSERT_EQUAL(MAVLINK_PRIO_BULK, mavlinkPriority(120));
+    TEST_ASSERT_EQUAL(MAVLINK_PRIO_NORMAL, mavlinkPriority(251));
+    TEST_ASSERT_EQUAL(MAVLINK_PRIO_NORMAL, mavlinkPriority(12915));
+}
+
+void test_classes_in_priority_order(void)
+{
+    MAVLinkScheduler sched;
+    push(sched, makeFrame(MSG_PARAM_VALUE, 25, 1));
+    push(sched, makeFrame(MSG_NAMED_VALUE_FLOAT, 18, 2));
+    push(sched, makeFrame(MSG_ATTITUDE, 28, 3));
+    push(sched, makeFrame(MSG_HEARTBEAT, 9, 4));
+    push(sched, makeFrame(MSG_NAMED_VALUE_FLOAT, 18, 5));
+
+    auto frames = popFrames(sched, 64, 0);
+    TEST_ASSERT_EQUAL(5, frames.size());
+    TEST_ASSERT_EQUAL(4, frames[0].second);
+    TEST_ASSERT_EQUAL(3, frames[1].second);
+    TEST_ASSERT_EQUAL(2, frames[2].second);
+    TEST_ASSERT_EQUAL(5, frames[3].second);
+    TEST_ASSERT_EQUAL(1, frames[4].second);
+    TEST_ASSERT_EQUAL(0, sched.size());
+}
+
+void test_state_coalesced(void)
+{
+    MAVLinkScheduler sched;
+    push(sched, makeFrame(MSG_ATTITUDE, 28, 1));
+    push(sched, makeFrame(MSG_ATTITUDE, 28, 2, 2)); // another vehicle is kept
+    push(sched, makeFrame(MSG_ATTITUDE, 28, 3));
+    push(sched, makeFrame(MSG_ATTITUDE, 27, 4));    // trimmed payload
+    push(sched, makeFrame(MSG_ATTITUDE, 27, 5));
+    // Non-state messages are never coalesced
+    push(sched, makeFrame(MSG_NAMED_VALUE_FLOAT, 18, 6));
+    push(sched, makeFrame(MSG_NAMED_VALUE_FLOAT, 18, 7));
+
+    TEST_ASSERT_EQUAL(3, sched.getStats(MAVLINK_PRIO_STATE).coalesced);
+    TEST_ASSERT_EQUAL(3, sched.totalCoalesced());
+    TEST_ASSERT_EQUAL(40 + 39 + 2 * 30, sched.size());
+
+    // The older frames are dropped, so what is left goes out in the order it was sent
+    auto frames = popFrames(sched, 64, 0);
+    TEST_ASSERT_EQUAL(4, frames.size());
+    TEST_ASSERT_EQUAL(2, frames[0].second);
+    TEST_ASSERT_EQUAL(5, frames[1].second);
+    TEST_ASSERT_EQUAL(6, frames[2].second);
+    TEST_ASSERT_EQUAL(7, frames[3].second);
+    TEST_ASSERT_EQUAL(0, sched.size());
+}
+
+void test_lower_classes_not_starved(void)
+{
+    MAVLinkScheduler sched;
+    sched.setLinkRate(1000);
+    const uint32_t stateMsgs[] = {1, 24, 30, 33, 74, 147};
+    uint32_t sent[MAVLINK_PRIO_COUNT] = {};
+    uint32_t queued[MAVLINK_PRIO_COUNT] = {};
+    uint32_t popped[MAVLINK_PRIO_COUNT] = {};
+    uint8_t buf[64];
+    uint8_t seq = 0;
+    for (uint32_t now = 1; now <= 10000; ++now)
+    {
+        // Each state message at 50Hz is several times what the link can carry,
+        // and a parameter download and other traffic always waiting behind it
+        if (now % 20 == 0)
+            for (uint32_t msgid : stateMsgs)
+                push(sched, makeFrame(msgid, 28, seq++));
+        if (queued[MAVLINK_PRIO_BULK] - popped[MAVLINK_PRIO_BULK] < 4)
+            queued[MAVLINK_PRIO_BULK] += push(sched, makeFrame(MSG_PARAM_VALUE, 25, seq++));
+        if (queued[MAVLINK_PRIO_NORMAL] - popped[MAVLINK_PRIO_NORMAL] < 4)
+            queued[MAVLINK_PRIO_NORMAL] += push(sched, makeFrame(MSG_NAMED_VALUE_FLOAT, 18, seq++));
+
+        uint16_t n = sched.pop(buf, sizeof(buf), now);
+        for (uint16_t pos = 0; pos < n; pos += mavlinkFrameLen(&buf[pos]))
+        {
+            mavlink_prio_e const prio = mavlinkPriority(mavlinkFrameMsgId(&buf[pos]));
+            sent[prio] += mavlinkFrameLen(&buf[pos]);
+            ++popped[prio];
+        }
+    }
+
+    // Shared 4:2:1 by weight
+    uint32_t const total = sent[MAVLINK_PRIO_STATE] + sent[MAVLINK_PRIO_NORMAL] + sent[MAVLINK_PRIO_BULK];
+    TEST_ASSERT_INT_WITHIN(500, 10000, total);
+    TEST_ASSERT_INT_WITHIN(total / 20, total * 4 / 7, sent[MAVLINK_PRIO_STATE]);
+    TEST_ASSERT_INT_WITHIN(total / 20, total * 2 / 7, sent[MAVLINK_PRIO_NORMAL]);
+    TEST_ASSERT_INT_WITHIN(total / 20, total / 7, sent[MAVLINK_PRIO_BULK]);
+    TEST_ASSERT_EQUAL(0, sched.totalDropped());
+}
+
+void test_full_queue_drops(void)
+{
+    MAVLinkScheduler sched;
+    unsigned pushed = 0;
+    for (unsigned i = 0; i < MAVLINK_SCHED_QUEUE_FRAMES + 4; ++i)
+        pushed += push(sched, makeFrame(MSG_NAMED_VALUE_FLOAT, 8, i)) ? 1 : 0;
+
+    TEST_ASSERT_EQUAL(MAVLINK_SCHED_QUEUE_FRAMES, pushed);
+    TEST_ASSERT_EQUAL(4, sched.getStats(MAVLINK_PRIO_NORMAL).dropped);
+    TEST_ASSERT_EQUAL(4, sched.totalDropped());
+    TEST_ASSERT_EQUAL(100, sched.fillPercent());
+    // Other classes still have room
+    TEST_ASSERT_TRUE(push(sched, makeFrame(MSG_HEARTBEAT, 9, 0)));
+
+    // Byte limit
+    MAVLinkScheduler bytes;
+    TEST_ASSERT_TRUE(push(bytes, makeFrame(MSG_PARAM_VALUE, 255, 0)));
+    TEST_ASSERT_FALSE(push(bytes, makeFrame(MSG_PARAM_VALUE, 255, 1)));
+    TEST_ASSERT_EQUAL(1, bytes.getStats(MAVLINK_PRIO_BULK).dropped);
+}
+
+void test_rate_shaping(void)
+{
+    MAVLinkScheduler sched;
+    // 1000 bytes/s, the bucket holds MAVLINK_FRAMER_MAX_FRAME_LEN as that's more than 250ms worth
+    sched.setLinkRate(1000);
+    uint32_t now = 1000;
+    uint8_t buf[64];
+    // Empty the bucket
+    for (unsigned i = 0; i < 20; ++i)
+        push(sched, makeFrame(MSG_NAMED_VALUE_FLOAT, 18, i));
+    uint32_t sent = 0;
+    uint16_t n;
+    while ((n = sched.pop(buf, sizeof(buf), now)) != 0)
+        sent += n;
+    TEST_ASSERT_LESS_OR_EQUAL(MAVLINK_FRAMER_MAX_FRAME_LEN, sent);
+    TEST_ASSERT_TRUE(sched.size() > 0);
+
+    // Over the next second the output should match the link rate
+    sent = 0;
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        ++now;
+        if (sched.size() < 100)
+            push(sched, makeFrame(MSG_NAMED_VALUE_FLOAT, 18, i));
+        sent += sched.pop(buf, sizeof(buf), now);
+    }
+    TEST_ASSERT_INT_WITHIN(30, 1000, sent);
+}
+
+void test_bulk_keeps_reserve(void)
+{
+    MAVLinkScheduler sched;
+    sched.setLinkRate(1000);
+    for (unsigned i = 0; i < 10; ++i)
+        push(sched, makeFrame(MSG_PARAM_VALUE, 25, i));
+
+    // Bulk stops with half the bucket left
+    uint32_t now = 1000;
+    uint8_t buf[64];
+    uint32_t sent = 0;
+    uint16_t n;
+    while ((n = sched.pop(buf, sizeof(buf), now)) != 0)
+        sent += n;
+    TEST_ASSERT_TRUE(sent <= MAVLINK_FRAMER_MAX_FRAME_LEN / 2 + 37);
+    TEST_ASSERT_TRUE(sent >= MAVLINK_FRAMER_MAX_FRAME_LEN / 2 - 37);
+
+    // which a heartbeat can still use
+    push(sched, makeFrame(MSG_HEARTBEAT, 9, 0));
+    TEST_ASSERT_EQUAL(21, sched.pop(buf, sizeof(buf), now));
+}
+
+void test_large_frame_split(void)
+{
+    MAVLinkScheduler sched;
+    vector<uint8_t> big = makeFrame(MSG_NAMED_VALUE_FLOAT, 100, 1);
+    push(sched, big);
+    push(sched, makeFrame(MSG_HEARTBEAT, 9, 2));
+
+    // The heartbeat goes first, it fits
+    uint8_t buf[64];
+    TEST_ASSERT_EQUAL(21, sched.pop(buf, sizeof(buf), 0));
+    // then the big frame in pieces, nothing else can get between them
+    vector<uint8_t> out;
+    uint16_t n = sched.pop(buf, sizeof(buf), 0);
+    TEST_ASSERT_EQUAL(sizeof(buf), n);
+    out.insert(out.end(), buf, buf + n);
+    push(sched, makeFrame(MSG_HEARTBEAT, 9, 3));
+    n = sched.pop(buf, sizeof(buf), 0);
+    TEST_ASSERT_EQUAL(big.size() - sizeof(buf), n);
+    out.insert(out.end(), buf, buf + n);
+    TEST_ASSERT_TRUE(out == big);
+    TEST_ASSERT_EQUAL(21, sched.pop(buf, sizeof(buf), 0));
+    TEST_ASSERT_EQUAL(0, sched.size());
+}
+
+void test_queue_wraps(void)
+{
+    MAVLinkScheduler sched;
+    uint8_t buf[MAVLINK_FRAMER_MAX_FRAME_LEN];
+    // Odd sizes so the frames wrap around the end of the queue at every offset
+    for (unsigned i = 0; i < 200; ++i)
+    {
+        vector<uint8_t> frame = makeFrame(MSG_NAMED_VALUE_FLOAT, 10 + i % 37, i);
+        TEST_ASSERT_TRUE(push(sched, frame));
+        TEST_ASSERT_EQUAL(frame.size(), sched.pop(buf, sizeof(buf), 0));
+        TEST_ASSERT_EQUAL_MEMORY(frame.data(), buf, frame.size());
+    }
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_priority_table);
+    RUN_TEST(test_classes_in_priority_order);
+    RUN_TEST(test_state_coalesced);
+    RUN_TEST(test_lower_classes_not_starved);
+    RUN_TEST(test_full_queue_drops);
+    RUN_TEST(test_rate_shaping);
+    RUN_TEST(test_bulk_keeps_reserve);
+    RUN_TEST(test_large_frame_split);
+    RUN_TEST(test_queue_wraps);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,373 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unity.h>
+#include "MAVLinkFramer.h"
+#include "MAVLinkTelemetry.h"
+#include "CRSF.h"
+
+using namespace std;
+
+#define MSG_HEARTBEAT 0
+#define MSG_GPS_RAW_INT 24
+#define MSG_ATTITUDE 30
+#define MSG_GLOBAL_POSITION_INT 33
+#define MSG_BATTERY_STATUS 147
+#define MSG_SYS_STATUS 1
+
+static const struct {
+    uint32_t msgid;
+    uint8_t crcExtra;
+    uint8_t len;
+} messages[] = {
+    {MSG_HEARTBEAT, 50, 9},
+    {MSG_SYS_STATUS, 124, 31},
+    {MSG_GPS_RAW_INT, 24, 30},
+    {MSG_ATTITUDE, 39, 28},
+    {MSG_GLOBAL_POSITION_INT, 104, 28},
+    {MSG_BATTERY_STATUS, 154, 36},
+};
+
+static bool testCrcExtra(uint32_t msgid, uint8_t *crcExtra)
+{
+    for (const auto &m : messages)
+    {
+        if (m.msgid == msgid)
+        {
+            *crcExtra = m.crcExtra;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint8_t payloadLen(uint32_t msgid)
+{
+    for (const auto &m : messages)
+        if (m.msgid == msgid)
+            return m.len;
+    return 0;
+}
+
+static void testFlightMode(char *name, uint8_t mavType, uint32_t customMode)
+{
+    // Copter LOITER
+    if (mavType == 2 && customMode == 5)
+        strcpy(name, "LOIT");
+    else
+        strcpy(name, "");
+}
+
+static uint16_t crcAccumulate(uint8_t data, uint16_t crc)
+{
+    uint8_t tmp = data ^ (uint8_t)(crc & 0xFF);
+    tmp ^= (tmp << 4);
+    return (crc >> 8) ^ (tmp << 8) ^ (tmp << 3) ^ (tmp >> 4);
+}
+
+/**
+ * Build a MAVLink2 frame the way mavlink_msg_to_send_buffer() does, with the
+ * trailing zeros of the payload trimmed
+ */
+static void appendFrame(vector<uint8_t> &out, uint32_t msgid, const uint8_t *payload, uint8_t compid = 1)
+{
+    uint8_t len = payloadLen(msgid);
+    while (len > 1 && payload[len - 1] == 0)
+        --len;
+
+    size_t start = out.size();
+    uint8_t hdr[] = {0xFD, len, 0, 0, 0, 1, compid, (uint8_t)msgid, (uint8_t)(msgid >> 8), (uint8_t)(msgid >> 16)};
+    out.insert(out.end(), hdr, hdr + sizeof(hdr));
+    out.insert(out.end(), payload, payload + len);
+
+    uint16_t crc = 0xFFFF;
+    for (size_t i = start + 1; i < out.size(); ++i)
+        crc = crcAccumulate(out[i], crc);
+    uint8_t crcExtra = 0;
+    testCrcExtra(msgid, &crcExtra);
+    crc = crcAccumulate(crcExtra, crc);
+    out.push_back(crc & 0xFF);
+    out.push_back(crc >> 8);
+}
+
+template <typename T>
+static void put(uint8_t *payload, uint8_t offset, T value)
+{
+    memcpy(&payload[offset], &value, sizeof(value));
+}
+
+static void heartbeat(vector<uint8_t> &out, uint32_t customMode, uint8_t type, uint8_t baseMode, uint8_t compid = 1)
+{
+    uint8_t p[9] = {0};
+    put<uint32_t>(p, 0, customMode);
+    p[4] = type;
+    p[5] = 3; // MAV_AUTOPILOT_ARDUPILOTMEGA
+    p[6] = baseMode;
+    p[7] = 4; // MAV_STATE_ACTIVE
+    p[8] = 3;
+    appendFrame(out, MSG_HEARTBEAT, p, compid);
+}
+
+static void attitude(vector<uint8_t> &out, float roll, float pitch, float yaw)
+{
+    uint8_t p[28] = {0};
+    put<uint32_t>(p, 0, 12345);
+    put<float>(p, 4, roll);
+    put<float>(p, 8, pitch);
+    put<float>(p, 12, yaw);
+    put<float>(p, 16, 0.1f);
+    appendFrame(out, MSG_ATTITUDE, p);
+}
+
+static void gpsRawInt(vector<uint8_t> &out, int32_t lat, int32_t lon, int32_t alt, uint16_t vel, uint16_t cog, uint8_t sats)
+{
+    uint8_t p[30] = {0};
+    put<uint64_t>(p, 0, 123456789);
+    put<int32_t>(p, 8, lat);
+    put<int32_t>(p, 12, lon);
+    put<int32_t>(p, 16, alt);
+    put<uint16_t>(p, 20, 120);
+    put<uint16_t>(p, 22, 200);
+    put<uint16_t>(p, 24, vel);
+    put<uint16_t>(p, 26, cog);
+    p[28] = 3;
+    p[29] = sats;
+    appendFrame(out, MSG_GPS_RAW_INT, p);
+}
+
+static void globalPositionInt(vector<uint8_t> &out, int32_t relativeAlt, int16_t vz)
+{
+    uint8_t p[28] = {0};
+    put<uint32_t>(p, 0, 12345);
+    put<int32_t>(p, 12, 150000);
+    put<int32_t>(p, 16, relativeAlt);
+    put<int16_t>(p, 24, vz);
+    appendFrame(out, MSG_GLOBAL_POSITION_INT, p);
+}
+
+static void batteryStatus(vector<uint8_t> &out, uint8_t id, uint16_t mV, int16_t cA, int32_t mAh, int8_t remaining)
+{
+    uint8_t p[36] = {0};
+    put<int32_t>(p, 0, mAh);
+    put<int32_t>(p, 4, -1);
+    put<int16_t>(p, 8, 2500);
+    for (unsigned i = 0; i < 10; ++i)
+        put<uint16_t>(p, 10 + i * 2, i == 0 ? mV : UINT16_MAX);
+    put<int16_t>(p, 30, cA);
+    p[32] = id;
+    p[35] = remaining;
+    appendFrame(out, MSG_BATTERY_STATUS, p);
+}
+
+static vector<uint8_t> translate(MAVLinkFramer &framer, MAVLinkTelemetry &tlm, const vector<uint8_t> &in)
+{
+    framer.append(in.data(), in.size());
+    framer.process(0, [&](const uint8_t *data, uint16_t len) { tlm.translate(data, len); });
+    uint8_t buf[MAVLINK_TLM_MAX_ENTRIES * MAVLINK_TLM_MAX_CRSF_LEN];
+    uint16_t len = tlm.flush(buf, sizeof(buf));
+    return vector<uint8_t>(buf, buf + len);
+}
+
+// Returns the payload of the CRSF frame of the type, or nullptr if it's not there or has a bad CRC
+static const uint8_t *findCrsf(const vector<uint8_t> &crsf, crsf_frame_type_e type)
+{
+    for (size_t pos = 0; pos < crsf.size(); pos += CRSF_FRAME_SIZE(crsf[pos + 1]))
+    {
+        const uint8_t *frame = &crsf[pos];
+        if (frame[2] != type)
+            continue;
+        uint8_t crc = crsf_crc.calc(&frame[CRSF_FRAME_NOT_COUNTED_BYTES], frame[1] - 1, 0);
+        if (crc != frame[CRSF_FRAME_NOT_COUNTED_BYTES + frame[1] - 1])
+            return nullptr;
+        return &frame[sizeof(crsf_header_t)];
+    }
+    return nullptr;
+}
+
+void test_translate_fields(void)
+{
+    vector<uint8_t> in;
+    heartbeat(in, 5, 2, 0x80 | 0x01);
+    attitude(in, 0.5f, -0.25f, 3.0f);
+    globalPositionInt(in, 12345, -150);
+    gpsRawInt(in, 473977418, 85455939, 500000, 1000, 18000, 12);
+    batteryStatus(in, 0, 12600, 1550, 0x123456, 87);
+
+    MAVLinkFramer framer(testCrcExtra);
+    MAVLinkTelemetry tlm(testFlightMode);
+    auto crsf = translate(framer, tlm, in);
+    TEST_ASSERT_EQUAL(5, tlm.framesTranslated);
+
+    const crsf_flight_mode_t *fm = (const crsf_flight_mode_t *)findCrsf(crsf, CRSF_FRAMETYPE_FLIGHT_MODE);
+    TEST_ASSERT_NOT_NULL(fm);
+    TEST_ASSERT_EQUAL_STRING("LOIT*", fm->flight_mode);
+
+    const crsf_sensor_attitude_t *att = (const crsf_sensor_attitude_t *)findCrsf(crsf, CRSF_FRAMETYPE_ATTITUDE);
+    TEST_ASSERT_NOT_NULL(att);
+    TEST_ASSERT_EQUAL(5000, (int16_t)htobe16(att->roll));
+    TEST_ASSERT_EQUAL(-2500, (int16_t)htobe16(att->pitch));
+    TEST_ASSERT_EQUAL(30000, (int16_t)htobe16(att->yaw));
+
+    const crsf_sensor_vario_t *vario = (const crsf_sensor_vario_t *)findCrsf(crsf, CRSF_FRAMETYPE_VARIO);
+    TEST_ASSERT_NOT_NULL(vario);
+    TEST_ASSERT_EQUAL(150, (int16_t)htobe16(vario->verticalspd));
+
+    const crsf_sensor_gps_t *gps = (const crsf_sensor_gps_t *)findCrsf(crsf, CRSF_FRAMETYPE_GPS);
+    TEST_ASSERT_NOT_NULL(gps);
+    TEST_ASSERT_EQUAL(473977418, (int32_t)htobe32(gps->latitude));
+    TEST_ASSERT_EQUAL(85455939, (int32_t)htobe32(gps->longitude));
+    TEST_ASSERT_EQUAL(1012, htobe16(gps->altitude)); // relative altitude, 12m + 1000
+    TEST_ASSERT_EQUAL(360, htobe16(gps->groundspeed));
+    TEST_ASSERT_EQUAL(18000, htobe16(gps->gps_heading));
+    TEST_ASSERT_EQUAL(12, gps->satellites_in_use);
+
+    const uint8_t *batt = findCrsf(crsf, CRSF_FRAMETYPE_BATTERY_SENSOR);
+    TEST_ASSERT_NOT_NULL(batt);
+    uint8_t expectedBatt[] = {0x00, 126, 0x00, 155, 0x12, 0x34, 0x56, 87};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expectedBatt, batt, sizeof(expectedBatt));
+
+    // Everything was flushed
+    uint8_t buf[64];
+    TEST_ASSERT_EQUAL(0, tlm.flush(buf, sizeof(buf)));
+}
+
+void test_trimmed_payload(void)
+{
+    // Disarmed, unknown mode, the trailing zeros are trimmed so type and base_mode aren't sent
+    vector<uint8_t> in;
+    uint8_t p[9] = {0};
+    put<uint32_t>(p, 0, 5);
+    appendFrame(in, MSG_HEARTBEAT, p);
+    TEST_ASSERT_EQUAL(10 + 1 + 2, in.size());
+
+    MAVLinkFramer framer(testCrcExtra);
+    MAVLinkTelemetry tlm(testFlightMode);
+    auto crsf = translate(framer, tlm, in);
+    const crsf_flight_mode_t *fm = (const crsf_flight_mode_t *)findCrsf(crsf, CRSF_FRAMETYPE_FLIGHT_MODE);
+    TEST_ASSERT_NOT_NULL(fm);
+    TEST_ASSERT_EQUAL_STRING("", fm->flight_mode);
+}
+
+void test_ignored(void)
+{
+    vector<uint8_t> in;
+    heartbeat(in, 5, 6, 0, 190);              // GCS heartbeat
+    batteryStatus(in, 1, 12600, 1550, 10, 50); // second battery
+    uint8_t p[31] = {1};
+    appendFrame(in, MSG_SYS_STATUS, p);       // nothing to convert
+
+    MAVLinkFramer framer(testCrcExtra);
+    MAVLinkTelemetry tlm(testFlightMode);
+    auto crsf = translate(framer, tlm, in);
+    TEST_ASSERT_EQUAL(3, framer.framesForwarded);
+    TEST_ASSERT_EQUAL(0, tlm.framesTranslated);
+    TEST_ASSERT_EQUAL(0, crsf.size());
+}
+
+void test_batch_newest_only(void)
+{
+    vector<uint8_t> in;
+    attitude(in, 0.1f, 0, 0);
+    heartbeat(in, 5, 2, 0);
+    attitude(in, 0.2f, 0, 0);
+    attitude(in, 0.3f, 0, 0);
+
+    MAVLinkFramer framer(testCrcExtra);
+    MAVLinkTelemetry tlm(testFlightMode);
+    framer.append(in.data(), in.size());
+    framer.process(0, [&](const uint8_t *data, uint16_t len) { tlm.translate(data, len); });
+    TEST_ASSERT_EQUAL(4, tlm.framesTranslated);
+    TEST_ASSERT_EQUAL(2, tlm.crsfSuperseded);
+
+    // Only room for the attitude, the flight mode waits for the next flush
+    uint8_t buf[MAVLINK_TLM_MAX_ENTRIES * MAVLINK_TLM_MAX_CRSF_LEN];
+    uint16_t len = tlm.flush(buf, CRSF_FRAME_NOT_COUNTED_BYTES + CRSF_FRAME_SIZE(sizeof(crsf_sensor_attitude_t)));
+    vector<uint8_t> crsf(buf, buf + len);
+    const crsf_sensor_attitude_t *att = (const crsf_sensor_attitude_t *)findCrsf(crsf, CRSF_FRAMETYPE_ATTITUDE);
+    TEST_ASSERT_NOT_NULL(att);
+    TEST_ASSERT_EQUAL(3000, (int16_t)htobe16(att->roll));
+    TEST_ASSERT_NULL(findCrsf(crsf, CRSF_FRAMETYPE_FLIGHT_MODE));
+
+    len = tlm.flush(buf, sizeof(buf));
+    crsf.assign(buf, buf + len);
+    TEST_ASSERT_NOT_NULL(findCrsf(crsf, CRSF_FRAMETYPE_FLIGHT_MODE));
+    TEST_ASSERT_NULL(findCrsf(crsf, CRSF_FRAMETYPE_ATTITUDE));
+}
+
+/**
+ * An ArduPilot telemetry stream at typical SRx_ rates, split into the
+ * payloads the TX gets from the downlink
+ */
+static vector<vector<uint8_t>> arduPilotStream(unsigned seconds, size_t &total)
+{
+    srand(42);
+    vector<uint8_t> all;
+    for (uint32_t ms = 0; ms < seconds * 1000; ms += 10)
+    {
+        if (ms % 1000 == 0)
+        {
+            heartbeat(all, 5, 2, 0x81);
+            batteryStatus(all, 0, 12000 + rand() % 600, rand() % 3000, ms / 100, 80);
+            uint8_t p[31];
+            for (auto &b : p)
+                b = rand() | 1;
+            appendFrame(all, MSG_SYS_STATUS, p);
+        }
+        if (ms % 100 == 0)
+            attitude(all, (rand() % 100) / 100.0f, (rand() % 100) / 100.0f, (rand() % 600) / 100.0f);
+        if (ms % 200 == 0)
+            globalPositionInt(all, rand() % 100000, rand() % 500 - 250);
+        if (ms % 500 == 0)
+            gpsRawInt(all, 473977418 + rand() % 1000, 85455939 + rand() % 1000, 500000, rand() % 2000, rand() % 36000, 12);
+    }
+
+    total = all.size();
+    vector<vector<uint8_t>> chunks;
+    for (size_t pos = 0; pos < all.size(); pos += CRSF_PAYLOAD_SIZE_MAX)
+        chunks.push_back(vector<uint8_t>(all.begin() + pos, all.begin() + min(all.size(), pos + CRSF_PAYLOAD_SIZE_MAX)));
+    return chunks;
+}
+
+void test_stream(void)
+{
+    size_t total;
+    auto chunks = arduPilotStream(60, total);
+
+    MAVLinkFramer framer(testCrcExtra);
+    MAVLinkTelemetry tlm(testFlightMode);
+    uint32_t frames = 0;
+    uint32_t batches = 0;
+    for (const auto &c : chunks)
+    {
+        framer.append(c.data(), c.size());
+        framer.process(0, [&](const uint8_t *data, uint16_t len) { tlm.translate(data, len); });
+        uint8_t buf[MAVLINK_TLM_MAX_ENTRIES * MAVLINK_TLM_MAX_CRSF_LEN];
+        uint16_t len = tlm.flush(buf, sizeof(buf));
+        for (uint16_t pos = 0; pos < len; pos += CRSF_FRAME_SIZE(buf[pos + 1]))
+            ++frames;
+        batches += len ? 1 : 0;
+    }
+    // Every frame converted either went out or was replaced by a newer one
+    TEST_ASSERT_TRUE(frames > 0);
+    TEST_ASSERT_EQUAL(tlm.framesTranslated, tlm.crsfSuperseded + frames);
+    // Several frames to a handset write
+    TEST_ASSERT_TRUE(batches < frames);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_translate_fields);
+    RUN_TEST(test_trimmed_payload);
+    RUN_TEST(test_ignored);
+    RUN_TEST(test_batch_newest_only);
+    RUN_TEST(test_stream);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include <cstdint>
+#include <cmath>
+#include <unity.h>
+#include "MixerSync.h"
+
+#define SYNC_INTERVAL_US 200000 // OpenTXsyncPacketInterval
+
+struct result_t {
+    double ageUs;   // average stick age at transmit
+    double late;    // fraction of RF packets without a new RC packet
+    uint16_t marginUs;
+};
+
+static uint32_t seed = 1;
+static double uniform()
+{
+    seed = seed * 1103515245 + 12345;
+    return ((seed >> 8) & 0xffff) / 65536.0;
+}
+
+/**
+ * A handset sending RC packets at the packet interval with UART jitter on each one, which
+ * shifts its mixer by half of the offset in each sync packet, against the RF packets going
+ * out on the packet interval. spikeEvery adds a long delay to one in that many packets.
+ */
+static result_t simulate(int32_t intervalUs, uint32_t jitterUs, uint32_t spikeEvery)
+{
+    seed = 1;
+    MixerSync sync;
+    sync.reset(intervalUs);
+
+    double phase = intervalUs / 3.0; // where in the RF interval the handset starts
+    double lastArrival = -1e9;
+    double nextArrival = phase;
+    uint32_t nextSync = SYNC_INTERVAL_US;
+    uint32_t k = 0;
+
+    double ageSum = 0;
+    uint32_t late = 0, count = 0;
+    uint32_t const packets = 20000000 / intervalUs; // 20 seconds
+    for (uint32_t n = 1; n <= packets; n++)
+    {
+        double const sendUs = (double)n * intervalUs;
+        while (nextArrival <= sendUs)
+        {
+            lastArrival = nextArrival;
+            ++k;
+            double jitter = uniform() * jitterUs;
+            if (spikeEvery && k % spikeEvery == 0)
+                jitter += intervalUs / 4.0;
+            nextArrival = phase + (double)k * intervalUs + jitter;
+        }
+        int32_t const delta = (int32_t)(sendUs - lastArrival);
+        bool const resync = sync.update(delta);
+
+        // Skip the first few seconds while the handset is pulled in
+        if (n > packets / 4)
+        {
+            ageSum += delta;
+            late += delta >= intervalUs;
+            ++count;
+        }
+
+        if (resync || sendUs >= nextSync)
+        {
+            int32_t const offset = sync.getOffset();
+            // The handset delays its packets by the offset, so they arrive margin before the send
+            phase += offset / 10.0 / 2;
+            nextArrival += offset / 10.0 / 2;
+            nextSync = (uint32_t)sendUs + SYNC_INTERVAL_US;
+        }
+    }
+    result_t r;
+    r.ageUs = ageSum / count;
+    r.late = late / (double)count;
+    r.marginUs = sync.getMarginUs();
+    return r;
+}
+
+void test_histogram(void)
+{
+    MixerSyncHistogram h;
+    h.reset(10);
+    TEST_ASSERT_EQUAL(0, h.percentile(99));
+    for (uint32_t i = 0; i < 100; i++)
+        h.add(i);
+    TEST_ASSERT_EQUAL(50, h.percentile(50));
+    TEST_ASSERT_EQUAL(100, h.percentile(99));
+    // Saturates in the last bin
+    h.add(100000);
+    TEST_ASSERT_EQUAL(MIXER_SYNC_BINS * 10, h.percentile(100));
+
+    // Decays rather than growing without limit
+    for (uint32_t i = 0; i < 5000; i++)
+        h.add(5);
+    TEST_ASSERT_TRUE(h.getCount() < MIXER_SYNC_DECAY_COUNT);
+    TEST_ASSERT_EQUAL(10, h.percentile(99));
+}
+
+void test_offset(void)
+{
+    // A steady handset, the offset is the average delta less the default margin until there is enough jitter data
+    MixerSync sync;
+    sync.reset(4000);
+    for (uint8_t i = 0; i < 10; i++)
+        TEST_ASSERT_FALSE(sync.update(1500));
+    TEST_ASSERT_EQUAL(15000 - MIXER_SYNC_DEFAULT_MARGIN_US * 10, sync.getOffset());
+
+    for (uint16_t i = 0; i < MIXER_SYNC_MIN_SAMPLES; i++)
+        sync.update(1500);
+    TEST_ASSERT_EQUAL(MIXER_SYNC_MIN_MARGIN_US, sync.getMarginUs());
+
+    // A missed packet resyncs
+    TEST_ASSERT_TRUE(sync.update(4100));
+    TEST_ASSERT_EQUAL(-1000, sync.getOffset() + sync.getMarginUs() * 10);
+    TEST_ASSERT_EQUAL(1, sync.getLateCount());
+}
+
+void test_traces(void)
+{
+    static const int32_t intervals[] = {4000, 2000, 1000};
+    static const uint32_t jitters[] = {10, 60, 250};
+    for (int32_t interval : intervals)
+    {
+        for (uint32_t jitter : jitters)
+        {
+            result_t const r = simulate(interval, jitter, 0);
+            // Hardly ever late, and the margin follows the jitter rather than a fixed 100us
+            TEST_ASSERT_TRUE(r.late < 0.001);
+            TEST_ASSERT_TRUE(r.marginUs >= jitter / 2);
+            if (jitter < 100)
+                TEST_ASSERT_TRUE(r.ageUs < 60);
+            else
+                TEST_ASSERT_TRUE(r.ageUs < 170);
+        }
+    }
+
+    // One in fifty packets held up by a quarter of the interval
+    result_t const r = simulate(2000, 20, 50);
+    TEST_ASSERT_TRUE(r.late < 0.005);
+}
+
+void test_age_report(void)
+{
+    MixerSync sync;
+    sync.reset(2000);
+    for (uint16_t i = 0; i < 1000; i++)
+        sync.update(300 + (i % 10) * 10);
+    // 125us bins
+    TEST_ASSERT_EQUAL(375, sync.getAgePercentileUs(50));
+    TEST_ASSERT_EQUAL(500, sync.getAgePercentileUs(99));
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_histogram);
+    RUN_TEST(test_offset);
+    RUN_TEST(test_traces);
+    RUN_TEST(test_age_report);
+    UNITY_END();
+
+    return 0;
+}
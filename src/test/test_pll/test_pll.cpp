@@ -0,0 +1,365 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <unity.h>
+#include "targets.h"
+#include "PLL.h"
+
+// Simulation of the RX timer tracking the TX packet timing. The TX packet period
+// is off by the crystal drift, packets arrive with some timing jitter and can be lost.
+// The RX timer runs at the nominal interval plus the frequency offset on each half
+// period, plus the phase shift, and the PFD measures the arrival vs the RX timer.
+
+struct SimResult
+{
+    int lockPacket;      // first packet index after which the phase error stayed within the lock window
+    double meanAbsError; // mean absolute phase error after the first quarter of the simulation
+    double maxAbsError;  // max absolute phase error after the first quarter of the simulation
+};
+
+struct SimParams
+{
+    uint32_t interval;
+    double driftPpm;
+    double driftPpmStep;    // drift after the temperature change at stepPacket
+    int stepPacket;
+    int jitterUs;           // +/- uniform packet arrival jitter
+    int lossPercent;        // random packet loss
+    int fadeStart;          // consecutive loss (fade) start
+    int fadeLen;
+    int packets;
+    int initialOffset;      // initial phase offset after the first sync
+};
+
+static const int LOCK_WINDOW = 5;
+static const int LOCK_HOLD = 100;
+
+// ticksPerUs is the resolution of the RX timer frequency offset, 5 on the ESP32 and ESP8266 RX
+static SimResult simulate(SimParams const &p, uint8_t ticksPerUs = 1)
+{
+    srand(1234);
+    PLL pll(ticksPerUs);
+    pll.reset(false);
+
+    double txTime = p.initialOffset;
+    double rxTime = 0;
+    int32_t freqOffset = 0;
+    int lockPacket = -1;
+    int inWindow = 0;
+    double sumAbs = 0;
+    double maxAbs = 0;
+    int samples = 0;
+
+    for (int n = 0; n < p.packets; ++n)
+    {
+        double ppm = (p.stepPacket && n >= p.stepPacket) ? p.driftPpmStep : p.driftPpm;
+        txTime += p.interval * (1.0 + ppm / 1e6);
+
+        // RX timer: two half periods with the frequency offset applied to each
+        rxTime += p.interval + 2.0 * freqOffset / ticksPerUs;
+
+        double trueError = txTime - rxTime;
+        bool lost = (rand() % 100) < p.lossPercent
+            || (n >= p.fadeStart && n < p.fadeStart + p.fadeLen);
+
+        int32_t shift = 0;
+        if (!lost)
+        {
+            int32_t jitter = p.jitterUs ? (rand() % (2 * p.jitterUs + 1)) - p.jitterUs : 0;
+            int32_t measured = (int32_t)lround(trueError) + jitter;
+            shift = pll.update(measured, false);
+        }
+        freqOffset = pll.nextFreqOffset();
+        rxTime += shift;
+
+        double absErr = fabs(trueError);
+        if (lockPacket < 0)
+        {
+            inWindow = (absErr <= LOCK_WINDOW) ? inWindow + 1 : 0;
+            if (inWindow >= LOCK_HOLD)
+                lockPacket = n - LOCK_HOLD;
+        }
+        if (n >= p.packets / 4)
+        {
+            sumAbs += absErr;
+            maxAbs = std::max(maxAbs, absErr);
+            ++samples;
+        }
+    }
+
+    SimResult r;
+    r.lockPacket = lockPacket;
+    r.meanAbsError = samples ? sumAbs / samples : 0;
+    r.maxAbsError = maxAbs;
+    return r;
+}
+
+void test_pll_fractional_drift_1000hz(void)
+{
+    // 40ppm at 1000Hz is 0.04us per packet, much less than one timer unit
+    SimParams p = { 1000, 40.0, 0, 0, 2, 5, 0, 0, 20000, 40 };
+    SimResult r = simulate(p);
+
+    TEST_ASSERT_NOT_EQUAL(-1, r.lockPacket);
+    TEST_ASSERT_LESS_THAN(100, r.lockPacket);
+    TEST_ASSERT_TRUE(r.meanAbsError <= 2);
+    TEST_ASSERT_TRUE(r.maxAbsError <= LOCK_WINDOW + 2);
+}
+
+void test_pll_drift_50hz_loss(void)
+{
+    // 50ppm at 50Hz is 1us per packet, more than a +/-1 step per period can follow
+    SimParams p = { 20000, -50.0, 0, 0, 2, 20, 0, 0, 5000, 200 };
+    SimResult r = simulate(p);
+
+    TEST_ASSERT_NOT_EQUAL(-1, r.lockPacket);
+    TEST_ASSERT_LESS_THAN(100, r.lockPacket);
+    TEST_ASSERT_TRUE(r.meanAbsError <= 2);
+    TEST_ASSERT_TRUE(r.maxAbsError <= LOCK_WINDOW);
+}
+
+void test_pll_temperature_step(void)
+{
+    // Drift changes from +10 to +60ppm after lock, the integrator must follow
+    SimParams p = { 4000, 10.0, 60.0, 2000, 1, 5, 0, 0, 6000, 20 };
+    SimResult r = simulate(p);
+
+    TEST_ASSERT_NOT_EQUAL(-1, r.lockPacket);
+    TEST_ASSERT_TRUE(r.meanAbsError <= 2);
+    TEST_ASSERT_TRUE(r.maxAbsError <= LOCK_WINDOW);
+}
+
+void test_pll_holds_drift_through_fade(void)
+{
+    // A 100 packet fade at 50Hz with 50ppm drift would be 100us without drift compensation
+    SimParams p = { 20000, 50.0, 0, 0, 1, 0, 2000, 100, 4000, 20 };
+    SimResult r = simulate(p);
+
+    TEST_ASSERT_NOT_EQUAL(-1, r.lockPacket);
+    TEST_ASSERT_TRUE(r.maxAbsError <= LOCK_WINDOW * 2);
+}
+
+void test_pll_tick_rate(void)
+{
+    // The same loop on a timer with 5 ticks per us, the bounds are the ones at 1 tick per us
+    SimParams fractional = { 1000, 40.0, 0, 0, 2, 5, 0, 0, 20000, 40 };
+    SimResult r = simulate(fractional, 5);
+    TEST_ASSERT_NOT_EQUAL(-1, r.lockPacket);
+    TEST_ASSERT_LESS_THAN(100, r.lockPacket);
+    TEST_ASSERT_TRUE(r.meanAbsError <= 2);
+    TEST_ASSERT_TRUE(r.maxAbsError <= LOCK_WINDOW + 2);
+
+    SimParams step = { 4000, 10.0, 60.0, 2000, 1, 5, 0, 0, 6000, 20 };
+    r = simulate(step, 5);
+    TEST_ASSERT_NOT_EQUAL(-1, r.lockPacket);
+    TEST_ASSERT_TRUE(r.meanAbsError <= 2);
+    TEST_ASSERT_TRUE(r.maxAbsError <= LOCK_WINDOW);
+
+    // 200ppm at 50Hz is 2us per half period, which the integrator has to make up
+    SimParams fast = { 20000, 200.0, 0, 0, 2, 5, 0, 0, 5000, 20 };
+    r = simulate(fast, 5);
+    TEST_ASSERT_NOT_EQUAL(-1, r.lockPacket);
+    TEST_ASSERT_LESS_THAN(20, r.lockPacket);
+    TEST_ASSERT_TRUE(r.meanAbsError <= 2);
+    TEST_ASSERT_TRUE(r.maxAbsError <= LOCK_WINDOW);
+
+    // The drift estimate is in us whatever the timer, only the offset is in ticks
+    PLL pll1, pll5(5);
+    pll1.setInterval(1000);
+    pll5.setInterval(1000);
+    pll1.update(3, false);
+    pll5.update(3, false);
+    TEST_ASSERT_EQUAL(pll1.getDrift(), pll5.getDrift());
+    int32_t sum = 0;
+    for (int i = 0; i < 256; ++i)
+    {
+        pll5.update(0, false);
+        sum += pll5.nextFreqOffset();
+    }
+    // 12/256 us per period is 60/256 ticks
+    TEST_ASSERT_EQUAL(60, sum);
+}
+
+void test_pll_keep_drift_on_reset(void)
+{
+    PLL pll;
+    pll.setInterval(1000);
+    for (int i = 0; i < 100; ++i)
+        pll.update(10, false);
+    for (int i = 0; i < 500; ++i)
+        pll.update(0, false);
+    int32_t drift = pll.getDrift();
+    TEST_ASSERT_NOT_EQUAL(0, drift);
+
+    // The averaged drift is kept, which has converged on the constant input
+    pll.reset(true);
+    TEST_ASSERT_INT_WITHIN(PLL_KI * 4, drift, pll.getDrift());
+    drift = pll.getDrift();
+    TEST_ASSERT_EQUAL(0, pll.getLockQuality());
+
+    // Drift is per period so scales with the interval
+    pll.setInterval(2000);
+    TEST_ASSERT_EQUAL(drift * 2, pll.getDrift());
+
+    pll.reset(false);
+    TEST_ASSERT_EQUAL(0, pll.getDrift());
+}
+
+void test_pll_acquire_does_not_integrate(void)
+{
+    PLL pll;
+    pll.setInterval(1000);
+    TEST_ASSERT_EQUAL(100, pll.update(200, true));
+    TEST_ASSERT_EQUAL(0, pll.getDrift());
+    TEST_ASSERT_EQUAL(50, pll.update(200, false));
+    TEST_ASSERT_EQUAL(PLL_MAX_INTEGRATED_ERROR * PLL_KI, pll.getDrift());
+}
+
+void test_pll_lock_quality(void)
+{
+    PLL pll;
+    pll.reset(false);
+    TEST_ASSERT_EQUAL(0, pll.getLockQuality());
+    for (int i = 0; i < 100; ++i)
+        pll.update(0, false);
+    TEST_ASSERT_EQUAL(100, pll.getLockQuality());
+    for (int i = 0; i < 100; ++i)
+        pll.update((i & 1) ? 10 : -10, false);
+    TEST_ASSERT_INT_WITHIN(2, 80, pll.getLockQuality());
+}
+
+void test_pll_dither(void)
+{
+    PLL pll;
+    pll.setInterval(1000);
+    // 3 * 4 = 12/256 units per period
+    pll.update(3, false);
+    int32_t sum = 0;
+    for (int i = 0; i < 256; ++i)
+    {
+        pll.update(0, false);
+        int32_t offset = pll.nextFreqOffset();
+        TEST_ASSERT_TRUE(offset == 0 || offset == 1);
+        sum += offset;
+    }
+    TEST_ASSERT_EQUAL(12, sum);
+}
+
+// Fade-to-reconnect simulation. The TX keeps sending and hopping through a fade, when the
+// fade ends the RX resumes on the first packet received in step if it is still coasting.
+struct FadeParams
+{
+    uint32_t interval;
+    uint8_t hopInterval;
+    double driftPpm;
+    uint32_t disconnectTimeoutMs;
+    uint32_t coastTimeoutMs;
+};
+
+// Returns the time from the end of the fade to reconnect, or 0 if the coast window was missed
+static uint32_t coastReconnectUs(FadeParams const &p, uint32_t fadeUs, int32_t *phaseAtReconnect)
+{
+    srand(4321);
+    PLL pll;
+    pll.reset(false);
+    pll.setInterval(p.interval);
+
+    double txTime = 0;
+    double rxTime = 0;
+    int32_t freqOffset = 0;
+    uint32_t const lockPackets = 2000;
+    uint32_t const fadePackets = fadeUs / p.interval;
+
+    for (uint32_t n = 0; ; ++n)
+    {
+        txTime += p.interval * (1.0 + p.driftPpm / 1e6);
+        rxTime += p.interval + 2 * freqOffset;
+        bool inFade = n >= lockPackets && n < lockPackets + fadePackets;
+        // Start coasting once the disconnect timeout passes
+        if (n == lockPackets + p.disconnectTimeoutMs * 1000 / p.interval)
+            pll.reset(true);
+
+        if (!inFade)
+        {
+            int32_t err = (int32_t)lround(txTime - rxTime) + (rand() % 3) - 1;
+            if (n >= lockPackets)
+            {
+                // First packet after the fade
+                uint32_t elapsedMs = (fadePackets + 1) * p.interval / 1000;
+                if (elapsedMs > p.disconnectTimeoutMs + p.coastTimeoutMs)
+                    return 0;
+                *phaseAtReconnect = pll.wrapPhase(err);
+                if ((uint32_t)abs(*phaseAtReconnect) > pll.getCoastWindow(elapsedMs))
+                    return 0;
+                return (n - lockPackets + 1) * p.interval - fadePackets * p.interval;
+            }
+            rxTime += pll.update(err, false);
+        }
+        freqOffset = pll.nextFreqOffset();
+    }
+}
+
+void test_coast_fade_reconnect(void)
+{
+    FadeParams p = { 4000, 4, 40.0, 2500, 5000 };
+    const uint32_t fades[] = { 3000, 5000, 7000 };
+
+    for (unsigned i = 0; i < sizeof(fades) / sizeof(fades[0]); ++i)
+    {
+        int32_t phase = 0;
+        uint32_t fadeUs = fades[i] * 1000;
+        uint32_t coast = coastReconnectUs(p, fadeUs, &phase);
+
+        // On the first packet after the fade
+        TEST_ASSERT_NOT_EQUAL(0, coast);
+        TEST_ASSERT_LESS_OR_EQUAL(p.interval, coast);
+    }
+}
+
+void test_coast_window_expires(void)
+{
+    FadeParams p = { 4000, 4, 40.0, 2500, 5000 };
+    int32_t phase = 0;
+    TEST_ASSERT_EQUAL(0, coastReconnectUs(p, 8000 * 1000, &phase));
+}
+
+void test_coast_window(void)
+{
+    PLL pll;
+    pll.setInterval(1000);
+    for (int i = 0; i < 100; ++i)
+        pll.update(0, false);
+    TEST_ASSERT_EQUAL(PLL_COAST_MIN_WINDOW, pll.getCoastWindow(0));
+    TEST_ASSERT_EQUAL(PLL_COAST_MIN_WINDOW + PLL_COAST_RESIDUAL_PPM, pll.getCoastWindow(1000));
+    // Limited to a quarter interval
+    TEST_ASSERT_EQUAL(250, pll.getCoastWindow(100000));
+
+    TEST_ASSERT_EQUAL(10, pll.wrapPhase(1010));
+    TEST_ASSERT_EQUAL(-10, pll.wrapPhase(990));
+    TEST_ASSERT_EQUAL(-10, pll.wrapPhase(-10));
+    TEST_ASSERT_EQUAL(-500, pll.wrapPhase(500));
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_pll_fractional_drift_1000hz);
+    RUN_TEST(test_pll_drift_50hz_loss);
+    RUN_TEST(test_pll_temperature_step);
+    RUN_TEST(test_pll_holds_drift_through_fade);
+    RUN_TEST(test_pll_tick_rate);
+    RUN_TEST(test_pll_keep_drift_on_reset);
+    RUN_TEST(test_pll_acquire_does_not_integrate);
+    RUN_TEST(test_pll_lock_quality);
+    RUN_TEST(test_pll_dither);
+    RUN_TEST(test_coast_fade_reconnect);
+    RUN_TEST(test_coast_window_expires);
+    RUN_TEST(test_coast_window);
+    UNITY_END();
+
+    return 0;
+}
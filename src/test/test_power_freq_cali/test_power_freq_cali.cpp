@@ -0,0 +1,111 @@
+#include <cstdint>
+#include <cmath>
+#include <SX1280_Regs.h>
+#include <FHSS.h>
+#include <POWERMGNT.h>
+#include <unity.h>
+
+#define FREQ_COUNT FHSSconfig->freq_count
+#define TARGET_DBM 20.0 // every hop needs to be at least this
+
+// A PA whose gain droops towards the top of the band, dB at each channel
+static double paGain(uint32_t channel)
+{
+    double const x = channel / (double)(FREQ_COUNT - 1);
+    return 1.0 - 4.0 * x * x + 0.5 * sin(x * 20);
+}
+
+static void buildSequence()
+{
+    FHSSrandomiseFHSSsequence(0x01020304L);
+}
+
+void test_segment(void)
+{
+    buildSequence();
+    TEST_ASSERT_EQUAL(0, powerFreqCaliSegment(0, FREQ_COUNT));
+    TEST_ASSERT_EQUAL(0, powerFreqCaliSegment(9, 80));
+    TEST_ASSERT_EQUAL(1, powerFreqCaliSegment(10, 80));
+    TEST_ASSERT_EQUAL(POWER_FREQ_CALI_SEGMENTS - 1, powerFreqCaliSegment(FREQ_COUNT - 1, FREQ_COUNT));
+    // Uneven counts still cover every segment
+    TEST_ASSERT_EQUAL(POWER_FREQ_CALI_SEGMENTS - 1, powerFreqCaliSegment(39, 40));
+    TEST_ASSERT_EQUAL(POWER_FREQ_CALI_SEGMENTS - 1, powerFreqCaliSegment(19, 20));
+}
+
+void test_build(void)
+{
+    buildSequence();
+    static const int8_t segments[POWER_FREQ_CALI_SEGMENTS] = {-2, -1, 0, 1, 2, 3, 4, -5};
+    int8_t hopCali[FHSS_SEQUENCE_LEN];
+    powerFreqCaliBuild(hopCali, segments, FHSSsequence, primaryBandCount, FREQ_COUNT);
+    for (uint16_t i = 0; i < primaryBandCount; i++)
+    {
+        int8_t expected = segments[FHSSsequence[i] * POWER_FREQ_CALI_SEGMENTS / FREQ_COUNT];
+        // Capped
+        if (expected > POWER_FREQ_CALI_MAX)
+            expected = POWER_FREQ_CALI_MAX;
+        if (expected < -POWER_FREQ_CALI_MAX)
+            expected = -POWER_FREQ_CALI_MAX;
+        TEST_ASSERT_EQUAL(expected, hopCali[i]);
+    }
+}
+
+void test_less_power(void)
+{
+    buildSequence();
+
+    // Calibrate the way power_cal_sweep.py does, from the channel in the middle of each segment
+    double readings[POWER_FREQ_CALI_SEGMENTS];
+    double mean = 0;
+    for (uint8_t s = 0; s < POWER_FREQ_CALI_SEGMENTS; s++)
+    {
+        uint32_t const channel = (s * 2 + 1) * FREQ_COUNT / (POWER_FREQ_CALI_SEGMENTS * 2);
+        TEST_ASSERT_EQUAL(s, powerFreqCaliSegment(channel, FREQ_COUNT));
+        readings[s] = paGain(channel);
+        mean += readings[s] / POWER_FREQ_CALI_SEGMENTS;
+    }
+    int8_t segments[POWER_FREQ_CALI_SEGMENTS];
+    for (uint8_t s = 0; s < POWER_FREQ_CALI_SEGMENTS; s++)
+    {
+        segments[s] = (int8_t)lround(mean - readings[s]);
+    }
+    int8_t hopCali[FHSS_SEQUENCE_LEN];
+    powerFreqCaliBuild(hopCali, segments, FHSSsequence, primaryBandCount, FREQ_COUNT);
+
+    // The drive needed for the weakest hop to reach the target, and the average power it then puts out
+    double flatMin = 1e9, corrMin = 1e9;
+    for (uint16_t i = 0; i < primaryBandCount; i++)
+    {
+        flatMin = fmin(flatMin, paGain(FHSSsequence[i]));
+        corrMin = fmin(corrMin, paGain(FHSSsequence[i]) + hopCali[i]);
+    }
+    double flatMw = 0, corrMw = 0, flatSpread[2] = {1e9, -1e9}, corrSpread[2] = {1e9, -1e9};
+    for (uint16_t i = 0; i < primaryBandCount; i++)
+    {
+        double const flat = TARGET_DBM - flatMin + paGain(FHSSsequence[i]);
+        double const corr = TARGET_DBM - corrMin + paGain(FHSSsequence[i]) + hopCali[i];
+        flatMw += pow(10, flat / 10) / primaryBandCount;
+        corrMw += pow(10, corr / 10) / primaryBandCount;
+        flatSpread[0] = fmin(flatSpread[0], flat);
+        flatSpread[1] = fmax(flatSpread[1], flat);
+        corrSpread[0] = fmin(corrSpread[0], corr);
+        corrSpread[1] = fmax(corrSpread[1], corr);
+    }
+    TEST_ASSERT_TRUE(corrSpread[1] - corrSpread[0] < flatSpread[1] - flatSpread[0]);
+    TEST_ASSERT_TRUE(corrMw < flatMw);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_segment);
+    RUN_TEST(test_build);
+    RUN_TEST(test_less_power);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include <cstdint>
+#include <cstring>
+#include <unity.h>
+#include "screenDiff.h"
+#include "monoFramebuffer.h"
+
+typedef MonoFramebuffer<128, 64> Framebuffer;
+typedef MonoPanel<128, 64> Panel;
+
+// Stand in for a font, every character is 6 columns with a bit pattern made from its code
+static void drawText(Framebuffer &fb, int x, int y, const char *str)
+{
+    for (; *str; ++str, x += 6)
+    {
+        for (int col = 0; col < 5; ++col)
+        {
+            uint8_t bits = (uint8_t)(*str * (col + 3) * 37) | 0x01;
+            for (int row = 0; row < 8; ++row)
+                fb.setPixel(x + col, y + row, (bits >> row) & 1);
+        }
+    }
+}
+
+static unsigned flushTo(TileShadow<16, 8> &shadow, const Framebuffer &fb, Panel &panel)
+{
+    return shadow.flush(fb.getBufferPtr(), [&](uint8_t tx, uint8_t ty, uint8_t tw) {
+        panel.updateArea(fb, tx, ty, tw);
+    });
+}
+
+void test_first_flush_sends_everything(void)
+{
+    Framebuffer fb;
+    Panel panel;
+    TileShadow<16, 8> shadow;
+    shadow.begin(Framebuffer::tilesX, Framebuffer::tilesY);
+
+    TEST_ASSERT_EQUAL(128, flushTo(shadow, fb, panel));
+    TEST_ASSERT_EQUAL(8, shadow.runsSent);
+    TEST_ASSERT_EQUAL(8 * (Panel::commandBytesPerRun + 128), panel.bytesSent);
+
+    // Nothing changed, nothing sent
+    TEST_ASSERT_EQUAL(0, flushTo(shadow, fb, panel));
+    TEST_ASSERT_EQUAL(2, shadow.flushes);
+
+    // Unless the panel was cleared behind our back
+    shadow.invalidate();
+    TEST_ASSERT_EQUAL(128, flushTo(shadow, fb, panel));
+}
+
+void test_only_changed_tiles_are_sent(void)
+{
+    Framebuffer fb;
+    Panel panel;
+    TileShadow<16, 8> shadow;
+    shadow.begin(Framebuffer::tilesX, Framebuffer::tilesY);
+    flushTo(shadow, fb, panel);
+
+    // A single pixel is one tile
+    fb.setPixel(20, 20, true);
+    TEST_ASSERT_EQUAL(1, flushTo(shadow, fb, panel));
+    TEST_ASSERT_TRUE(panel.panel.getPixel(20, 20));
+
+    // Two separate areas on the same row are two runs
+    uint32_t runs = shadow.runsSent;
+    fb.fillRect(0, 40, 16, 4, true);
+    fb.fillRect(104, 40, 8, 4, true);
+    TEST_ASSERT_EQUAL(3, flushTo(shadow, fb, panel));
+    TEST_ASSERT_EQUAL(runs + 2, shadow.runsSent);
+
+    // Crossing a page boundary touches two tile rows
+    fb.fillRect(64, 6, 4, 4, true);
+    TEST_ASSERT_EQUAL(2, flushTo(shadow, fb, panel));
+
+    TEST_ASSERT_EQUAL_MEMORY(fb.getBufferPtr(), panel.panel.getBufferPtr(), Framebuffer::size);
+}
+
+void test_small_panel(void)
+{
+    // 128x32 panel in a shadow sized for 128x64
+    MonoFramebuffer<128, 32> fb;
+    MonoPanel<128, 32> panel;
+    TileShadow<16, 8> shadow;
+    shadow.begin(fb.tilesX, fb.tilesY);
+    auto send = [&](uint8_t tx, uint8_t ty, uint8_t tw) { panel.updateArea(fb, tx, ty, tw); };
+
+    TEST_ASSERT_EQUAL(64, shadow.flush(fb.getBufferPtr(), send));
+    fb.fillRect(120, 24, 8, 8, true);
+    TEST_ASSERT_EQUAL(1, shadow.flush(fb.getBufferPtr(), send));
+    TEST_ASSERT_EQUAL_MEMORY(fb.getBufferPtr(), panel.panel.getBufferPtr(), fb.size);
+}
+
+void test_snapshot(void)
+{
+    static const uint8_t arrow[] = {
+        0x08, 0x0c, 0xfe, 0x0c, 0x08
+    };
+    MonoFramebuffer<16, 8> fb;
+    fb.drawXBM(4, 1, 8, 5, arrow);
+    fb.setPixel(0, 7, true);
+    fb.setPixel(15, 0, true);
+
+    char out[200];
+    size_t len = fb.snapshot(out, sizeof(out), 0, 0, 16, 8);
+    TEST_ASSERT_EQUAL(17 * 8, len);
+    TEST_ASSERT_EQUAL_STRING(
+        "...............#\n"
+        ".......#........\n"
+        "......##........\n"
+        ".....#######....\n"
+        "......##........\n"
+        ".......#........\n"
+        "................\n"
+        "#...............\n",
+        out);
+
+    // Truncated to fit the output
+    len = fb.snapshot(out, 6, 12, 0, 4, 2);
+    TEST_ASSERT_EQUAL(5, len);
+    TEST_ASSERT_EQUAL_STRING("...#\n", out);
+}
+
+void test_retained_text(void)
+{
+    RetainedText<2, 8> regions;
+    TEST_ASSERT_TRUE(regions.update(0, "250Hz", 1, 2));
+    TEST_ASSERT_TRUE(regions.update(1, "1:128", 1, 2));
+    TEST_ASSERT_FALSE(regions.update(0, "250Hz", 1, 2));
+    TEST_ASSERT_FALSE(regions.update(1, "1:128", 1, 2));
+
+    // Text and either colour are content
+    TEST_ASSERT_TRUE(regions.update(0, "500Hz", 1, 2));
+    TEST_ASSERT_TRUE(regions.update(0, "500Hz", 3, 2));
+    TEST_ASSERT_TRUE(regions.update(0, "500Hz", 3, 4));
+    TEST_ASSERT_FALSE(regions.update(0, "500Hz", 3, 4));
+
+    regions.invalidate(1);
+    TEST_ASSERT_FALSE(regions.update(0, "500Hz", 3, 4));
+    TEST_ASSERT_TRUE(regions.update(1, "1:128", 1, 2));
+    regions.invalidate();
+    TEST_ASSERT_TRUE(regions.update(0, "500Hz", 3, 4));
+    TEST_ASSERT_TRUE(regions.update(1, "1:128", 1, 2));
+
+    // Too long to retain, always drawn
+    TEST_ASSERT_TRUE(regions.update(1, "100mW Dynamic", 1, 2));
+    TEST_ASSERT_TRUE(regions.update(1, "100mW Dynamic", 1, 2));
+
+    TEST_ASSERT_EQUAL(10, regions.redraws);
+    TEST_ASSERT_EQUAL(4, regions.skipped);
+}
+
+// Layout of the 128x64 OLED idle screen
+static void drawIdle(Framebuffer &fb, const char *message, const char *rate, const char *ratio, const char *power)
+{
+    fb.clear();
+    drawText(fb, 0, 3, message);
+    drawText(fb, 0, 19, "Ver: 3.4.0");
+    drawText(fb, 0, 35, rate);
+    drawText(fb, 70, 35, ratio);
+    drawText(fb, 70, 48, "TLM");
+    drawText(fb, 0, 50, power);
+}
+
+void test_idle_redraw_cost(void)
+{
+    static const char *const steps[][4] = {
+        {"ExpressLRS", "250Hz", "1:128", "100mW"},
+        {"[  Connected  ]", "250Hz", "1:128", "100mW"},
+        {"[  Connected  ]", "250Hz", "1:128", "25mW *"},
+        {"[  Connected  ]", "250Hz", "1:128", "50mW *"},
+        {"[  ! Armed !  ]", "250Hz", "1:128", "50mW *"},
+        {"[  ! Armed !  ]", "250Hz", "1:128", "100mW *"},
+        {"[  Connected  ]", "250Hz", "1:128", "100mW *"},
+        {"[  Connected  ]", "500Hz", "1:128", "100mW *"},
+        {"[  Connected  ]", "500Hz", "1:64", "100mW *"},
+        {"ExpressLRS", "500Hz", "1:64", "100mW"},
+    };
+
+    Framebuffer fb;
+    Panel full, diffed;
+    TileShadow<16, 8> shadow;
+    shadow.begin(Framebuffer::tilesX, Framebuffer::tilesY);
+    for (const auto &step : steps)
+    {
+        drawIdle(fb, step[0], step[1], step[2], step[3]);
+        full.sendBuffer(fb);
+        flushTo(shadow, fb, diffed);
+        // Both panels always show the same thing
+        TEST_ASSERT_EQUAL_MEMORY(full.panel.getBufferPtr(), diffed.panel.getBufferPtr(), Framebuffer::size);
+    }
+
+    // The first update has to send everything, the rest only a line or two each
+    TEST_ASSERT_LESS_THAN(full.bytesSent / 3, diffed.bytesSent);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_first_flush_sends_everything);
+    RUN_TEST(test_only_changed_tiles_are_sent);
+    RUN_TEST(test_small_panel);
+    RUN_TEST(test_snapshot);
+    RUN_TEST(test_retained_text);
+    RUN_TEST(test_idle_redraw_cost);
+    UNITY_END();
+
+    return 0;
+}
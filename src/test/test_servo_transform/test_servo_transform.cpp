@@ -0,0 +1,124 @@
+#include <cstdint>
+#include <unity.h>
+#include "crsf_protocol.h"
+#include "ServoTransform.h"
+
+void test_matches_crsf_to_us(void)
+{
+    for (uint32_t crsf = 1; crsf < 2048; ++crsf)
+    {
+        uint16_t const us = CRSF_to_US(crsf);
+        int32_t const q16 = ((int32_t)crsf * SERVO_CRSF_TO_US_MUL + SERVO_CRSF_TO_US_ADD);
+        // Below CRSF_CHANNEL_VALUE_MIN fmap() rounds towards zero rather than down
+        if (crsf >= CRSF_CHANNEL_VALUE_MIN)
+            TEST_ASSERT_EQUAL(us, q16 >> 16);
+        else
+            TEST_ASSERT_INT_WITHIN(1, us, q16 >> 16);
+        // Never a whole number, which inversion relies on
+        TEST_ASSERT_NOT_EQUAL(0, q16 & 0xffff);
+    }
+}
+
+typedef struct {
+    eServoOutputMode mode;
+    bool inverted;
+    bool narrow;
+    uint16_t atMin;     // CRSF_CHANNEL_VALUE_MIN, 988us
+    uint16_t atMid;     // CRSF_CHANNEL_VALUE_MID, 1500us
+    uint16_t atMax;     // CRSF_CHANNEL_VALUE_MAX, 2012us
+} transform_case_t;
+
+static const transform_case_t cases[] = {
+    {som50Hz, false, false, 988, 1500, 2012},
+    {som50Hz, true, false, 2012, 1500, 988},
+    {som400Hz, false, true, 494, 750, 1006},
+    {som10KHzDuty, false, false, 0, 500, 1000},
+    {som10KHzDuty, true, false, 1000, 500, 0},
+    {somOnOff, false, false, 0, 0, 1},
+    {somOnOff, true, false, 1, 0, 0},
+    // Clamped to the DShot throttle range rather than wrapping
+    {somDShot, false, false, 48, 1047, 2047},
+    {somDShot, true, false, 2047, 1047, 48},
+};
+
+void test_output_ranges(void)
+{
+    servo_transform_t t;
+    for (const transform_case_t &c : cases)
+    {
+        servoTransformInit(&t, 0, c.inverted, c.mode, c.narrow, PWMFAILSAFE_SET_POSITION, 1500);
+        TEST_ASSERT_EQUAL(c.atMin, servoTransformApply(&t, CRSF_CHANNEL_VALUE_MIN));
+        TEST_ASSERT_EQUAL(c.atMid, servoTransformApply(&t, CRSF_CHANNEL_VALUE_MID));
+        TEST_ASSERT_EQUAL(c.atMax, servoTransformApply(&t, CRSF_CHANNEL_VALUE_MAX));
+
+        // Never steps back across the range
+        uint16_t last = servoTransformApply(&t, CRSF_CHANNEL_VALUE_MIN);
+        for (uint32_t crsf = CRSF_CHANNEL_VALUE_MIN + 1; crsf < 2048; ++crsf)
+        {
+            uint16_t const out = servoTransformApply(&t, crsf);
+            if (c.inverted)
+                TEST_ASSERT_TRUE(out <= last);
+            else
+                TEST_ASSERT_TRUE(out >= last);
+            last = out;
+        }
+    }
+}
+
+void test_failsafe(void)
+{
+    servo_transform_t t;
+    // Set position isn't inverted
+    servoTransformInit(&t, 0, true, som50Hz, false, PWMFAILSAFE_SET_POSITION, 1200);
+    TEST_ASSERT_EQUAL(1200, t.failsafe);
+    servoTransformInit(&t, 0, false, som50Hz, true, PWMFAILSAFE_SET_POSITION, 1200);
+    TEST_ASSERT_EQUAL(600, t.failsafe);
+    servoTransformInit(&t, 0, false, somDShot, false, PWMFAILSAFE_SET_POSITION, 1200);
+    TEST_ASSERT_EQUAL(447, t.failsafe);
+
+    // No pulses is the lowest output of each mode
+    servoTransformInit(&t, 0, false, som50Hz, false, PWMFAILSAFE_NO_PULSES, 1200);
+    TEST_ASSERT_EQUAL(0, t.failsafe);
+    servoTransformInit(&t, 0, false, som10KHzDuty, false, PWMFAILSAFE_NO_PULSES, 1200);
+    TEST_ASSERT_EQUAL(0, t.failsafe);
+    servoTransformInit(&t, 0, false, somOnOff, false, PWMFAILSAFE_NO_PULSES, 1200);
+    TEST_ASSERT_EQUAL(0, t.failsafe);
+    // 0us used to wrap around to full throttle
+    servoTransformInit(&t, 0, false, somDShot, false, PWMFAILSAFE_NO_PULSES, 1200);
+    TEST_ASSERT_EQUAL(48, t.failsafe);
+}
+
+void test_all_outputs(void)
+{
+    servo_transform_t t[4];
+    servoTransformInit(&t[0], 2, false, som50Hz, false, PWMFAILSAFE_SET_POSITION, 1500);
+    servoTransformInit(&t[1], 0, true, som50Hz, false, PWMFAILSAFE_SET_POSITION, 1500);
+    servoTransformInit(&t[2], 5, false, somOnOff, false, PWMFAILSAFE_SET_POSITION, 1500);
+    servoTransformInit(&t[3], 2, false, somDShot, false, PWMFAILSAFE_SET_POSITION, 1500);
+
+    uint32_t channelData[16] = {0};
+    channelData[0] = CRSF_CHANNEL_VALUE_MIN;
+    channelData[2] = CRSF_CHANNEL_VALUE_MAX;
+    uint16_t out[4];
+    // Channel 5 hasn't been received
+    TEST_ASSERT_EQUAL(0b1011, servoTransformAll(t, 4, channelData, out));
+    TEST_ASSERT_EQUAL(2012, out[0]);
+    TEST_ASSERT_EQUAL(3000 - 988, out[1]);
+    TEST_ASSERT_EQUAL(2047, out[3]);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_crsf_to_us);
+    RUN_TEST(test_output_ranges);
+    RUN_TEST(test_failsafe);
+    RUN_TEST(test_all_outputs);
+    UNITY_END();
+
+    return 0;
+}
@@ -20,6 +20,7 @@ void test_stubborn_link_sends_data(void)
     uint8_t data[1];
     uint8_t packageIndex;
     bool confirmValue = true;
+    uint8_t const delivered = sender.GetDeliveredCount();
 
     for(int i = 0; i < sizeof(batterySequence)-1; i++)
     {
@@ -38,8 +39,10 @@ void test_stubborn_link_sends_data(void)
     TEST_ASSERT_EQUAL(true, sender.IsActive());
     sender.ConfirmCurrentPayload(!confirmValue);
     TEST_ASSERT_EQUAL(true, sender.IsActive());
+    TEST_ASSERT_EQUAL(delivered, sender.GetDeliveredCount());
     sender.ConfirmCurrentPayload(confirmValue);
     TEST_ASSERT_EQUAL(false, sender.IsActive());
+    TEST_ASSERT_EQUAL(delivered + 1, sender.GetDeliveredCount());
 }
 
 void test_stubborn_link_sends_data_even_bytes_per_call(void)
@@ -129,8 +132,10 @@ void test_stubborn_link_receives_data(void)
     }
 
     TEST_ASSERT_EQUAL_UINT8_ARRAY(batterySequence, data, sizeof(batterySequence));
+    TEST_ASSERT_EQUAL(sizeof(batterySequence), receiver.GetReceivedLength());
 
     receiver.Unlock();
+    TEST_ASSERT_EQUAL(0, receiver.GetReceivedLength());
 }
 
 void test_stubborn_link_receives_data_with_multiple_bytes(void)
@@ -182,6 +187,7 @@ void test_stubborn_link_resyncs(void)
     receiver.SetDataToReceive(buffer, sizeof(buffer));
 
     // wait for resync to happen
+    uint8_t const delivered = sender.GetDeliveredCount();
     for(int i = 0; i < sender.GetMaxPacketsBeforeResync() + 1; i++)
     {
         packageIndex = sender.GetCurrentPayload(data, 1);
@@ -196,6 +202,8 @@ void test_stubborn_link_resyncs(void)
     receiver.ReceiveData(packageIndex, data, 1);
     sender.ConfirmCurrentPayload(receiver.GetCurrentConfirm());
     TEST_ASSERT_EQUAL(false, sender.IsActive());
+    // Given up on, not delivered
+    TEST_ASSERT_EQUAL(delivered, sender.GetDeliveredCount());
 
     // both are in sync again
     sender.SetDataToTransmit(batterySequence, sizeof(batterySequence));
@@ -237,6 +237,117 @@ void test_function_add_type_with_zero_crc(void)
     }
 }
 
+typedef CRSF_MK_FRAME_T(crsf_sensor_baro_vario_t) baro_frame_t;
+
+static void makeBaro(baro_frame_t &frame, uint16_t altitude)
+{
+    memset(&frame, 0, sizeof(frame));
+    frame.p.altitude = htobe16(altitude);
+    frame.p.verticalspd = htobe16(altitude / 4);
+}
+
+void test_function_sensor_payload_crc(void)
+{
+    telemetry.ResetState();
+    baro_frame_t baro;
+    baro_frame_t expected;
+    makeBaro(baro, 10123);
+    makeBaro(expected, 10123);
+    CRSF::SetHeaderAndCrc((uint8_t *)&expected, CRSF_FRAMETYPE_BARO_ALTITUDE, CRSF_FRAME_SIZE(sizeof(crsf_sensor_baro_vario_t)), CRSF_ADDRESS_CRSF_TRANSMITTER);
+
+    TEST_ASSERT_TRUE(telemetry.AppendSensorPayload((uint8_t *)&baro, CRSF_FRAMETYPE_BARO_ALTITUDE, CRSF_FRAME_SIZE(sizeof(crsf_sensor_baro_vario_t))));
+    TEST_ASSERT_EQUAL(1, telemetry.UpdatedPayloadCount());
+
+    // The same frame as it was before the CRC was left until it is sent
+    uint8_t* data;
+    uint8_t receivedLength;
+    TEST_ASSERT_TRUE(telemetry.GetNextPayload(&receivedLength, &data));
+    TEST_ASSERT_EQUAL(sizeof(expected), receivedLength);
+    TEST_ASSERT_EQUAL_MEMORY(&expected, data, sizeof(expected));
+}
+
+void test_function_merge_while_locked(void)
+{
+    telemetry.ResetState();
+    baro_frame_t baro;
+    baro_frame_t expected;
+    uint8_t const frameSize = CRSF_FRAME_SIZE(sizeof(crsf_sensor_baro_vario_t));
+
+    makeBaro(baro, 10000);
+    telemetry.AppendSensorPayload((uint8_t *)&baro, CRSF_FRAMETYPE_BARO_ALTITUDE, frameSize);
+    uint8_t* data;
+    uint8_t receivedLength;
+    telemetry.GetNextPayload(&receivedLength, &data);
+
+    // Two more while the first is being sent, the one being sent stays as it was
+    makeBaro(baro, 10001);
+    telemetry.AppendSensorPayload((uint8_t *)&baro, CRSF_FRAMETYPE_BARO_ALTITUDE, frameSize);
+    makeBaro(baro, 10002);
+    telemetry.AppendSensorPayload((uint8_t *)&baro, CRSF_FRAMETYPE_BARO_ALTITUDE, frameSize);
+    makeBaro(expected, 10000);
+    CRSF::SetHeaderAndCrc((uint8_t *)&expected, CRSF_FRAMETYPE_BARO_ALTITUDE, frameSize, CRSF_ADDRESS_CRSF_TRANSMITTER);
+    TEST_ASSERT_EQUAL_MEMORY(&expected, data, sizeof(expected));
+
+    // The newest is sent next rather than being lost
+    TEST_ASSERT_TRUE(telemetry.GetNextPayload(&receivedLength, &data));
+    makeBaro(expected, 10002);
+    CRSF::SetHeaderAndCrc((uint8_t *)&expected, CRSF_FRAMETYPE_BARO_ALTITUDE, frameSize, CRSF_ADDRESS_CRSF_TRANSMITTER);
+    TEST_ASSERT_EQUAL_MEMORY(&expected, data, sizeof(expected));
+    TEST_ASSERT_FALSE(telemetry.GetNextPayload(&receivedLength, &data));
+
+    uint32_t updates, sends;
+    TEST_ASSERT_TRUE(telemetry.GetPayloadStats(CRSF_FRAMETYPE_BARO_ALTITUDE, &updates, &sends));
+    TEST_ASSERT_EQUAL(3, updates);
+    TEST_ASSERT_EQUAL(2, sends);
+    TEST_ASSERT_FALSE(telemetry.GetPayloadStats(CRSF_FRAMETYPE_MSP_RESP, &updates, &sends));
+}
+
+void test_function_merge_rate(void)
+{
+    // devBaro gives a frame every 20ms, the link sends one frame every 50ms and has the
+    // battery to send as well
+    telemetry.ResetState();
+    baro_frame_t baro;
+    CRSF_MK_FRAME_T(crsf_sensor_battery_t) batt;
+    uint16_t lastAltitude = 0;
+    uint32_t stale = 0;
+    for (uint32_t ms = 0; ms < 10000; ms += 10)
+    {
+        if (ms % 20 == 0)
+        {
+            makeBaro(baro, 10000 + ms / 20);
+            telemetry.AppendSensorPayload((uint8_t *)&baro, CRSF_FRAMETYPE_BARO_ALTITUDE, CRSF_FRAME_SIZE(sizeof(crsf_sensor_baro_vario_t)));
+        }
+        if (ms % 100 == 0)
+        {
+            memset(&batt, 0, sizeof(batt));
+            batt.p.voltage = htobe16(168);
+            telemetry.AppendSensorPayload((uint8_t *)&batt, CRSF_FRAMETYPE_BATTERY_SENSOR, CRSF_FRAME_SIZE(sizeof(crsf_sensor_battery_t)));
+        }
+        if (ms % 50 == 0)
+        {
+            uint8_t* data;
+            uint8_t receivedLength;
+            if (telemetry.GetNextPayload(&receivedLength, &data) && data[CRSF_TELEMETRY_TYPE_INDEX] == CRSF_FRAMETYPE_BARO_ALTITUDE)
+            {
+                // Every baro frame sent is newer than the last
+                uint16_t const altitude = be16toh(((crsf_sensor_baro_vario_t *)&data[sizeof(crsf_header_t)])->altitude);
+                stale += altitude <= lastAltitude;
+                lastAltitude = altitude;
+            }
+        }
+    }
+
+    uint32_t baroUpdates, baroSends, battUpdates, battSends;
+    telemetry.GetPayloadStats(CRSF_FRAMETYPE_BARO_ALTITUDE, &baroUpdates, &baroSends);
+    telemetry.GetPayloadStats(CRSF_FRAMETYPE_BATTERY_SENSOR, &battUpdates, &battSends);
+    TEST_ASSERT_EQUAL(0, stale);
+    TEST_ASSERT_EQUAL(500, baroUpdates);
+    TEST_ASSERT_EQUAL(100, battUpdates);
+    TEST_ASSERT_TRUE(baroSends + battSends <= 200);
+    TEST_ASSERT_TRUE(baroSends >= 90);
+}
+
 // Unity setup/teardown
 void setUp() {}
 void tearDown() {}
@@ -255,6 +366,9 @@ int main(int argc, char **argv)
     RUN_TEST(test_function_store_unknown_type_two_slots);
     RUN_TEST(test_function_store_ardupilot_status_text);
     RUN_TEST(test_function_add_type_with_zero_crc);
+    RUN_TEST(test_function_sensor_payload_crc);
+    RUN_TEST(test_function_merge_while_locked);
+    RUN_TEST(test_function_merge_rate);
     UNITY_END();
 
     return 0;
@@ -0,0 +1,381 @@
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <unity.h>
+#include "CRSF.h"
+#include "TelemetryDelta.h"
+
+typedef std::vector<uint8_t> frame_t;
+
+typedef struct {
+    uint32_t ms;
+    frame_t frame;
+} sample_t;
+
+#define MSG_SIZE_MAX    (2 * CRSF_MAX_PACKET_LEN)
+#define TLM_INTERVAL_MS 16      // 250Hz at 1:4
+#define FLIGHT_MS       180000
+
+static TelemetryDeltaEncoder encoder;
+static TelemetryDeltaDecoder decoder;
+
+static frame_t makeFrame(crsf_frame_type_e type, const void *payload, uint8_t len)
+{
+    frame_t frame(CRSF_FRAME_NOT_COUNTED_BYTES + CRSF_FRAME_SIZE(len));
+    memcpy(&frame[sizeof(crsf_header_t)], payload, len);
+    CRSF::SetHeaderAndCrc(frame.data(), type, CRSF_FRAME_SIZE(len), CRSF_ADDRESS_CRSF_TRANSMITTER);
+    return frame;
+}
+
+static void put24(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 16;
+    p[1] = v >> 8;
+    p[2] = v;
+}
+
+// A 3 minute flight as the FC sends it: GPS and baro at 10Hz, attitude at 25Hz and
+// the battery at 5Hz, with the sensors' own noise on them
+static std::vector<sample_t> recordFlight()
+{
+    std::vector<sample_t> samples;
+    uint32_t seed = 7;
+    auto noise = [&seed](int32_t amplitude) {
+        seed = seed * 1103515245 + 12345;
+        return (int32_t)((seed >> 16) % (2 * amplitude + 1)) - amplitude;
+    };
+
+    double lat = 47.3977419, lon = 8.5455938, heading = 0, alt = 0, vspd = 0, mah = 0;
+    for (uint32_t ms = 0; ms < FLIGHT_MS; ms += 20)
+    {
+        double const t = ms / 1000.0;
+        double const speed = t < 5 ? t * 3 : 15 + 3 * sin(t / 7);   // m/s
+        double const turn = 0.15 * sin(t / 11);                     // rad/s
+        double const current = 8 + 6 * sin(t / 3) * sin(t / 3);    // A
+
+        if (ms % 40 == 0)
+        {
+            crsf_sensor_attitude_t att;
+            att.pitch = htobe16((int16_t)(-2000 - 1000 * sin(t / 3) + noise(20)));
+            att.roll = htobe16((int16_t)(turn * 30000 + noise(20)));
+            att.yaw = htobe16((int16_t)(fmod(heading, 2 * M_PI) * 10000 - 31416));
+            samples.push_back({ms, makeFrame(CRSF_FRAMETYPE_ATTITUDE, &att, sizeof(att))});
+        }
+
+        if (ms % 100 == 0)
+        {
+            heading += turn * 0.1;
+            lat += speed * 0.1 * cos(heading) / 111320.0;
+            lon += speed * 0.1 * sin(heading) / (111320.0 * cos(lat * M_PI / 180));
+            vspd = t < 20 ? 2.5 : 0.5 * sin(t / 5);
+            alt += vspd * 0.1;
+
+            crsf_sensor_gps_t gps;
+            gps.latitude = htobe32((int32_t)(lat * 1e7));
+            gps.longitude = htobe32((int32_t)(lon * 1e7));
+            gps.groundspeed = htobe16((uint16_t)(speed * 36 + noise(2)));
+            gps.gps_heading = htobe16((uint16_t)(fmod(heading * 180 / M_PI + 360, 360) * 100));
+            gps.altitude = htobe16((uint16_t)(alt + 1000 + 430));
+            gps.satellites_in_use = t < 60 ? 14 : 15;
+            samples.push_back({ms, makeFrame(CRSF_FRAMETYPE_GPS, &gps, sizeof(gps))});
+
+            crsf_sensor_baro_vario_t baro;
+            baro.altitude = htobe16((uint16_t)(alt * 10 + 10000 + noise(1)));
+            baro.verticalspd = htobe16((int16_t)(vspd * 100 + noise(5)));
+            samples.push_back({ms, makeFrame(CRSF_FRAMETYPE_BARO_ALTITUDE, &baro, sizeof(baro))});
+        }
+
+        if (ms % 200 == 0)
+        {
+            mah += current * 0.2 / 3.6;
+            uint8_t batt[8];
+            uint16_t const voltage = 168 - mah / 100 - current / 2 + noise(1);
+            batt[0] = voltage >> 8;
+            batt[1] = voltage;
+            batt[2] = (uint16_t)(current * 10 + noise(3)) >> 8;
+            batt[3] = (uint16_t)(current * 10 + noise(3));
+            put24(&batt[4], (uint32_t)mah);
+            batt[7] = 100 - mah / 22;
+            samples.push_back({ms, makeFrame(CRSF_FRAMETYPE_BATTERY_SENSOR, batt, sizeof(batt))});
+        }
+
+        if (ms % 5000 == 0)
+        {
+            // Not delta encoded
+            crsf_flight_mode_t mode = {"ANGL"};
+            samples.push_back({ms, makeFrame(CRSF_FRAMETYPE_FLIGHT_MODE, &mode, 5)});
+        }
+    }
+    return samples;
+}
+
+// What the TX does with a message from the RX, the frames it passes to the handset
+static std::vector<frame_t> receive(const uint8_t *msg)
+{
+    std::vector<frame_t> frames;
+    uint8_t const end = msg[1] + 2;
+    for (uint8_t pos = TLM_DELTA_MSG_HEADER_LEN; pos + 1 < end; pos += msg[pos + 1] + 2)
+    {
+        frame_t frame(CRSF_FRAME_SIZE_MAX);
+        if (decoder.decode(&msg[pos], frame.data()))
+        {
+            frame.resize(CRSF_FRAME_SIZE(frame[CRSF_TELEMETRY_LENGTH_INDEX]));
+            frames.push_back(frame);
+        }
+    }
+    return frames;
+}
+
+// Telemetry packets the stubborn sender needs for a message, a message which fits in
+// one still needs the next to tell the TX it is done
+static uint32_t packetsFor(uint32_t len)
+{
+    uint32_t const calls = (len + ELRS8_TELEMETRY_BYTES_PER_CALL - 1) / ELRS8_TELEMETRY_BYTES_PER_CALL;
+    return calls < 2 ? 2 : calls;
+}
+
+void setUp()
+{
+    encoder.reset();
+    decoder.reset();
+}
+
+void tearDown() {}
+
+void test_round_trip(void)
+{
+    std::vector<sample_t> const flight = recordFlight();
+    uint8_t msg[MSG_SIZE_MAX];
+    uint32_t deltas = 0;
+    for (size_t i = 0; i < flight.size();)
+    {
+        // Up to 4 frames in each message, some with the same type twice
+        uint8_t len = TLM_DELTA_MSG_HEADER_LEN;
+        size_t const first = i;
+        for (; i < flight.size() && i < first + 4; i++)
+        {
+            uint8_t const added = encoder.encode(flight[i].frame.data(), &msg[len]);
+            TEST_ASSERT_TRUE(added <= flight[i].frame.size());
+            deltas += msg[len] == TLM_DELTA_ADDRESS;
+            len += added;
+        }
+        TelemetryDeltaEncoder::setMessageHeader(msg, len);
+        std::vector<frame_t> const rebuilt = receive(msg);
+        encoder.confirm(true);
+
+        // The same frames for the handset, CRC and all
+        TEST_ASSERT_EQUAL(i - first, rebuilt.size());
+        for (size_t f = 0; f < rebuilt.size(); f++)
+        {
+            TEST_ASSERT_EQUAL(flight[first + f].frame.size(), rebuilt[f].size());
+            TEST_ASSERT_EQUAL_MEMORY(flight[first + f].frame.data(), rebuilt[f].data(), rebuilt[f].size());
+        }
+    }
+    TEST_ASSERT_TRUE(deltas > flight.size() * 3 / 4);
+}
+
+typedef struct {
+    uint8_t type;
+    uint32_t frames;
+    uint32_t bytes;
+} type_stats_t;
+
+typedef struct {
+    type_stats_t types[5];
+    uint32_t packets;
+    uint32_t messages;
+} link_stats_t;
+
+static type_stats_t *statsFor(link_stats_t &stats, uint8_t type)
+{
+    for (type_stats_t &t : stats.types)
+        if (t.type == type)
+            return &t;
+    return nullptr;
+}
+
+/**
+ * The flight over a link with a telemetry packet every TLM_INTERVAL_MS. Like the RX, the
+ * newest frame of each type waits until the sender is free. Without delta encoding each
+ * message is one frame, taking turns between the types. With delta encoding each message is every frame
+ * waiting, encoded against what the TX has.
+ */
+static void simulateLink(const std::vector<sample_t> &flight, bool delta, link_stats_t &stats)
+{
+    stats = {{{CRSF_FRAMETYPE_GPS},
+              {CRSF_FRAMETYPE_ATTITUDE},
+              {CRSF_FRAMETYPE_BATTERY_SENSOR},
+              {CRSF_FRAMETYPE_BARO_ALTITUDE},
+              {CRSF_FRAMETYPE_FLIGHT_MODE}}};
+    frame_t waiting[5];
+    uint8_t next = 0;
+    size_t sample = 0;
+    uint32_t packetsLeft = 0;
+    uint8_t msg[MSG_SIZE_MAX];
+    std::vector<uint8_t> inMessage;
+
+    for (uint32_t ms = 0; ms < FLIGHT_MS; ms += TLM_INTERVAL_MS)
+    {
+        for (; sample < flight.size() && flight[sample].ms <= ms; sample++)
+            waiting[statsFor(stats, flight[sample].frame[CRSF_TELEMETRY_TYPE_INDEX]) - stats.types] = flight[sample].frame;
+
+        if (packetsLeft == 0)
+        {
+            uint8_t len = 0;
+            inMessage.clear();
+            if (delta)
+            {
+                len = TLM_DELTA_MSG_HEADER_LEN;
+                for (uint8_t t = 0; t < 5; t++)
+                {
+                    if (waiting[t].empty())
+                        continue;
+                    uint8_t const added = encoder.encode(waiting[t].data(), &msg[len]);
+                    stats.types[t].bytes += added;
+                    len += added;
+                    inMessage.push_back(t);
+                    waiting[t].clear();
+                }
+                TelemetryDeltaEncoder::setMessageHeader(msg, len);
+                if (inMessage.empty())
+                    len = 0;
+            }
+            else
+            {
+                for (uint8_t i = 0; i < 5 && len == 0; i++)
+                {
+                    uint8_t const t = (next + i) % 5;
+                    if (waiting[t].empty())
+                        continue;
+                    len = waiting[t].size();
+                    stats.types[t].bytes += len;
+                    inMessage.push_back(t);
+                    waiting[t].clear();
+                    next = t + 1;
+                }
+            }
+            if (len)
+            {
+                packetsLeft = packetsFor(len);
+                ++stats.messages;
+            }
+        }
+
+        if (packetsLeft)
+        {
+            ++stats.packets;
+            if (--packetsLeft == 0)
+            {
+                for (uint8_t t : inMessage)
+                    ++stats.types[t].frames;
+                if (delta)
+                {
+                    TEST_ASSERT_EQUAL(inMessage.size(), receive(msg).size());
+                    encoder.confirm(true);
+                }
+            }
+        }
+    }
+}
+
+void test_bytes_saved(void)
+{
+    // Each frame as its own message, as to a TX without the delta feature, against delta messages
+    std::vector<sample_t> const flight = recordFlight();
+    link_stats_t whole, delta;
+    simulateLink(flight, false, whole);
+    simulateLink(flight, true, delta);
+
+    uint32_t wholeFrames = 0, deltaFrames = 0;
+    for (uint8_t t = 0; t < 5; t++)
+    {
+        const type_stats_t &w = whole.types[t];
+        const type_stats_t &d = delta.types[t];
+        wholeFrames += w.frames;
+        deltaFrames += d.frames;
+
+        TEST_ASSERT_TRUE(d.frames >= w.frames);
+        if (w.type == CRSF_FRAMETYPE_FLIGHT_MODE)
+            TEST_ASSERT_EQUAL(w.bytes * d.frames, d.bytes * w.frames);
+        else
+            TEST_ASSERT_TRUE(d.bytes * w.frames < w.bytes * d.frames);
+    }
+    TEST_ASSERT_TRUE(delta.packets * wholeFrames < whole.packets * deltaFrames);
+}
+
+void test_given_up_frames(void)
+{
+    std::vector<sample_t> const flight = recordFlight();
+    uint8_t msg[MSG_SIZE_MAX];
+    uint32_t passedOn = 0;
+    uint32_t messages = 0;
+    for (size_t i = 0; i < flight.size(); messages++)
+    {
+        uint8_t len = TLM_DELTA_MSG_HEADER_LEN;
+        size_t const first = i;
+        for (; i < flight.size() && i < first + 3; i++)
+            len += encoder.encode(flight[i].frame.data(), &msg[len]);
+        TelemetryDeltaEncoder::setMessageHeader(msg, len);
+
+        // Every 50th message is lost, and every 50th after that got through but the RX gave
+        // up waiting for the confirm
+        bool const lost = messages % 100 == 10;
+        bool const unconfirmed = messages % 100 == 60;
+        if (!lost)
+        {
+            std::vector<frame_t> const rebuilt = receive(msg);
+            // Never against a frame the TX doesn't have, so nothing is dropped
+            TEST_ASSERT_EQUAL(i - first, rebuilt.size());
+            for (size_t f = 0; f < rebuilt.size(); f++)
+                TEST_ASSERT_EQUAL_MEMORY(flight[first + f].frame.data(), rebuilt[f].data(), rebuilt[f].size());
+            passedOn += rebuilt.size();
+        }
+        encoder.confirm(!lost && !unconfirmed);
+    }
+    TEST_ASSERT_TRUE(passedOn > flight.size() * 95 / 100);
+}
+
+void test_bad_delta(void)
+{
+    std::vector<sample_t> const flight = recordFlight();
+    uint8_t msg[MSG_SIZE_MAX];
+    frame_t rebuilt(CRSF_FRAME_SIZE_MAX);
+    // Nothing to rebuild from yet
+    uint8_t const delta[] = {TLM_DELTA_ADDRESS, 3, CRSF_FRAMETYPE_GPS, 0, 0};
+    TEST_ASSERT_FALSE(decoder.decode(delta, rebuilt.data()));
+
+    // Up to the first frame which is sent as a delta
+    uint8_t len = 0;
+    size_t i = 0;
+    msg[0] = 0;
+    for (; msg[0] != TLM_DELTA_ADDRESS; i++)
+    {
+        encoder.confirm(true);
+        len = encoder.encode(flight[i].frame.data(), msg);
+        if (msg[0] != TLM_DELTA_ADDRESS)
+            TEST_ASSERT_TRUE(decoder.decode(msg, rebuilt.data()));
+    }
+    const frame_t &frame = flight[i - 1].frame;
+
+    // Cut short it can't be used
+    msg[1] = len - 3;
+    TEST_ASSERT_FALSE(decoder.decode(msg, rebuilt.data()));
+    // Nor any after it of the same type, as the TX no longer knows what the RX has, until a full frame
+    msg[1] = len - 2;
+    TEST_ASSERT_FALSE(decoder.decode(msg, rebuilt.data()));
+    TEST_ASSERT_TRUE(decoder.decode(frame.data(), rebuilt.data()));
+    TEST_ASSERT_EQUAL_MEMORY(frame.data(), rebuilt.data(), frame.size());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_bytes_saved);
+    RUN_TEST(test_given_up_frames);
+    RUN_TEST(test_bad_delta);
+    UNITY_END();
+
+    return 0;
+}
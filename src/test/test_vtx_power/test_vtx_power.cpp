@@ -0,0 +1,140 @@
+#include <cstdint>
+#include <unity.h>
+#include "VtxPowerControl.h"
+
+#define VPD_BUFFER 5
+#define MIN_PWM 2000
+#define MAX_PWM 3700
+#define INTERVAL_MS 20
+
+static const uint16_t calFreqs[] = {5650, 5750, 5850, 5950};
+static const uint16_t vpd25[] = {1100, 1140, 1150, 1120};
+static const uint16_t vpd100[] = {1500, 1560, 1580, 1540};
+static const uint16_t pwm25[] = {2900, 2880, 2850, 2870};
+static const uint16_t pwm100[] = {2600, 2570, 2520, 2550};
+static const uint16_t *const vpdArrays[VTX_POWER_CAL_LEVELS] = {vpd25, vpd100};
+static const uint16_t *const pwmArrays[VTX_POWER_CAL_LEVELS] = {pwm25, pwm100};
+
+void test_interpolate(void)
+{
+    TEST_ASSERT_EQUAL(1100, vtxInterpolate(5000, calFreqs, vpd25, 4));
+    TEST_ASSERT_EQUAL(1100, vtxInterpolate(5650, calFreqs, vpd25, 4));
+    TEST_ASSERT_EQUAL(1120, vtxInterpolate(5950, calFreqs, vpd25, 4));
+    TEST_ASSERT_EQUAL(1120, vtxInterpolate(6000, calFreqs, vpd25, 4));
+    // Each point and in between, rising and falling
+    TEST_ASSERT_EQUAL(1140, vtxInterpolate(5750, calFreqs, vpd25, 4));
+    TEST_ASSERT_EQUAL(1120, vtxInterpolate(5700, calFreqs, vpd25, 4));
+    TEST_ASSERT_EQUAL(1145, vtxInterpolate(5800, calFreqs, vpd25, 4));
+    TEST_ASSERT_EQUAL(1135, vtxInterpolate(5900, calFreqs, vpd25, 4));
+    TEST_ASSERT_EQUAL(2535, vtxInterpolate(5900, calFreqs, pwm100, 4));
+    TEST_ASSERT_EQUAL(2586, vtxInterpolate(5695, calFreqs, pwm100, 4));
+}
+
+void test_calibration(void)
+{
+    vtx_power_cal_t cal;
+    vtxPowerCalibrate(&cal, 5850, calFreqs, 4, vpdArrays, pwmArrays);
+    TEST_ASSERT_EQUAL(1150, cal.vpd[0]);
+    TEST_ASSERT_EQUAL(1580, cal.vpd[1]);
+    TEST_ASSERT_EQUAL(2850, cal.pwm[0]);
+    TEST_ASSERT_EQUAL(2520, cal.pwm[1]);
+    // 330 PWM for 430 VPD
+    TEST_ASSERT_EQUAL((330 << 8) / 430, cal.gain);
+
+    // Arrays which don't say which way the PWM goes
+    static const uint16_t flat[] = {2700, 2700, 2700, 2700};
+    static const uint16_t *const flatArrays[VTX_POWER_CAL_LEVELS] = {flat, flat};
+    vtxPowerCalibrate(&cal, 5850, calFreqs, 4, vpdArrays, flatArrays);
+    TEST_ASSERT_EQUAL(VTX_POWER_DEFAULT_GAIN, cal.gain);
+}
+
+void test_table(void)
+{
+    static VtxPowerTable table;
+    table.build(calFreqs, 4, vpdArrays, pwmArrays);
+
+    vtx_power_cal_t fromTable, expected;
+    for (uint8_t i = 0; i < FREQ_TABLE_SIZE; i++)
+    {
+        table.get(channelFreqTable[i], &fromTable);
+        vtxPowerCalibrate(&expected, channelFreqTable[i], calFreqs, 4, vpdArrays, pwmArrays);
+        TEST_ASSERT_EQUAL_MEMORY(&expected, &fromTable, sizeof(expected));
+    }
+    // Not a channel
+    table.get(5800, &fromTable);
+    TEST_ASSERT_EQUAL(1145, fromTable.vpd[0]);
+}
+
+// The PA, 4/3 VPD per PWM when the calibration says 430/330, with an offset from temperature
+static uint16_t paVpd(uint16_t pwm, int16_t offset, uint32_t &seed)
+{
+    seed = seed * 1103515245 + 12345;
+    int32_t const noise = (int32_t)((seed >> 16) % 7) - 3;
+    int32_t const vpd = 1150 + offset + ((int32_t)2850 - pwm) * 4 / 3 + noise;
+    return vpd < 0 ? 0 : vpd;
+}
+
+static uint16_t controllerSettle(VtxPowerController &ctrl, const vtx_power_cal_t &cal, uint8_t level, int16_t offset)
+{
+    uint32_t seed = 1;
+    ctrl.start(cal.vpd[level], cal.pwm[level], cal.gain, MIN_PWM, MAX_PWM, VPD_BUFFER);
+    for (uint16_t i = 0; i < 2000; i++)
+    {
+        ctrl.update(paVpd(ctrl.getPwm(), offset, seed));
+    }
+    return ctrl.getSettleIterations();
+}
+
+void test_settling(void)
+{
+    vtx_power_cal_t cal;
+    vtxPowerCalibrate(&cal, 5850, calFreqs, 4, vpdArrays, pwmArrays);
+    VtxPowerController ctrl;
+
+    static const int16_t offsets[] = {0, 150, -150, 400};
+    for (int16_t offset : offsets)
+    {
+        for (uint8_t level = 0; level < VTX_POWER_CAL_LEVELS; level++)
+        {
+            uint16_t const p = controllerSettle(ctrl, cal, level, offset);
+            // Within 200ms however far the temperature has moved the PA
+            TEST_ASSERT_NOT_EQUAL(0, p);
+            TEST_ASSERT_TRUE(p * INTERVAL_MS <= 200);
+            TEST_ASSERT_INT_WITHIN(VPD_BUFFER, 0, ctrl.getSteadyStateError());
+        }
+    }
+}
+
+void test_limits(void)
+{
+    VtxPowerController ctrl;
+    uint32_t seed = 1;
+    // More than the PA can do
+    ctrl.start(3000, 2600, 256, MIN_PWM, MAX_PWM, VPD_BUFFER);
+    for (uint16_t i = 0; i < 50; i++)
+        ctrl.update(paVpd(ctrl.getPwm(), 0, seed));
+    TEST_ASSERT_EQUAL(MIN_PWM, ctrl.getPwm());
+    TEST_ASSERT_FALSE(ctrl.isSettled());
+
+    ctrl.start(5, 2600, 256, MIN_PWM, MAX_PWM, VPD_BUFFER);
+    for (uint16_t i = 0; i < 50; i++)
+        ctrl.update(paVpd(ctrl.getPwm(), 0, seed));
+    TEST_ASSERT_EQUAL(MAX_PWM, ctrl.getPwm());
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_interpolate);
+    RUN_TEST(test_calibration);
+    RUN_TEST(test_table);
+    RUN_TEST(test_settling);
+    RUN_TEST(test_limits);
+    UNITY_END();
+
+    return 0;
+}